@@ -0,0 +1,567 @@
+// mprp-bench: hot-path throughput benchmarks.
+//
+// Writes one line per case to bench_output.txt (or --out FILE) in a
+// stable key=value format, e.g.
+//
+//   bench=nco size=4096 channels=16 isa=avx2 iters=2048 samples_per_sec=1.9e+09 ns_per_sample=0.52 allocs_per_call=0
+//
+// Lines starting with '#' are comments. "samples" are the unit each
+// kernel consumes or produces (input IQ samples, rendered audio samples,
+// encoded symbols), and allocs_per_call counts operator new calls made
+// inside the timed loop.
+//
+// --repeat N measures each case N times and reports the median, which is
+// how baselines are recorded. With --baseline FILE (an earlier output, e.g.
+// bench/baseline.txt) it is also a perf gate: a case whose samples_per_sec falls more than
+// --max-regression (default 0.25) below its baseline line is measured
+// twice more, and if the best of the three still falls short the run is
+// reported and exits 1. Cases without a baseline line are not gated.
+
+#include "mprp/arena.hpp"
+#include "mprp/convolutional.hpp"
+#include "mprp/modulator.hpp"
+#include "mprp/nco.hpp"
+#include "mprp/polyphase.hpp"
+#include "mprp/rx_stages.hpp"
+#include "mprp/sample_format.hpp"
+#include "mprp/spectrum.hpp"
+#include "mprp/spsc_ring.hpp"
+#include "mprp/sync_search.hpp"
+#include "mprp/task_pool.hpp"
+#include "mprp/wspr.hpp"
+#include "mprp/wspr_search.hpp"
+
+#include "reference.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <new>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<std::uint64_t> allocations{0};
+
+// Out of line so that GCC does not see malloc() and free() meet across an
+// inlined new/delete pair and warn (-Wmismatched-new-delete).
+[[gnu::noinline]] void* counted_malloc(std::size_t size) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+[[gnu::noinline]] void counted_free(void* p) noexcept
+{
+    std::free(p);
+}
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    if (void* p = counted_malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    counted_free(p);
+}
+
+namespace {
+
+using namespace mprp;
+using Seconds = std::chrono::duration<double>;
+
+struct Options {
+    std::string out = "bench_output.txt";
+    double min_time_s = 0.2;
+    unsigned repeat = 1;
+    std::string filter;
+    std::string baseline;
+    double max_regression = 0.25;
+    std::size_t workers = 1;  ///< Size of the pool the parallel cases run on.
+};
+
+/// samples_per_sec of each case in a bench output, keyed by everything
+/// before iters=.
+std::map<std::string, double> read_baseline(const std::string& path)
+{
+    std::map<std::string, double> out;
+    std::ifstream in(path);
+    for (std::string line; std::getline(in, line);) {
+        const auto iters = line.find(" iters=");
+        const auto rate = line.find(" samples_per_sec=");
+        if (line.empty() || line[0] == '#' || iters == std::string::npos || rate == std::string::npos)
+            continue;
+        out[line.substr(0, iters)] = std::atof(line.c_str() + rate + 17);
+    }
+    return out;
+}
+
+class Reporter {
+public:
+    Reporter(const Options& opt, std::FILE* out) : opt_(opt), out_(out), pool_(opt.workers)
+    {
+        if (!opt_.baseline.empty())
+            baseline_ = read_baseline(opt_.baseline);
+    }
+
+    /// Times fn (one call processes samples_per_call samples) until
+    /// min_time has elapsed and reports the result.
+    template <typename F>
+    void run(const char* name, std::size_t size, std::size_t channels, const char* isa,
+             double samples_per_call, F&& fn)
+    {
+        if (!opt_.filter.empty() && opt_.filter != name)
+            return;
+        fn();  // warm caches and lazy one-time setup
+
+        char key[160];
+        std::snprintf(key, sizeof key, "bench=%s size=%zu channels=%zu isa=%s", name, size, channels, isa);
+        const auto base = baseline_.find(key);
+        std::vector<Result> runs;
+        for (unsigned i = 0; i < opt_.repeat; ++i)
+            runs.push_back(measure(samples_per_call, fn));
+        std::sort(runs.begin(), runs.end(),
+                  [](const Result& a, const Result& b) { return a.samples_per_sec < b.samples_per_sec; });
+        Result best = runs[runs.size() / 2];
+        if (!opt_.baseline.empty() && base == baseline_.end()) {
+            ++missing_;
+            std::fprintf(stderr, "mprp-bench: NO BASELINE %s\n", key);
+        }
+        if (base != baseline_.end()) {
+            const double floor = base->second * (1.0 - opt_.max_regression);
+            for (int retry = 0; retry < 2 && best.samples_per_sec < floor; ++retry) {
+                const Result again = measure(samples_per_call, fn);
+                if (again.samples_per_sec > best.samples_per_sec)
+                    best = again;
+            }
+            if (best.samples_per_sec < floor) {
+                ++regressions_;
+                std::fprintf(stderr, "mprp-bench: REGRESSION %s: %.4g samples/s, baseline %.4g (%+.0f%%)\n", key,
+                             best.samples_per_sec, base->second, (best.samples_per_sec / base->second - 1.0) * 100.0);
+            }
+        }
+        std::fprintf(out_, "%s iters=%llu samples_per_sec=%.4g ns_per_sample=%.4g allocs_per_call=%.4g\n", key,
+                     static_cast<unsigned long long>(best.iters), best.samples_per_sec, 1e9 / best.samples_per_sec,
+                     best.allocs_per_call);
+        std::fflush(out_);
+    }
+
+    unsigned regressions() const noexcept { return regressions_; }
+    unsigned missing() const noexcept { return missing_; }
+
+    /// The pool of the parallel cases: a fixed --workers size rather than
+    /// the machine's, so their channels= (and baseline keys) match across
+    /// machines.
+    TaskPool& pool() noexcept { return pool_; }
+
+private:
+    struct Result {
+        std::uint64_t iters;
+        double samples_per_sec;
+        double allocs_per_call;
+    };
+
+    template <typename F>
+    Result measure(double samples_per_call, F& fn)
+    {
+        std::uint64_t iters = 0;
+        std::uint64_t allocs = 0;
+        const auto start = std::chrono::steady_clock::now();
+        auto now = start;
+        for (std::uint64_t batch = 1; Seconds(now - start).count() < opt_.min_time_s; batch *= 2) {
+            const std::uint64_t before = allocations.load(std::memory_order_relaxed);
+            for (std::uint64_t i = 0; i < batch; ++i)
+                fn();
+            allocs += allocations.load(std::memory_order_relaxed) - before;
+            iters += batch;
+            now = std::chrono::steady_clock::now();
+        }
+        const double elapsed = Seconds(now - start).count();
+        const double samples = samples_per_call * static_cast<double>(iters);
+        return {iters, samples / elapsed, static_cast<double>(allocs) / static_cast<double>(iters)};
+    }
+
+    const Options& opt_;
+    std::FILE* out_;
+    std::map<std::string, double> baseline_;
+    unsigned regressions_ = 0;
+    unsigned missing_ = 0;
+    TaskPool pool_;
+};
+
+std::vector<Isa> isas()
+{
+    std::vector<Isa> out{Isa::Scalar};
+    if (best_isa() != Isa::Scalar)
+        out.push_back(best_isa());
+    return out;
+}
+
+std::vector<Complex> test_signal(std::size_t n, double rate)
+{
+    std::vector<Complex> x(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        const double t = static_cast<double>(i) / rate;
+        x[i] = 0.5f * std::polar(1.0f, static_cast<float>(2.0 * 3.14159265358979 * 1234.5 * t))
+               + 0.01f * Complex(static_cast<float>(std::sin(i * 0.37)), static_cast<float>(std::cos(i * 0.91)));
+    }
+    return x;
+}
+
+void bench_encoders(Reporter& r)
+{
+    for (std::size_t batch : {1, 64, 512}) {
+        std::vector<WsprMessage> msgs(batch, WsprMessage{"KI5UXW", "EM10", 23});
+        std::vector<WsprSymbols> out(batch);
+        r.run("wspr_encode", batch, 1, "scalar", static_cast<double>(batch * wspr_symbol_count),
+              [&] { wspr_encode_batch(msgs, out); });
+    }
+    for (double wpm : {20.0, 40.0}) {
+        const CwModulator mod(48000.0, 700.0, wpm, 0.8);
+        const auto plan = mod.plan(encode_morse("VVV DE KI5UXW KI5UXW EM10"));
+        std::vector<float> out(plan.total);
+        r.run("cw_render", plan.total, 1, to_string(best_isa()), static_cast<double>(plan.total),
+              [&] { mod.render(plan, out); });
+    }
+}
+
+void bench_nco(Reporter& r)
+{
+    for (Isa isa : isas())
+        for (std::size_t block : {256, 4096})
+            for (std::size_t tones : {1, 4, 16}) {
+                NcoBank bank(48000.0, isa);
+                for (std::size_t t = 0; t < tones; ++t)
+                    bank.add_tone(500.0 + 97.0 * t, 1.0f / tones);
+                std::vector<float> out(block);
+                r.run("nco", block, tones, to_string(isa), static_cast<double>(block),
+                      [&] { bank.render(out); });
+                std::vector<Complex> iq(block);
+                r.run("nco_iq", block, tones, to_string(isa), static_cast<double>(block),
+                      [&] { bank.render(std::span<Complex>(iq)); });
+            }
+}
+
+void bench_fir(Reporter& r)
+{
+    for (Isa isa : isas())
+        for (double out_rate : {48000.0, 12000.0})
+            for (std::size_t block : {16384, 65536}) {
+                ResamplerCascade cascade(2400000.0, out_rate, 0.4 * out_rate, 80.0, isa);
+                const auto in = test_signal(block, 2400000.0);
+                std::vector<Complex> out(cascade.max_output(block) + 64);
+                r.run(out_rate == 48000.0 ? "fir_decimate_2m4_48k" : "fir_decimate_2m4_12k", block,
+                      1, to_string(isa), static_cast<double>(block),
+                      [&] { cascade.process(in, out); });
+            }
+}
+
+void bench_iq(Reporter& r)
+{
+    // The receive chain's first stage on raw SDR samples: a separate
+    // expansion to Complex followed by the mix, against the fused kernel.
+    constexpr std::size_t block = 16384;
+    const auto signal = test_signal(block, 2400000.0);
+    std::vector<Complex> lo(block);
+    nco_accumulate(0, phase_step(-120000.0, 2400000.0), 1.0f, std::span<Complex>(lo));
+    std::vector<Complex> buf(block);
+    for (IqFormat format : {IqFormat::Cs16, IqFormat::Cu8}) {
+        std::vector<unsigned char> raw(block * iq_sample_bytes(format));
+        encode_iq(format, signal, raw.data());
+        const bool cs16 = format == IqFormat::Cs16;
+        r.run(cs16 ? "iq_decode_mix_cs16" : "iq_decode_mix_cu8", block, 1, "scalar", static_cast<double>(block), [&] {
+            decode_iq(format, raw.data(), buf);
+            for (std::size_t i = 0; i < block; ++i)
+                buf[i] = {buf[i].real() * lo[i].real() - buf[i].imag() * lo[i].imag(),
+                          buf[i].real() * lo[i].imag() + buf[i].imag() * lo[i].real()};
+        });
+        r.run(cs16 ? "iq_mix_fused_cs16" : "iq_mix_fused_cu8", block, 1, "scalar", static_cast<double>(block), [&] {
+            with_sample_type(format, [&]<typename T>(std::type_identity<T>) {
+                mix_frames<T>(raw.data(), block, lo.data(), {buf.data()});
+            });
+        });
+    }
+}
+
+void bench_front_end(Reporter& r)
+{
+    // 2.4 MS/s cs16 to 48 kS/s: whole-block mix then decimate, against the
+    // tiled FrontEndStage (output blocks are dropped by the null emitter).
+    constexpr std::size_t block = 65536;
+    constexpr double rate = 2400000.0;
+    std::vector<unsigned char> raw(block * iq_sample_bytes(IqFormat::Cs16));
+    encode_iq(IqFormat::Cs16, test_signal(block, rate), raw.data());
+
+    ResamplerCascade cascade(rate, 48000.0, 19200.0);
+    std::vector<Complex> lo(block), mixed(block), out(cascade.max_output(block) + 64);
+    std::uint32_t phase = 0;
+    const std::uint32_t step = phase_step(-120000.0, rate);
+    r.run("front_end_separate", block, 1, to_string(best_isa()), static_cast<double>(block), [&] {
+        std::fill(lo.begin(), lo.end(), Complex{});
+        phase = nco_accumulate(phase, step, 1.0f, std::span<Complex>(lo));
+        mix_frames<Cs16Sample>(raw.data(), block, lo.data(), {mixed.data()});
+        cascade.process(mixed, out);
+    });
+
+    FrontEndStage stage(120000.0, 48000.0, 19200.0, std::nullopt, 4096);
+    BufferPool pool(1, block);
+    BufferRef in = pool.acquire();
+    std::memcpy(in->data, raw.data(), raw.size());
+    in->size = block;
+    in->sample_rate = rate;
+    in->format = IqFormat::Cs16;
+    r.run("front_end_fused", block, 1, to_string(best_isa()), static_cast<double>(block),
+          [&] { stage.process(in, Emitter{}); });
+}
+
+void bench_fft(Reporter& r)
+{
+    for (std::size_t fft : {1024, 4096, 16384})
+        for (std::size_t channels : {1, 8}) {
+            SpectrumConfig cfg;
+            cfg.sample_rate = 48000.0;
+            cfg.fft_size = fft;
+            for (std::size_t c = 0; c < channels; ++c)
+                cfg.channels.push_back({"ch", -20000.0 + 5000.0 * c, 200.0});
+            SpectrumMonitor mon(cfg);
+            const auto in = test_signal(4 * fft, 48000.0);
+            r.run("fft_monitor", fft, channels, "scalar", static_cast<double>(in.size()),
+                  [&] { mon.push(in); });
+        }
+}
+
+void bench_fft_batch(Reporter& r)
+{
+    // channels= is the worker count; 0 workers means the calling thread only.
+    constexpr std::size_t fft = 4096;
+    constexpr std::size_t frames = 64;
+    const auto plan = fft_plan(fft);
+    const auto in = test_signal(fft * frames, 48000.0);
+    std::vector<Complex> work(in.size());
+    r.run("fft_batch", fft, 0, "scalar", static_cast<double>(work.size()), [&] {
+        std::copy(in.begin(), in.end(), work.begin());
+        plan->forward_batch(work);
+    });
+    TaskPool& pool = r.pool();
+    r.run("fft_batch", fft, pool.workers(), "scalar", static_cast<double>(work.size()), [&] {
+        std::copy(in.begin(), in.end(), work.begin());
+        plan->forward_batch(work, &pool);
+    });
+}
+
+void bench_decoders(Reporter& r)
+{
+    // Soft symbols at a moderate SNR from a fixed LCG so runs are comparable;
+    // "samples" are decoded source bits.
+    std::uint32_t seed = 12345;
+    auto noise = [&] {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<int>(seed >> 26) - 32;
+    };
+    auto soften = [&](std::span<const std::uint8_t> coded, std::span<std::int8_t> soft) {
+        for (std::size_t i = 0; i < coded.size(); ++i)
+            soft[i] = static_cast<std::int8_t>((coded[i] ? 40 : -40) + noise());
+    };
+
+    constexpr std::size_t bits = 4096;
+    // Fixed arrays: GCC's -Wmismatched-new-delete misfires on byte vectors
+    // against the counting operator new above.
+    std::array<std::uint8_t, bits> source{};
+    for (std::size_t i = 0; i + k7_code.k - 1 < bits; ++i)
+        source[i] = static_cast<std::uint8_t>(noise() & 1);
+    std::array<std::uint8_t, 2 * bits> coded;
+    std::array<std::int8_t, 2 * bits> soft;
+    conv_encode(k7_code, source, coded);
+    soften(coded, soft);
+    std::array<std::uint8_t, bits> decoded;
+    for (Isa isa : isas()) {
+        ViterbiDecoder viterbi(k7_code, isa);
+        r.run("viterbi_k7", bits, 1, to_string(isa), static_cast<double>(bits),
+              [&] { viterbi.decode(soft, decoded); });
+    }
+
+    WsprSymbols symbols;
+    wspr_encode({"K1ABC", "FN42", 37}, symbols);
+    WsprSoftSymbols wspr_soft;
+    for (std::size_t i = 0; i < wspr_symbol_count; ++i) {
+        const std::uint8_t bit = symbols[i] >> 1;
+        soften(std::span<const std::uint8_t>(&bit, 1), std::span<std::int8_t>(&wspr_soft[i], 1));
+    }
+    FanoDecoder fano(wspr_code);
+    std::optional<WsprReport> report;
+    r.run("fano_wspr", wspr_symbol_count, 1, "scalar", 81.0, [&] { report = wspr_decode(wspr_soft, fano); });
+
+    // One slot's worth of candidates, decoder state from a per-slot arena;
+    // size= is the candidate count.
+    constexpr std::size_t candidates = 32;
+    std::vector<WsprSoftSymbols> batch(candidates, wspr_soft);
+    std::vector<std::optional<WsprReport>> reports(candidates);
+    TaskPool& pool = r.pool();
+    Arena arena;
+    r.run("wspr_decode_batch", candidates, pool.workers(), "scalar", 81.0 * candidates, [&] {
+        wspr_decode_batch(pool, batch, reports, {}, &arena);
+        arena.reset();
+    });
+
+    // Full-band sync search at the 375 Hz defaults: a batch of peak
+    // queries over 4 s of lag and +-4 Hz of drift; samples are grid cells.
+    constexpr std::size_t width = 200, steps = 4, lags = 65, drift_steps = 8, peaks = 8;
+    const std::size_t columns = lags + (wspr_symbol_count - 1) * steps;
+    std::vector<float> power(columns * width);
+    std::uint32_t lcg = 1;
+    for (float& v : power) {
+        lcg = lcg * 1664525u + 1013904223u;
+        v = static_cast<float>(lcg >> 8) * 0x1p-24f;
+    }
+    std::vector<std::int16_t> offsets((2 * drift_steps + 1) * wspr_symbol_count);
+    for (std::size_t d = 0; d <= 2 * drift_steps; ++d)
+        for (std::size_t i = 0; i < wspr_symbol_count; ++i)
+            offsets[d * wspr_symbol_count + i] = static_cast<std::int16_t>(
+                std::lround((static_cast<double>(d) - drift_steps) * (static_cast<double>(i) - 80.5) / 161.0));
+    const SyncTile tile{power, width, steps, 0, offsets, drift_steps};
+    std::vector<SyncQuery> queries;
+    for (std::size_t q = 0; q < peaks; ++q) {
+        const auto b = static_cast<std::ptrdiff_t>(20 + q * 20);
+        queries.push_back({b - 1, b + 1, 0, lags - 1, -static_cast<std::ptrdiff_t>(drift_steps),
+                           static_cast<std::ptrdiff_t>(drift_steps)});
+    }
+    std::vector<SyncHit> hits(peaks);
+    const double cells = static_cast<double>(peaks * 3 * lags * (2 * drift_steps + 1));
+    for (SearchDevice device : {SearchDevice::Cpu, SearchDevice::OpenCl}) {
+        const auto backend = make_sync_backend(device);
+        if (device != SearchDevice::Cpu && std::strcmp(backend->name(), to_string(device)) != 0)
+            continue;  // no device: the CPU case already covers it
+        r.run("wspr_sync_search", peaks, 1, backend->name(), cells, [&] { backend->search(tile, queries, hits); });
+    }
+}
+
+void bench_decode_window(Reporter& r)
+{
+    // Whole WSPR slots of the reference capture through the decode stage,
+    // so a call is one window: spectrogram, candidate search, tone
+    // extraction and the Fano batch. Seeded is the steady state, full the
+    // every-tenth-slot (or nothing tracked) case.
+    const auto slot = test::wspr_reference(1);
+    TaskPool& pool = r.pool();
+    for (const unsigned every : {1u, 10u}) {
+        WsprSearchConfig config;
+        config.sample_rate = test::reference_rate;
+        config.full_search_every = every;
+        std::size_t spots = 0;
+        WsprDecodeStage stage(config, [&](std::span<const WsprSpot> s) { spots += s.size(); }, &pool);
+        BufferPool blocks(2, slot.size());
+        std::uint64_t first = 0;
+        r.run(every == 1 ? "wspr_window_full" : "wspr_window_seeded", slot.size(), pool.workers(), "scalar",
+              static_cast<double>(slot.size()), [&] {
+                  BufferRef b = blocks.acquire();
+                  std::copy(slot.begin(), slot.end(), b->data);
+                  b->size = slot.size();
+                  b->sample_rate = test::reference_rate;
+                  b->first_sample = first;
+                  first += slot.size();
+                  stage.process(std::move(b), Emitter{});
+              });
+        if (spots == 0)
+            std::fprintf(stderr, "mprp-bench: reference capture decoded no spots\n");
+    }
+}
+
+void bench_ring(Reporter& r)
+{
+    for (std::size_t block : {64, 1024}) {
+        SpscRing<float> ring(8192);
+        std::vector<float> src(block, 0.5f);
+        std::vector<float> dst(block);
+        r.run("spsc_ring", block, 1, "scalar", static_cast<double>(block), [&] {
+            ring.push(src);
+            ring.pop(dst);
+        });
+    }
+}
+
+bool parse_args(int argc, char** argv, Options& opt)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            opt.out = argv[++i];
+        else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+            opt.min_time_s = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--only") == 0 && i + 1 < argc)
+            opt.filter = argv[++i];
+        else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+            opt.repeat = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+            opt.baseline = argv[++i];
+        else if (std::strcmp(argv[i], "--max-regression") == 0 && i + 1 < argc)
+            opt.max_regression = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+            opt.workers = static_cast<std::size_t>(std::max(1, std::atoi(argv[++i])));
+        else
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::fprintf(stderr, "usage: mprp-bench [--out FILE|-] [--min-time S] [--repeat N] [--only NAME]\n"
+                             "                  [--workers N] [--baseline FILE [--max-regression F]]\n");
+        return 2;
+    }
+    std::FILE* out = opt.out == "-" ? stdout : std::fopen(opt.out.c_str(), "w");
+    if (!out) {
+        std::fprintf(stderr, "mprp-bench: cannot open %s\n", opt.out.c_str());
+        return 1;
+    }
+
+    std::fprintf(out, "# mprp-bench format=1 best_isa=%s min_time_s=%g repeat=%u\n", to_string(best_isa()),
+                 opt.min_time_s, opt.repeat);
+    Reporter r(opt, out);
+    bench_encoders(r);
+    bench_nco(r);
+    bench_fir(r);
+    bench_iq(r);
+    bench_front_end(r);
+    bench_fft(r);
+    bench_fft_batch(r);
+    bench_decoders(r);
+    bench_decode_window(r);
+    bench_ring(r);
+
+    if (out != stdout)
+        std::fclose(out);
+    if (r.regressions()) {
+        std::fprintf(stderr, "mprp-bench: %u case(s) regressed past %.0f%% of %s\n", r.regressions(),
+                     opt.max_regression * 100.0, opt.baseline.c_str());
+        return 1;
+    }
+    if (r.missing()) {
+        std::fprintf(stderr, "mprp-bench: %u case(s) have no line in %s; re-record it\n", r.missing(),
+                     opt.baseline.c_str());
+        return 1;
+    }
+    return 0;
+}
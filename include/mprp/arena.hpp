@@ -0,0 +1,143 @@
+#pragma once
+
+// Memory resources for the receive path.
+//
+// Arena is a monotonic per-slot resource: decode and search temporaries
+// bump-allocate from it and everything is released at once by reset() at
+// the end of the slot. Its chunks are kept (coalesced to the high-water
+// size), so from the second slot on it never calls the upstream allocator.
+//
+// PoolResource recycles long-lived buffers (pipeline block storage, stage
+// work areas) through per-size-class free lists, so pipelines built and
+// torn down per capture or per band reuse the same memory.
+//
+// Both are std::pmr::memory_resources and work with std::pmr containers.
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace mprp {
+
+/// Monotonic bump allocator. allocate() is lock-free and may be called
+/// from several threads at once (e.g. a batch decode on a TaskPool);
+/// deallocate() is a no-op. reset() must not race with allocate().
+class Arena final : public std::pmr::memory_resource {
+public:
+    explicit Arena(std::size_t initial_bytes = 64 * 1024,
+                   std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    ~Arena() override;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /// n value-initialised objects; T must be trivially destructible since
+    /// the arena never runs destructors.
+    template <typename T>
+    std::span<T> make_span(std::size_t n)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+        T* p = static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+        std::uninitialized_value_construct_n(p, n);
+        return {p, n};
+    }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+        return ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /// Releases every allocation. Several chunks are merged into one of
+    /// their combined size, so the next slot fits without growing.
+    void reset();
+
+    /// Bytes handed out since the last reset (including alignment padding).
+    std::size_t used() const noexcept;
+    /// Bytes reserved from upstream.
+    std::size_t capacity() const noexcept;
+    /// Largest used() seen at a reset.
+    std::size_t high_water() const noexcept { return high_water_; }
+    /// Chunks taken from upstream over the arena's life.
+    std::uint64_t upstream_allocations() const noexcept
+    {
+        return upstream_allocations_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Chunk;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    Chunk* new_chunk(std::size_t bytes, Chunk* next);
+    void free_chunks(Chunk* chunk) noexcept;
+
+    std::pmr::memory_resource* upstream_;
+    std::atomic<Chunk*> current_{nullptr};
+    std::mutex grow_mutex_;
+    std::size_t next_chunk_bytes_;
+    std::size_t high_water_ = 0;
+    std::atomic<std::uint64_t> upstream_allocations_{0};
+};
+
+/// Size-class pool for long-lived buffers: blocks are rounded up to a power
+/// of two (64 B .. 64 MiB, cache-line aligned) and returned to a per-class
+/// free list instead of upstream. Larger or over-aligned requests pass
+/// straight through. Thread-safe.
+class PoolResource final : public std::pmr::memory_resource {
+public:
+    explicit PoolResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    ~PoolResource() override;
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    /// Returns every cached free block to upstream.
+    void release() noexcept;
+
+    /// Requests served from a free list / from upstream.
+    std::uint64_t reused() const noexcept { return reused_.load(std::memory_order_relaxed); }
+    std::uint64_t upstream_allocations() const noexcept
+    {
+        return upstream_allocations_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr std::size_t min_class_bits = 6;
+    static constexpr std::size_t max_class_bits = 26;
+    static constexpr std::size_t classes = max_class_bits - min_class_bits + 1;
+    static constexpr std::size_t block_alignment = 64;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    struct SizeClass {
+        std::mutex mutex;
+        FreeBlock* head = nullptr;
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    std::pmr::memory_resource* upstream_;
+    std::array<SizeClass, classes> classes_;
+    std::atomic<std::uint64_t> reused_{0};
+    std::atomic<std::uint64_t> upstream_allocations_{0};
+};
+
+/// Process-wide pool for pipeline buffers, created on first use.
+PoolResource& default_pool_resource();
+
+} // namespace mprp
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "mprp/sample_format.hpp"
+#include "mprp/scheduler.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace mprp {
+
+class BufferPool;
+
+/// One fixed-capacity block of IQ samples plus stream metadata. Blocks are
+/// owned by a BufferPool and handed around through BufferRef.
+struct Block {
+    Complex* data = nullptr;
+    std::size_t capacity = 0;
+    std::size_t size = 0;
+    double sample_rate = 0.0;
+    std::uint64_t sequence = 0;      ///< Block number within the stream.
+    std::uint64_t first_sample = 0;  ///< Stream position of data[0] at sample_rate.
+    TimePoint start{};               ///< Capture time of data[0], if known.
+    /// Layout of data: Cf32 (Complex) unless a source delivered its raw
+    /// samples for the first stage to convert (see Stage::accepts_raw()).
+    IqFormat format = IqFormat::Cf32;
+
+private:
+    friend class BufferPool;
+    friend class BufferRef;
+    std::atomic<std::uint32_t> refs{0};
+    BufferPool* pool = nullptr;
+    Complex* home = nullptr;  ///< The pool's own storage for this block.
+    bool view = false;        ///< data points at read-only memory outside the pool.
+};
+
+/// Reference-counted handle to a pooled Block. Copying a BufferRef shares
+/// the block; the block returns to its pool when the last handle goes.
+class BufferRef {
+public:
+    BufferRef() noexcept = default;
+    BufferRef(const BufferRef& other) noexcept : block_(other.block_) { retain(); }
+    BufferRef(BufferRef&& other) noexcept : block_(other.block_) { other.block_ = nullptr; }
+    BufferRef& operator=(BufferRef other) noexcept
+    {
+        std::swap(block_, other.block_);
+        return *this;
+    }
+    ~BufferRef() { reset(); }
+
+    void reset() noexcept;
+
+    explicit operator bool() const noexcept { return block_ != nullptr; }
+    Block* operator->() const noexcept { return block_; }
+    Block& operator*() const noexcept { return *block_; }
+
+    /// The filled part of the block.
+    std::span<Complex> samples() const noexcept { return {block_->data, block_->size}; }
+
+    /// The whole block, for writers.
+    std::span<Complex> storage() const noexcept { return {block_->data, block_->capacity}; }
+
+    /// True if no other handle shares the block and it is not a read-only
+    /// view, so it may be modified in place.
+    bool unique() const noexcept
+    {
+        return !block_->view && block_->refs.load(std::memory_order_acquire) == 1;
+    }
+
+    /// Gives up ownership without dropping the reference (for queues that
+    /// carry raw pointers); adopt() takes it back.
+    Block* detach() noexcept { return std::exchange(block_, nullptr); }
+    static BufferRef adopt(Block* block) noexcept { return BufferRef(block); }
+
+private:
+    friend class BufferPool;
+    explicit BufferRef(Block* block) noexcept : block_(block) {}
+    void retain() noexcept
+    {
+        if (block_)
+            block_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Block* block_ = nullptr;
+};
+
+/// Fixed set of equally sized sample blocks allocated once up front.
+///
+/// acquire() blocks while every block is in flight, which is what bounds
+/// the memory of a streaming pipeline: a slow stage back-pressures the
+/// source instead of letting queues grow. The pool must outlive every
+/// BufferRef taken from it.
+///
+/// Sample storage comes from resource (by default the process-wide
+/// PoolResource), so pools created per capture recycle the same memory.
+class BufferPool {
+public:
+    BufferPool(std::size_t blocks, std::size_t block_samples, std::pmr::memory_resource* resource = nullptr);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /// Waits for a free block. The returned block has size 0 and cleared metadata.
+    BufferRef acquire();
+
+    /// Returns an empty ref instead of waiting.
+    BufferRef try_acquire();
+
+    /// Waits for a free block and points it at external samples instead of
+    /// pool storage (zero-copy sources such as a mapped capture). The block
+    /// is never unique(), so stages copy before modifying it; the memory
+    /// must stay valid until the block comes back to the pool.
+    BufferRef acquire_view(std::span<Complex> samples);
+
+    std::size_t blocks() const noexcept { return blocks_.size(); }
+    std::size_t block_samples() const noexcept { return block_samples_; }
+    std::size_t available() const;
+
+private:
+    friend class BufferRef;
+    void recycle(Block* block) noexcept;
+    BufferRef hand_out();
+
+    std::size_t block_samples_;
+    std::pmr::memory_resource* resource_;
+    Complex* storage_ = nullptr;
+    std::vector<std::unique_ptr<Block>> blocks_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::vector<Block*> free_;
+};
+
+inline void BufferRef::reset() noexcept
+{
+    if (block_ && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        block_->pool->recycle(block_);
+    block_ = nullptr;
+}
+
+} // namespace mprp
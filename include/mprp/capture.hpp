@@ -0,0 +1,187 @@
+#pragma once
+
+// Chunked IQ capture container (.mprpcap).
+//
+//   header   64 bytes   magic, version, sample format, index location
+//   chunk    64 bytes   ChunkInfo record, then the stored payload padded
+//   ...                 to 64 bytes (uncompressed payloads stay aligned)
+//   index    n * 64     copy of every ChunkInfo, written on close
+//
+// Chunks carry their own capture time, centre frequency and sample rate, so
+// a reader jumps to a time range through the index without touching the
+// samples. A capture whose writer died before close() has no index; the
+// reader rebuilds it by walking the chunk records.
+
+#include "mprp/rx_pipeline.hpp"
+#include "mprp/rx_stages.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace mprp {
+
+enum class CaptureCodec : std::uint32_t {
+    None = 0,
+    Zlib = 1,  ///< Deflate per chunk; available when built with zlib.
+};
+
+/// True if payloads with this codec can be written and read in this build.
+bool capture_codec_supported(CaptureCodec codec) noexcept;
+
+/// One chunk's index entry, stored verbatim in the file (little endian).
+struct ChunkInfo {
+    std::int64_t start_unix_ns;  ///< Capture time of the first sample.
+    double centre_hz;            ///< RF centre frequency.
+    double sample_rate;
+    std::uint64_t first_sample;  ///< Position in the capture's sample stream.
+    std::uint64_t samples;
+    std::uint64_t offset;        ///< File offset of the payload.
+    std::uint64_t stored_bytes;  ///< Payload size as stored (after compression).
+    std::uint32_t codec;         ///< CaptureCodec.
+    std::uint32_t checksum;      ///< Low half of Fnv1a over the stored payload.
+
+    TimePoint start() const noexcept { return TimePoint(std::chrono::nanoseconds(start_unix_ns)); }
+    TimePoint end() const noexcept;
+};
+static_assert(sizeof(ChunkInfo) == 64);
+
+/// Most samples a compressed chunk may hold (its stored size says nothing
+/// about how far it inflates); readers reject files that claim more.
+constexpr std::uint64_t max_compressed_chunk_samples = std::uint64_t{1} << 26;
+
+/// Appends chunks to a new capture file.
+class CaptureWriter {
+public:
+    /// Throws std::runtime_error if the file cannot be created or the codec
+    /// is not available.
+    CaptureWriter(const std::string& path, IqFormat format, CaptureCodec codec = CaptureCodec::None,
+                  int zlib_level = 1);
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    /// Appends samples as one chunk, converted to the file's format.
+    void append(std::span<const Complex> samples, TimePoint start, double centre_hz,
+                double sample_rate);
+
+    /// Appends samples already in the file's format (e.g. straight from an
+    /// rtl_sdr read) as one chunk. Throws std::invalid_argument for a
+    /// compressed chunk over max_compressed_chunk_samples.
+    void append_raw(const void* raw, std::size_t samples, TimePoint start, double centre_hz,
+                    double sample_rate);
+
+    /// Writes the index and header; called by the destructor if needed.
+    /// Throws std::runtime_error on I/O failure.
+    void close();
+
+    std::size_t chunks() const noexcept { return index_.size(); }
+
+private:
+    void write(const void* data, std::size_t n);
+
+    std::FILE* file_ = nullptr;
+    IqFormat format_;
+    CaptureCodec codec_;
+    int level_;
+    std::uint64_t position_ = 0;
+    std::uint64_t samples_ = 0;
+    std::vector<ChunkInfo> index_;
+    std::vector<unsigned char> scratch_;
+};
+
+/// Read-only mapping of a capture file.
+class CaptureReader {
+public:
+    /// Throws std::runtime_error if the file is missing or not a capture.
+    explicit CaptureReader(const std::string& path);
+    /// Reads a capture held in memory (e.g. from capture_window()); image
+    /// must outlive the reader. Throws std::runtime_error if it is not one.
+    explicit CaptureReader(std::span<const unsigned char> image);
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    IqFormat format() const noexcept { return format_; }
+    std::span<const ChunkInfo> chunks() const noexcept { return index_; }
+
+    /// True if the file was closed cleanly and its index is sound (the
+    /// index was read, not rebuilt).
+    bool indexed() const noexcept { return indexed_; }
+
+    /// Index of the first chunk that ends after t (chunks().size() if none).
+    std::size_t find(TimePoint t) const noexcept;
+
+    /// The stored payload of a chunk.
+    std::span<const unsigned char> payload(std::size_t chunk) const noexcept;
+
+    /// The chunk's samples in place, when they are stored as uncompressed
+    /// cf32; empty otherwise.
+    std::span<const Complex> view(std::size_t chunk) const noexcept;
+
+    /// Decodes a chunk into out (at least chunks()[chunk].samples long);
+    /// returns the sample count. Throws std::runtime_error on a corrupt
+    /// payload.
+    std::size_t decode(std::size_t chunk, std::span<Complex> out) const;
+
+    /// Recomputes a chunk's payload checksum.
+    bool verify(std::size_t chunk) const noexcept;
+
+private:
+    bool load();
+    void rebuild_index();
+
+    const unsigned char* base_ = nullptr;
+    std::size_t length_ = 0;
+    bool mapped_ = false;  ///< base_ is our mapping of a file.
+    IqFormat format_ = IqFormat::Cf32;
+    bool indexed_ = false;
+    std::vector<ChunkInfo> index_;
+};
+
+/// A self-contained capture image (header, chunks, index) holding the
+/// samples of reader between from and to, for shipping a window to another
+/// node. Uncompressed chunks are cut to the window; compressed chunks are
+/// copied whole.
+std::vector<unsigned char> capture_window(const CaptureReader& reader, TimePoint from, TimePoint to);
+
+/// Pipeline source over a time range of a capture. Uncompressed cf32
+/// chunks go downstream as read-only views of the mapping (no copy);
+/// other chunks are decoded once into a chunk buffer.
+class CaptureSource final : public Source {
+public:
+    /// [from, to) in capture time; defaults cover the whole file. Throws
+    /// std::invalid_argument if the range is empty or spans chunks of
+    /// different sample rates.
+    CaptureSource(const CaptureReader& reader, TimePoint from = TimePoint::min(),
+                  TimePoint to = TimePoint::max());
+
+    double sample_rate() const noexcept override { return sample_rate_; }
+    std::size_t read(std::span<Complex> out) override;
+    BufferRef next(BufferPool& pool) override;
+    void set_raw(bool raw) noexcept override { raw_ = raw; }
+
+private:
+    bool load_chunk();
+    std::size_t remaining() const noexcept;
+    void advance(std::size_t n) noexcept;
+
+    const CaptureReader& reader_;
+    TimePoint from_;
+    TimePoint to_;
+    double sample_rate_ = 0.0;
+    std::size_t chunk_;                 ///< Next chunk to load.
+    std::span<const Complex> current_;  ///< Unconsumed samples of the loaded chunk.
+    TimePoint current_start_{};         ///< Capture time of current_[0].
+    bool mapped_ = false;               ///< current_ points into the mapping.
+    bool raw_ = false;
+    std::span<const unsigned char> raw_current_;  ///< Raw-mode stand-in for current_.
+    std::vector<Complex> decoded_;
+};
+
+} // namespace mprp
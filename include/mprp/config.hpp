@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mprp {
+
+/// Transmission mode of a beacon entry.
+enum class Mode {
+    Cw,   ///< On/off keyed Morse carrier.
+    Fsk,  ///< Continuous-phase M-ary FSK carrying the message bytes.
+    Wspr, ///< WSPR type 1 report (callsign, grid, power) on 4-FSK.
+};
+
+/// Parses a mode name ("cw", "fsk", "wspr"); throws ConfigError on unknown names.
+Mode parse_mode(std::string_view name);
+
+/// Returns the canonical lower-case name of a mode.
+const char* to_string(Mode mode) noexcept;
+
+/// Thrown for malformed or out-of-range configuration.
+class ConfigError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/// One beacon transmission in the round-robin rotation.
+struct BeaconEntry {
+    std::string name;
+    Mode mode = Mode::Cw;
+    std::string message;            ///< CW / FSK payload text.
+    std::string callsign;           ///< WSPR reporting station.
+    std::string grid;               ///< WSPR four-character locator.
+    int power_dbm = 37;             ///< WSPR reported power.
+    double audio_hz = 1500.0;       ///< Carrier / centre tone in the audio passband.
+    double amplitude = 0.8;         ///< Peak output level, 0..1.
+    double wpm = 20.0;              ///< CW keying speed.
+    double cw_rise_ms = 5.0;        ///< CW raised-cosine edge duration.
+    unsigned tones = 2;             ///< FSK alphabet size (power of two).
+    double tone_spacing_hz = 170.0; ///< FSK tone spacing.
+    double baud = 45.45;            ///< FSK symbol rate.
+    double dial_hz = 0.0;           ///< Rig dial frequency (0 = leave the rig's).
+    unsigned tx_power_w = 0;        ///< Rig output power (0 = leave the rig's).
+
+    bool operator==(const BeaconEntry&) const = default;
+};
+
+/// Everything the engine needs, loaded once at daemon start.
+struct EngineConfig {
+    double sample_rate = 48000.0;
+    double slot_period_s = 120.0;   ///< Length of one transmit slot.
+    double slot_offset_s = 1.0;     ///< Start of transmission within the slot.
+    std::vector<BeaconEntry> beacons;
+
+    /// Throws ConfigError if any field is out of range.
+    void validate() const;
+};
+
+/// Parses the key = value configuration format.
+///
+/// Top-level keys configure the engine; each `[beacon]` header starts a new
+/// BeaconEntry whose keys follow it. `#` starts a comment.
+EngineConfig parse_config(std::string_view text);
+
+/// Sets one key as a configuration file line would: a top-level key if
+/// entry is null, else one of that entry's keys. Throws ConfigError for an
+/// unknown key or malformed value; does not validate().
+void set_config_key(EngineConfig& config, BeaconEntry* entry, std::string_view key, std::string_view value);
+
+/// Reads and parses a configuration file.
+EngineConfig load_config(const std::string& path);
+
+} // namespace mprp
@@ -0,0 +1,66 @@
+#pragma once
+
+// A daemon's control socket: a Unix stream socket taking one command per
+// line and answering each with one reply line from a handler. Served by
+// coroutines on the control-plane event loop (see mprp/event_loop.hpp), so
+// an idle socket costs neither a thread nor a wake-up. The handler runs on
+// the loop thread and should not block on I/O.
+
+#include "mprp/event_loop.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace mprp {
+
+struct ControlServerOptions {
+    std::string path;              ///< Socket path; a stale socket there is replaced.
+    std::size_t max_line = 4096;   ///< A client sending a longer line is dropped.
+    std::chrono::milliseconds timeout{60000};  ///< Idle clients are dropped; also bounds each reply.
+    EventLoop* loop = nullptr;     ///< Where clients are served; default control_loop().
+};
+
+class ControlServer {
+public:
+    /// Maps a command (without its newline) to the reply line; an exception
+    /// becomes the reply "error <what()>".
+    using Handler = std::function<std::string(std::string_view)>;
+
+    /// Throws std::invalid_argument without a path, std::runtime_error if
+    /// the socket cannot be created or another process is serving it.
+    ControlServer(ControlServerOptions options, Handler handler);
+    /// Disconnects clients, stops listening and removes the socket. Not to
+    /// be called on the loop's own thread.
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    std::uint64_t commands() const noexcept { return commands_.load(std::memory_order_relaxed); }
+
+private:
+    Task<void> listen();
+    Task<void> serve(int fd);
+    void finished() noexcept;
+
+    ControlServerOptions options_;
+    Handler handler_;
+    EventLoop& loop_;
+    int listen_fd_ = -1;
+    std::unordered_set<int> clients_;  ///< Loop thread only.
+    std::atomic<bool> stopping_{false};
+    std::mutex mutex_;
+    std::condition_variable idle_;
+    std::size_t running_ = 0;  ///< Coroutines not yet finished.
+    std::atomic<std::uint64_t> commands_{0};
+};
+
+} // namespace mprp
@@ -0,0 +1,123 @@
+#pragma once
+
+// Soft-decision decoders for rate-1/2 convolutional codes.
+//
+// Soft bits are signed bytes: positive means "1", negative "0", the
+// magnitude is the confidence and 0 is an erasure. Codes are tail
+// terminated: the last k - 1 source bits are the zero flush, so both
+// decoders end in state 0.
+
+#include "mprp/cpu.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+namespace mprp {
+
+/// Rate-1/2 feed-forward code: constraint length k (register bits, the
+/// newest in bit 0) and one generator polynomial per output.
+struct ConvCode {
+    unsigned k;
+    std::array<std::uint32_t, 2> polys;
+};
+
+/// The WSPR code (K=32, r=1/2, Layland-Lushbaugh polynomials).
+inline constexpr ConvCode wspr_code{32, {0xF2D05351u, 0xE4613C47u}};
+
+/// The common K=7 r=1/2 code (NASA standard, 171/133 octal).
+inline constexpr ConvCode k7_code{7, {0x4Fu, 0x6Du}};
+
+/// Encodes bits (one per byte) into 2 * bits.size() hard output bits.
+/// Mostly for tests and loopback; the transmit path has its own encoders.
+void conv_encode(const ConvCode& code, std::span<const std::uint8_t> bits, std::span<std::uint8_t> out) noexcept;
+
+enum class DecodeStatus : std::uint8_t {
+    Ok,
+    BudgetExhausted,  ///< Fano gave up after its cycle budget.
+};
+
+struct DecodeResult {
+    DecodeStatus status = DecodeStatus::Ok;
+    std::int64_t metric = 0;    ///< Final path metric (higher is better for Fano, lower for Viterbi).
+    std::uint64_t cycles = 0;   ///< Fano: forward/backward moves; Viterbi: trellis steps.
+};
+
+struct FanoOptions {
+    /// Soft value to log-likelihood ratio (natural log) scale: soft 16
+    /// means LLR 1 by default, suiting symbols normalised to RMS ~50.
+    double llr_per_unit = 1.0 / 16.0;
+
+    /// Subtracted from each bit metric; the code rate is the textbook choice.
+    double bias = 0.5;
+
+    /// Threshold step in metric units (bit metrics are scaled by 16).
+    int delta = 64;
+
+    /// Early exit: give up after this many moves per decoded bit.
+    std::uint32_t cycles_per_bit = 10000;
+};
+
+/// Sequential (Fano) decoder for long-constraint codes such as K=32, where
+/// Viterbi's 2^(k-1) states are out of reach.
+///
+/// Work is near-linear in the bit count on a clean signal and grows sharply
+/// near threshold, so every decode is bounded by a cycle budget: a weak
+/// candidate costs at most cycles_per_bit * bits moves instead of blowing
+/// the slot deadline. Reusable; the node stack is kept between calls and
+/// drawn from resource (e.g. the slot's Arena) when one is given.
+class FanoDecoder {
+public:
+    /// Throws std::invalid_argument if k is outside 2..32.
+    explicit FanoDecoder(const ConvCode& code, FanoOptions options = {},
+                         std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /// Decodes bits.size() source bits (tail included) from
+    /// 2 * bits.size() soft symbols; bits receive 0/1.
+    DecodeResult decode(std::span<const std::int8_t> soft, std::span<std::uint8_t> bits);
+
+private:
+    struct Node {
+        std::uint32_t state;   ///< Source bits before this node, newest in bit 0.
+        std::int32_t gamma;    ///< Path metric up to this node.
+        std::int32_t tm[2];    ///< Branch metrics, best first.
+        std::uint8_t bit[2];   ///< Branch input bits, best first.
+        std::uint8_t tried;    ///< Index of the branch being followed.
+    };
+
+    void branches(Node& node, std::size_t depth, bool tail, std::span<const std::int8_t> soft) const noexcept;
+
+    ConvCode code_;
+    FanoOptions options_;
+    std::array<std::int32_t, 256> metric1_;  ///< Bit metric for "1", by soft + 128.
+    std::pmr::vector<Node> nodes_;
+};
+
+/// Maximum-likelihood decoder for short-constraint codes (k <= 9), with
+/// vectorised add-compare-select across the states.
+class ViterbiDecoder {
+public:
+    /// Throws std::invalid_argument if k is outside 3..9.
+    explicit ViterbiDecoder(const ConvCode& code, Isa isa = best_isa(),
+                            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /// Decodes bits.size() source bits (tail included) from
+    /// 2 * bits.size() soft symbols; bits receive 0/1. Path metrics are
+    /// 32-bit, good for millions of bits per frame.
+    DecodeResult decode(std::span<const std::int8_t> soft, std::span<std::uint8_t> bits);
+
+    Isa isa() const noexcept { return isa_; }
+
+private:
+    ConvCode code_;
+    Isa isa_;
+    std::size_t states_;
+    std::pmr::vector<std::int32_t> signs_;   ///< Expected-output signs, kernel layout.
+    std::pmr::vector<std::int32_t> metrics_; ///< Two rows of path metrics.
+    std::pmr::vector<std::uint8_t> decisions_;
+};
+
+} // namespace mprp
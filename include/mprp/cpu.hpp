@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+namespace mprp {
+
+/// Instruction-set level a kernel was built for.
+enum class Isa {
+    Scalar,
+    Avx2,  ///< x86-64 AVX2 + FMA.
+    Neon,  ///< ARM Advanced SIMD.
+};
+
+const char* to_string(Isa isa) noexcept;
+
+/// True if this build contains kernels for isa and the running CPU executes them.
+bool isa_supported(Isa isa) noexcept;
+
+/// The fastest supported ISA, detected once. Setting MPRP_FORCE_SCALAR in
+/// the environment pins it to Isa::Scalar for A/B comparisons.
+Isa best_isa() noexcept;
+
+/// Per-core L1 data cache size in bytes, detected once; 32 KiB where the
+/// system does not report it. Blocked kernels size their tiles from it.
+std::size_t l1_data_cache_bytes() noexcept;
+
+} // namespace mprp
@@ -0,0 +1,157 @@
+#pragma once
+
+// Distributed WSPR decode: a coordinator splits captures into jobs (one
+// two-minute slot of one sub-band each) and serves them to any number of
+// workers over TCP; workers decode and send their spots back, and the
+// coordinator merges and deduplicates them. Adding a box adds capacity:
+// a worker only needs the coordinator's address.
+//
+// Protocol: length-prefixed frames, each a 16-byte header (magic, type,
+// version, payload size, payload checksum) and a payload.
+//
+//   Challenge coord -> worker nonce
+//   Hello   worker -> coord   capacity, node name, nonce, HMAC-SHA-256 of
+//                             the challenge and the Hello under the secret
+//   Welcome coord -> worker   HMAC-SHA-256 of both nonces under the secret
+//   Job     coord -> worker   id, band, window, then the window's samples
+//                             as a capture image (see capture_window())
+//   Result  worker -> coord   id, status, then LogRecords
+//   Bye     coord -> worker   no more jobs
+//
+// A peer that fails the handshake is disconnected before any job moves.
+// The handshake authenticates both ends but later frames are neither
+// signed nor encrypted, so keep the link on a trusted network. A worker
+// keeps up to its capacity of jobs in flight. Jobs a worker drops
+// (disconnect, timeout) go back in the queue.
+
+#include "mprp/spot_log.hpp"
+#include "mprp/timing.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mprp {
+
+class CaptureReader;
+
+/// One unit of decode work: a window of a capture and the sub-band of it
+/// to search.
+struct DecodeJob {
+    std::uint64_t id = 0;
+    double shift_hz = 0.0;     ///< Sub-band centre, relative to the capture centre.
+    double out_rate = 375.0;   ///< Baseband rate for WsprSearchConfig::sample_rate.
+    double min_hz = -150.0;    ///< Search band around the sub-band centre.
+    double max_hz = 150.0;
+    double dial_hz = 0.0;      ///< Added to the spots' stream-relative frequencies.
+    TimePoint from{};          ///< Window; compressed chunks may reach past it.
+    TimePoint to{};
+    std::vector<unsigned char> capture;  ///< capture_window() image.
+};
+
+/// Decodes a job in this process (what a worker runs for each job).
+/// Throws std::runtime_error on a corrupt capture image.
+std::vector<LogRecord> decode_job(const DecodeJob& job);
+
+/// Keeps one record per transmission heard more than once (overlapping
+/// sub-bands, several receivers): spots in the same slot with the same
+/// callsign within tolerance_hz are merged into the strongest. Returns
+/// the survivors ordered by time, then frequency.
+std::vector<LogRecord> merge_spots(std::vector<LogRecord> spots, double tolerance_hz = 5.0);
+
+struct CoordinatorOptions {
+    std::string bind_address = "127.0.0.1";  ///< "::" listens on every interface.
+    std::uint16_t port = 7373;       ///< 0 picks a free port (see Coordinator::port()).
+    std::string secret;              ///< Shared with the workers; required unless bound to loopback.
+    double shift_hz = 0.0;           ///< Centre of the searched span, relative to the capture centre.
+    double span_hz = 200.0;          ///< Searched width, split into `bands` sub-bands.
+    std::size_t bands = 1;
+    double guard_hz = 5.0;           ///< Overlap searched on each side of a sub-band.
+    double out_rate = 375.0;
+    std::optional<double> dial_hz;   ///< Default: the capture's centre frequency.
+    unsigned max_attempts = 3;       ///< Per job, across workers.
+    std::chrono::seconds job_timeout{600};
+};
+
+/// Splits captures into jobs and serves them to workers.
+class Coordinator {
+public:
+    /// Binds and listens; throws std::runtime_error if the port is taken
+    /// and std::invalid_argument on unusable options (including a
+    /// non-loopback bind_address without a secret).
+    explicit Coordinator(CoordinatorOptions options);
+    ~Coordinator();
+
+    Coordinator(const Coordinator&) = delete;
+    Coordinator& operator=(const Coordinator&) = delete;
+
+    /// Adds a job for every slot and sub-band of reader, which must outlive
+    /// run(). May be called for several captures (e.g. one per antenna).
+    void add_capture(const CaptureReader& reader);
+
+    /// Serves jobs until every one has a result or ran out of attempts;
+    /// returns the merged spots.
+    std::vector<LogRecord> run();
+
+    std::uint16_t port() const noexcept { return port_; }
+    std::size_t jobs() const noexcept { return plan_.size(); }
+    std::size_t failed() const noexcept { return failed_; }    ///< Jobs given up on.
+    std::size_t workers() const noexcept { return workers_; }  ///< Connections served.
+
+private:
+    struct Planned {
+        const CaptureReader* reader;
+        TimePoint slot;
+        std::size_t band;
+        double dial_hz;  ///< RF frequency of the capture centre.
+    };
+
+    struct Hello {
+        std::uint32_t capacity;
+    };
+
+    /// Runs the handshake; nullopt if the peer does not hold the secret.
+    std::optional<Hello> authenticate(int fd);
+    void serve(int fd);
+    DecodeJob make_job(std::size_t index);
+    /// Puts a dropped or failed job back in the queue, or gives up on it.
+    void retry(std::size_t index);
+
+    CoordinatorOptions options_;
+    int listen_fd_ = -1;
+    std::uint16_t port_ = 0;
+    std::vector<Planned> plan_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<std::size_t> pending_;  ///< Indices into plan_.
+    std::vector<unsigned> attempts_;
+    std::size_t finished_ = 0;         ///< Jobs with a result or given up on.
+    std::size_t failed_ = 0;
+    std::size_t workers_ = 0;
+    std::vector<LogRecord> spots_;
+    std::vector<std::thread> threads_;
+};
+
+struct WorkerOptions {
+    std::string host = "localhost";
+    std::uint16_t port = 7373;
+    unsigned threads = 1;         ///< Jobs decoded at once (and the in-flight limit).
+    std::string name;             ///< Default: the host name.
+    std::string secret;           ///< The coordinator's CoordinatorOptions::secret.
+};
+
+/// Connects to a coordinator and decodes jobs until it says Bye or the
+/// connection drops; returns the number of jobs completed. Throws
+/// std::runtime_error if the coordinator cannot be reached or the
+/// handshake fails.
+std::size_t run_worker(const WorkerOptions& options);
+
+} // namespace mprp
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace mprp {
+
+/// One keyed element of a Morse transmission, measured in dot units.
+struct KeyElement {
+    bool on;
+    std::uint16_t units;
+};
+
+/// Encodes text as Morse key-down / key-up runs.
+///
+/// Letters are case-insensitive; characters without a Morse code are
+/// skipped. Adjacent gaps are merged, so the result alternates on/off.
+std::vector<KeyElement> encode_morse(std::string_view text);
+
+/// Encodes text for M-ary FSK: each byte MSB-first, log2(tones) bits per
+/// symbol, zero-padded on the final symbol.
+std::vector<std::uint8_t> encode_fsk(std::string_view text, unsigned tones);
+
+} // namespace mprp
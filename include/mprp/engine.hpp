@@ -0,0 +1,74 @@
+#pragma once
+
+#include "mprp/config.hpp"
+#include "mprp/encoder.hpp"
+#include "mprp/modulator.hpp"
+#include "mprp/scheduler.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace mprp {
+
+/// In-process beacon pipeline: message encoding, modulation and slot
+/// scheduling behind one object.
+///
+/// All per-entry work that does not depend on the slot (parsing, symbol
+/// encoding, modulator setup) happens once in the constructor, so a
+/// long-running daemon only pays for the render on each cycle.
+class Engine {
+public:
+    explicit Engine(EngineConfig config);
+
+    /// A new version of previous: entries whose render_key() is unchanged
+    /// take over its prepared symbols and modulator instead of setting them
+    /// up again (see LiveEngine).
+    Engine(EngineConfig config, const Engine& previous);
+
+    /// Loads and validates a configuration file.
+    static Engine from_file(const std::string& path);
+
+    const EngineConfig& config() const noexcept { return config_; }
+    std::size_t entries() const noexcept { return entries_.size(); }
+
+    /// The next transmit slot at or after now.
+    SlotPlan next_slot(TimePoint now) const noexcept { return clock_.next(now); }
+    const SlotClock& clock() const noexcept { return clock_; }
+
+    /// Samples in the full transmission of an entry.
+    std::size_t transmission_samples(std::size_t entry) const;
+
+    /// Renders an entry's transmission into out; returns samples written.
+    /// Throws std::out_of_range for an unknown entry.
+    std::size_t render(std::size_t entry, std::span<float> out) const;
+
+    /// Content key of an entry's rendered samples: a hash of the sample
+    /// rate and every field that shapes the waveform (not the entry name).
+    /// Equal keys render identical samples; see RenderCache.
+    std::uint64_t render_key(std::size_t entry) const;
+
+private:
+    struct CwPlan {
+        CwModulator modulator;
+        KeyingPlan keying;
+    };
+    struct FskPlan {
+        FskModulator modulator;
+        std::vector<std::uint8_t> symbols;
+    };
+    using Plan = std::variant<CwPlan, FskPlan>;
+
+    static Plan prepare(const EngineConfig& config, const BeaconEntry& entry);
+    const Plan& plan(std::size_t entry) const;
+
+    EngineConfig config_;
+    SlotClock clock_;
+    std::vector<Plan> entries_;
+    std::vector<std::uint64_t> keys_;
+};
+
+} // namespace mprp
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace mprp {
+
+/// Rising raised-cosine edge of the given length, values in (0, 1).
+///
+/// Tables are built on first use and cached process-wide, so every keyer
+/// with the same rise time shares one copy. The falling edge is the same
+/// table read backwards.
+std::shared_ptr<const std::vector<float>> raised_cosine_edge(std::size_t samples);
+
+} // namespace mprp
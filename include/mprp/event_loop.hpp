@@ -0,0 +1,332 @@
+#pragma once
+
+// Control-plane I/O on one thread: an epoll event loop that resumes C++20
+// coroutines when their file descriptor is ready or their timer expires.
+//
+// Spot uploads, rig control and the daemon's control socket spend nearly
+// all their time waiting. Instead of a blocking thread each (a stack and a
+// context switch per wake-up on a four-core board), each is a Task that
+// co_awaits readiness of a non-blocking descriptor, and all of them share
+// one loop thread: control_loop() unless the caller brings its own. DSP
+// stages keep their dedicated threads.
+//
+// A loop's descriptors and timers are only touched from its own thread.
+// spawn() and post() are the way in from other threads, and a coroutine
+// that must continue on the loop co_awaits schedule(). Readiness is
+// level-triggered and may be spurious (a descriptor number reused between
+// events), so I/O after a wait must still expect EAGAIN; the helpers at the
+// bottom do.
+//
+// Bind a co_await's result to a local before testing it: GCC 12 has been
+// seen to miscompile `if (!co_await f())` inside a loop.
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mprp {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept
+        {
+            const std::coroutine_handle<> next = h.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+};
+
+template <typename T>
+struct TaskPromise final : TaskPromiseBase {
+    Task<T> get_return_object() noexcept;
+    template <typename U>
+    void return_value(U&& value)
+    {
+        result.emplace(std::forward<U>(value));
+    }
+    std::optional<T> result;
+};
+
+template <>
+struct TaskPromise<void> final : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+};
+
+using SteadyTime = std::chrono::steady_clock::time_point;
+
+/// One suspended wait: for a descriptor (fd >= 0), a deadline, or both.
+struct LoopWait {
+    std::coroutine_handle<> handle;
+    int fd = -1;
+    bool write = false;
+    bool ready = false;  ///< The descriptor became ready (else the deadline passed).
+    bool timed = false;
+    std::multimap<SteadyTime, LoopWait*>::iterator timer;
+};
+
+} // namespace detail
+
+/// A lazily started coroutine producing T. It runs when co_awaited (on the
+/// awaiting thread) and resumes the awaiter when it finishes; exceptions
+/// propagate to the awaiter. spawn() runs a Task<void> detached on a loop.
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            if (handle_)
+                handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~Task()
+    {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+    {
+        handle_.promise().continuation = awaiter;
+        return handle_;
+    }
+    T await_resume()
+    {
+        if (handle_.promise().error)
+            std::rethrow_exception(handle_.promise().error);
+        if constexpr (!std::is_void_v<T>)
+            return std::move(*handle_.promise().result);
+    }
+
+private:
+    friend promise_type;
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+class EventLoop {
+public:
+    /// Throws std::system_error if epoll or the wake-up eventfd cannot be
+    /// created.
+    EventLoop();
+    /// Stops and joins the loop's thread if start() made one. Coroutines
+    /// still suspended on the loop are not resumed or destroyed: their
+    /// owners must have finished them first.
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /// Runs the loop on the calling thread until stop().
+    void run();
+    /// Runs the loop on a thread of its own.
+    void start();
+    /// Makes run() return after the current round; thread-safe.
+    void stop() noexcept;
+
+    /// Queues fn to run on the loop thread; thread-safe.
+    void post(std::function<void()> fn);
+
+    bool in_loop_thread() const noexcept
+    {
+        return thread_id_.load(std::memory_order_relaxed) == std::this_thread::get_id();
+    }
+
+    class ScheduleAwaiter {
+    public:
+        explicit ScheduleAwaiter(EventLoop& loop) noexcept : loop_(loop) {}
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { loop_.post([h] { h.resume(); }); }
+        void await_resume() const noexcept {}
+
+    private:
+        EventLoop& loop_;
+    };
+
+    class WaitAwaiter {
+    public:
+        WaitAwaiter(EventLoop& loop, int fd, bool write, std::optional<detail::SteadyTime> deadline) noexcept
+            : loop_(loop), deadline_(deadline)
+        {
+            wait_.fd = fd;
+            wait_.write = write;
+        }
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            wait_.handle = h;
+            return loop_.arm(wait_, deadline_);
+        }
+        /// True if the descriptor is ready, false if the deadline passed.
+        bool await_resume() const noexcept { return wait_.ready; }
+
+    private:
+        EventLoop& loop_;
+        std::optional<detail::SteadyTime> deadline_;
+        detail::LoopWait wait_;
+    };
+
+    /// Resumes the awaiting coroutine on the loop thread.
+    ScheduleAwaiter schedule() noexcept { return ScheduleAwaiter(*this); }
+
+    /// Waits (on the loop thread) for fd to become readable or writable,
+    /// optionally until a deadline; co_await yields false on timeout.
+    /// Descriptors epoll cannot watch (regular files) count as ready.
+    WaitAwaiter readable(int fd) noexcept { return {*this, fd, false, std::nullopt}; }
+    WaitAwaiter readable(int fd, detail::SteadyTime deadline) noexcept { return {*this, fd, false, deadline}; }
+    WaitAwaiter readable(int fd, std::chrono::milliseconds timeout) noexcept
+    {
+        return {*this, fd, false, std::chrono::steady_clock::now() + timeout};
+    }
+    WaitAwaiter writable(int fd) noexcept { return {*this, fd, true, std::nullopt}; }
+    WaitAwaiter writable(int fd, detail::SteadyTime deadline) noexcept { return {*this, fd, true, deadline}; }
+    WaitAwaiter writable(int fd, std::chrono::milliseconds timeout) noexcept
+    {
+        return {*this, fd, true, std::chrono::steady_clock::now() + timeout};
+    }
+
+    /// Suspends the awaiting coroutine (on the loop thread) until deadline.
+    WaitAwaiter sleep_until(detail::SteadyTime deadline) noexcept { return {*this, -1, false, deadline}; }
+    WaitAwaiter sleep_for(std::chrono::steady_clock::duration d) noexcept
+    {
+        return sleep_until(std::chrono::steady_clock::now() + d);
+    }
+
+    /// Coroutines resumed so far, across all wake-up kinds.
+    std::uint64_t resumes() const noexcept { return resumes_.load(std::memory_order_relaxed); }
+
+private:
+    struct FdWaiters {
+        detail::LoopWait* reader = nullptr;
+        detail::LoopWait* writer = nullptr;
+        std::uint32_t armed = 0;  ///< Events registered with epoll; 0 = not added.
+    };
+
+    /// Registers a wait; false if it completed at once (resume without
+    /// suspending).
+    bool arm(detail::LoopWait& wait, std::optional<detail::SteadyTime> deadline);
+    /// Syncs fd's epoll registration with its waiters; false if epoll
+    /// refuses the descriptor.
+    bool update(int fd, FdWaiters& waiters);
+    void fire_fd(int fd, std::uint32_t events);
+    void fire_timers();
+    void run_posted();
+    void resume(detail::LoopWait& wait, bool ready);
+
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::atomic<std::thread::id> thread_id_{};
+    std::thread thread_;
+    std::unordered_map<int, FdWaiters> fds_;
+    std::multimap<detail::SteadyTime, detail::LoopWait*> timers_;
+    std::mutex posted_mutex_;
+    std::vector<std::function<void()>> posted_;
+    std::vector<std::function<void()>> running_;
+    std::atomic<std::uint64_t> resumes_{0};
+};
+
+/// The process's shared control-plane loop, running on its own thread from
+/// first use until exit.
+EventLoop& control_loop();
+
+/// Runs task detached on loop, starting on the loop thread. An exception
+/// escaping it is counted (metric "loop.task_errors") and dropped.
+void spawn(EventLoop& loop, Task<void> task);
+
+/// A wake-up signal another thread can raise for a coroutine on a loop
+/// (backed by an eventfd). Signals do not queue: several set() calls before
+/// a wait satisfy that one wait. At most one coroutine waits at a time.
+class AsyncEvent {
+public:
+    /// Throws std::system_error if the eventfd cannot be created.
+    explicit AsyncEvent(EventLoop& loop);
+    ~AsyncEvent();
+
+    AsyncEvent(const AsyncEvent&) = delete;
+    AsyncEvent& operator=(const AsyncEvent&) = delete;
+
+    /// Thread-safe and async-signal-safe.
+    void set() noexcept;
+
+    /// Waits for and consumes a signal; false if deadline passed first.
+    Task<bool> wait_until(detail::SteadyTime deadline);
+    Task<void> wait();
+
+private:
+    bool consume() noexcept;
+
+    EventLoop& loop_;
+    int fd_ = -1;
+};
+
+/// Connects a non-blocking TCP socket (TCP_NODELAY, close-on-exec) to
+/// host:port within timeout; -1 on failure. Names that are not numeric
+/// addresses are resolved on a short-lived helper thread, so DNS never
+/// stalls the loop.
+Task<int> tcp_connect(EventLoop& loop, std::string host, std::uint16_t port, std::chrono::milliseconds timeout);
+
+/// Reads what is available from a non-blocking fd into buffer, waiting up
+/// to timeout for the first byte; returns the byte count, 0 at end of
+/// file, or -1 on error or timeout. buffer must outlive the await.
+Task<std::ptrdiff_t> read_some(EventLoop& loop, int fd, std::span<char> buffer, std::chrono::milliseconds timeout);
+
+/// Writes all of data to a non-blocking socket, pipe or tty, each wait for
+/// room bounded by timeout; false on error or timeout. data must outlive
+/// the await.
+Task<bool> write_all(EventLoop& loop, int fd, std::string_view data, std::chrono::milliseconds timeout);
+
+} // namespace mprp
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "mprp/buffer_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace mprp {
+
+class TaskPool;
+
+/// Precomputed in-place radix-2 FFT of one power-of-two size.
+///
+/// Twiddles are stored stage by stage so every butterfly pass reads them
+/// sequentially; the bit-reversal permutation is a lookup table. Plans are
+/// immutable and shared, so one plan serves every thread.
+class FftPlan {
+public:
+    /// Throws std::invalid_argument unless n is a power of two >= 2.
+    explicit FftPlan(std::size_t n);
+
+    std::size_t size() const noexcept { return n_; }
+
+    /// Forward transform (e^{-j...}), unnormalised.
+    void forward(std::span<Complex> data) const noexcept;
+
+    /// Inverse transform, unnormalised (scale by 1/n for a round trip).
+    void inverse(std::span<Complex> data) const noexcept;
+
+    /// Forward-transforms frames.size() / size() consecutive frames (e.g.
+    /// every row of a decode window's spectrogram), split across pool when
+    /// given. A trailing partial frame is left untouched.
+    void forward_batch(std::span<Complex> frames, TaskPool* pool = nullptr) const;
+
+private:
+    template <bool Inverse>
+    void transform(Complex* data) const noexcept;
+
+    std::size_t n_;
+    std::vector<std::uint32_t> bitrev_;
+    std::vector<Complex> twiddles_;  ///< Stage m/2 = 1, 2, 4, ... concatenated.
+};
+
+/// Plan for size n from the process-wide cache, built on first use.
+std::shared_ptr<const FftPlan> fft_plan(std::size_t n);
+
+/// Analysis windows for spectral estimation.
+enum class Window {
+    Rectangular,
+    Hann,
+    BlackmanHarris,  ///< 4-term, ~92 dB sidelobes.
+};
+
+/// A window table with the gains needed to calibrate power readings.
+struct WindowTable {
+    std::vector<float> values;
+    double coherent_gain;  ///< mean(w): amplitude scale of a bin-centred tone.
+    double enbw_bins;      ///< Equivalent noise bandwidth in bins.
+};
+
+/// Window of length n from the process-wide cache, built on first use.
+std::shared_ptr<const WindowTable> window_table(Window window, std::size_t n);
+
+} // namespace mprp
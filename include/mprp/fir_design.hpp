@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace mprp {
+
+/// Kaiser window beta for a stopband attenuation in dB.
+double kaiser_beta(double atten_db) noexcept;
+
+/// Taps needed for a Kaiser design with the given transition width
+/// (fraction of the sample rate) and attenuation.
+std::size_t kaiser_length(double transition, double atten_db) noexcept;
+
+/// Kaiser-windowed sinc low-pass with unit DC gain. cutoff and transition
+/// are fractions of the sample rate. The length is rounded up to a
+/// multiple of `multiple` (e.g. the polyphase interpolation factor).
+/// Throws std::invalid_argument for an unrealisable specification.
+std::vector<float> design_lowpass(double cutoff, double transition, double atten_db = 80.0,
+                                  std::size_t multiple = 1);
+
+} // namespace mprp
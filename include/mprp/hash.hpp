@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+namespace mprp {
+
+/// 64-bit FNV-1a over a sequence of fields. Used for content keys and file
+/// checksums, not as a cryptographic hash.
+class Fnv1a {
+public:
+    Fnv1a& bytes(const void* data, std::size_t n) noexcept
+    {
+        const auto* p = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < n; ++i) {
+            h_ ^= p[i];
+            h_ *= prime;
+        }
+        return *this;
+    }
+
+    /// Strings are length-prefixed so adjacent fields cannot alias.
+    Fnv1a& add(std::string_view s) noexcept
+    {
+        add(static_cast<std::uint64_t>(s.size()));
+        return bytes(s.data(), s.size());
+    }
+
+    template <class T>
+        requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+    Fnv1a& add(T v) noexcept
+    {
+        return bytes(&v, sizeof v);
+    }
+
+    template <class T>
+    Fnv1a& add(std::span<const T> v) noexcept
+    {
+        add(static_cast<std::uint64_t>(v.size()));
+        return bytes(v.data(), v.size_bytes());
+    }
+
+    std::uint64_t value() const noexcept { return h_; }
+
+private:
+    static constexpr std::uint64_t prime = 0x100000001b3ull;
+    std::uint64_t h_ = 0xcbf29ce484222325ull;
+};
+
+using Digest256 = std::array<unsigned char, 32>;
+
+/// HMAC-SHA-256 (RFC 2104) of message under key, for authenticating peers
+/// that share a secret.
+Digest256 hmac_sha256(std::span<const unsigned char> key, std::span<const unsigned char> message);
+
+/// Compares in time independent of where a and b differ.
+bool digest_equal(const Digest256& a, const Digest256& b) noexcept;
+
+} // namespace mprp
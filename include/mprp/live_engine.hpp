@@ -0,0 +1,70 @@
+#pragma once
+
+// A beacon schedule that can be changed while it runs.
+//
+// Each configuration is an immutable Engine tagged with a version number.
+// publish() builds the next one off to the side (reusing the prepared
+// modulators of every entry whose render_key() is unchanged) and swaps it in
+// with one atomic pointer store, RCU-style: readers never wait for a writer,
+// they keep using the version they loaded for as long as they hold it, and a
+// retired version is freed when its last reader lets go. Only version() is
+// lock-free; current() loads a std::atomic<std::shared_ptr>, which libstdc++
+// implements with a short internal lock. A TxScheduler checks version() once
+// per slot, a single atomic load, and only calls current() when the number
+// has moved, so a change takes effect from the next slot it has not yet
+// committed to.
+
+#include "mprp/config.hpp"
+#include "mprp/engine.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace mprp {
+
+/// One published configuration.
+struct EngineVersion {
+    std::uint64_t version;
+    Engine engine;
+};
+
+class LiveEngine {
+public:
+    /// Version 1. Throws ConfigError as publish() does.
+    explicit LiveEngine(EngineConfig config);
+
+    LiveEngine(const LiveEngine&) = delete;
+    LiveEngine& operator=(const LiveEngine&) = delete;
+
+    /// The newest version number; lock-free.
+    std::uint64_t version() const noexcept { return version_.load(std::memory_order_acquire); }
+
+    /// The newest version and its engine, kept alive for as long as the
+    /// pointer is held. Not lock-free (see the header comment), so read
+    /// version() first on hot paths.
+    std::shared_ptr<const EngineVersion> current() const noexcept
+    {
+        return current_.load(std::memory_order_acquire);
+    }
+
+    /// Replaces the configuration and returns the new version number.
+    /// Throws ConfigError (leaving the current version in place) if config
+    /// is invalid or has no entries. Writers are serialised; thread-safe.
+    std::uint64_t publish(EngineConfig config);
+
+    /// Applies edit to a copy of the current configuration and publishes
+    /// the result; edit may throw to abandon the change.
+    std::uint64_t update(const std::function<void(EngineConfig&)>& edit);
+
+private:
+    std::uint64_t publish_locked(EngineConfig config);
+
+    std::mutex writer_;
+    std::atomic<std::shared_ptr<const EngineVersion>> current_;
+    std::atomic<std::uint64_t> version_{0};
+};
+
+} // namespace mprp
@@ -0,0 +1,221 @@
+#pragma once
+
+// Hot-path instrumentation: per-stage latency histograms and named
+// counters kept in one shared-memory page, so `mprp-stat` can read a
+// running daemon without talking to it.
+//
+// Recording is lock-free: each thread writes to its own shard (one of
+// metrics::shards) with relaxed atomics, and readers sum the shards. Until
+// metrics::open() is called every record is a single relaxed load and a
+// not-taken branch; building with MPRP_METRICS=0 removes even that.
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#ifndef MPRP_METRICS
+#define MPRP_METRICS 1
+#endif
+
+namespace mprp::metrics {
+
+inline constexpr std::size_t max_stages = 32;
+inline constexpr std::size_t max_counters = 64;
+inline constexpr std::size_t shards = 8;
+inline constexpr std::size_t name_length = 48;
+
+/// Log-linear (HDR-style) buckets: 8 sub-buckets per power of two, exact
+/// below 8 ns, ~6% relative precision above, up to 2^40 ns.
+inline constexpr unsigned sub_bucket_bits = 3;
+inline constexpr std::size_t histogram_buckets = (40 - sub_bucket_bits + 1) << sub_bucket_bits;
+
+constexpr std::size_t bucket_index(std::uint64_t ns) noexcept
+{
+    constexpr std::uint64_t sub = std::uint64_t{1} << sub_bucket_bits;
+    if (ns < sub)
+        return static_cast<std::size_t>(ns);
+    const unsigned e = static_cast<unsigned>(std::bit_width(ns)) - 1;
+    const std::size_t i = (static_cast<std::size_t>(e - sub_bucket_bits + 1) << sub_bucket_bits)
+                          + static_cast<std::size_t>((ns >> (e - sub_bucket_bits)) & (sub - 1));
+    return i < histogram_buckets ? i : histogram_buckets - 1;
+}
+
+/// Smallest value that lands in bucket i.
+constexpr std::uint64_t bucket_floor(std::size_t i) noexcept
+{
+    constexpr std::size_t sub = std::size_t{1} << sub_bucket_bits;
+    if (i < sub)
+        return i;
+    const unsigned e = static_cast<unsigned>(i >> sub_bucket_bits) + sub_bucket_bits - 1;
+    return static_cast<std::uint64_t>(sub + (i & (sub - 1))) << (e - sub_bucket_bits);
+}
+
+static_assert(bucket_index(bucket_floor(100)) == 100);
+static_assert(bucket_index(1000) == bucket_index(bucket_floor(bucket_index(1000))));
+
+// ---- shared page layout (versioned; readers check magic and version) ----
+
+struct alignas(64) HistogramShard {
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> sum_ns;
+    std::atomic<std::uint64_t> max_ns;
+    std::atomic<std::uint64_t> buckets[histogram_buckets];
+};
+
+struct StageSlot {
+    char name[name_length];
+    HistogramShard shard[shards];
+};
+
+struct alignas(64) CounterShard {
+    std::atomic<std::uint64_t> value;
+};
+
+struct CounterSlot {
+    char name[name_length];
+    CounterShard shard[shards];
+};
+
+inline constexpr std::uint64_t page_magic = 0x5350524d5054454dull;  // "METPMRPS"
+inline constexpr std::uint32_t page_version = 1;
+
+struct Page {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t pid;
+    std::int64_t start_unix_ns;
+    std::atomic<std::uint32_t> stages;
+    std::atomic<std::uint32_t> counters;
+    StageSlot stage[max_stages];
+    CounterSlot counter[max_counters];
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "shared-memory metrics need address-free 64-bit atomics");
+
+// ---- writer side -------------------------------------------------------
+
+using StageId = std::uint32_t;
+using CounterId = std::uint32_t;
+
+/// Creates (or replaces) the page /dev/shm/mprp-<name> and starts
+/// recording. An empty name keeps the page private to the process.
+/// Returns false if the page could not be created.
+bool open(const std::string& name);
+
+/// Stops recording and unlinks the page. The mapping itself is kept until
+/// exit, so threads still recording into it never fault.
+void close() noexcept;
+
+/// Registers a stage or counter by name (idempotent; setup-time only).
+/// Ids are stable for the life of the process, whether or not recording
+/// is enabled; names beyond the capacity share the last slot.
+StageId stage(const std::string& name);
+CounterId counter(const std::string& name);
+
+namespace detail {
+
+extern std::atomic<Page*> page;
+std::size_t thread_shard() noexcept;
+void record_slow(Page* p, StageId id, std::uint64_t ns) noexcept;
+
+} // namespace detail
+
+/// True once open() succeeded.
+inline bool enabled() noexcept
+{
+#if MPRP_METRICS
+    return detail::page.load(std::memory_order_relaxed) != nullptr;
+#else
+    return false;
+#endif
+}
+
+/// Adds one latency sample for a stage.
+inline void record(StageId id, std::uint64_t ns) noexcept
+{
+#if MPRP_METRICS
+    if (Page* p = detail::page.load(std::memory_order_relaxed))
+        detail::record_slow(p, id, ns);
+#else
+    (void)id;
+    (void)ns;
+#endif
+}
+
+/// Adds n to a counter.
+inline void add(CounterId id, std::uint64_t n = 1) noexcept
+{
+#if MPRP_METRICS
+    if (Page* p = detail::page.load(std::memory_order_relaxed))
+        p->counter[id].shard[detail::thread_shard()].value.fetch_add(n, std::memory_order_relaxed);
+#else
+    (void)id;
+    (void)n;
+#endif
+}
+
+/// Times its own scope into a stage histogram; reads the clock only when
+/// recording is enabled.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(StageId id) noexcept : id_(id)
+    {
+        if (enabled())
+            start_ = std::chrono::steady_clock::now();
+    }
+    ~ScopedTimer()
+    {
+        if (start_)
+            record(id_, static_cast<std::uint64_t>(
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now() - *start_)
+                                 .count()));
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    StageId id_;
+    std::optional<std::chrono::steady_clock::time_point> start_;
+};
+
+// ---- reader side -------------------------------------------------------
+
+struct StageSummary {
+    std::string name;
+    std::uint64_t count = 0;
+    double mean_ns = 0.0;
+    std::uint64_t max_ns = 0;
+    std::uint64_t p50_ns = 0;
+    std::uint64_t p90_ns = 0;
+    std::uint64_t p99_ns = 0;
+    std::uint64_t p999_ns = 0;
+};
+
+struct CounterSummary {
+    std::string name;
+    std::uint64_t value = 0;
+};
+
+struct Snapshot {
+    std::uint32_t pid = 0;
+    std::int64_t start_unix_ns = 0;
+    std::vector<StageSummary> stages;
+    std::vector<CounterSummary> counters;
+};
+
+/// Summarises a page (shards summed, percentiles from the buckets).
+Snapshot summarize(const Page& page);
+
+/// Maps /dev/shm/mprp-<name> read-only and summarises it; empty name reads
+/// this process's page. Returns nothing if the page is absent or from an
+/// incompatible version.
+std::optional<Snapshot> read(const std::string& name);
+
+} // namespace mprp::metrics
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "mprp/encoder.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace mprp {
+
+/// Key-down interval of a rendered Morse message, in samples.
+struct KeyRun {
+    std::size_t start;
+    std::size_t length;
+};
+
+/// A whole message reduced to sample-exact key-down runs. Built once per
+/// message and speed; rendering then never touches the element list.
+struct KeyingPlan {
+    std::vector<KeyRun> runs;
+    std::size_t total = 0;  ///< Samples including the key-up gaps.
+};
+
+/// Keys a sine carrier from a KeyingPlan, with raised-cosine rise and fall
+/// edges taken from the shared envelope cache.
+class CwModulator {
+public:
+    CwModulator(double sample_rate, double tone_hz, double wpm, double amplitude,
+                double rise_s = 0.005);
+
+    /// Samples per dot unit at the configured speed (not rounded, so the
+    /// timing stays exact at any WPM).
+    double unit_samples() const noexcept { return unit_; }
+
+    /// Edge length in samples.
+    std::size_t edge_samples() const noexcept { return edge_->size(); }
+
+    /// Converts elements to sample-exact key-down runs.
+    KeyingPlan plan(std::span<const KeyElement> elements) const;
+
+    /// Renders a plan into out; returns the number of samples written,
+    /// which is min(plan.total, out.size()).
+    std::size_t render(const KeyingPlan& plan, std::span<float> out) const noexcept;
+
+private:
+    double sample_rate_;
+    double tone_hz_;
+    double amplitude_;
+    double unit_;
+    std::shared_ptr<const std::vector<float>> edge_;
+};
+
+/// Continuous-phase M-ary FSK centred on a carrier frequency.
+class FskModulator {
+public:
+    FskModulator(double sample_rate, double centre_hz, double spacing_hz, double baud,
+                 unsigned tones, double amplitude);
+
+    /// Total samples needed for a symbol sequence of the given length.
+    std::size_t length(std::size_t symbols) const noexcept;
+
+    /// Renders symbols into out; returns the number of samples written.
+    std::size_t render(std::span<const std::uint8_t> symbols, std::span<float> out) const noexcept;
+
+    /// Frequency of tone k.
+    double tone_hz(unsigned k) const noexcept;
+
+private:
+    double sample_rate_;
+    double centre_hz_;
+    double spacing_hz_;
+    double baud_;
+    unsigned tones_;
+    double amplitude_;
+};
+
+} // namespace mprp
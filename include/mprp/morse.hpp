@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace mprp {
+
+/// Morse code of one character: `length` elements, read MSB-first from the
+/// low `length` bits of `pattern` (1 = dah, 0 = dit). length 0 means the
+/// character has no code.
+struct MorseSymbol {
+    std::uint8_t length = 0;
+    std::uint8_t pattern = 0;
+
+    constexpr bool valid() const noexcept { return length != 0; }
+    constexpr bool dah(unsigned i) const noexcept
+    {
+        return (pattern >> (length - 1 - i)) & 1u;
+    }
+    /// Key-down plus intra-character gaps, in dot units.
+    constexpr unsigned units() const noexcept
+    {
+        unsigned u = length - 1;
+        for (unsigned i = 0; i < length; ++i)
+            u += dah(i) ? 3 : 1;
+        return u;
+    }
+};
+
+namespace detail {
+
+struct MorseDef {
+    char c;
+    const char* code;
+};
+
+inline constexpr MorseDef morse_defs[] = {
+    {'A', ".-"},     {'B', "-..."},   {'C', "-.-."},   {'D', "-.."},    {'E', "."},
+    {'F', "..-."},   {'G', "--."},    {'H', "...."},   {'I', ".."},     {'J', ".---"},
+    {'K', "-.-"},    {'L', ".-.."},   {'M', "--"},     {'N', "-."},     {'O', "---"},
+    {'P', ".--."},   {'Q', "--.-"},   {'R', ".-."},    {'S', "..."},    {'T', "-"},
+    {'U', "..-"},    {'V', "...-"},   {'W', ".--"},    {'X', "-..-"},   {'Y', "-.--"},
+    {'Z', "--.."},   {'0', "-----"},  {'1', ".----"},  {'2', "..---"},  {'3', "...--"},
+    {'4', "....-"},  {'5', "....."},  {'6', "-...."},  {'7', "--..."},  {'8', "---.."},
+    {'9', "----."},  {'/', "-..-."},  {'?', "..--.."}, {'.', ".-.-.-"}, {',', "--..--"},
+    {'=', "-...-"},  {'+', ".-.-."},  {'-', "-....-"},
+};
+
+constexpr std::array<MorseSymbol, 128> build_morse_table()
+{
+    std::array<MorseSymbol, 128> table{};
+    for (const auto& def : morse_defs) {
+        MorseSymbol sym;
+        for (const char* p = def.code; *p; ++p) {
+            sym.pattern = static_cast<std::uint8_t>((sym.pattern << 1) | (*p == '-' ? 1 : 0));
+            ++sym.length;
+        }
+        table[static_cast<unsigned char>(def.c)] = sym;
+        if (def.c >= 'A' && def.c <= 'Z')
+            table[static_cast<unsigned char>(def.c - 'A' + 'a')] = sym;
+    }
+    return table;
+}
+
+} // namespace detail
+
+/// ASCII to Morse, built at compile time.
+inline constexpr std::array<MorseSymbol, 128> morse_table = detail::build_morse_table();
+
+constexpr MorseSymbol morse_lookup(char c) noexcept
+{
+    const auto u = static_cast<unsigned char>(c);
+    return u < morse_table.size() ? morse_table[u] : MorseSymbol{};
+}
+
+static_assert(morse_lookup('k').length == 3 && morse_lookup('K').pattern == 0b101);
+static_assert(morse_lookup('0').units() == 19);
+static_assert(!morse_lookup(' ').valid());
+
+} // namespace mprp
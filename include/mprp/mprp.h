@@ -0,0 +1,52 @@
+/* Plain C interface to libmprp, for daemons and scripts loading the shared
+ * library through an FFI (ctypes, cffi). All functions are thread-compatible:
+ * one engine may be used from several threads as long as none of them is
+ * closing it. */
+#ifndef MPRP_MPRP_H
+#define MPRP_MPRP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mprp_engine mprp_engine;
+
+/* Opens an engine from a config file. Returns NULL on failure; the reason is
+ * available from mprp_last_error(). */
+mprp_engine* mprp_engine_open(const char* config_path);
+
+/* Same as mprp_engine_open but parses config text held in memory. */
+mprp_engine* mprp_engine_open_text(const char* config_text);
+
+void mprp_engine_close(mprp_engine* engine);
+
+/* Number of beacon entries in the rotation. */
+size_t mprp_engine_entries(const mprp_engine* engine);
+
+/* Computes the next slot starting at or after unix_time_ns. Writes the slot
+ * start (ns since epoch) and the entry scheduled in it. Returns 0 on success. */
+int mprp_engine_next_slot(const mprp_engine* engine, int64_t unix_time_ns,
+                          int64_t* start_ns, size_t* entry);
+
+/* Samples in the full transmission of an entry, or 0 for an unknown entry. */
+size_t mprp_engine_transmission_samples(const mprp_engine* engine, size_t entry);
+
+/* Renders an entry into out[0..capacity). Returns samples written, or -1 on
+ * error. */
+long mprp_engine_render(const mprp_engine* engine, size_t entry, float* out, size_t capacity);
+
+/* Encodes a WSPR type 1 message into 162 channel symbols (0..3). Returns 0 on
+ * success or a positive mprp::WsprStatus code; never allocates. */
+int mprp_wspr_encode(const char* callsign, const char* grid, int power_dbm, uint8_t out[162]);
+
+/* Message describing the last failure on the calling thread. */
+const char* mprp_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPRP_MPRP_H */
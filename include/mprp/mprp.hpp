@@ -0,0 +1,44 @@
+#pragma once
+
+// Umbrella header for the libmprp C++ API.
+
+#include "mprp/arena.hpp"
+#include "mprp/buffer_pool.hpp"
+#include "mprp/capture.hpp"
+#include "mprp/config.hpp"
+#include "mprp/control_server.hpp"
+#include "mprp/convolutional.hpp"
+#include "mprp/cpu.hpp"
+#include "mprp/distributed.hpp"
+#include "mprp/encoder.hpp"
+#include "mprp/engine.hpp"
+#include "mprp/envelope.hpp"
+#include "mprp/event_loop.hpp"
+#include "mprp/fft.hpp"
+#include "mprp/fir_design.hpp"
+#include "mprp/hash.hpp"
+#include "mprp/live_engine.hpp"
+#include "mprp/metrics.hpp"
+#include "mprp/modulator.hpp"
+#include "mprp/morse.hpp"
+#include "mprp/nco.hpp"
+#include "mprp/polyphase.hpp"
+#include "mprp/power.hpp"
+#include "mprp/render_cache.hpp"
+#include "mprp/rig_control.hpp"
+#include "mprp/rx_pipeline.hpp"
+#include "mprp/rx_stages.hpp"
+#include "mprp/sample_format.hpp"
+#include "mprp/scheduler.hpp"
+#include "mprp/spectrum.hpp"
+#include "mprp/spot_log.hpp"
+#include "mprp/spot_store.hpp"
+#include "mprp/spot_upload.hpp"
+#include "mprp/spsc_ring.hpp"
+#include "mprp/sync_search.hpp"
+#include "mprp/table_snapshot.hpp"
+#include "mprp/task_pool.hpp"
+#include "mprp/timing.hpp"
+#include "mprp/tx_scheduler.hpp"
+#include "mprp/wspr.hpp"
+#include "mprp/wspr_search.hpp"
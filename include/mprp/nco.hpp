@@ -0,0 +1,71 @@
+#pragma once
+
+#include "mprp/cpu.hpp"
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace mprp {
+
+/// Phase-accumulator increment for a tone. The full 32-bit range is one
+/// cycle, so frequency resolution is sample_rate / 2^32.
+std::uint32_t phase_step(double hz, double sample_rate) noexcept;
+
+/// Converts a phase in cycles (turns) to accumulator units.
+std::uint32_t phase_from_turns(double turns) noexcept;
+
+/// Adds amplitude * sin(phase + k * step) to out[k] for every k and returns
+/// the phase following the last sample.
+std::uint32_t nco_accumulate(std::uint32_t phase, std::uint32_t step, float amplitude,
+                             std::span<float> out, Isa isa = best_isa()) noexcept;
+
+/// Complex variant: adds amplitude * exp(j(phase + k * step)).
+std::uint32_t nco_accumulate(std::uint32_t phase, std::uint32_t step, float amplitude,
+                             std::span<std::complex<float>> out, Isa isa = best_isa()) noexcept;
+
+/// A bank of numerically controlled oscillators rendering many tones per
+/// call into caller-provided buffers.
+///
+/// Each tone is a 32-bit phase accumulator; sine values come from a
+/// polynomial evaluated eight (AVX2) or four (NEON) samples at a time, with
+/// the kernel chosen at runtime. Phases persist across calls, so
+/// consecutive renders are continuous.
+class NcoBank {
+public:
+    explicit NcoBank(double sample_rate, Isa isa = best_isa());
+
+    /// Adds a tone and returns its index.
+    std::size_t add_tone(double hz, float amplitude = 1.0f, double phase_turns = 0.0);
+
+    void set_frequency(std::size_t tone, double hz) noexcept;
+    void set_amplitude(std::size_t tone, float amplitude) noexcept;
+    void clear() noexcept;
+
+    std::size_t size() const noexcept { return phase_.size(); }
+    double sample_rate() const noexcept { return sample_rate_; }
+    Isa isa() const noexcept { return isa_; }
+
+    /// Writes the sum of all tones to out.
+    void render(std::span<float> out) noexcept;
+
+    /// Writes the complex (IQ) sum of all tones to out.
+    void render(std::span<std::complex<float>> out) noexcept;
+
+    /// Writes tone t to channels[t][0..frames); channels.size() must equal size().
+    void render_channels(std::span<float* const> channels, std::size_t frames) noexcept;
+
+private:
+    template <typename T>
+    void render_sum(std::span<T> out) noexcept;
+
+    double sample_rate_;
+    Isa isa_;
+    std::vector<std::uint32_t> phase_;
+    std::vector<std::uint32_t> step_;
+    std::vector<float> amplitude_;
+};
+
+} // namespace mprp
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "mprp/buffer_pool.hpp"
+#include "mprp/cpu.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace mprp {
+
+/// Rational L/M polyphase resampler for complex samples.
+///
+/// The prototype low-pass is split once into L sub-filters, each stored
+/// reversed with every tap duplicated (re, im lanes), so one output is a
+/// contiguous float dot product against the interleaved delay line. Only
+/// the outputs that are kept are computed: decimating by M costs one
+/// sub-filter per output, not M full-rate filters.
+class PolyphaseResampler {
+public:
+    /// prototype is designed at the upsampled rate (input rate * interp).
+    PolyphaseResampler(unsigned interp, unsigned decim, std::vector<float> prototype,
+                       Isa isa = best_isa());
+
+    /// Designs the prototype from pass- and stop-band edges given as
+    /// fractions of the input rate.
+    static PolyphaseResampler design(unsigned interp, unsigned decim, double passband,
+                                     double stopband, double atten_db = 80.0,
+                                     Isa isa = best_isa());
+
+    unsigned interpolation() const noexcept { return interp_; }
+    unsigned decimation() const noexcept { return decim_; }
+    std::size_t taps_per_phase() const noexcept { return taps_; }
+
+    /// Upper bound on outputs produced for n more inputs.
+    std::size_t max_output(std::size_t n) const noexcept;
+
+    /// Consumes all of in and writes outputs to out (sized with
+    /// max_output); returns the number written. Never allocates.
+    std::size_t process(std::span<const Complex> in, std::span<Complex> out) noexcept;
+
+    /// Clears the delay line and phase.
+    void reset() noexcept;
+
+private:
+    std::size_t process_chunk(std::size_t n, Complex* out) noexcept;
+
+    unsigned interp_;
+    unsigned decim_;
+    std::size_t taps_;
+    Isa isa_;
+    std::vector<float> bank_;     ///< interp_ phases x 2*taps_ floats.
+    std::vector<Complex> delay_;  ///< taps_-1 history samples + one chunk.
+    std::size_t next_ = 0;        ///< Upsampled-domain index of the next output.
+};
+
+/// Chain of polyphase stages converting between two integer sample rates.
+/// Integer decimation is split into stages, e.g. 2.4 MS/s to 12 kS/s as
+/// 8 x 5 x 5; early stages use wide transition bands (only the final pass
+/// band has to survive), which keeps the total tap count far below a
+/// single-stage design. Rational ratios run as one L/M stage.
+class ResamplerCascade {
+public:
+    /// passband_hz must be below half the lower of the two rates.
+    ResamplerCascade(double in_rate, double out_rate, double passband_hz, double atten_db = 80.0,
+                     Isa isa = best_isa());
+
+    double in_rate() const noexcept { return in_rate_; }
+    double out_rate() const noexcept { return out_rate_; }
+    std::size_t stages() const noexcept { return stages_.size(); }
+    const PolyphaseResampler& stage(std::size_t i) const noexcept { return stages_[i]; }
+
+    std::size_t max_output(std::size_t n) const noexcept;
+
+    /// Runs in through every stage into out (sized with max_output).
+    std::size_t process(std::span<const Complex> in, std::span<Complex> out) noexcept;
+
+    void reset() noexcept;
+
+private:
+    double in_rate_;
+    double out_rate_;
+    std::vector<PolyphaseResampler> stages_;
+    std::vector<std::vector<Complex>> scratch_;
+};
+
+/// Splits a decimation factor into stage factors no larger than max_stage,
+/// largest first.
+std::vector<unsigned> plan_decimation(unsigned factor, unsigned max_stage = 8);
+
+} // namespace mprp
@@ -0,0 +1,59 @@
+#pragma once
+
+// Per-period CPU time and energy for battery and solar nodes.
+//
+// CPU time is the whole process's (every thread, the control-plane loop
+// included). Energy is measured where the kernel exposes a package energy
+// counter (Intel RAPL under /sys/class/powercap, usually readable by root
+// only) and otherwise estimated from a two-term board model: idle power
+// over the wall time plus per-core active power over the CPU time. The
+// model is crude but monotone in both terms, which is what tuning a duty
+// cycle needs; calibrate it once against a USB power meter.
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace mprp {
+
+struct PowerModel {
+    double idle_w = 0.6;  ///< Whole board with every core idle (Pi Zero 2 W class).
+    double core_w = 0.4;  ///< Added by one fully busy core.
+    /// Use the package energy counter when there is a readable one.
+    bool measure = true;
+};
+
+/// One period between two PowerMeter::lap() calls.
+struct PowerSample {
+    std::chrono::nanoseconds wall{0};
+    std::chrono::nanoseconds cpu{0};
+    double energy_j = 0.0;
+    bool measured = false;  ///< energy_j is from the energy counter, not the model.
+};
+
+class PowerMeter {
+public:
+    explicit PowerMeter(PowerModel model = {});
+
+    /// The period since the previous lap() (or construction).
+    PowerSample lap() noexcept;
+
+    /// False if energies are model estimates.
+    bool measuring() const noexcept { return !counter_.empty(); }
+
+private:
+    /// The counter in microjoules, or -1 if it cannot be read.
+    std::int64_t read_counter() const noexcept;
+
+    PowerModel model_;
+    std::string counter_;           ///< energy_uj path; empty = estimate.
+    std::int64_t counter_range_ = 0;  ///< Wrap-around of the counter.
+    std::chrono::steady_clock::time_point wall_;
+    std::chrono::nanoseconds cpu_{0};
+    std::int64_t energy_uj_ = -1;
+};
+
+/// CPU time used by the whole process so far.
+std::chrono::nanoseconds process_cpu_time() noexcept;
+
+} // namespace mprp
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+namespace mprp {
+
+/// A fully rendered transmission, either held in memory or mapped read-only
+/// from the disk tier. Immutable once published.
+class RenderedBuffer {
+public:
+    virtual ~RenderedBuffer() = default;
+    virtual std::span<const float> samples() const noexcept = 0;
+};
+
+/// Content-addressed cache of rendered transmissions.
+///
+/// Keys are content hashes of everything that shapes the samples
+/// (Engine::render_key()), so changing a modulation parameter changes the
+/// key and the old entry is simply never hit again. The memory tier is an
+/// LRU bounded in bytes; the optional disk tier keeps one file per key in
+/// a directory and serves hits by mapping it, so a restarted daemon plays
+/// its first slot straight from the page cache.
+class RenderCache {
+public:
+    using Render = std::function<std::size_t(std::span<float>)>;
+
+    /// An empty directory disables the disk tier; the directory is created
+    /// if missing. Throws std::runtime_error if it cannot be.
+    explicit RenderCache(std::size_t memory_bytes, std::string directory = {});
+
+    /// The cached buffer for key, or nothing.
+    std::shared_ptr<const RenderedBuffer> find(std::uint64_t key);
+
+    /// Returns the cached buffer for key, rendering it with at most
+    /// max_samples samples on a miss.
+    std::shared_ptr<const RenderedBuffer> get(std::uint64_t key, std::size_t max_samples,
+                                              const Render& render);
+
+    /// Deletes disk-tier files whose key is not in keep.
+    void retain(std::span<const std::uint64_t> keep);
+
+    std::uint64_t hits() const noexcept { return hits_.load(std::memory_order_relaxed); }
+    std::uint64_t disk_hits() const noexcept { return disk_hits_.load(std::memory_order_relaxed); }
+    std::uint64_t misses() const noexcept { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        std::shared_ptr<const RenderedBuffer> buffer;
+        std::list<std::uint64_t>::iterator lru;
+    };
+
+    std::shared_ptr<const RenderedBuffer> find_locked(std::uint64_t key);
+    void insert_locked(std::uint64_t key, std::shared_ptr<const RenderedBuffer> buffer);
+    std::string path(std::uint64_t key) const;
+
+    std::size_t capacity_;
+    std::string directory_;
+    std::mutex mutex_;
+    std::list<std::uint64_t> lru_;  ///< Most recent first.
+    std::unordered_map<std::uint64_t, Entry> entries_;
+    std::size_t bytes_ = 0;
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> disk_hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+};
+
+} // namespace mprp
@@ -0,0 +1,149 @@
+#pragma once
+
+// CAT control of the transmitter: dial frequency, mode, power and PTT over
+// the rig's serial port, driven by a coroutine on the control-plane event
+// loop (see mprp/event_loop.hpp).
+//
+// Callers state what they want (request(), set_ptt(), release_at()) and
+// never wait for the rig. Wanted values are coalesced per setting, so only
+// the last of several queued frequencies is sent, and compared against the
+// rig's last confirmed state, so re-selecting the band the rig is already
+// on costs nothing. What is left goes out as one batch: Kenwood-style CAT
+// sets carry no acknowledgement, so a whole batch is a single write closed
+// by one frequency query as a fence; CI-V acknowledges every command, so
+// its commands go one at a time. Setup is never sent while the rig is
+// keyed: it waits for the PTT release.
+//
+// In the transmit pipeline setup is queued when a slot is committed to
+// (TxSchedulerOptions::prepare), long before the edge, which leaves only
+// the short PTT command for the edge itself (TxSchedulerOptions::key, at
+// ptt_latency() ahead of it).
+
+#include "mprp/event_loop.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace mprp {
+
+enum class RigProtocol {
+    Kenwood,  ///< ASCII `;`-terminated CAT (Kenwood, Elecraft, QRP Labs, ...).
+    Civ,      ///< Icom CI-V binary frames.
+};
+
+/// Parses "kenwood" or "civ"; throws std::invalid_argument otherwise.
+RigProtocol parse_rig_protocol(std::string_view name);
+const char* to_string(RigProtocol protocol) noexcept;
+
+enum class RigMode { Lsb, Usb, Cw, Am, Fm };
+
+/// Rig settings; an empty field is unknown (in state()) or left alone (in
+/// request()).
+struct RigState {
+    std::optional<std::uint64_t> frequency_hz;
+    std::optional<RigMode> mode;
+    std::optional<unsigned> power_w;
+    std::optional<bool> ptt;
+};
+
+struct RigControlOptions {
+    std::string device;  ///< Serial port, e.g. /dev/ttyUSB0.
+    unsigned baud = 9600;
+    RigProtocol protocol = RigProtocol::Kenwood;
+    std::uint8_t civ_address = 0x94;  ///< The rig's CI-V address.
+    unsigned civ_max_power_w = 100;   ///< Output at CI-V power level 255.
+    std::chrono::milliseconds timeout{500};  ///< For each reply.
+    /// The rig's own transmit switching time once the PTT command is in.
+    std::chrono::microseconds ptt_delay{0};
+    unsigned max_attempts = 3;  ///< Per batch, including the first.
+    EventLoop* loop = nullptr;  ///< Where the port is driven; default control_loop().
+};
+
+/// Queues rig settings and applies them from an event-loop coroutine.
+/// Thread-safe, but not to be used from the loop's own thread (sync() and
+/// the destructor wait for the loop).
+class RigControl {
+public:
+    /// Throws std::runtime_error if the port cannot be opened and set up,
+    /// std::invalid_argument for an unsupported baud rate.
+    explicit RigControl(RigControlOptions options);
+    /// Drops queued setup, unkeys the rig if it may be keyed and closes the
+    /// port once that is done or given up on.
+    ~RigControl();
+
+    RigControl(const RigControl&) = delete;
+    RigControl& operator=(const RigControl&) = delete;
+
+    /// Queues the set fields of wanted, replacing queued values of the same
+    /// settings; never blocks on I/O.
+    void request(const RigState& wanted);
+    void set_ptt(bool on)
+    {
+        RigState s;
+        s.ptt = on;
+        request(s);
+    }
+
+    /// Queues PTT off for when (on the steady clock), e.g. the end of the
+    /// transmission just keyed. Setup requested meanwhile waits for it.
+    void release_at(std::chrono::steady_clock::time_point when);
+
+    /// Waits until everything queued has been sent and confirmed (or given
+    /// up on), or timeout; a later release_at() is not waited for. Returns
+    /// true if nothing is left.
+    bool sync(std::chrono::milliseconds timeout);
+
+    /// The rig's last confirmed settings.
+    RigState state() const;
+    /// Forgets state(), e.g. after the rig was touched by hand, so the next
+    /// request of each setting is sent.
+    void invalidate();
+
+    /// Time from set_ptt(true) to the rig being on the air: the PTT
+    /// command's time on the wire at the port's baud rate plus ptt_delay.
+    std::chrono::nanoseconds ptt_latency() const noexcept;
+
+    std::uint64_t commands() const noexcept { return commands_.load(std::memory_order_relaxed); }  ///< Sent to the rig.
+    std::uint64_t skipped() const noexcept { return skipped_.load(std::memory_order_relaxed); }    ///< No-ops not sent.
+    std::uint64_t batches() const noexcept { return batches_.load(std::memory_order_relaxed); }
+    std::uint64_t errors() const noexcept { return errors_.load(std::memory_order_relaxed); }      ///< Failed batches.
+
+private:
+    struct Batch;
+
+    Task<void> run();
+    Batch take_locked();
+    Task<bool> send(const Batch& batch);
+    Task<bool> send_kenwood(const Batch& batch);
+    Task<bool> send_civ(const Batch& batch);
+    Task<bool> civ_command(std::string_view body);
+    Task<bool> fill();
+
+    RigControlOptions options_;
+    EventLoop& loop_;
+    int fd_ = -1;
+    std::string in_;  ///< Received, not yet parsed (loop thread only).
+    std::optional<std::uint64_t> reported_hz_;  ///< Fence reply of the last batch (loop thread only).
+    AsyncEvent wake_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable idle_;
+    RigState wanted_;
+    RigState state_;
+    std::optional<std::chrono::steady_clock::time_point> release_;
+    bool busy_ = false;  ///< A batch is in flight.
+    bool stopping_ = false;
+    bool done_ = false;  ///< run() has returned.
+    std::atomic<std::uint64_t> commands_{0};
+    std::atomic<std::uint64_t> skipped_{0};
+    std::atomic<std::uint64_t> batches_{0};
+    std::atomic<std::uint64_t> errors_{0};
+};
+
+} // namespace mprp
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "mprp/buffer_pool.hpp"
+#include "mprp/spsc_ring.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace mprp {
+
+/// Hand-off between two pipeline threads. Carries one reference per block
+/// (never the samples) through a lock-free ring; the consumer parks on an
+/// atomic wait when the ring is empty. A null block marks end of stream.
+class BlockQueue {
+public:
+    explicit BlockQueue(std::size_t capacity) : ring_(capacity) {}
+
+    void push(BufferRef block) noexcept;
+    void push_end() noexcept;
+
+    /// Waits for the next block; an empty ref means end of stream.
+    BufferRef pop() noexcept;
+
+private:
+    void post(Block* block) noexcept;
+
+    SpscRing<Block*> ring_;
+    std::atomic<std::uint32_t> posted_{0};
+};
+
+/// Forwards blocks from a stage to the next one (or drops them at the end
+/// of the chain).
+class Emitter {
+public:
+    explicit Emitter(BlockQueue* next = nullptr) noexcept : next_(next) {}
+    void operator()(BufferRef block) const noexcept
+    {
+        if (next_ && block)
+            next_->push(std::move(block));
+    }
+
+private:
+    BlockQueue* next_;
+};
+
+/// Produces the raw stream. read() runs on the source thread only.
+class Source {
+public:
+    virtual ~Source() = default;
+    virtual double sample_rate() const noexcept = 0;
+
+    /// Fills out with the next samples; returns the count, 0 at end of stream.
+    virtual std::size_t read(std::span<Complex> out) = 0;
+
+    /// The next block, or an empty ref at end of stream. The default fills a
+    /// block from pool through read(); sources that already hold samples in
+    /// memory override it to hand out views. The pipeline sets the stream
+    /// metadata except start, which the source may fill in.
+    virtual BufferRef next(BufferPool& pool);
+
+    /// Asks next() for blocks in the source's own sample format (see
+    /// Block::format) instead of Complex. Called before the pipeline starts
+    /// when the first stage accepts raw blocks; sources without a raw
+    /// format ignore it.
+    virtual void set_raw(bool) noexcept {}
+};
+
+/// One processing step. process() runs on the stage's own thread and may
+/// modify a block in place (when it holds the only reference), emit a new
+/// block from the pool, or emit nothing.
+class Stage {
+public:
+    virtual ~Stage() = default;
+    virtual const char* name() const noexcept = 0;
+    virtual void process(BufferRef block, const Emitter& emit) = 0;
+
+    /// Called once after the last block, to flush internal state.
+    virtual void finish(const Emitter&) {}
+
+    /// True if process() takes blocks in any IqFormat and emits Complex
+    /// ones, converting as part of its own work. The pipeline then lets
+    /// the source skip its separate conversion pass.
+    virtual bool accepts_raw() const noexcept { return false; }
+};
+
+/// Per-stage throughput counters, readable while the pipeline runs.
+struct StageStats {
+    std::atomic<std::uint64_t> blocks{0};
+    std::atomic<std::uint64_t> samples{0};
+    std::atomic<std::uint64_t> busy_ns{0};
+};
+
+/// Streaming receive chain: source -> stage -> ... -> stage, each on its own
+/// thread (optionally pinned to a core), exchanging pooled blocks by
+/// reference.
+///
+/// Memory is fixed by the pool: the source waits for a free block whenever
+/// downstream stages fall behind, so a multi-hour capture runs in the same
+/// footprint as a short one.
+class RxPipeline {
+public:
+    RxPipeline(BufferPool& pool, std::unique_ptr<Source> source);
+    ~RxPipeline();
+
+    RxPipeline(const RxPipeline&) = delete;
+    RxPipeline& operator=(const RxPipeline&) = delete;
+
+    /// Appends a stage; cpu >= 0 pins its thread to that core.
+    RxPipeline& add(std::unique_ptr<Stage> stage, int cpu = -1);
+
+    /// Pins the source thread.
+    RxPipeline& source_cpu(int cpu) noexcept
+    {
+        source_cpu_ = cpu;
+        return *this;
+    }
+
+    void start();
+
+    /// Asks the source to stop; the stages drain what is in flight.
+    void stop() noexcept { stopping_.store(true, std::memory_order_relaxed); }
+
+    /// Joins all threads.
+    void wait();
+
+    /// start() + wait().
+    void run()
+    {
+        start();
+        wait();
+    }
+
+    std::size_t stages() const noexcept { return stages_.size(); }
+    const StageStats& stats(std::size_t stage) const noexcept { return *stats_[stage]; }
+    std::uint64_t source_samples() const noexcept
+    {
+        return source_samples_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void source_loop();
+    void stage_loop(std::size_t index);
+
+    BufferPool& pool_;
+    std::unique_ptr<Source> source_;
+    int source_cpu_ = -1;
+    std::vector<std::unique_ptr<Stage>> stages_;
+    std::vector<int> cpus_;
+    std::vector<std::unique_ptr<BlockQueue>> queues_;
+    std::vector<std::unique_ptr<StageStats>> stats_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<std::uint64_t> source_samples_{0};
+};
+
+/// Pins the calling thread to one CPU; returns false if the OS refused.
+bool pin_current_thread(int cpu) noexcept;
+
+} // namespace mprp
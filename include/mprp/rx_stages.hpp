@@ -0,0 +1,197 @@
+#pragma once
+
+#include "mprp/polyphase.hpp"
+#include "mprp/rx_pipeline.hpp"
+#include "mprp/sample_format.hpp"
+
+#include <cstdio>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mprp {
+
+/// Parses "cf32", "cs16", "cu8" or "cs8"; throws std::invalid_argument otherwise.
+IqFormat parse_iq_format(const std::string& name);
+
+/// Bytes per complex sample in the given format.
+std::size_t iq_sample_bytes(IqFormat format) noexcept;
+
+/// Converts out.size() raw samples to complex float (unit full scale).
+void decode_iq(IqFormat format, const void* raw, std::span<Complex> out) noexcept;
+
+/// Converts samples to the raw format (saturating); raw must hold
+/// samples.size() * iq_sample_bytes(format) bytes.
+void encode_iq(IqFormat format, std::span<const Complex> samples, void* raw) noexcept;
+
+/// Streams a raw IQ file block by block; only one block of the file is in
+/// memory at a time. In raw mode the file's samples are read straight into
+/// the block, unconverted.
+class FileSource final : public Source {
+public:
+    FileSource(const std::string& path, IqFormat format, double sample_rate);
+    ~FileSource() override;
+
+    double sample_rate() const noexcept override { return sample_rate_; }
+    std::size_t read(std::span<Complex> out) override;
+    BufferRef next(BufferPool& pool) override;
+    void set_raw(bool raw) noexcept override { raw_mode_ = raw; }
+
+private:
+    std::FILE* file_;
+    IqFormat format_;
+    double sample_rate_;
+    bool raw_mode_ = false;
+    std::vector<unsigned char> raw_;
+};
+
+/// Shifts the stream by -shift_hz (moves a signal at shift_hz to DC), in
+/// place when the block is not shared. Shared blocks are mixed into a
+/// small private pool, created on first need. Raw blocks are converted in
+/// the same pass.
+class MixerStage final : public Stage {
+public:
+    explicit MixerStage(double shift_hz);
+    const char* name() const noexcept override { return "mixer"; }
+    void process(BufferRef block, const Emitter& emit) override;
+    bool accepts_raw() const noexcept override { return true; }
+
+private:
+    double shift_hz_;
+    std::uint32_t phase_ = 0;
+    std::vector<Complex> lo_;
+    std::unique_ptr<BufferPool> spare_;
+};
+
+/// Polyphase rate conversion to out_rate (e.g. SDR rate down to audio
+/// bandwidth), designed once when the first block reveals the input rate.
+///
+/// Output blocks come from the stage's own pool. Drawing them from the
+/// source's pool could deadlock: the source may hold every block in the
+/// queue feeding this stage.
+class ResamplerStage final : public Stage {
+public:
+    ResamplerStage(double out_rate, double passband_hz, std::size_t out_block_samples,
+                   std::size_t out_blocks = 4);
+    const char* name() const noexcept override { return "resampler"; }
+    void process(BufferRef block, const Emitter& emit) override;
+    void finish(const Emitter& emit) override;
+
+private:
+    void flush(const Emitter& emit);
+
+    double out_rate_;
+    double passband_hz_;
+    BufferPool pool_;
+    std::optional<ResamplerCascade> cascade_;
+    std::vector<Complex> scratch_;
+    BufferRef out_;
+    std::uint64_t out_sequence_ = 0;
+    std::uint64_t out_position_ = 0;
+};
+
+/// Automatic gain control applied at the output rate: a power envelope
+/// with separate attack and decay time constants, and a gain that brings
+/// it to target_rms (never above max_gain_db).
+struct AgcConfig {
+    double target_rms = 0.25;
+    double attack_s = 0.005;
+    double decay_s = 0.5;
+    double max_gain_db = 60.0;
+};
+
+/// Receive front end in one pass: mix by -shift_hz, decimate to out_rate
+/// and (optionally) AGC. Each input block is walked in tiles sized to the
+/// L1 data cache; a tile is converted and mixed, runs through every
+/// decimation stage and is gain-controlled while still cache-resident, so
+/// the full-rate samples are read once instead of once per stage.
+///
+/// Output blocks come from the stage's own pool, as with ResamplerStage.
+class FrontEndStage final : public Stage {
+public:
+    FrontEndStage(double shift_hz, double out_rate, double passband_hz, std::optional<AgcConfig> agc,
+                  std::size_t out_block_samples, std::size_t out_blocks = 4);
+    const char* name() const noexcept override { return "front_end"; }
+    void process(BufferRef block, const Emitter& emit) override;
+    void finish(const Emitter& emit) override;
+    bool accepts_raw() const noexcept override { return true; }
+
+    /// Input samples per tile.
+    std::size_t tile() const noexcept { return tile_; }
+
+private:
+    template <typename T>
+    void run(const unsigned char* in, std::size_t n, const Block& like, const Emitter& emit);
+    void apply_agc(std::span<Complex> y) noexcept;
+    void flush(const Emitter& emit);
+
+    double shift_hz_;
+    double out_rate_;
+    double passband_hz_;
+    std::optional<AgcConfig> agc_;
+    std::size_t tile_;
+    BufferPool pool_;
+    std::optional<ResamplerCascade> cascade_;
+    std::uint32_t phase_ = 0;
+    std::vector<Complex> lo_;       ///< One tile of oscillator.
+    std::vector<Complex> mixed_;    ///< One tile, converted and mixed.
+    std::vector<Complex> scratch_;  ///< One tile's decimated output.
+    float agc_attack_ = 0.0f;       ///< Per-output-sample smoothing factors.
+    float agc_decay_ = 0.0f;
+    float agc_max_gain_ = 1.0f;
+    float agc_level_ = 0.0f;        ///< Tracked mean power.
+    BufferRef out_;
+    std::uint64_t out_sequence_ = 0;
+    std::uint64_t out_position_ = 0;
+};
+
+/// Real-tap FIR filter applied in place (on a private copy when the block
+/// is shared), with the delay line carried across block boundaries. Raw
+/// blocks are converted a chunk at a time as they are filtered.
+class FirStage final : public Stage {
+public:
+    explicit FirStage(std::vector<float> taps);
+    const char* name() const noexcept override { return "fir"; }
+    void process(BufferRef block, const Emitter& emit) override;
+    bool accepts_raw() const noexcept override { return true; }
+
+    /// Windowed-sinc low-pass design (Hamming), cutoff as a fraction of
+    /// the sample rate (0 < cutoff < 0.5).
+    static std::vector<float> lowpass(std::size_t taps, double cutoff);
+
+private:
+    template <typename T>
+    void filter_raw(Block& block) noexcept;
+
+    std::vector<float> taps_;
+    std::vector<Complex> window_;  ///< Converted chunk plus its taps-1 predecessors.
+    std::vector<Complex> history_;
+    std::vector<Complex> next_history_;
+    std::unique_ptr<BufferPool> spare_;
+};
+
+/// Block-power detector: tracks a slow noise-floor estimate and reports
+/// blocks whose power rises threshold_db above it.
+class EnergyDetector final : public Stage {
+public:
+    struct Detection {
+        std::uint64_t first_sample;
+        double sample_rate;
+        double power_db;
+        double floor_db;
+    };
+    using Callback = std::function<void(const Detection&)>;
+
+    EnergyDetector(double threshold_db, Callback callback);
+    const char* name() const noexcept override { return "detector"; }
+    void process(BufferRef block, const Emitter& emit) override;
+
+private:
+    double threshold_db_;
+    Callback callback_;
+    double floor_ = 0.0;
+    bool primed_ = false;
+};
+
+} // namespace mprp
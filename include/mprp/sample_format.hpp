@@ -0,0 +1,170 @@
+#pragma once
+
+// Raw IQ sample formats, and receive kernels templated on them.
+//
+// SDRs and sound cards deliver int8, uint8, int16 or float32 IQ, while the
+// pipeline computes in Complex (float32 I/Q). Rather than expanding every
+// block to float in a separate pass, a source may hand its raw samples to
+// the first stage, which converts them inside its own loop. Each kernel
+// is a template over the sample type and the number of interleaved
+// channels. The per-format instantiations are fixed at compile time, and
+// with_sample_type() picks one per block.
+//
+// Raw samples are read through byte pointers (memcpy), and kernels expand
+// a block in place: each one walks the block back to front, a chunk at a
+// time.
+
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace mprp {
+
+using Complex = std::complex<float>;
+
+/// Layout of raw interleaved IQ.
+enum class IqFormat {
+    Cf32,  ///< float32 I, float32 Q (GNU Radio / SDR# style).
+    Cs16,  ///< int16 I, int16 Q (sound cards, SDRplay, Airspy).
+    Cu8,   ///< uint8 offset-binary I, Q (rtl_sdr).
+    Cs8,   ///< int8 I, Q (HackRF).
+};
+
+struct Cs16Sample {
+    std::int16_t i, q;
+};
+struct Cu8Sample {
+    std::uint8_t i, q;
+};
+struct Cs8Sample {
+    std::int8_t i, q;
+};
+
+/// Format tag and conversion to Complex at unit full scale for each raw
+/// sample type.
+template <typename T>
+struct SampleTraits;
+
+template <>
+struct SampleTraits<Complex> {
+    static constexpr IqFormat format = IqFormat::Cf32;
+    static Complex load(const unsigned char* p) noexcept
+    {
+        Complex s;
+        std::memcpy(&s, p, sizeof s);
+        return s;
+    }
+};
+
+template <>
+struct SampleTraits<Cs16Sample> {
+    static constexpr IqFormat format = IqFormat::Cs16;
+    static Complex load(const unsigned char* p) noexcept
+    {
+        Cs16Sample s;
+        std::memcpy(&s, p, sizeof s);
+        return {s.i * (1.0f / 32768.0f), s.q * (1.0f / 32768.0f)};
+    }
+};
+
+template <>
+struct SampleTraits<Cu8Sample> {
+    static constexpr IqFormat format = IqFormat::Cu8;
+    static Complex load(const unsigned char* p) noexcept
+    {
+        return {(p[0] - 127.5f) * (1.0f / 128.0f), (p[1] - 127.5f) * (1.0f / 128.0f)};
+    }
+};
+
+template <>
+struct SampleTraits<Cs8Sample> {
+    static constexpr IqFormat format = IqFormat::Cs8;
+    static Complex load(const unsigned char* p) noexcept
+    {
+        Cs8Sample s;
+        std::memcpy(&s, p, sizeof s);
+        return {s.i * (1.0f / 128.0f), s.q * (1.0f / 128.0f)};
+    }
+};
+
+/// Calls f(std::type_identity<T>{}) with the sample type stored in format.
+template <typename F>
+decltype(auto) with_sample_type(IqFormat format, F&& f)
+{
+    switch (format) {
+    case IqFormat::Cs16: return f(std::type_identity<Cs16Sample>{});
+    case IqFormat::Cu8: return f(std::type_identity<Cu8Sample>{});
+    case IqFormat::Cs8: return f(std::type_identity<Cs8Sample>{});
+    case IqFormat::Cf32: break;
+    }
+    return f(std::type_identity<Complex>{});
+}
+
+/// Frames a kernel converts into a local buffer at a time; blocks are
+/// walked back to front in these chunks so the output may overwrite the
+/// (narrower) input of the frames already done.
+inline constexpr std::size_t kernel_chunk = 256;
+
+/// Splits frames of Channels interleaved raw samples into one Complex
+/// stream per channel. With one channel, out[0] may be the input buffer
+/// itself.
+template <typename T, std::size_t Channels = 1>
+void convert_frames(const unsigned char* in, std::size_t frames, const std::array<Complex*, Channels>& out) noexcept
+{
+    Complex tmp[Channels][kernel_chunk];
+    for (std::size_t end = frames; end > 0;) {
+        const std::size_t begin = end > kernel_chunk ? end - kernel_chunk : 0;
+        const unsigned char* src = in + begin * Channels * sizeof(T);
+        for (std::size_t k = 0; k < end - begin; ++k)
+            for (std::size_t c = 0; c < Channels; ++c)
+                tmp[c][k] = SampleTraits<T>::load(src + (k * Channels + c) * sizeof(T));
+        for (std::size_t c = 0; c < Channels; ++c)
+            std::memcpy(out[c] + begin, tmp[c], (end - begin) * sizeof(Complex));
+        end = begin;
+    }
+}
+
+/// Conversion fused with a mix: out[c][k] = in[k][c] * lo[k]. With one
+/// channel, out[0] may be the input buffer itself.
+template <typename T, std::size_t Channels = 1>
+void mix_frames(const unsigned char* in, std::size_t frames, const Complex* lo,
+                const std::array<Complex*, Channels>& out) noexcept
+{
+    Complex tmp[Channels][kernel_chunk];
+    for (std::size_t end = frames; end > 0;) {
+        const std::size_t begin = end > kernel_chunk ? end - kernel_chunk : 0;
+        const unsigned char* src = in + begin * Channels * sizeof(T);
+        const Complex* w = lo + begin;
+        for (std::size_t k = 0; k < end - begin; ++k)
+            for (std::size_t c = 0; c < Channels; ++c) {
+                const Complex x = SampleTraits<T>::load(src + (k * Channels + c) * sizeof(T));
+                // Spelled out, like the FFT butterflies: std::complex
+                // operator* carries NaN handling that blocks vectorisation.
+                tmp[c][k] = {x.real() * w[k].real() - x.imag() * w[k].imag(),
+                             x.real() * w[k].imag() + x.imag() * w[k].real()};
+            }
+        for (std::size_t c = 0; c < Channels; ++c)
+            std::memcpy(out[c] + begin, tmp[c], (end - begin) * sizeof(Complex));
+        end = begin;
+    }
+}
+
+/// Mean |x|^2 of each channel over frames raw frames (unit full scale).
+template <typename T, std::size_t Channels = 1>
+std::array<double, Channels> mean_power(const unsigned char* in, std::size_t frames) noexcept
+{
+    std::array<double, Channels> power{};
+    if (frames == 0)
+        return power;
+    for (std::size_t k = 0; k < frames; ++k)
+        for (std::size_t c = 0; c < Channels; ++c)
+            power[c] += std::norm(SampleTraits<T>::load(in + (k * Channels + c) * sizeof(T)));
+    for (double& p : power)
+        p /= static_cast<double>(frames);
+    return power;
+}
+
+} // namespace mprp
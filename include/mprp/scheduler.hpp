@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace mprp {
+
+using Clock = std::chrono::system_clock;
+using TimePoint = std::chrono::time_point<Clock, std::chrono::nanoseconds>;
+
+/// A concrete transmit opportunity.
+struct SlotPlan {
+    std::int64_t index;   ///< Slots since the Unix epoch.
+    TimePoint start;      ///< Transmission start (slot start + offset).
+    std::size_t entry;    ///< Beacon entry keyed in this slot.
+};
+
+/// Maps wall-clock time onto epoch-aligned slots and rotates the beacon
+/// entries round-robin across them, so every node sharing a schedule picks
+/// the same entry for the same slot.
+class SlotClock {
+public:
+    SlotClock(double period_s, double offset_s, std::size_t entries);
+
+    /// The slot with the given index.
+    SlotPlan at(std::int64_t index) const noexcept;
+
+    /// The first slot whose transmission start is not before now.
+    SlotPlan next(TimePoint now) const noexcept;
+
+    std::chrono::nanoseconds period() const noexcept { return period_; }
+
+private:
+    std::chrono::nanoseconds period_;
+    std::chrono::nanoseconds offset_;
+    std::size_t entries_;
+};
+
+} // namespace mprp
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "mprp/fft.hpp"
+#include "mprp/rx_pipeline.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace mprp {
+
+/// A beacon channel watched inside the monitored band.
+struct SpectrumChannel {
+    std::string name;
+    double offset_hz = 0.0;     ///< Relative to the capture centre.
+    double bandwidth_hz = 200.0;
+};
+
+/// Peak and noise inside one channel for one transform.
+struct ChannelReading {
+    std::size_t channel;
+    double peak_hz;   ///< Interpolated peak, relative to the capture centre.
+    double peak_db;   ///< dBFS for a complex tone of unit amplitude.
+    double noise_db;  ///< Median bin power in the channel, same scale.
+    double snr_db;    ///< peak_db - noise_db, per-bin bandwidth.
+};
+
+/// One transform's output. The spans point into the monitor's arena and
+/// stay valid only until the next frame.
+struct SpectrumFrame {
+    std::uint64_t index;
+    std::uint64_t first_sample;        ///< Stream position of the frame start.
+    std::span<const float> power_db;   ///< fft_size bins, -fs/2 first.
+    std::span<const ChannelReading> channels;
+};
+
+struct SpectrumConfig {
+    double sample_rate = 48000.0;
+    std::size_t fft_size = 4096;       ///< Power of two.
+    std::size_t hop = 0;               ///< Samples between frames; 0 means fft_size / 2.
+    Window window = Window::BlackmanHarris;
+    std::size_t history_rows = 64;     ///< Waterfall rows kept.
+    std::vector<SpectrumChannel> channels;
+};
+
+/// Waterfall engine reading every watched beacon channel from one shared
+/// transform per frame.
+///
+/// Plans and windows come from the process-wide caches; every buffer
+/// (overlap carry, FFT work area, waterfall rows, readings) is allocated
+/// at construction, so push() never allocates. A large input block is
+/// turned into as many overlapped frames as it contains in one call.
+class SpectrumMonitor {
+public:
+    using Callback = std::function<void(const SpectrumFrame&)>;
+
+    explicit SpectrumMonitor(SpectrumConfig config, Callback callback = {});
+
+    /// Feeds samples; returns the number of frames transformed.
+    std::size_t push(std::span<const Complex> samples);
+
+    const SpectrumConfig& config() const noexcept { return config_; }
+    double bin_hz() const noexcept { return config_.sample_rate / static_cast<double>(n_); }
+    std::uint64_t frames() const noexcept { return frames_; }
+
+    /// Waterfall row `age` frames old (0 = newest); requires age < rows().
+    std::span<const float> row(std::size_t age = 0) const noexcept;
+    std::size_t rows() const noexcept;
+
+    /// Readings of the newest frame.
+    std::span<const ChannelReading> readings() const noexcept { return readings_; }
+
+private:
+    void transform_frame(std::span<const Complex> carry, std::span<const Complex> fresh);
+    void read_channels(const float* power);
+
+    SpectrumConfig config_;
+    Callback callback_;
+    std::size_t n_;
+    std::size_t hop_;
+    std::shared_ptr<const FftPlan> plan_;
+    std::shared_ptr<const WindowTable> window_;
+    float scale_db_;
+
+    std::vector<Complex> carry_;
+    std::size_t carry_size_ = 0;
+    std::uint64_t consumed_ = 0;    ///< Stream samples seen.
+    std::uint64_t next_frame_ = 0;  ///< Stream position of the next frame.
+    std::uint64_t frames_ = 0;
+
+    std::vector<Complex> work_;
+    std::vector<float> waterfall_;
+    std::vector<ChannelReading> readings_;
+    std::vector<std::pair<std::size_t, std::size_t>> channel_bins_;
+    std::vector<float> scratch_;
+};
+
+/// Pipeline stage feeding a SpectrumMonitor; blocks pass through unchanged.
+class SpectrumStage final : public Stage {
+public:
+    SpectrumStage(SpectrumConfig config, SpectrumMonitor::Callback callback);
+    const char* name() const noexcept override { return "spectrum"; }
+    void process(BufferRef block, const Emitter& emit) override;
+
+    const SpectrumMonitor& monitor() const noexcept { return monitor_; }
+
+private:
+    SpectrumMonitor monitor_;
+};
+
+} // namespace mprp
@@ -0,0 +1,179 @@
+#pragma once
+
+// Append-only binary log of receive spots and transmit telemetry (.mprplog).
+//
+//   header   128 bytes   magic, version, record size, creation time
+//   record   128 bytes   LogRecord, repeated; never rewritten
+//
+// Records are fixed size and self-checking, so a reader maps the file and
+// indexes it directly, and a torn tail from a crash is simply the part
+// past the last whole record. Writes are group-committed: append() only
+// queues, and a background thread writes everything queued in one write()
+// plus fdatasync() every commit interval, instead of one flushed text line
+// per event.
+
+#include "mprp/config.hpp"
+#include "mprp/scheduler.hpp"
+#include "mprp/timing.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace mprp {
+
+struct WsprSpot;
+
+enum class LogKind : std::uint16_t {
+    Spot = 1,  ///< A decoded transmission heard by this node.
+    Tx = 2,    ///< A transmission this node keyed.
+};
+
+const char* to_string(LogKind kind) noexcept;
+
+/// One log entry, stored verbatim (little endian). Text fields are
+/// NUL-padded and not necessarily NUL-terminated at full length.
+struct LogRecord {
+    std::int64_t time_unix_ns;  ///< Spot: slot start. Tx: transmission start.
+    std::uint64_t sequence;     ///< Record number within the log, from 0.
+    LogKind kind;
+    std::uint16_t entry;        ///< Tx: beacon entry index.
+    std::int16_t power_dbm;     ///< Reported (spot) or sent (tx) WSPR power.
+    std::uint8_t mode;          ///< Mode.
+    std::uint8_t lock;          ///< Tx: TimeLock at the start.
+    double freq_hz;             ///< Spot: dial + audio offset. Tx: audio centre.
+    float snr_db;
+    float drift_hz;
+    float dt_s;
+    float sync;
+    float late_us;              ///< Tx: start error.
+    std::uint32_t samples;      ///< Tx: rendered samples.
+    char callsign[16];
+    char grid[8];
+    char name[32];              ///< Tx: entry name.
+    std::uint8_t reserved[12];
+    std::uint32_t checksum;     ///< Low half of Fnv1a over the bytes before it.
+
+    std::string_view callsign_view() const noexcept;
+    std::string_view grid_view() const noexcept;
+    std::string_view name_view() const noexcept;
+    TimePoint time() const noexcept { return TimePoint(std::chrono::nanoseconds(time_unix_ns)); }
+};
+static_assert(sizeof(LogRecord) == 128);
+
+/// Record for a decoded spot; dial_hz is added to the spot's
+/// stream-relative frequency.
+LogRecord spot_record(const WsprSpot& spot, double dial_hz = 0.0) noexcept;
+
+/// Record for a keyed transmission.
+LogRecord tx_record(const SlotPlan& plan, const BeaconEntry& entry, TimeLock lock, std::chrono::nanoseconds late,
+                    std::size_t samples) noexcept;
+
+struct SpotLogOptions {
+    /// Upper bound on how long an appended record waits before it's durable.
+    std::chrono::milliseconds commit_interval{1000};
+    /// Commit early once this many records are queued.
+    std::size_t batch_records = 256;
+    /// Records queued beyond this are dropped (counted) rather than letting
+    /// a stalled disk grow memory.
+    std::size_t max_queued = 65536;
+    bool sync = true;  ///< fdatasync() after every commit.
+};
+
+/// Appends to a log, creating it if needed. An existing log is continued
+/// after its last whole record (a torn tail is cut off). Thread-safe.
+class SpotLogWriter {
+public:
+    /// Throws std::runtime_error if the file can't be opened or isn't a log.
+    explicit SpotLogWriter(const std::string& path, SpotLogOptions options = {});
+    /// Commits what's queued and stops the commit thread.
+    ~SpotLogWriter();
+
+    SpotLogWriter(const SpotLogWriter&) = delete;
+    SpotLogWriter& operator=(const SpotLogWriter&) = delete;
+
+    /// Queues a record (sequence and checksum are filled in); never waits
+    /// for I/O. Returns false if the queue was full and the record dropped.
+    bool append(LogRecord record);
+
+    /// Writes and syncs everything queued so far before returning.
+    void flush();
+
+    std::uint64_t records() const noexcept { return next_sequence_.load(std::memory_order_relaxed); }
+    std::uint64_t commits() const noexcept { return commits_.load(std::memory_order_relaxed); }
+    std::uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+    /// Commits that failed to write; their records are lost (a partial
+    /// write is cut back off, so the log stays whole records).
+    std::uint64_t errors() const noexcept { return errors_.load(std::memory_order_relaxed); }
+
+private:
+    void commit_loop();
+    void commit(std::vector<LogRecord>& batch) noexcept;
+
+    SpotLogOptions options_;
+    int fd_ = -1;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable committed_;
+    std::vector<LogRecord> queue_;
+    std::uint64_t queued_total_ = 0;     ///< Records ever queued (for flush()).
+    std::uint64_t committed_total_ = 0;  ///< Records ever taken by a commit.
+    bool flush_requested_ = false;
+    bool stopping_ = false;
+    std::atomic<std::uint64_t> next_sequence_{0};
+    std::atomic<std::uint64_t> commits_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<std::uint64_t> errors_{0};
+    std::thread thread_;
+};
+
+/// Read-only mapping of a log. Records appended after opening are not seen.
+class SpotLogReader {
+public:
+    /// Throws std::runtime_error if the file can't be mapped or isn't a log.
+    explicit SpotLogReader(const std::string& path);
+    ~SpotLogReader();
+
+    SpotLogReader(const SpotLogReader&) = delete;
+    SpotLogReader& operator=(const SpotLogReader&) = delete;
+
+    /// Every whole record, in append order.
+    std::span<const LogRecord> records() const noexcept { return records_; }
+    std::int64_t created_unix_ns() const noexcept { return created_unix_ns_; }
+
+    /// First record at or after t (records are appended in time order per
+    /// writer, so this is a binary search).
+    std::size_t find(TimePoint t) const noexcept;
+
+private:
+    const unsigned char* base_ = nullptr;
+    std::size_t length_ = 0;
+    std::span<const LogRecord> records_;
+    std::int64_t created_unix_ns_ = 0;
+};
+
+/// True if the record's checksum matches.
+bool verify(const LogRecord& record) noexcept;
+/// Fills in the checksum, as SpotLogWriter::append() does.
+void seal(LogRecord& record) noexcept;
+
+enum class ExportFormat {
+    Csv,   ///< Header line, then one line per record.
+    Json,  ///< One JSON object per line.
+};
+
+/// Writes records as text; returns how many were written. Records failing
+/// verify() are skipped.
+std::size_t export_records(std::span<const LogRecord> records, ExportFormat format, std::FILE* out);
+
+} // namespace mprp
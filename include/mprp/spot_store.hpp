@@ -0,0 +1,172 @@
+#pragma once
+
+// Columnar store of receive spots for propagation queries (.mprpdb), built
+// from one or more spot logs (mprp/spot_log.hpp).
+//
+//   header    256 bytes    magic, version, counts, section table, checksum
+//   sections  64-byte aligned: one array per column, the block zone maps,
+//             the callsign and grid dictionaries
+//
+// Spots are sorted into time clusters (a UTC day by default), within a
+// cluster by band and then callsign, and cut into blocks of block_rows
+// rows. Each column is a plain array over all rows: time and frequency as
+// stored in the log, callsigns and grids as indices into sorted
+// dictionaries. Per block, a zone map keeps the minimum and maximum of the
+// filtered columns; the clustering keeps those ranges narrow, so a block
+// holds one or two bands and a slice of the alphabet. A query
+// binary-searches the blocks of its time range, skips blocks whose zone
+// map rules the filter out and tests only the columns a block's zone map
+// does not already settle, with vector compare kernels that produce a
+// match bitmask per 64 rows. A callsign not in the dictionary answers
+// without touching a block.
+//
+// The store is derived data: the header, zone maps and dictionaries are
+// checksummed, the columns are not, and a store from another version is
+// rebuilt from the logs rather than converted.
+
+#include "mprp/cpu.hpp"
+#include "mprp/spot_log.hpp"
+#include "mprp/timing.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mprp {
+
+struct SpotStoreOptions {
+    std::size_t block_rows = 1024;  ///< Rows per block; a multiple of 64.
+    /// Time cluster; shorter suits stores queried over hours, longer ones
+    /// spanning years.
+    std::chrono::seconds cluster{86400};
+};
+
+struct SpotStoreBuildStats {
+    std::size_t logs = 0;
+    std::size_t records = 0;     ///< Read from the logs, of any kind.
+    std::size_t invalid = 0;     ///< Failing their checksum; skipped.
+    std::size_t duplicates = 0;  ///< Spots present in more than one log (or twice in one).
+    std::size_t spots = 0;       ///< Rows stored.
+    std::size_t blocks = 0;
+    std::size_t callsigns = 0;
+};
+
+/// Builds a store at path from the spot records of logs (Tx records are
+/// left out), replacing it atomically (temporary file plus rename).
+/// Identical spots read from overlapping logs are stored once. Throws
+/// std::runtime_error if a log can't be read or the store can't be
+/// written, std::invalid_argument for a bad block_rows.
+SpotStoreBuildStats build_spot_store(std::span<const std::string> logs, const std::string& path,
+                                     SpotStoreOptions options = {});
+
+/// Filters of a query; unset fields match everything. Ranges are half-open.
+struct SpotQuery {
+    std::optional<TimePoint> from;
+    std::optional<TimePoint> to;
+    std::optional<double> min_hz;  ///< Spot frequency (dial + audio offset).
+    std::optional<double> max_hz;
+    std::string callsign;  ///< Exact, case-insensitive; empty for any.
+    std::optional<double> min_snr_db;
+};
+
+/// Sets min_hz and max_hz to an amateur band by name ("20m", "630m", ...,
+/// IARU edges); false, leaving query alone, for an unknown name.
+bool set_band(SpotQuery& query, std::string_view band);
+
+struct SpotQueryStats {
+    std::size_t blocks = 0;   ///< In the query's time range.
+    std::size_t pruned = 0;   ///< Of those, ruled out by their zone map.
+    std::size_t scanned = 0;  ///< Rows of blocks whose columns had to be tested.
+    std::size_t matched = 0;
+};
+
+/// Read-only mapping of a store. Thread-safe.
+class SpotStore {
+public:
+    /// Throws std::runtime_error if the file can't be mapped, isn't a
+    /// store of this version, fails its checksum or has a callsign or grid
+    /// index past its dictionary.
+    explicit SpotStore(const std::string& path);
+    ~SpotStore();
+
+    SpotStore(const SpotStore&) = delete;
+    SpotStore& operator=(const SpotStore&) = delete;
+
+    std::size_t rows() const noexcept { return rows_; }
+    std::size_t blocks() const noexcept { return zones_.size(); }
+    std::size_t block_rows() const noexcept { return block_rows_; }
+    std::size_t callsigns() const noexcept { return calls_.count; }
+
+    /// Rows matching query, in time order. isa picks the scan kernels
+    /// (scalar if unsupported).
+    std::vector<std::size_t> query(const SpotQuery& query, SpotQueryStats* stats = nullptr,
+                                   Isa isa = best_isa()) const;
+
+    TimePoint time(std::size_t row) const noexcept { return TimePoint(std::chrono::nanoseconds(time_[row])); }
+    double freq_hz(std::size_t row) const noexcept { return freq_[row]; }
+    std::string_view callsign(std::size_t row) const noexcept { return calls_.at(call_[row]); }
+    std::string_view grid(std::size_t row) const noexcept { return grids_.at(grid_[row]); }
+
+    /// The row as a spot log record (sequence = row, checksum filled in),
+    /// e.g. for export_records().
+    LogRecord record(std::size_t row) const noexcept;
+
+    /// Per-block minimum and maximum of the filtered columns.
+    struct Zone {
+        std::int64_t min_time_ns;
+        std::int64_t max_time_ns;
+        double min_hz;
+        double max_hz;
+        std::uint32_t min_call;
+        std::uint32_t max_call;
+        float min_snr_db;
+        float max_snr_db;
+    };
+    /// Block i covers rows [i * block_rows(), (i + 1) * block_rows()),
+    /// which are in storage (not time) order.
+    std::span<const Zone> zones() const noexcept { return zones_; }
+
+private:
+    struct Filter;
+
+    struct Dictionary {
+        const std::uint32_t* offsets = nullptr;  ///< count + 1 entries into text.
+        const char* text = nullptr;
+        std::uint32_t count = 0;
+
+        std::string_view at(std::uint32_t id) const noexcept
+        {
+            return {text + offsets[id], offsets[id + 1] - offsets[id]};
+        }
+        /// Index of s, or count if absent.
+        std::uint32_t find(std::string_view s) const noexcept;
+    };
+
+    void scan(std::size_t block, const Filter& filter, std::vector<std::size_t>& out, SpotQueryStats& stats) const;
+
+    const unsigned char* base_ = nullptr;
+    std::size_t length_ = 0;
+    std::size_t rows_ = 0;
+    std::size_t block_rows_ = 0;
+    std::int64_t cluster_ns_ = 0;
+    const std::int64_t* time_ = nullptr;
+    const double* freq_ = nullptr;
+    const std::uint32_t* call_ = nullptr;
+    const std::uint32_t* grid_ = nullptr;
+    const float* snr_ = nullptr;
+    const float* drift_ = nullptr;
+    const float* dt_ = nullptr;
+    const float* sync_ = nullptr;
+    const std::int16_t* power_ = nullptr;
+    const std::uint8_t* mode_ = nullptr;
+    std::span<const Zone> zones_;
+    Dictionary calls_;
+    Dictionary grids_;
+};
+
+} // namespace mprp
@@ -0,0 +1,96 @@
+#pragma once
+
+// Asynchronous spot reporting. Decoders hand spots to SpotUploader::submit(),
+// which only queues; a coroutine on the control-plane event loop (see
+// mprp/event_loop.hpp) gathers them into batches and posts each batch as
+// one request (WSPRnet's spot-file upload), over a kept-alive HTTP
+// connection, retrying transient failures with exponential backoff. A slow
+// or absent network therefore never reaches the decode threads: at worst
+// the bounded queue fills and further spots are dropped and counted.
+
+#include "mprp/event_loop.hpp"
+#include "mprp/spot_log.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <string>
+
+namespace mprp {
+
+struct SpotUploadOptions {
+    std::string host = "wsprnet.org";
+    std::uint16_t port = 80;
+    std::string path = "/meptspots.php";
+    std::string reporter_call;  ///< Receiving station, sent with every batch.
+    std::string reporter_grid;
+
+    std::size_t batch_spots = 200;  ///< Post as soon as this many are queued...
+    /// ...or once the oldest queued spot has waited this long (a WSPR slot's
+    /// spots arrive together, so this mostly groups one slot per request).
+    std::chrono::milliseconds batch_delay{5000};
+    std::size_t max_queued = 4096;  ///< Spots beyond this are dropped.
+
+    std::chrono::milliseconds retry_initial{1000};  ///< First backoff; doubles per failure.
+    std::chrono::milliseconds retry_max{60000};
+    unsigned max_attempts = 6;  ///< Per batch, including the first.
+    std::chrono::milliseconds timeout{15000};  ///< Connect, send and receive, each.
+    EventLoop* loop = nullptr;  ///< Where the upload runs; default control_loop().
+};
+
+/// Queues spots and uploads them in batches from an event-loop coroutine.
+/// Thread-safe, but not to be used from the loop's own thread (flush()
+/// and the destructor wait for the loop).
+class SpotUploader {
+public:
+    /// Throws std::invalid_argument without a reporter call and grid.
+    explicit SpotUploader(SpotUploadOptions options);
+    /// Makes one last attempt at what's queued (no backoff) and stops.
+    ~SpotUploader();
+
+    SpotUploader(const SpotUploader&) = delete;
+    SpotUploader& operator=(const SpotUploader&) = delete;
+
+    /// Queues a spot record (other kinds are ignored); never blocks on I/O.
+    /// Returns false if the queue was full and the spot dropped.
+    bool submit(const LogRecord& spot);
+    void submit(std::span<const LogRecord> spots);
+
+    /// Waits until the queue is empty and no batch is in flight, or timeout;
+    /// returns true if everything was posted or given up on.
+    bool flush(std::chrono::milliseconds timeout);
+
+    std::uint64_t sent() const noexcept { return sent_.load(std::memory_order_relaxed); }      ///< Spots accepted by the server.
+    std::uint64_t batches() const noexcept { return batches_.load(std::memory_order_relaxed); } ///< Successful requests.
+    std::uint64_t retries() const noexcept { return retries_.load(std::memory_order_relaxed); }
+    std::uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); } ///< Queue full.
+    std::uint64_t failed() const noexcept { return failed_.load(std::memory_order_relaxed); }   ///< Spots given up on.
+    std::uint64_t connections() const noexcept { return connections_.load(std::memory_order_relaxed); }
+
+private:
+    Task<void> run();
+
+    SpotUploadOptions options_;
+    EventLoop& loop_;
+    AsyncEvent wake_;
+    std::mutex mutex_;
+    std::condition_variable idle_;
+    std::deque<LogRecord> queue_;
+    std::chrono::steady_clock::time_point oldest_{};
+    bool busy_ = false;      ///< A batch is in flight.
+    bool flushing_ = false;  ///< flush() is waiting: post without batch_delay.
+    bool stopping_ = false;
+    bool done_ = false;      ///< run() has returned.
+    std::atomic<std::uint64_t> sent_{0};
+    std::atomic<std::uint64_t> batches_{0};
+    std::atomic<std::uint64_t> retries_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<std::uint64_t> failed_{0};
+    std::atomic<std::uint64_t> connections_{0};
+};
+
+} // namespace mprp
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+namespace mprp {
+
+/// Size used to keep producer- and consumer-owned state on separate lines.
+inline constexpr std::size_t cache_line_size = 64;
+
+/// Lock-free single-producer / single-consumer ring of trivially copyable
+/// samples, e.g. between the modulator thread and a sound card or SDR
+/// callback.
+///
+/// Both sides work on spans into the ring itself: the producer asks for
+/// writable space, fills it and commits; the consumer asks for readable
+/// data, consumes it and releases. Neither side blocks or allocates after
+/// construction. Because the storage wraps, a request returns up to two
+/// spans (the second covers the part after the wrap).
+///
+/// Indices are free-running 64-bit counters, so full and empty never
+/// alias and no slot is wasted.
+template <typename T>
+class SpscRing {
+    static_assert(std::is_trivially_copyable_v<T>, "ring elements are copied with memcpy");
+
+public:
+    /// Two contiguous pieces of the ring; second is empty unless the
+    /// region wraps.
+    template <typename U>
+    struct Region {
+        std::span<U> first;
+        std::span<U> second;
+
+        std::size_t size() const noexcept { return first.size() + second.size(); }
+        bool empty() const noexcept { return size() == 0; }
+    };
+
+    /// capacity is rounded up to a power of two.
+    explicit SpscRing(std::size_t capacity)
+        : capacity_(round_up(capacity)),
+          mask_(capacity_ - 1),
+          data_(std::make_unique<T[]>(capacity_))
+    {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    // ---- producer side ------------------------------------------------
+
+    /// Free space available to the producer, up to max elements.
+    Region<T> write_region(std::size_t max = SIZE_MAX) noexcept
+    {
+        const std::uint64_t w = producer_.index.load(std::memory_order_relaxed);
+        std::uint64_t r = producer_.cached_other;
+        if (capacity_ - (w - r) < std::min<std::uint64_t>(max, capacity_)) {
+            r = consumer_.index.load(std::memory_order_acquire);
+            producer_.cached_other = r;
+        }
+        return split<T>(w, std::min<std::uint64_t>(capacity_ - (w - r), max));
+    }
+
+    /// Publishes n elements written into the last write_region().
+    void commit(std::size_t n) noexcept
+    {
+        const std::uint64_t w = producer_.index.load(std::memory_order_relaxed);
+        producer_.index.store(w + n, std::memory_order_release);
+    }
+
+    /// Copies as much of src as fits; the rest is counted as overrun.
+    /// Returns the number of elements accepted.
+    std::size_t push(std::span<const T> src) noexcept
+    {
+        const auto region = write_region(src.size());
+        copy_in(region, src);
+        commit(region.size());
+        if (region.size() < src.size())
+            overruns_.fetch_add(src.size() - region.size(), std::memory_order_relaxed);
+        return region.size();
+    }
+
+    // ---- consumer side ------------------------------------------------
+
+    /// Data available to the consumer, up to max elements.
+    Region<const T> read_region(std::size_t max = SIZE_MAX) noexcept
+    {
+        const std::uint64_t r = consumer_.index.load(std::memory_order_relaxed);
+        std::uint64_t w = consumer_.cached_other;
+        if (w - r < std::min<std::uint64_t>(max, capacity_)) {
+            w = producer_.index.load(std::memory_order_acquire);
+            consumer_.cached_other = w;
+        }
+        return split<const T>(r, std::min<std::uint64_t>(w - r, max));
+    }
+
+    /// Frees n elements obtained from the last read_region().
+    void release(std::size_t n) noexcept
+    {
+        const std::uint64_t r = consumer_.index.load(std::memory_order_relaxed);
+        consumer_.index.store(r + n, std::memory_order_release);
+    }
+
+    /// Fills dst from the ring. Any shortfall is counted as underrun and,
+    /// when fill_silence is set, padded with value-initialised elements so
+    /// an audio callback always hands back a full buffer.
+    std::size_t pop(std::span<T> dst, bool fill_silence = true) noexcept
+    {
+        const auto region = read_region(dst.size());
+        std::size_t n = 0;
+        for (auto part : {region.first, region.second}) {
+            std::copy(part.begin(), part.end(), dst.begin() + n);
+            n += part.size();
+        }
+        release(n);
+        if (n < dst.size()) {
+            underruns_.fetch_add(dst.size() - n, std::memory_order_relaxed);
+            if (fill_silence)
+                std::fill(dst.begin() + n, dst.end(), T{});
+        }
+        return n;
+    }
+
+    // ---- either side --------------------------------------------------
+
+    /// Elements currently queued (a snapshot; exact only on the calling side).
+    std::size_t size() const noexcept
+    {
+        return static_cast<std::size_t>(producer_.index.load(std::memory_order_acquire)
+                                        - consumer_.index.load(std::memory_order_acquire));
+    }
+
+    /// Elements the consumer wanted but the ring did not have.
+    std::uint64_t underruns() const noexcept { return underruns_.load(std::memory_order_relaxed); }
+
+    /// Elements the producer offered but the ring could not hold.
+    std::uint64_t overruns() const noexcept { return overruns_.load(std::memory_order_relaxed); }
+
+    /// Records a consumer shortfall when the caller did its own read_region().
+    void note_underrun(std::size_t n) noexcept { underruns_.fetch_add(n, std::memory_order_relaxed); }
+
+    /// Records a dropped producer block when the caller did its own write_region().
+    void note_overrun(std::size_t n) noexcept { overruns_.fetch_add(n, std::memory_order_relaxed); }
+
+private:
+    // Each side's index plus its cached copy of the other side's index,
+    // so the common case touches only lines the side already owns.
+    struct alignas(cache_line_size) Side {
+        std::atomic<std::uint64_t> index{0};
+        std::uint64_t cached_other = 0;
+    };
+
+    static std::size_t round_up(std::size_t n)
+    {
+        if (n == 0 || n > (std::size_t{1} << 62))
+            throw std::invalid_argument("SpscRing capacity out of range");
+        std::size_t c = 1;
+        while (c < n)
+            c <<= 1;
+        return c;
+    }
+
+    template <typename U>
+    Region<U> split(std::uint64_t at, std::uint64_t n) const noexcept
+    {
+        const std::size_t begin = static_cast<std::size_t>(at) & mask_;
+        const std::size_t first = std::min<std::size_t>(static_cast<std::size_t>(n), capacity_ - begin);
+        return {{data_.get() + begin, first},
+                {data_.get(), static_cast<std::size_t>(n) - first}};
+    }
+
+    static void copy_in(const Region<T>& region, std::span<const T> src) noexcept
+    {
+        std::copy_n(src.begin(), region.first.size(), region.first.begin());
+        std::copy_n(src.begin() + region.first.size(), region.second.size(), region.second.begin());
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    const std::unique_ptr<T[]> data_;
+
+    Side producer_;
+    Side consumer_;
+    alignas(cache_line_size) std::atomic<std::uint64_t> underruns_{0};
+    std::atomic<std::uint64_t> overruns_{0};
+};
+
+} // namespace mprp
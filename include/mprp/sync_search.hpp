@@ -0,0 +1,75 @@
+#pragma once
+
+// The WSPR sync-correlation grid search, behind a backend interface so it
+// can run on an accelerator.
+//
+// A search hands the backend one spectrogram tile (every column its window
+// can use, unwrapped from the ring) and a batch of queries, each a box of
+// bins x lags x drifts; the backend returns only the best-correlating cell
+// of each box. The CPU backend is the reference. The OpenCL backend
+// uploads the tile once per batch, reduces every box on the device and
+// reads back one hit per query; it is chosen with SearchDevice::OpenCl
+// and falls back to the CPU when the OpenCL runtime or a GPU is missing,
+// or a device call fails.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace mprp {
+
+enum class SearchDevice {
+    Cpu,
+    OpenCl,  ///< A GPU or accelerator through OpenCL, else the CPU.
+};
+
+const char* to_string(SearchDevice device) noexcept;
+
+/// Power spectrogram columns for one window.
+struct SyncTile {
+    std::span<const float> power;  ///< Columns x width, row-major.
+    std::size_t width = 0;         ///< Bins per column.
+    std::size_t steps = 1;         ///< Columns per symbol.
+    std::ptrdiff_t lag_origin = 0; ///< Lag of the tile's first column.
+    /// Bin offset of every symbol for each drift step: (2 drift_steps + 1)
+    /// rows of 162, drift -drift_steps first.
+    std::span<const std::int16_t> offsets;
+    std::ptrdiff_t drift_steps = 0;
+};
+
+/// Inclusive ranges of tone-0 bin, lag (in columns) and drift step. Every
+/// cell must keep its tones inside the tile.
+struct SyncQuery {
+    std::ptrdiff_t bin_lo, bin_hi;
+    std::ptrdiff_t lag_lo, lag_hi;
+    std::ptrdiff_t drift_lo, drift_hi;
+};
+
+/// Best cell of a query. Ties go to the first cell in drift, bin, lag
+/// order; sync is -1 for an empty query.
+struct SyncHit {
+    std::ptrdiff_t bin;
+    std::ptrdiff_t lag;
+    std::ptrdiff_t drift;
+    double sync;
+};
+
+class SyncSearchBackend {
+public:
+    virtual ~SyncSearchBackend() = default;
+    virtual const char* name() const noexcept = 0;
+
+    /// Fills hits[i] with the best cell of queries[i]; hits.size() >=
+    /// queries.size().
+    virtual void search(const SyncTile& tile, std::span<const SyncQuery> queries, std::span<SyncHit> hits) = 0;
+};
+
+/// The reference search on the calling thread.
+void sync_search_cpu(const SyncTile& tile, std::span<const SyncQuery> queries, std::span<SyncHit> hits) noexcept;
+
+/// A backend for device; never null (the CPU one when device is
+/// unavailable).
+std::unique_ptr<SyncSearchBackend> make_sync_backend(SearchDevice device);
+
+} // namespace mprp
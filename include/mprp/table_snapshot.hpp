@@ -0,0 +1,65 @@
+#pragma once
+
+// Snapshot of precomputed tables (.mprptab): FFT plans, analysis windows,
+// keying edges and low-pass designs, so a node that reboots maps them
+// instead of recomputing every twiddle and Kaiser tap.
+//
+//   header   64 bytes          magic, version, table format, count, checksum
+//   index    32 bytes / table  kind, key, offset, size; sorted by (kind, key)
+//   data     64-byte aligned table bodies
+//
+// The table builders (fft_plan(), window_table(), raised_cosine_edge(),
+// design_lowpass()) look a table up in the loaded snapshot before
+// computing it, and note every table they do compute; a process that
+// computed anything rewrites the snapshot with save_table_snapshot(). A
+// snapshot from another table format (any generator changed) or failing
+// its checksum is ignored, so a stale file only costs one slow start.
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace mprp {
+
+enum class TableKind : std::uint32_t {
+    FftPlan = 1,       ///< Bit-reversal table, then stage twiddles.
+    Window = 2,        ///< Gains (two doubles), then values.
+    RaisedCosine = 3,  ///< Edge values.
+    Lowpass = 4,       ///< Taps.
+};
+
+/// Maps a snapshot for the table builders to read from. Returns false, and
+/// leaves nothing loaded, if the file is missing, from another version or
+/// table format, or corrupt. The mapping is kept for the process's life.
+bool load_table_snapshot(const std::string& path);
+
+/// Writes every table loaded or computed so far (temporary file plus
+/// rename, so readers never see a partial snapshot). Returns false on an
+/// I/O error.
+bool save_table_snapshot(const std::string& path);
+
+/// True if a table had to be computed since the last successful save (or
+/// since start-up, if there was none), i.e. saving would change the
+/// snapshot.
+bool table_snapshot_dirty() noexcept;
+
+struct TableSnapshotStats {
+    std::size_t loaded = 0;    ///< Tables in the mapped snapshot.
+    std::size_t hits = 0;      ///< Builds served from it.
+    std::size_t computed = 0;  ///< Builds that had to compute.
+};
+
+TableSnapshotStats table_snapshot_stats() noexcept;
+
+namespace detail {
+
+/// A table's bytes from the loaded snapshot, or an empty span.
+std::span<const std::byte> snapshot_table(TableKind kind, std::uint64_t key) noexcept;
+
+/// Records a freshly computed table for the next save.
+void note_table(TableKind kind, std::uint64_t key, std::span<const std::byte> bytes);
+
+} // namespace detail
+
+} // namespace mprp
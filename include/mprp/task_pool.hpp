@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mprp {
+
+class TaskGroup;
+
+/// Work-stealing pool for decode jobs, FFT batches and file tasks.
+///
+/// Each worker owns a deque: it pushes and pops its own tasks at the back
+/// (newest first, cache-warm) and steals from the front of the others when
+/// it runs dry. Tasks submitted from outside the pool go to a shared
+/// injection queue. Waiting on a TaskGroup runs queued tasks instead of
+/// blocking, so nested parallelism never adds threads: at most
+/// workers() + waiting callers are busy, whatever the nesting depth.
+class TaskPool {
+public:
+    /// threads == 0 uses one worker per hardware thread; more than that is
+    /// clamped to it. pin places worker i on core i.
+    explicit TaskPool(std::size_t threads = 0, bool pin = false);
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    std::size_t workers() const noexcept { return queues_.size(); }
+
+    /// Tasks taken from another worker's deque so far.
+    std::uint64_t steals() const noexcept { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    friend class TaskGroup;
+
+    struct Task {
+        std::function<void()> fn;
+        TaskGroup* group = nullptr;
+    };
+
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void push(Task task);
+    bool try_run_one(std::ptrdiff_t self);
+    bool pop_local(std::size_t self, Task& out);
+    bool steal(std::ptrdiff_t self, Task& out);
+    void run(Task& task) noexcept;
+    void worker_loop(std::size_t index, bool pin);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    Queue injected_;
+    std::vector<std::thread> threads_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<std::size_t> sleeping_{0};
+    std::atomic<bool> stopping_{false};
+    std::atomic<std::uint64_t> steals_{0};
+};
+
+/// A set of tasks to wait for together. The first exception a task throws
+/// is rethrown by wait(); the remaining tasks still run.
+class TaskGroup {
+public:
+    explicit TaskGroup(TaskPool& pool) noexcept : pool_(pool) {}
+
+    /// Waits for outstanding tasks (exceptions are dropped here; call
+    /// wait() to see them).
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(std::function<void()> fn);
+
+    /// Runs queued tasks until every task of this group has finished.
+    void wait();
+
+private:
+    friend class TaskPool;
+    void finish(std::exception_ptr error) noexcept;
+
+    TaskPool& pool_;
+    std::atomic<std::uint32_t> pending_{0};
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+};
+
+/// Calls body(begin, end) over [0, n) in chunks of at least grain items,
+/// spread over the pool, and waits. Runs inline when one chunk suffices.
+void parallel_for(TaskPool& pool, std::size_t n, std::size_t grain,
+                  const std::function<void(std::size_t, std::size_t)>& body);
+
+/// Process-wide pool sized to the machine, created on first use.
+TaskPool& default_task_pool();
+
+} // namespace mprp
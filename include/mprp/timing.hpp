@@ -0,0 +1,104 @@
+#pragma once
+
+// Disciplined time for slot starts: where "now" comes from (the kernel clock
+// as steered by NTP/chrony, or a PPS edge), how to wait for an instant
+// precisely, and real-time thread setup for the transmit thread.
+
+#include "mprp/scheduler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace mprp {
+
+enum class TimeLock {
+    Unsynchronised,  ///< Free-running system clock.
+    Ntp,             ///< Kernel clock reported synchronised (ntpd, chrony, gpsd).
+    Pps,             ///< Corrected against a recent PPS edge.
+};
+
+const char* to_string(TimeLock lock) noexcept;
+
+/// A source of UTC on the system_clock timeline.
+class TimeSource {
+public:
+    virtual ~TimeSource() = default;
+
+    virtual TimePoint now() const noexcept = 0;
+
+    /// now() minus CLOCK_REALTIME; sleeps are issued on the system clock
+    /// shifted by this amount.
+    virtual std::chrono::nanoseconds correction() const noexcept = 0;
+
+    virtual TimeLock lock() const noexcept = 0;
+
+    /// Estimated error bound of now(); negative when unknown.
+    virtual std::chrono::nanoseconds uncertainty() const noexcept = 0;
+};
+
+/// CLOCK_REALTIME as disciplined by the NTP daemon; lock and error come
+/// from the kernel's adjtimex() state.
+class SystemTime final : public TimeSource {
+public:
+    TimePoint now() const noexcept override;
+    std::chrono::nanoseconds correction() const noexcept override { return {}; }
+    TimeLock lock() const noexcept override;
+    std::chrono::nanoseconds uncertainty() const noexcept override;
+};
+
+/// Corrects the system clock against a kernel PPS device (/dev/ppsN).
+///
+/// A background thread fetches each assert edge, takes its distance from
+/// the nearest whole second as the clock's offset and smooths it; now() is
+/// CLOCK_REALTIME minus that offset. The system clock must already be
+/// within half a second (NTP or gpsd). Without an edge for a few seconds
+/// the source reports the system clock's own lock and keeps the last
+/// correction.
+class PpsTime final : public TimeSource {
+public:
+    /// Throws std::runtime_error if the device cannot be opened.
+    explicit PpsTime(const std::string& device);
+    ~PpsTime() override;
+
+    PpsTime(const PpsTime&) = delete;
+    PpsTime& operator=(const PpsTime&) = delete;
+
+    TimePoint now() const noexcept override;
+    std::chrono::nanoseconds correction() const noexcept override;
+    TimeLock lock() const noexcept override;
+    std::chrono::nanoseconds uncertainty() const noexcept override;
+
+    std::uint64_t edges() const noexcept { return edges_.load(std::memory_order_relaxed); }
+
+private:
+    void fetch_loop();
+
+    int fd_ = -1;
+    SystemTime system_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<std::int64_t> offset_ns_{0};   ///< CLOCK_REALTIME minus UTC.
+    std::atomic<std::int64_t> jitter_ns_{-1};
+    std::atomic<std::int64_t> last_edge_ns_{0};
+    std::atomic<std::uint64_t> edges_{0};
+    std::thread thread_;
+};
+
+/// Sleeps on the system clock until spin before target, then busy-waits on
+/// time.now() for the remainder. Returns how late now() was when it
+/// returned (zero or a few tens of nanoseconds when the sleep lands in
+/// time, more if the thread was scheduled out).
+std::chrono::nanoseconds wait_until(const TimeSource& time, TimePoint target,
+                                    std::chrono::nanoseconds spin) noexcept;
+
+/// Moves the calling thread to SCHED_FIFO at the given priority (1-99);
+/// 0 leaves the policy alone. Returns false without privilege.
+bool set_realtime_priority(int priority) noexcept;
+
+/// Locks current and future pages into RAM so a real-time thread does not
+/// fault on its first touch of a buffer.
+bool lock_memory() noexcept;
+
+} // namespace mprp
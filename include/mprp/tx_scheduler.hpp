@@ -0,0 +1,167 @@
+#pragma once
+
+#include "mprp/engine.hpp"
+#include "mprp/live_engine.hpp"
+#include "mprp/power.hpp"
+#include "mprp/render_cache.hpp"
+#include "mprp/timing.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace mprp {
+
+struct TxSchedulerOptions {
+    /// Busy-wait window before each slot start.
+    std::chrono::nanoseconds spin = std::chrono::microseconds(500);
+
+    /// A slot is only taken if it starts at least this far ahead; otherwise
+    /// the scheduler skips to the next one rather than start late.
+    std::chrono::nanoseconds lead = std::chrono::milliseconds(200);
+
+    /// SCHED_FIFO priority for the transmit thread (0 = normal scheduling).
+    int realtime_priority = 0;
+
+    /// Core for the transmit thread (-1 = any).
+    int cpu = -1;
+
+    /// mlockall() before the first slot.
+    bool lock_memory = false;
+
+    /// Serve repeated transmissions from this cache instead of re-rendering
+    /// (must outlive the scheduler).
+    RenderCache* cache = nullptr;
+
+    /// Called on the transmit thread as soon as a slot is committed to, at
+    /// least lead before it starts, with the engine version it was planned
+    /// from: where slow transmitter setup (a rig's band, mode and power) is
+    /// queued so that it is done before the edge. Called once per slot;
+    /// again only if a configuration change moves the slot or alters the
+    /// entry keyed in it.
+    std::function<void(const SlotPlan&, const Engine&)> prepare;
+
+    /// Called on the transmit thread key_lead before each slot start, with
+    /// the same sleep-and-spin precision as the start itself, to key the
+    /// transmitter so that it is on the air at the edge.
+    std::function<void(const SlotPlan&)> key;
+    std::chrono::nanoseconds key_lead{0};
+
+    /// Power-aware mode for battery and solar nodes: run() renders every
+    /// entry up front in one burst, then starts slots from those buffers
+    /// with no render thread at all, so between slots the only thread left
+    /// is the transmit thread asleep on its timer. Costs memory for every
+    /// entry's transmission at once.
+    bool low_power = false;
+    /// Threads of the burst (0 = one per hardware thread); never more than
+    /// the hardware threads or the entries to render.
+    std::size_t burst_threads = 0;
+
+    /// Board model for the per-slot energy estimates (recorded in any mode).
+    PowerModel power;
+};
+
+/// One slot being started.
+struct TxSlot {
+    SlotPlan plan;
+    const Engine& engine;   ///< The version the slot was planned from.
+    std::uint64_t version;  ///< Its LiveEngine version (0 for a fixed engine).
+    std::span<const float> samples;
+    std::chrono::nanoseconds late;  ///< time.now() at hand-off minus plan.start.
+    TimeLock lock;
+    /// CPU time and energy of the whole process over the previous slot
+    /// period (from one slot's last sleep to this one's; the first period
+    /// starts in run() and includes any burst). Also recorded as metrics
+    /// power.slot_cpu, power.cpu_us, power.wall_ms and power.energy_mj.
+    PowerSample power;
+};
+
+/// Runs the engine's slot schedule against a disciplined time source.
+///
+/// The next slot is rendered on a helper thread while the current one is
+/// waited for and handed off, so the transmit thread only sleeps, spins
+/// and calls back; the callback runs on the thread that called run(). In
+/// low-power mode everything is rendered before the first slot instead
+/// (TxSchedulerOptions::low_power).
+///
+/// Scheduled from a LiveEngine, the version is checked twice per slot (once
+/// the previous slot is handed off, and again lead before the start): a new
+/// version re-plans the slot from the new rotation, and only entries whose
+/// render_key() changed are rendered again.
+class TxScheduler {
+public:
+    /// Return false from the callback to stop.
+    using Callback = std::function<bool(const TxSlot&)>;
+
+    /// engine (or live) must outlive the scheduler.
+    TxScheduler(const Engine& engine, const TimeSource& time, TxSchedulerOptions options = {});
+    TxScheduler(const LiveEngine& live, const TimeSource& time, TxSchedulerOptions options = {});
+    ~TxScheduler();
+
+    TxScheduler(const TxScheduler&) = delete;
+    TxScheduler& operator=(const TxScheduler&) = delete;
+
+    /// Applies the thread options to the calling thread and starts slots
+    /// until the callback returns false or stop() is called. Throws
+    /// std::runtime_error if SCHED_FIFO or mlockall() was requested but
+    /// refused.
+    void run(const Callback& callback);
+
+    /// Makes run() return before the next slot.
+    void stop() noexcept;
+
+    /// Slots passed over because the previous one overran or the render
+    /// was not ready in time.
+    std::uint64_t skipped() const noexcept { return skipped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Buffer {
+        std::vector<float> samples;               ///< Own render target (no cache).
+        std::shared_ptr<const RenderedBuffer> cached;
+        std::shared_ptr<const Engine> engine;     ///< Version plan is from.
+        SlotPlan plan{};
+        std::uint64_t ticket = 0;  ///< Bumped per request; a render for an older one is dropped.
+        std::size_t size = 0;
+        bool ready = false;
+        bool queued = false;       ///< Requested and not yet taken by the render thread.
+    };
+
+    void render_loop();
+    void request(std::size_t buffer, const SlotPlan& plan);
+    /// Requests plan into buffer unless the buffer already holds (or is
+    /// rendering) the same samples; returns whether it requested.
+    bool want(std::size_t buffer, const SlotPlan& plan);
+    bool wait_ready(std::size_t buffer);
+    bool sleep_until(TimePoint target);
+    std::shared_ptr<const RenderedBuffer> render_entry(const Engine& engine, std::size_t entry) const;
+    void prerender(const Engine* previous);
+    bool stopping();
+    /// Takes the live engine's newest version if it moved; returns the
+    /// version it replaced, or null.
+    std::shared_ptr<const Engine> adopt();
+
+    const LiveEngine* live_ = nullptr;
+    std::shared_ptr<const Engine> engine_;  ///< Used by the transmit thread only.
+    std::uint64_t version_ = 0;
+    const TimeSource& time_;
+    TxSchedulerOptions options_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    Buffer buffers_[2];
+    std::vector<std::shared_ptr<const RenderedBuffer>> prerendered_;  ///< Per entry (low power).
+    std::ptrdiff_t pending_ = -1;  ///< Latest request, filled first when both buffers are queued.
+    bool stopping_ = false;
+    std::atomic<std::uint64_t> skipped_{0};
+    std::thread renderer_;
+};
+
+} // namespace mprp
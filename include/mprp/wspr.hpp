@@ -0,0 +1,100 @@
+#pragma once
+
+#include "mprp/convolutional.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace mprp {
+
+class Arena;
+class TaskPool;
+
+/// Channel symbols in one WSPR transmission.
+inline constexpr std::size_t wspr_symbol_count = 162;
+
+/// 4-FSK tone indices (0..3), sync bit in the LSB.
+using WsprSymbols = std::array<std::uint8_t, wspr_symbol_count>;
+
+/// WSPR air timing: 12000 / 8192 baud, tones spaced by the same amount.
+inline constexpr double wspr_baud = 12000.0 / 8192.0;
+inline constexpr double wspr_tone_spacing_hz = 12000.0 / 8192.0;
+
+/// A standard (type 1) WSPR message.
+struct WsprMessage {
+    std::string_view callsign;  ///< Up to six characters, digit in position 2 or 3.
+    std::string_view grid;      ///< Four-character Maidenhead locator.
+    int power_dbm = 0;          ///< 0..60, last digit 0, 3 or 7.
+};
+
+enum class WsprStatus : std::uint8_t {
+    Ok,
+    BadCallsign,
+    BadGrid,
+    BadPower,
+};
+
+const char* to_string(WsprStatus status) noexcept;
+
+/// Packs a message into its 50 source bits (MSB-first, byte-aligned,
+/// trailing bits zero).
+WsprStatus wspr_pack(const WsprMessage& message, std::array<std::uint8_t, 11>& packed) noexcept;
+
+/// Encodes a message into channel symbols: pack, K=32 r=1/2 convolutional
+/// code, bit-reversal interleave and sync merge. Never allocates; out is
+/// left untouched on failure.
+WsprStatus wspr_encode(const WsprMessage& message, std::span<std::uint8_t, wspr_symbol_count> out) noexcept;
+
+/// Encodes messages[i] into out[i] for every i, e.g. when precomputing a
+/// whole schedule. status, when non-empty, receives each entry's result.
+/// Returns how many messages encoded successfully.
+std::size_t wspr_encode_batch(std::span<const WsprMessage> messages, std::span<WsprSymbols> out,
+                              std::span<WsprStatus> status = {}) noexcept;
+
+// ---- receive side -------------------------------------------------------
+
+/// Energy of each of the four tones in every symbol period, from the
+/// candidate's per-symbol spectra.
+using WsprTonePowers = std::array<std::array<float, 4>, wspr_symbol_count>;
+
+/// Soft channel symbols in air (interleaved) order; see convolutional.hpp
+/// for the sign convention.
+using WsprSoftSymbols = std::array<std::int8_t, wspr_symbol_count>;
+
+/// A decoded standard message; unlike WsprMessage it owns its text.
+struct WsprReport {
+    std::string callsign;
+    std::string grid;
+    int power_dbm = 0;
+};
+
+/// Inverse of wspr_pack. Returns nothing for bits that are not a valid
+/// type 1 message (compound calls and hashed types are not decoded).
+std::optional<WsprReport> wspr_unpack(const std::array<std::uint8_t, 11>& packed);
+
+/// Soft data bits from tone energies: the difference between the two
+/// tones the sync bit allows, scaled to RMS ~50 to match FanoOptions.
+void wspr_soft_symbols(const WsprTonePowers& powers, WsprSoftSymbols& soft) noexcept;
+
+/// Deinterleaves and Fano-decodes one candidate. Returns nothing when the
+/// decoder hits its budget or the bits do not unpack; info, if given,
+/// receives the decoder result either way.
+std::optional<WsprReport> wspr_decode(const WsprSoftSymbols& soft, FanoDecoder& fano,
+                                      DecodeResult* info = nullptr);
+
+/// Decodes candidates[i] into out[i] across the pool, one decoder per
+/// chunk. Decoder state comes from arena when given (the slot's), so the
+/// batch makes no allocator calls per candidate. Returns how many decoded.
+std::size_t wspr_decode_batch(TaskPool& pool, std::span<const WsprSoftSymbols> candidates,
+                              std::span<std::optional<WsprReport>> out, FanoOptions options = {},
+                              Arena* arena = nullptr);
+
+/// The 162-bit WSPR sync vector.
+extern const std::array<std::uint8_t, wspr_symbol_count> wspr_sync_vector;
+
+} // namespace mprp
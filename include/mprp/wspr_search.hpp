@@ -0,0 +1,190 @@
+#pragma once
+
+// WSPR receive chain: a sliding spectrogram of the baseband stream, the
+// per-slot candidate search over it, and a pipeline stage that decodes
+// every slot into spots.
+//
+// Spectrogram columns are computed once, as samples arrive, and kept in a
+// ring one transmission long, so a search only reads columns. Search is
+// incremental: stations found in the previous slot seed a narrow search
+// around their predicted frequency, drift and timing, and the full-band
+// search runs only every full_search_every slots (or when nothing is
+// being tracked).
+
+#include "mprp/arena.hpp"
+#include "mprp/fft.hpp"
+#include "mprp/rx_pipeline.hpp"
+#include "mprp/scheduler.hpp"
+#include "mprp/sync_search.hpp"
+#include "mprp/wspr.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace mprp {
+
+class TaskPool;
+
+struct WsprSearchConfig {
+    /// Complex baseband rate; 375 Hz times a power of two (375 .. 12000),
+    /// so one symbol is a power-of-two number of samples.
+    double sample_rate = 375.0;
+    double min_hz = -150.0;  ///< Search band, relative to the stream centre.
+    double max_hz = 150.0;
+    std::size_t steps_per_symbol = 4;  ///< Spectrogram columns per symbol (timing resolution).
+    double min_lag_s = 0.0;  ///< Transmission start search range, from the window start.
+    double max_lag_s = 4.0;
+    double max_drift_hz = 4.0;  ///< Linear drift over the transmission, both signs.
+    double drift_step_hz = 0.5;
+    double min_sync = 0.2;       ///< Sync correlation (0..1) a candidate needs.
+    double min_snr_db = -33.0;   ///< Spectral peak threshold, 2500 Hz reference.
+    std::size_t max_candidates = 64;
+    unsigned full_search_every = 10;  ///< Slots per full-band search; 1 searches fully every slot.
+    double seed_range_hz = 3.0;       ///< Seeded search half-widths around the prediction.
+    double seed_lag_s = 0.5;
+    double seed_drift_hz = 1.0;
+    /// Where the full-band sync search runs (mprp/sync_search.hpp);
+    /// seeded searches are small and always stay on the CPU.
+    SearchDevice device = SearchDevice::Cpu;
+};
+
+/// A sync-correlated signal in one window.
+struct WsprCandidate {
+    double freq_hz;   ///< Centre of the four tones at mid-transmission, relative to the stream centre.
+    double drift_hz;  ///< Frequency change from first to last symbol.
+    double lag_s;     ///< Transmission start after the window start.
+    double sync;
+    double snr_db;    ///< 2500 Hz reference bandwidth.
+};
+
+/// Sliding spectrogram plus candidate search for one baseband stream.
+/// Long-lived buffers come from resource (default: the process pool);
+/// search() draws its temporaries from the caller's per-slot arena.
+class WsprSearch {
+public:
+    /// Throws std::invalid_argument on an unsupported rate or empty band.
+    explicit WsprSearch(WsprSearchConfig config, std::pmr::memory_resource* resource = nullptr);
+
+    /// Appends samples and computes only the spectrogram columns they
+    /// complete; returns how many.
+    std::size_t push(std::span<const Complex> samples);
+
+    /// True once every column a window starting at stream sample
+    /// window_start can use has been computed and is still in the ring.
+    bool ready(std::uint64_t window_start) const noexcept;
+
+    /// Candidates for the window starting at window_start, strongest
+    /// first; requires ready(window_start). Seeded unless a full search is
+    /// due. The span stays valid until the next search().
+    std::span<const WsprCandidate> search(std::uint64_t window_start, Arena& arena);
+
+    /// Tone energies of every symbol of a candidate from the same window,
+    /// for wspr_soft_symbols().
+    void extract(const WsprCandidate& candidate, std::uint64_t window_start, WsprTonePowers& out) const noexcept;
+
+    /// Replaces the stations tracked into the next slot (by default the
+    /// last search's candidates); callers pass the ones that decoded.
+    void set_seeds(std::span<const WsprCandidate> seeds);
+
+    /// Makes the next search a full one.
+    void request_full_search() noexcept { force_full_ = true; }
+
+    const WsprSearchConfig& config() const noexcept { return config_; }
+    std::size_t symbol_samples() const noexcept { return symbol_; }
+    bool last_search_full() const noexcept { return last_full_; }
+    std::uint64_t columns() const noexcept { return columns_; }
+    std::uint64_t full_searches() const noexcept { return full_searches_; }
+    std::uint64_t seeded_searches() const noexcept { return seeded_searches_; }
+    /// The full search's backend, e.g. "cpu" when OpenCL was asked for
+    /// but is unavailable.
+    const char* backend_name() const noexcept { return backend_->name(); }
+
+private:
+    void transform_column(std::span<const Complex> carry, std::span<const Complex> fresh);
+    const float* column(std::uint64_t index) const noexcept;
+    std::uint64_t first_column(std::uint64_t window_start) const noexcept;
+    WsprCandidate candidate_at(std::uint64_t window_start, std::uint64_t col0, const SyncHit& hit,
+                               std::span<const float> comb, double noise) const noexcept;
+
+    WsprSearchConfig config_;
+    std::size_t symbol_;           ///< Samples per symbol.
+    std::size_t nfft_;             ///< Two symbols: bins at half the tone spacing.
+    std::size_t hop_;
+    double bin_hz_;
+    std::ptrdiff_t band_lo_;       ///< First stored bin (fft-shifted index).
+    std::size_t width_;            ///< Stored bins per column.
+    std::ptrdiff_t lag_lo_;        ///< Lag search range in columns.
+    std::ptrdiff_t lag_hi_;
+    std::ptrdiff_t drift_steps_;   ///< Drift grid is -drift_steps_ .. +drift_steps_.
+    std::size_t ring_columns_;
+    std::shared_ptr<const FftPlan> plan_;
+    std::unique_ptr<SyncSearchBackend> backend_;
+
+    std::pmr::vector<Complex> carry_;
+    std::size_t carry_size_ = 0;
+    std::uint64_t consumed_ = 0;
+    std::uint64_t columns_ = 0;
+    std::pmr::vector<Complex> work_;
+    std::pmr::vector<float> ring_;
+
+    std::pmr::vector<WsprCandidate> candidates_;
+    std::pmr::vector<WsprCandidate> seeds_;
+    std::optional<std::uint64_t> last_window_;
+    unsigned since_full_ = 0;
+    bool force_full_ = false;
+    bool last_full_ = false;
+    std::uint64_t full_searches_ = 0;
+    std::uint64_t seeded_searches_ = 0;
+};
+
+/// One decoded transmission.
+struct WsprSpot {
+    TimePoint slot;    ///< Slot start (stream-relative from the epoch when the stream carries no time).
+    double freq_hz;    ///< Relative to the stream centre.
+    double drift_hz;
+    double dt_s;       ///< Start offset from the nominal slot start + 1 s.
+    double snr_db;
+    double sync;
+    WsprReport report;
+};
+
+/// Pipeline stage decoding every two-minute slot of a WSPR baseband stream
+/// (blocks pass through unchanged). Slots are aligned to even UTC minutes
+/// when blocks carry a start time, to the stream start otherwise. Each slot
+/// runs search, tone extraction and a batch Fano decode on pool from one
+/// arena that is reset afterwards, then reports its spots.
+class WsprDecodeStage final : public Stage {
+public:
+    using Callback = std::function<void(std::span<const WsprSpot>)>;
+
+    WsprDecodeStage(WsprSearchConfig config, Callback callback, TaskPool* pool = nullptr,
+                    FanoOptions fano = {});
+    const char* name() const noexcept override { return "wspr"; }
+    void process(BufferRef block, const Emitter& emit) override;
+
+    const WsprSearch& search() const noexcept { return search_; }
+    std::uint64_t slots() const noexcept { return slots_; }
+
+private:
+    void decode_slot();
+
+    WsprSearch search_;
+    Callback callback_;
+    TaskPool* pool_;
+    FanoOptions fano_;
+    Arena arena_;
+    std::optional<TimePoint> stream_start_;
+    std::uint64_t next_window_ = 0;   ///< Stream sample of the next slot start.
+    TimePoint next_slot_{};
+    std::uint64_t slots_ = 0;
+    std::vector<std::optional<WsprReport>> reports_;
+    std::vector<WsprSpot> spots_;
+    std::vector<WsprCandidate> decoded_;
+};
+
+} // namespace mprp
@@ -0,0 +1,181 @@
+#include "mprp/arena.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace mprp {
+
+namespace {
+
+// log2 of the power-of-two block serving a request.
+std::size_t class_bits(std::size_t bytes, std::size_t min_bits) noexcept
+{
+    return std::max(min_bits, static_cast<std::size_t>(std::bit_width(std::max<std::size_t>(bytes, 1) - 1)));
+}
+
+} // namespace
+
+// ---- Arena ------------------------------------------------------------------
+
+struct Arena::Chunk {
+    Chunk* next;
+    std::size_t size;
+    std::atomic<std::size_t> used{0};
+
+    static constexpr std::size_t header = 64;
+    char* data() noexcept { return reinterpret_cast<char*>(this) + header; }
+};
+
+Arena::Arena(std::size_t initial_bytes, std::pmr::memory_resource* upstream)
+    : upstream_(upstream), next_chunk_bytes_(std::max<std::size_t>(initial_bytes, 4096))
+{
+}
+
+Arena::~Arena()
+{
+    free_chunks(current_.load(std::memory_order_relaxed));
+}
+
+Arena::Chunk* Arena::new_chunk(std::size_t bytes, Chunk* next)
+{
+    static_assert(sizeof(Chunk) <= Chunk::header);
+    void* p = upstream_->allocate(Chunk::header + bytes, Chunk::header);
+    upstream_allocations_.fetch_add(1, std::memory_order_relaxed);
+    Chunk* c = ::new (p) Chunk;
+    c->next = next;
+    c->size = bytes;
+    return c;
+}
+
+void Arena::free_chunks(Chunk* chunk) noexcept
+{
+    while (chunk) {
+        Chunk* next = chunk->next;
+        const std::size_t bytes = Chunk::header + chunk->size;
+        chunk->~Chunk();
+        upstream_->deallocate(chunk, bytes, Chunk::header);
+        chunk = next;
+    }
+}
+
+void* Arena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    for (;;) {
+        Chunk* c = current_.load(std::memory_order_acquire);
+        if (c) {
+            const auto base = reinterpret_cast<std::uintptr_t>(c->data());
+            std::size_t off = c->used.load(std::memory_order_relaxed);
+            for (;;) {
+                const std::uintptr_t p = (base + off + alignment - 1) & ~(std::uintptr_t{alignment} - 1);
+                const std::size_t end = static_cast<std::size_t>(p - base) + bytes;
+                if (end > c->size)
+                    break;
+                if (c->used.compare_exchange_weak(off, end, std::memory_order_relaxed))
+                    return reinterpret_cast<void*>(p);
+            }
+        }
+        // Chunk full: one thread adds the next, the others retry on it.
+        std::lock_guard lock(grow_mutex_);
+        if (current_.load(std::memory_order_relaxed) != c)
+            continue;
+        const std::size_t size = std::max(next_chunk_bytes_, bytes + alignment);
+        current_.store(new_chunk(size, c), std::memory_order_release);
+        next_chunk_bytes_ = size * 2;
+    }
+}
+
+void Arena::reset()
+{
+    Chunk* c = current_.load(std::memory_order_relaxed);
+    if (!c)
+        return;
+    high_water_ = std::max(high_water_, used());
+    if (!c->next) {
+        c->used.store(0, std::memory_order_relaxed);
+        return;
+    }
+    const std::size_t total = capacity();
+    current_.store(nullptr, std::memory_order_relaxed);
+    free_chunks(c);
+    current_.store(new_chunk(total, nullptr), std::memory_order_relaxed);
+    next_chunk_bytes_ = total;
+}
+
+std::size_t Arena::used() const noexcept
+{
+    std::size_t n = 0;
+    for (Chunk* c = current_.load(std::memory_order_acquire); c; c = c->next)
+        n += c->used.load(std::memory_order_relaxed);
+    return n;
+}
+
+std::size_t Arena::capacity() const noexcept
+{
+    std::size_t n = 0;
+    for (Chunk* c = current_.load(std::memory_order_acquire); c; c = c->next)
+        n += c->size;
+    return n;
+}
+
+// ---- PoolResource -----------------------------------------------------------
+
+PoolResource::PoolResource(std::pmr::memory_resource* upstream) : upstream_(upstream) {}
+
+PoolResource::~PoolResource()
+{
+    release();
+}
+
+void* PoolResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    const std::size_t bits = class_bits(bytes, min_class_bits);
+    if (bits > max_class_bits || alignment > block_alignment) {
+        upstream_allocations_.fetch_add(1, std::memory_order_relaxed);
+        return upstream_->allocate(bytes, alignment);
+    }
+    SizeClass& sc = classes_[bits - min_class_bits];
+    {
+        std::lock_guard lock(sc.mutex);
+        if (FreeBlock* b = sc.head) {
+            sc.head = b->next;
+            reused_.fetch_add(1, std::memory_order_relaxed);
+            return b;
+        }
+    }
+    upstream_allocations_.fetch_add(1, std::memory_order_relaxed);
+    return upstream_->allocate(std::size_t{1} << bits, block_alignment);
+}
+
+void PoolResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+    const std::size_t bits = class_bits(bytes, min_class_bits);
+    if (bits > max_class_bits || alignment > block_alignment) {
+        upstream_->deallocate(p, bytes, alignment);
+        return;
+    }
+    SizeClass& sc = classes_[bits - min_class_bits];
+    auto* b = ::new (p) FreeBlock{nullptr};
+    std::lock_guard lock(sc.mutex);
+    b->next = sc.head;
+    sc.head = b;
+}
+
+void PoolResource::release() noexcept
+{
+    for (std::size_t i = 0; i < classes; ++i) {
+        SizeClass& sc = classes_[i];
+        std::lock_guard lock(sc.mutex);
+        while (FreeBlock* b = sc.head) {
+            sc.head = b->next;
+            upstream_->deallocate(b, std::size_t{1} << (i + min_class_bits), block_alignment);
+        }
+    }
+}
+
+PoolResource& default_pool_resource()
+{
+    static PoolResource pool;
+    return pool;
+}
+
+} // namespace mprp
@@ -0,0 +1,94 @@
+#include "mprp/buffer_pool.hpp"
+
+#include "mprp/arena.hpp"
+
+#include <stdexcept>
+
+namespace mprp {
+
+BufferPool::BufferPool(std::size_t blocks, std::size_t block_samples, std::pmr::memory_resource* resource)
+    : block_samples_(block_samples), resource_(resource ? resource : &default_pool_resource())
+{
+    if (blocks == 0 || block_samples == 0)
+        throw std::invalid_argument("BufferPool needs at least one non-empty block");
+    blocks_.reserve(blocks);
+    free_.reserve(blocks);
+    for (std::size_t i = 0; i < blocks; ++i) {
+        auto b = std::make_unique<Block>();
+        b->capacity = block_samples;
+        b->pool = this;
+        free_.push_back(b.get());
+        blocks_.push_back(std::move(b));
+    }
+    // Storage last, so a throwing block allocation cannot leak it.
+    storage_ = static_cast<Complex*>(resource_->allocate(blocks * block_samples * sizeof(Complex), alignof(Complex)));
+    std::uninitialized_value_construct_n(storage_, blocks * block_samples);
+    for (std::size_t i = 0; i < blocks; ++i) {
+        blocks_[i]->data = storage_ + i * block_samples;
+        blocks_[i]->home = blocks_[i]->data;
+    }
+}
+
+BufferPool::~BufferPool()
+{
+    resource_->deallocate(storage_, blocks_.size() * block_samples_ * sizeof(Complex), alignof(Complex));
+}
+
+BufferRef BufferPool::hand_out()
+{
+    Block* b = free_.back();
+    free_.pop_back();
+    b->size = 0;
+    b->sample_rate = 0.0;
+    b->sequence = 0;
+    b->first_sample = 0;
+    b->start = {};
+    b->format = IqFormat::Cf32;
+    b->refs.store(1, std::memory_order_relaxed);
+    return BufferRef(b);
+}
+
+BufferRef BufferPool::acquire()
+{
+    std::unique_lock lock(mutex_);
+    ready_.wait(lock, [this] { return !free_.empty(); });
+    return hand_out();
+}
+
+BufferRef BufferPool::try_acquire()
+{
+    std::lock_guard lock(mutex_);
+    if (free_.empty())
+        return {};
+    return hand_out();
+}
+
+BufferRef BufferPool::acquire_view(std::span<Complex> samples)
+{
+    BufferRef ref = acquire();
+    ref->data = samples.data();
+    ref->capacity = samples.size();
+    ref->size = samples.size();
+    ref->view = true;
+    return ref;
+}
+
+std::size_t BufferPool::available() const
+{
+    std::lock_guard lock(mutex_);
+    return free_.size();
+}
+
+void BufferPool::recycle(Block* block) noexcept
+{
+    block->data = block->home;
+    block->capacity = block_samples_;
+    block->view = false;
+    {
+        std::lock_guard lock(mutex_);
+        free_.push_back(block);
+    }
+    ready_.notify_one();
+}
+
+} // namespace mprp
@@ -0,0 +1,105 @@
+#include "mprp/mprp.h"
+
+#include "mprp/engine.hpp"
+#include "mprp/wspr.hpp"
+
+#include <exception>
+#include <string>
+
+struct mprp_engine {
+    mprp::Engine engine;
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+template <typename F>
+auto guarded(F&& f, decltype(f()) on_error) noexcept -> decltype(f())
+{
+    try {
+        return f();
+    } catch (const std::exception& e) {
+        last_error = e.what();
+    } catch (...) {
+        last_error = "unknown error";
+    }
+    return on_error;
+}
+
+} // namespace
+
+extern "C" {
+
+mprp_engine* mprp_engine_open(const char* config_path)
+{
+    return guarded([&] { return new mprp_engine{mprp::Engine::from_file(config_path)}; },
+                   nullptr);
+}
+
+mprp_engine* mprp_engine_open_text(const char* config_text)
+{
+    return guarded([&] { return new mprp_engine{mprp::Engine(mprp::parse_config(config_text))}; },
+                   nullptr);
+}
+
+void mprp_engine_close(mprp_engine* engine)
+{
+    delete engine;
+}
+
+size_t mprp_engine_entries(const mprp_engine* engine)
+{
+    return engine ? engine->engine.entries() : 0;
+}
+
+int mprp_engine_next_slot(const mprp_engine* engine, int64_t unix_time_ns, int64_t* start_ns,
+                          size_t* entry)
+{
+    if (!engine || !start_ns || !entry) {
+        last_error = "null argument";
+        return -1;
+    }
+    const auto plan =
+        engine->engine.next_slot(mprp::TimePoint(std::chrono::nanoseconds(unix_time_ns)));
+    *start_ns = plan.start.time_since_epoch().count();
+    *entry = plan.entry;
+    return 0;
+}
+
+size_t mprp_engine_transmission_samples(const mprp_engine* engine, size_t entry)
+{
+    if (!engine)
+        return 0;
+    return guarded([&] { return engine->engine.transmission_samples(entry); }, size_t{0});
+}
+
+long mprp_engine_render(const mprp_engine* engine, size_t entry, float* out, size_t capacity)
+{
+    if (!engine || (!out && capacity)) {
+        last_error = "null argument";
+        return -1;
+    }
+    return guarded(
+        [&] { return static_cast<long>(engine->engine.render(entry, {out, capacity})); }, -1L);
+}
+
+int mprp_wspr_encode(const char* callsign, const char* grid, int power_dbm, uint8_t out[162])
+{
+    if (!callsign || !grid || !out) {
+        last_error = "null argument";
+        return -1;
+    }
+    const auto st = mprp::wspr_encode({callsign, grid, power_dbm},
+                                      std::span<std::uint8_t, mprp::wspr_symbol_count>(out, 162));
+    if (st != mprp::WsprStatus::Ok)
+        last_error = mprp::to_string(st);
+    return static_cast<int>(st);
+}
+
+const char* mprp_last_error(void)
+{
+    return last_error.c_str();
+}
+
+} // extern "C"
@@ -0,0 +1,504 @@
+#include "mprp/capture.hpp"
+
+#include "mprp/hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if MPRP_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace mprp {
+
+namespace {
+
+constexpr std::uint64_t capture_magic = 0x0050414350525050ull;  // "PPRPCAP\0"
+constexpr std::uint32_t capture_version = 1;
+constexpr std::size_t alignment = 64;
+
+struct FileHeader {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t format;        ///< IqFormat.
+    std::uint64_t index_offset;  ///< 0 until the writer closes.
+    std::uint64_t chunks;
+    std::int64_t created_unix_ns;
+    std::uint8_t reserved[24];
+};
+static_assert(sizeof(FileHeader) == 64);
+
+std::uint64_t padded(std::uint64_t n) noexcept
+{
+    return (n + alignment - 1) / alignment * alignment;
+}
+
+std::uint32_t payload_checksum(const void* data, std::size_t n) noexcept
+{
+    return static_cast<std::uint32_t>(Fnv1a().bytes(data, n).value());
+}
+
+std::int64_t ns_since(TimePoint a, TimePoint b) noexcept
+{
+    return (a - b).count();
+}
+
+std::uint64_t samples_in(std::int64_t ns, double rate) noexcept
+{
+    return ns <= 0 ? 0 : static_cast<std::uint64_t>(std::ceil(static_cast<double>(ns) * rate / 1e9));
+}
+
+} // namespace
+
+bool capture_codec_supported(CaptureCodec codec) noexcept
+{
+    switch (codec) {
+    case CaptureCodec::None:
+        return true;
+    case CaptureCodec::Zlib:
+        return MPRP_HAVE_ZLIB != 0;
+    }
+    return false;
+}
+
+TimePoint ChunkInfo::end() const noexcept
+{
+    return start() + std::chrono::nanoseconds(std::llround(static_cast<double>(samples) * 1e9 / sample_rate));
+}
+
+// ---- writer ---------------------------------------------------------------
+
+CaptureWriter::CaptureWriter(const std::string& path, IqFormat format, CaptureCodec codec, int zlib_level)
+    : format_(format), codec_(codec), level_(zlib_level)
+{
+    if (!capture_codec_supported(codec))
+        throw std::runtime_error("capture compression is not available in this build");
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_)
+        throw std::runtime_error("cannot create capture '" + path + "'");
+    FileHeader h{};
+    h.magic = capture_magic;
+    h.version = capture_version;
+    h.format = static_cast<std::uint32_t>(format_);
+    h.created_unix_ns = Clock::now().time_since_epoch().count();
+    write(&h, sizeof h);
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    if (file_) {
+        try {
+            close();
+        } catch (const std::exception&) {
+            // Nothing to report from a destructor; the chunks already on
+            // disk remain readable without the index.
+        }
+    }
+}
+
+void CaptureWriter::write(const void* data, std::size_t n)
+{
+    if (std::fwrite(data, 1, n, file_) != n)
+        throw std::runtime_error("capture write failed");
+    position_ += n;
+}
+
+void CaptureWriter::append(std::span<const Complex> samples, TimePoint start, double centre_hz,
+                           double sample_rate)
+{
+    if (format_ == IqFormat::Cf32) {
+        append_raw(samples.data(), samples.size(), start, centre_hz, sample_rate);
+        return;
+    }
+    std::vector<unsigned char> raw(samples.size() * iq_sample_bytes(format_));
+    encode_iq(format_, samples, raw.data());
+    append_raw(raw.data(), samples.size(), start, centre_hz, sample_rate);
+}
+
+void CaptureWriter::append_raw(const void* raw, std::size_t samples, TimePoint start, double centre_hz,
+                               double sample_rate)
+{
+    if (!file_)
+        throw std::logic_error("CaptureWriter: append after close");
+    if (!(sample_rate > 0.0))
+        throw std::invalid_argument("CaptureWriter: sample rate must be positive");
+    if (codec_ != CaptureCodec::None && samples > max_compressed_chunk_samples)
+        throw std::invalid_argument("CaptureWriter: compressed chunk too long");
+
+    const std::size_t raw_bytes = samples * iq_sample_bytes(format_);
+    const void* stored = raw;
+    std::size_t stored_bytes = raw_bytes;
+#if MPRP_HAVE_ZLIB
+    if (codec_ == CaptureCodec::Zlib) {
+        uLongf out = compressBound(static_cast<uLong>(raw_bytes));
+        scratch_.resize(out);
+        if (compress2(scratch_.data(), &out, static_cast<const Bytef*>(raw), static_cast<uLong>(raw_bytes),
+                      level_)
+            != Z_OK)
+            throw std::runtime_error("capture compression failed");
+        stored = scratch_.data();
+        stored_bytes = out;
+    }
+#endif
+
+    ChunkInfo c{};
+    c.start_unix_ns = start.time_since_epoch().count();
+    c.centre_hz = centre_hz;
+    c.sample_rate = sample_rate;
+    c.first_sample = samples_;
+    c.samples = samples;
+    c.offset = position_ + sizeof(ChunkInfo);
+    c.stored_bytes = stored_bytes;
+    c.codec = static_cast<std::uint32_t>(codec_);
+    c.checksum = payload_checksum(stored, stored_bytes);
+
+    static constexpr unsigned char zeros[alignment] = {};
+    write(&c, sizeof c);
+    write(stored, stored_bytes);
+    write(zeros, padded(stored_bytes) - stored_bytes);
+    index_.push_back(c);
+    samples_ += samples;
+}
+
+void CaptureWriter::close()
+{
+    if (!file_)
+        return;
+    std::FILE* f = file_;
+    FileHeader h{};
+    h.magic = capture_magic;
+    h.version = capture_version;
+    h.format = static_cast<std::uint32_t>(format_);
+    h.index_offset = position_;
+    h.chunks = index_.size();
+    h.created_unix_ns = index_.empty() ? Clock::now().time_since_epoch().count() : index_.front().start_unix_ns;
+
+    bool ok = std::fwrite(index_.data(), sizeof(ChunkInfo), index_.size(), f) == index_.size();
+    // The header goes last, so a reader never sees an index offset before
+    // the index itself is complete.
+    ok = ok && std::fflush(f) == 0 && std::fseek(f, 0, SEEK_SET) == 0 && std::fwrite(&h, sizeof h, 1, f) == 1;
+    file_ = nullptr;
+    if (std::fclose(f) != 0 || !ok)
+        throw std::runtime_error("capture close failed");
+}
+
+// ---- reader ---------------------------------------------------------------
+
+CaptureReader::CaptureReader(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("cannot open capture '" + path + "'");
+    struct stat st {};
+    void* base = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(FileHeader))
+        base = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+        throw std::runtime_error("'" + path + "' is not a capture file");
+    base_ = static_cast<const unsigned char*>(base);
+    length_ = static_cast<std::size_t>(st.st_size);
+    mapped_ = true;
+    if (!load()) {
+        ::munmap(base, length_);
+        throw std::runtime_error("'" + path + "' is not a version " + std::to_string(capture_version)
+                                 + " capture file");
+    }
+}
+
+CaptureReader::CaptureReader(std::span<const unsigned char> image) : base_(image.data()), length_(image.size())
+{
+    if (!load())
+        throw std::runtime_error("not a version " + std::to_string(capture_version) + " capture image");
+}
+
+bool CaptureReader::load()
+{
+    if (length_ < sizeof(FileHeader))
+        return false;
+    FileHeader h;
+    std::memcpy(&h, base_, sizeof h);
+    if (h.magic != capture_magic || h.version != capture_version || h.format > static_cast<std::uint32_t>(IqFormat::Cs8))
+        return false;
+    format_ = static_cast<IqFormat>(h.format);
+
+    // The index is trusted no further than the file: a damaged or hostile
+    // one (captures also arrive from the network, see mprp/distributed.hpp)
+    // must not point a chunk outside the mapping. Any bad entry and the
+    // chunks are found by walking the file instead.
+    if (h.index_offset >= sizeof(FileHeader) && h.index_offset <= length_
+        && h.chunks <= (length_ - h.index_offset) / sizeof(ChunkInfo)) {
+        index_.resize(h.chunks);
+        std::memcpy(index_.data(), base_ + h.index_offset, h.chunks * sizeof(ChunkInfo));
+        indexed_ = std::all_of(index_.begin(), index_.end(), [this](const ChunkInfo& c) {
+            return c.offset >= sizeof(FileHeader) + sizeof(ChunkInfo) && c.offset <= length_
+                   && c.stored_bytes <= length_ - c.offset && c.sample_rate > 0.0;
+        });
+    }
+    if (!indexed_) {
+        index_.clear();
+        rebuild_index();
+    }
+    // Sample counts are trusted no further either: everything downstream
+    // sizes buffers and spans from them.
+    const std::uint64_t width = iq_sample_bytes(format_);
+    for (const ChunkInfo& c : index_) {
+        const bool sound = c.codec == static_cast<std::uint32_t>(CaptureCodec::None)
+                               ? c.stored_bytes % width == 0 && c.samples == c.stored_bytes / width
+                               : c.codec == static_cast<std::uint32_t>(CaptureCodec::Zlib)
+                                     && c.samples <= max_compressed_chunk_samples;
+        if (!sound)
+            return false;
+    }
+    // Chunks are appended in capture order; find() relies on it.
+    std::stable_sort(index_.begin(), index_.end(),
+                     [](const ChunkInfo& a, const ChunkInfo& b) { return a.start_unix_ns < b.start_unix_ns; });
+    return true;
+}
+
+CaptureReader::~CaptureReader()
+{
+    if (mapped_)
+        ::munmap(const_cast<unsigned char*>(base_), length_);
+}
+
+void CaptureReader::rebuild_index()
+{
+    std::uint64_t pos = sizeof(FileHeader);
+    while (pos + sizeof(ChunkInfo) <= length_) {
+        ChunkInfo c;
+        std::memcpy(&c, base_ + pos, sizeof c);
+        if (c.offset != pos + sizeof(ChunkInfo) || c.stored_bytes > length_ - c.offset
+            || !(c.sample_rate > 0.0))
+            break;  // torn tail of an interrupted capture
+        index_.push_back(c);
+        pos = c.offset + padded(c.stored_bytes);
+    }
+}
+
+std::size_t CaptureReader::find(TimePoint t) const noexcept
+{
+    const auto it = std::partition_point(index_.begin(), index_.end(),
+                                         [t](const ChunkInfo& c) { return c.end() <= t; });
+    return static_cast<std::size_t>(it - index_.begin());
+}
+
+std::span<const unsigned char> CaptureReader::payload(std::size_t chunk) const noexcept
+{
+    const ChunkInfo& c = index_[chunk];
+    return {base_ + c.offset, static_cast<std::size_t>(c.stored_bytes)};
+}
+
+std::span<const Complex> CaptureReader::view(std::size_t chunk) const noexcept
+{
+    const ChunkInfo& c = index_[chunk];
+    if (format_ != IqFormat::Cf32 || c.codec != static_cast<std::uint32_t>(CaptureCodec::None)
+        || c.stored_bytes != c.samples * sizeof(Complex))
+        return {};
+    return {reinterpret_cast<const Complex*>(base_ + c.offset), static_cast<std::size_t>(c.samples)};
+}
+
+std::size_t CaptureReader::decode(std::size_t chunk, std::span<Complex> out) const
+{
+    const ChunkInfo& c = index_[chunk];
+    const auto stored = payload(chunk);
+    const std::size_t n = static_cast<std::size_t>(c.samples);
+    const std::size_t raw_bytes = n * iq_sample_bytes(format_);
+    if (out.size() < n)
+        throw std::invalid_argument("CaptureReader::decode: output too small");
+
+    switch (static_cast<CaptureCodec>(c.codec)) {
+    case CaptureCodec::None:
+        if (stored.size() != raw_bytes)
+            throw std::runtime_error("capture chunk has the wrong size");
+        decode_iq(format_, stored.data(), out.first(n));
+        return n;
+    case CaptureCodec::Zlib: {
+#if MPRP_HAVE_ZLIB
+        std::vector<unsigned char> raw(raw_bytes);
+        uLongf len = static_cast<uLongf>(raw_bytes);
+        if (uncompress(raw.data(), &len, stored.data(), static_cast<uLong>(stored.size())) != Z_OK
+            || len != raw_bytes)
+            throw std::runtime_error("corrupt compressed capture chunk");
+        decode_iq(format_, raw.data(), out.first(n));
+        return n;
+#else
+        throw std::runtime_error("capture uses zlib, which this build lacks");
+#endif
+    }
+    }
+    throw std::runtime_error("unknown capture codec");
+}
+
+bool CaptureReader::verify(std::size_t chunk) const noexcept
+{
+    const auto p = payload(chunk);
+    return payload_checksum(p.data(), p.size()) == index_[chunk].checksum;
+}
+
+std::vector<unsigned char> capture_window(const CaptureReader& reader, TimePoint from, TimePoint to)
+{
+    const std::size_t width = iq_sample_bytes(reader.format());
+    const auto chunks = reader.chunks();
+    std::vector<unsigned char> image(sizeof(FileHeader));
+    std::vector<ChunkInfo> index;
+    for (std::size_t i = reader.find(from); i < chunks.size() && chunks[i].start() < to; ++i) {
+        ChunkInfo c = chunks[i];
+        std::span<const unsigned char> stored = reader.payload(i);
+        // Uncompressed chunks are cut to the window; compressed ones go
+        // whole, and the receiver trims them by time.
+        if (c.codec == static_cast<std::uint32_t>(CaptureCodec::None) && c.stored_bytes == c.samples * width) {
+            const std::uint64_t skip =
+                from > c.start() ? std::min<std::uint64_t>(samples_in(ns_since(from, c.start()), c.sample_rate), c.samples) : 0;
+            const std::uint64_t keep =
+                to < c.end() ? std::min<std::uint64_t>(samples_in(ns_since(to, c.start()), c.sample_rate), c.samples)
+                             : c.samples;
+            if (keep <= skip)
+                continue;
+            stored = stored.subspan(static_cast<std::size_t>(skip * width), static_cast<std::size_t>((keep - skip) * width));
+            c.start_unix_ns += std::llround(static_cast<double>(skip) * 1e9 / c.sample_rate);
+            c.first_sample += skip;
+            c.samples = keep - skip;
+            c.stored_bytes = stored.size();
+            c.checksum = payload_checksum(stored.data(), stored.size());
+        }
+        c.offset = image.size() + sizeof(ChunkInfo);
+        image.resize(c.offset + padded(c.stored_bytes));
+        std::memcpy(image.data() + c.offset - sizeof(ChunkInfo), &c, sizeof c);
+        std::memcpy(image.data() + c.offset, stored.data(), stored.size());
+        index.push_back(c);
+    }
+
+    FileHeader h{};
+    h.magic = capture_magic;
+    h.version = capture_version;
+    h.format = static_cast<std::uint32_t>(reader.format());
+    h.index_offset = image.size();
+    h.chunks = index.size();
+    h.created_unix_ns = index.empty() ? from.time_since_epoch().count() : index.front().start_unix_ns;
+    std::memcpy(image.data(), &h, sizeof h);
+    const auto* bytes = reinterpret_cast<const unsigned char*>(index.data());
+    image.insert(image.end(), bytes, bytes + index.size() * sizeof(ChunkInfo));
+    return image;
+}
+
+// ---- source ---------------------------------------------------------------
+
+CaptureSource::CaptureSource(const CaptureReader& reader, TimePoint from, TimePoint to)
+    : reader_(reader), from_(from), to_(to), chunk_(reader.find(from))
+{
+    const auto chunks = reader.chunks();
+    if (chunk_ == chunks.size() || chunks[chunk_].start() >= to_)
+        throw std::invalid_argument("capture has no samples in the requested range");
+    sample_rate_ = chunks[chunk_].sample_rate;
+    for (std::size_t i = chunk_; i < chunks.size() && chunks[i].start() < to_; ++i)
+        if (chunks[i].sample_rate != sample_rate_)
+            throw std::invalid_argument("capture range mixes sample rates");
+}
+
+bool CaptureSource::load_chunk()
+{
+    const auto chunks = reader_.chunks();
+    if (chunk_ == chunks.size() || chunks[chunk_].start() >= to_)
+        return false;
+    const std::size_t i = chunk_++;
+    const ChunkInfo& c = chunks[i];
+
+    // Compare before subtracting: the open-ended defaults are min()/max().
+    const std::uint64_t skip =
+        from_ > c.start() ? std::min<std::uint64_t>(samples_in(ns_since(from_, c.start()), c.sample_rate), c.samples) : 0;
+    const std::uint64_t keep =
+        to_ < c.end() ? std::min<std::uint64_t>(samples_in(ns_since(to_, c.start()), c.sample_rate), c.samples)
+                      : c.samples;
+    const std::size_t count = keep > skip ? static_cast<std::size_t>(keep - skip) : 0;
+    current_start_ = c.start() + std::chrono::nanoseconds(std::llround(static_cast<double>(skip) * 1e9 / c.sample_rate));
+
+    // Raw mode, uncompressed narrow samples: the first stage converts them
+    // straight from the mapping.
+    const std::size_t width = iq_sample_bytes(reader_.format());
+    if (raw_ && reader_.format() != IqFormat::Cf32 && c.codec == static_cast<std::uint32_t>(CaptureCodec::None)
+        && c.stored_bytes == c.samples * width) {
+        raw_current_ = reader_.payload(i).subspan(static_cast<std::size_t>(skip) * width, count * width);
+        current_ = {};
+        mapped_ = false;
+        return true;
+    }
+    raw_current_ = {};
+
+    std::span<const Complex> all = reader_.view(i);
+    mapped_ = !all.empty();
+    if (!mapped_) {
+        decoded_.resize(static_cast<std::size_t>(c.samples));
+        all = std::span<const Complex>(decoded_.data(), reader_.decode(i, decoded_));
+    }
+    current_ = all.subspan(static_cast<std::size_t>(skip), count);
+    return true;
+}
+
+std::size_t CaptureSource::remaining() const noexcept
+{
+    return raw_current_.empty() ? current_.size() : raw_current_.size() / iq_sample_bytes(reader_.format());
+}
+
+void CaptureSource::advance(std::size_t n) noexcept
+{
+    if (raw_current_.empty())
+        current_ = current_.subspan(n);
+    else
+        raw_current_ = raw_current_.subspan(n * iq_sample_bytes(reader_.format()));
+    current_start_ += std::chrono::nanoseconds(std::llround(static_cast<double>(n) * 1e9 / sample_rate_));
+}
+
+std::size_t CaptureSource::read(std::span<Complex> out)
+{
+    std::size_t done = 0;
+    while (done < out.size()) {
+        if (remaining() == 0 && !load_chunk())
+            break;
+        const std::size_t n = std::min(out.size() - done, remaining());
+        if (raw_current_.empty())
+            std::copy_n(current_.data(), n, out.data() + done);
+        else
+            decode_iq(reader_.format(), raw_current_.data(), out.subspan(done, n));
+        advance(n);
+        done += n;
+    }
+    return done;
+}
+
+BufferRef CaptureSource::next(BufferPool& pool)
+{
+    while (remaining() == 0)
+        if (!load_chunk())
+            return {};
+    const std::size_t n = std::min(remaining(), pool.block_samples());
+    BufferRef block;
+    if (!raw_current_.empty()) {
+        // Raw: one copy at the file's width, no conversion pass.
+        block = pool.acquire();
+        std::memcpy(block->data, raw_current_.data(), n * iq_sample_bytes(reader_.format()));
+        block->size = n;
+        block->format = reader_.format();
+    } else if (mapped_) {
+        // Mapped samples: hand out a read-only view. Blocks that are views
+        // are never unique(), so no stage writes through the const_cast.
+        block = pool.acquire_view({const_cast<Complex*>(current_.data()), n});
+    } else {
+        // Decoded chunk: copy, since decoded_ is reused for the next chunk.
+        block = pool.acquire();
+        std::copy_n(current_.data(), n, block->data);
+        block->size = n;
+    }
+    block->start = current_start_;
+    advance(n);
+    return block;
+}
+
+} // namespace mprp
@@ -0,0 +1,214 @@
+#include "mprp/config.hpp"
+
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+
+namespace mprp {
+
+namespace {
+
+std::string_view trim(std::string_view s)
+{
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front())))
+        s.remove_prefix(1);
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back())))
+        s.remove_suffix(1);
+    return s;
+}
+
+// Line 0 is a key set outside any file (set_config_key()).
+[[noreturn]] void fail(std::size_t line, const std::string& what)
+{
+    if (line == 0)
+        throw ConfigError(what);
+    throw ConfigError("config line " + std::to_string(line) + ": " + what);
+}
+
+double to_double(std::string_view value, std::size_t line)
+{
+    // std::from_chars for double is available in libstdc++ 11+.
+    double out = 0.0;
+    auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), out);
+    if (ec != std::errc{} || ptr != value.data() + value.size())
+        fail(line, "expected a number, got '" + std::string(value) + "'");
+    return out;
+}
+
+unsigned to_unsigned(std::string_view value, std::size_t line)
+{
+    unsigned out = 0;
+    auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), out);
+    if (ec != std::errc{} || ptr != value.data() + value.size())
+        fail(line, "expected an unsigned integer, got '" + std::string(value) + "'");
+    return out;
+}
+
+void set_engine_key(EngineConfig& cfg, std::string_view key, std::string_view value,
+                    std::size_t line)
+{
+    if (key == "sample_rate")
+        cfg.sample_rate = to_double(value, line);
+    else if (key == "slot_period_s")
+        cfg.slot_period_s = to_double(value, line);
+    else if (key == "slot_offset_s")
+        cfg.slot_offset_s = to_double(value, line);
+    else
+        fail(line, "unknown key '" + std::string(key) + "'");
+}
+
+void set_beacon_key(BeaconEntry& b, std::string_view key, std::string_view value,
+                    std::size_t line)
+{
+    if (key == "name")
+        b.name = value;
+    else if (key == "mode")
+        b.mode = parse_mode(value);
+    else if (key == "message")
+        b.message = value;
+    else if (key == "callsign")
+        b.callsign = value;
+    else if (key == "grid")
+        b.grid = value;
+    else if (key == "power_dbm")
+        b.power_dbm = static_cast<int>(to_double(value, line));
+    else if (key == "audio_hz")
+        b.audio_hz = to_double(value, line);
+    else if (key == "amplitude")
+        b.amplitude = to_double(value, line);
+    else if (key == "wpm")
+        b.wpm = to_double(value, line);
+    else if (key == "cw_rise_ms")
+        b.cw_rise_ms = to_double(value, line);
+    else if (key == "tones")
+        b.tones = to_unsigned(value, line);
+    else if (key == "tone_spacing_hz")
+        b.tone_spacing_hz = to_double(value, line);
+    else if (key == "baud")
+        b.baud = to_double(value, line);
+    else if (key == "dial_hz")
+        b.dial_hz = to_double(value, line);
+    else if (key == "tx_power_w")
+        b.tx_power_w = to_unsigned(value, line);
+    else
+        fail(line, "unknown beacon key '" + std::string(key) + "'");
+}
+
+} // namespace
+
+Mode parse_mode(std::string_view name)
+{
+    if (name == "cw")
+        return Mode::Cw;
+    if (name == "fsk")
+        return Mode::Fsk;
+    if (name == "wspr")
+        return Mode::Wspr;
+    throw ConfigError("unknown mode '" + std::string(name) + "'");
+}
+
+const char* to_string(Mode mode) noexcept
+{
+    switch (mode) {
+    case Mode::Cw: return "cw";
+    case Mode::Fsk: return "fsk";
+    case Mode::Wspr: return "wspr";
+    }
+    return "?";
+}
+
+void EngineConfig::validate() const
+{
+    if (!(sample_rate >= 8000.0 && sample_rate <= 384000.0))
+        throw ConfigError("sample_rate out of range");
+    if (!(slot_period_s > 0.0))
+        throw ConfigError("slot_period_s must be positive");
+    if (!(slot_offset_s >= 0.0 && slot_offset_s < slot_period_s))
+        throw ConfigError("slot_offset_s must lie inside the slot");
+    for (const auto& b : beacons) {
+        const std::string who = b.name.empty() ? std::string("beacon") : b.name;
+        if (b.mode != Mode::Wspr && b.message.empty())
+            throw ConfigError(who + ": empty message");
+        if (b.mode == Mode::Wspr && (b.callsign.empty() || b.grid.empty()))
+            throw ConfigError(who + ": wspr needs callsign and grid");
+        if (!(b.audio_hz > 0.0 && b.audio_hz < sample_rate / 2.0))
+            throw ConfigError(who + ": audio_hz outside the passband");
+        if (!(b.amplitude > 0.0 && b.amplitude <= 1.0))
+            throw ConfigError(who + ": amplitude must be in (0, 1]");
+        if (!(b.dial_hz >= 0.0 && b.dial_hz < 1e11))
+            throw ConfigError(who + ": dial_hz out of range");
+        if (b.mode == Mode::Cw && !(b.wpm >= 1.0 && b.wpm <= 100.0))
+            throw ConfigError(who + ": wpm out of range");
+        if (b.mode == Mode::Cw && !(b.cw_rise_ms > 0.0 && b.cw_rise_ms <= 50.0))
+            throw ConfigError(who + ": cw_rise_ms out of range");
+        if (b.mode == Mode::Fsk) {
+            if (b.tones < 2 || b.tones > 256 || (b.tones & (b.tones - 1)) != 0)
+                throw ConfigError(who + ": tones must be a power of two in [2, 256]");
+            if (!(b.baud > 0.0 && b.baud < sample_rate / 4.0))
+                throw ConfigError(who + ": baud out of range");
+            if (!(b.tone_spacing_hz > 0.0))
+                throw ConfigError(who + ": tone_spacing_hz must be positive");
+        }
+    }
+}
+
+EngineConfig parse_config(std::string_view text)
+{
+    EngineConfig cfg;
+    BeaconEntry* current = nullptr;
+    std::size_t line_no = 0;
+
+    while (!text.empty()) {
+        const auto nl = text.find('\n');
+        std::string_view line = text.substr(0, nl);
+        text.remove_prefix(nl == std::string_view::npos ? text.size() : nl + 1);
+        ++line_no;
+
+        if (const auto hash = line.find('#'); hash != std::string_view::npos)
+            line = line.substr(0, hash);
+        line = trim(line);
+        if (line.empty())
+            continue;
+
+        if (line.front() == '[') {
+            if (line != "[beacon]")
+                fail(line_no, "unknown section '" + std::string(line) + "'");
+            current = &cfg.beacons.emplace_back();
+            continue;
+        }
+
+        const auto eq = line.find('=');
+        if (eq == std::string_view::npos)
+            fail(line_no, "expected key = value");
+        const auto key = trim(line.substr(0, eq));
+        const auto value = trim(line.substr(eq + 1));
+        if (current)
+            set_beacon_key(*current, key, value, line_no);
+        else
+            set_engine_key(cfg, key, value, line_no);
+    }
+
+    cfg.validate();
+    return cfg;
+}
+
+void set_config_key(EngineConfig& config, BeaconEntry* entry, std::string_view key, std::string_view value)
+{
+    if (entry)
+        set_beacon_key(*entry, key, value, 0);
+    else
+        set_engine_key(config, key, value, 0);
+}
+
+EngineConfig load_config(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw ConfigError("cannot open config file '" + path + "'");
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return parse_config(ss.str());
+}
+
+} // namespace mprp
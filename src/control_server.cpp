@@ -0,0 +1,160 @@
+#include "mprp/control_server.hpp"
+
+#include "mprp/metrics.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace mprp {
+
+namespace {
+
+sockaddr_un socket_address(const std::string& path)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof addr.sun_path)
+        throw std::invalid_argument("control socket path too long: " + path);
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    return addr;
+}
+
+// True if a process is accepting on the socket at addr.
+bool in_use(const sockaddr_un& addr)
+{
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    const bool live = ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) == 0;
+    ::close(fd);
+    return live;
+}
+
+} // namespace
+
+ControlServer::ControlServer(ControlServerOptions options, Handler handler)
+    : options_(std::move(options)),
+      handler_(std::move(handler)),
+      loop_(options_.loop ? *options_.loop : control_loop())
+{
+    if (options_.path.empty())
+        throw std::invalid_argument("control socket needs a path");
+    const sockaddr_un addr = socket_address(options_.path);
+    struct stat st{};
+    if (::lstat(options_.path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        if (in_use(addr))
+            throw std::runtime_error("control socket " + options_.path + " is in use");
+        ::unlink(options_.path.c_str());
+    }
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (listen_fd_ < 0)
+        throw std::runtime_error(std::string("control socket: ") + std::strerror(errno));
+    if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0
+        || ::listen(listen_fd_, 8) != 0) {
+        const int err = errno;
+        ::close(listen_fd_);
+        throw std::runtime_error("cannot listen on " + options_.path + ": " + std::strerror(err));
+    }
+    running_ = 1;
+    spawn(loop_, listen());
+}
+
+ControlServer::~ControlServer()
+{
+    stopping_.store(true, std::memory_order_relaxed);
+    // A shut-down socket reads as ready (end of file for clients), which
+    // wakes every coroutine parked on one. The posted call counts as
+    // running too, so it cannot outlive the object.
+    {
+        std::lock_guard lock(mutex_);
+        ++running_;
+    }
+    loop_.post([this] {
+        ::shutdown(listen_fd_, SHUT_RDWR);
+        for (const int fd : clients_)
+            ::shutdown(fd, SHUT_RDWR);
+        finished();
+    });
+    std::unique_lock lock(mutex_);
+    idle_.wait(lock, [this] { return running_ == 0; });
+    ::close(listen_fd_);
+    ::unlink(options_.path.c_str());
+}
+
+void ControlServer::finished() noexcept
+{
+    std::lock_guard lock(mutex_);
+    --running_;
+    idle_.notify_all();
+}
+
+Task<void> ControlServer::listen()
+{
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        const bool ready = co_await loop_.readable(listen_fd_);
+        if (!ready || stopping_.load(std::memory_order_relaxed))
+            break;
+        const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (fd < 0)
+            continue;  // EAGAIN after a spurious wake-up, or the client gave up
+        // Registered here rather than in serve(), so that a stop posted
+        // from now on finds it.
+        clients_.insert(fd);
+        {
+            std::lock_guard lock(mutex_);
+            ++running_;
+        }
+        spawn(loop_, serve(fd));
+    }
+    finished();
+}
+
+Task<void> ControlServer::serve(int fd)
+{
+    const auto command_counter = metrics::counter("control.commands");
+    std::array<char, 512> buf{};
+    std::string pending;
+    bool open = true;
+    while (open && !stopping_.load(std::memory_order_relaxed)) {
+        const std::ptrdiff_t n = co_await read_some(loop_, fd, buf, options_.timeout);
+        if (n <= 0)
+            break;
+        pending.append(buf.data(), static_cast<std::size_t>(n));
+        std::size_t nl;
+        while (open && (nl = pending.find('\n')) != std::string::npos) {
+            std::string_view line(pending.data(), nl);
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            std::string reply;
+            if (!line.empty()) {
+                try {
+                    reply = handler_(line);
+                } catch (const std::exception& e) {
+                    reply = std::string("error ") + e.what();
+                }
+                reply += '\n';
+                commands_.fetch_add(1, std::memory_order_relaxed);
+                metrics::add(command_counter);
+            }
+            pending.erase(0, nl + 1);
+            if (!reply.empty()) {
+                const bool sent = co_await write_all(loop_, fd, reply, options_.timeout);
+                open = sent;
+            }
+        }
+        if (pending.size() > options_.max_line)
+            open = false;
+    }
+    clients_.erase(fd);
+    ::close(fd);
+    finished();
+}
+
+} // namespace mprp
@@ -0,0 +1,218 @@
+#include "mprp/convolutional.hpp"
+
+#include "viterbi_kernels.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace mprp {
+
+namespace {
+
+unsigned parity(std::uint32_t x) noexcept
+{
+    return static_cast<unsigned>(std::popcount(x) & 1);
+}
+
+std::uint32_t register_mask(unsigned k) noexcept
+{
+    return k >= 32 ? ~0u : (1u << k) - 1u;
+}
+
+// Starting metric of unreachable Viterbi states; far above any real path
+// but with room to add branch costs without overflow.
+constexpr std::int32_t unreachable = 1 << 28;
+
+} // namespace
+
+void conv_encode(const ConvCode& code, std::span<const std::uint8_t> bits, std::span<std::uint8_t> out) noexcept
+{
+    const std::uint32_t mask = register_mask(code.k);
+    std::uint32_t reg = 0;
+    const std::size_t n = std::min(bits.size(), out.size() / 2);
+    for (std::size_t i = 0; i < n; ++i) {
+        reg = ((reg << 1) | (bits[i] & 1u)) & mask;
+        out[2 * i] = static_cast<std::uint8_t>(parity(reg & code.polys[0]));
+        out[2 * i + 1] = static_cast<std::uint8_t>(parity(reg & code.polys[1]));
+    }
+}
+
+// ---- Fano -------------------------------------------------------------------
+
+FanoDecoder::FanoDecoder(const ConvCode& code, FanoOptions options, std::pmr::memory_resource* resource)
+    : code_(code), options_(options), nodes_(resource)
+{
+    if (code.k < 2 || code.k > 32)
+        throw std::invalid_argument("FanoDecoder: constraint length must be 2..32");
+    // Fano bit metric log2(P(r|1) / P(r)) - bias, with P(r|1) / P(r) =
+    // 2 / (1 + e^-llr), scaled by 16 into integers.
+    for (int r = -128; r < 128; ++r) {
+        const int clamped = std::max(r, -127);
+        const double llr = clamped * options_.llr_per_unit;
+        const double m = std::log2(2.0 / (1.0 + std::exp(-llr))) - options_.bias;
+        metric1_[static_cast<std::size_t>(r + 128)] = static_cast<std::int32_t>(std::lround(16.0 * m));
+    }
+}
+
+void FanoDecoder::branches(Node& node, std::size_t depth, bool tail, std::span<const std::int8_t> soft) const noexcept
+{
+    const int r0 = soft[2 * depth];
+    const int r1 = soft[2 * depth + 1];
+    auto metric = [&](unsigned bit, int r) {
+        // Expecting 0 is expecting 1 of the negated symbol.
+        return metric1_[static_cast<std::size_t>((bit ? std::max(r, -127) : -std::max(r, -127)) + 128)];
+    };
+    auto branch = [&](unsigned b) {
+        const std::uint32_t reg = (node.state << 1) | b;
+        return metric(parity(reg & code_.polys[0]), r0) + metric(parity(reg & code_.polys[1]), r1);
+    };
+
+    const std::int32_t m0 = branch(0);
+    if (tail) {
+        node.tm[0] = m0;
+        node.bit[0] = 0;
+        node.tm[1] = std::numeric_limits<std::int32_t>::min() / 2;
+        node.bit[1] = 1;
+    } else {
+        const std::int32_t m1 = branch(1);
+        const bool one_first = m1 > m0;
+        node.tm[0] = one_first ? m1 : m0;
+        node.tm[1] = one_first ? m0 : m1;
+        node.bit[0] = one_first ? 1 : 0;
+        node.bit[1] = one_first ? 0 : 1;
+    }
+    node.tried = 0;
+}
+
+DecodeResult FanoDecoder::decode(std::span<const std::int8_t> soft, std::span<std::uint8_t> bits)
+{
+    const std::size_t n = bits.size();
+    if (soft.size() < 2 * n)
+        throw std::invalid_argument("FanoDecoder: need two soft symbols per bit");
+    DecodeResult result;
+    if (n == 0)
+        return result;
+
+    const std::size_t tail_start = n > code_.k - 1 ? n - (code_.k - 1) : 0;
+    nodes_.resize(n + 1);
+    Node* const first = nodes_.data();
+    Node* const last = first + n;
+    Node* np = first;
+    np->state = 0;
+    np->gamma = 0;
+    branches(*np, 0, tail_start == 0, soft);
+
+    const std::int32_t delta = options_.delta;
+    const std::uint64_t budget = static_cast<std::uint64_t>(options_.cycles_per_bit) * n;
+    std::int32_t threshold = 0;
+    bool done = false;
+
+    while (result.cycles < budget) {
+        ++result.cycles;
+        const std::int32_t ngamma = np->gamma + np->tm[np->tried];
+        if (ngamma >= threshold) {
+            // Tighten the threshold on a node's first visit.
+            if (np->gamma < threshold + delta)
+                while (ngamma >= threshold + delta)
+                    threshold += delta;
+            Node* next = np + 1;
+            next->gamma = ngamma;
+            next->state = (np->state << 1) | np->bit[np->tried];
+            np = next;
+            if (np == last) {
+                done = true;
+                break;
+            }
+            const auto depth = static_cast<std::size_t>(np - first);
+            branches(*np, depth, depth >= tail_start, soft);
+            continue;
+        }
+        // Look back for an unexplored branch above the threshold.
+        for (;;) {
+            if (np == first || np[-1].gamma < threshold) {
+                threshold -= delta;
+                np->tried = 0;
+                break;
+            }
+            --np;
+            if (static_cast<std::size_t>(np - first) < tail_start && np->tried == 0) {
+                np->tried = 1;
+                break;
+            }
+        }
+    }
+
+    // On give-up the bits hold the deepest path still on the stack.
+    const auto reached = static_cast<std::size_t>(np - first);
+    for (std::size_t d = 0; d < n; ++d)
+        bits[d] = d < reached ? static_cast<std::uint8_t>(first[d + 1].state & 1u) : 0;
+    result.status = done ? DecodeStatus::Ok : DecodeStatus::BudgetExhausted;
+    result.metric = np->gamma;
+    return result;
+}
+
+// ---- Viterbi ----------------------------------------------------------------
+
+ViterbiDecoder::ViterbiDecoder(const ConvCode& code, Isa isa, std::pmr::memory_resource* resource)
+    : code_(code),
+      isa_(isa_supported(isa) ? isa : Isa::Scalar),
+      states_(std::size_t{1} << (code.k - 1)),
+      signs_(resource),
+      metrics_(resource),
+      decisions_(resource)
+{
+    if (code.k < 3 || code.k > 9)
+        throw std::invalid_argument("ViterbiDecoder: constraint length must be 3..9");
+    const std::size_t half = states_ / 2;
+    signs_.resize(8 * half);
+    for (unsigned o = 0; o < 2; ++o)
+        for (unsigned b = 0; b < 2; ++b)
+            for (unsigned h = 0; h < 2; ++h)
+                for (std::size_t j = 0; j < half; ++j) {
+                    const auto from = static_cast<std::uint32_t>(j + h * half);
+                    const std::uint32_t reg = (from << 1) | b;
+                    signs_[((o * 2 + b) * 2 + h) * half + j] = parity(reg & code_.polys[o]) ? -1 : 1;
+                }
+    metrics_.resize(2 * states_);
+}
+
+DecodeResult ViterbiDecoder::decode(std::span<const std::int8_t> soft, std::span<std::uint8_t> bits)
+{
+    const std::size_t n = bits.size();
+    if (soft.size() < 2 * n)
+        throw std::invalid_argument("ViterbiDecoder: need two soft symbols per bit");
+    const std::size_t half = states_ / 2;
+    const std::size_t row = (states_ + 7) / 8;
+    if (decisions_.size() < n * row)
+        decisions_.resize(n * row);  // grows to the longest frame, then stays
+
+    std::int32_t* cur = metrics_.data();
+    std::int32_t* nxt = metrics_.data() + states_;
+    std::fill_n(cur, states_, unreachable);
+    cur[0] = 0;
+
+    const auto step = detail::viterbi_step_kernel(isa_, half);
+    for (std::size_t t = 0; t < n; ++t) {
+        step(cur, nxt, half, signs_.data(), soft[2 * t], soft[2 * t + 1], decisions_.data() + t * row);
+        std::swap(cur, nxt);
+    }
+
+    // Tail termination: the path ends in state 0.
+    std::size_t state = 0;
+    for (std::size_t t = n; t-- > 0;) {
+        const std::uint8_t* d = decisions_.data() + t * row;
+        bits[t] = static_cast<std::uint8_t>(state & 1u);
+        const bool upper = (d[state / 8] >> (state % 8)) & 1u;
+        state = (state >> 1) | (upper ? half : 0);
+    }
+
+    DecodeResult result;
+    result.metric = cur[0];
+    result.cycles = n;
+    return result;
+}
+
+} // namespace mprp
@@ -0,0 +1,74 @@
+#include "mprp/cpu.hpp"
+
+#include <cstdlib>
+#include <initializer_list>
+
+#include <unistd.h>
+
+#if defined(__arm__) && defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+namespace mprp {
+
+const char* to_string(Isa isa) noexcept
+{
+    switch (isa) {
+    case Isa::Scalar: return "scalar";
+    case Isa::Avx2: return "avx2";
+    case Isa::Neon: return "neon";
+    }
+    return "?";
+}
+
+bool isa_supported(Isa isa) noexcept
+{
+    switch (isa) {
+    case Isa::Scalar:
+        return true;
+    case Isa::Avx2:
+#if defined(MPRP_HAVE_AVX2)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+        return false;
+#endif
+    case Isa::Neon:
+#if defined(MPRP_HAVE_NEON) && defined(__aarch64__)
+        return true;  // Advanced SIMD is mandatory on AArch64.
+#elif defined(MPRP_HAVE_NEON) && defined(__linux__)
+        return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+Isa best_isa() noexcept
+{
+    static const Isa isa = [] {
+        if (std::getenv("MPRP_FORCE_SCALAR"))
+            return Isa::Scalar;
+        for (Isa candidate : {Isa::Avx2, Isa::Neon})
+            if (isa_supported(candidate))
+                return candidate;
+        return Isa::Scalar;
+    }();
+    return isa;
+}
+
+std::size_t l1_data_cache_bytes() noexcept
+{
+    static const std::size_t bytes = [] {
+#if defined(_SC_LEVEL1_DCACHE_SIZE)
+        const long n = ::sysconf(_SC_LEVEL1_DCACHE_SIZE);
+        if (n > 0)
+            return static_cast<std::size_t>(n);
+#endif
+        return std::size_t{32 * 1024};
+    }();
+    return bytes;
+}
+
+} // namespace mprp
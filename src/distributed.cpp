@@ -0,0 +1,650 @@
+#include "mprp/distributed.hpp"
+
+#include "mprp/capture.hpp"
+#include "mprp/hash.hpp"
+#include "mprp/metrics.hpp"
+#include "mprp/rx_stages.hpp"
+#include "mprp/wspr_search.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace mprp {
+
+namespace {
+
+constexpr std::uint32_t frame_magic = 0x4452504d;  // "MPRD"
+constexpr std::uint16_t protocol_version = 2;
+constexpr std::uint32_t max_payload = 1u << 30;
+constexpr std::int64_t slot_ns = 120'000'000'000;
+// A window starts this far ahead of its slot, so the slot boundary is
+// always inside it, and must reach this far into the slot to be decodable
+// (the latest transmission start plus 162 symbols).
+constexpr std::int64_t lead_ns = 1'000'000'000;
+constexpr std::int64_t decodable_ns = 116'000'000'000;
+// A connection that has not authenticated by then is dropped.
+constexpr std::chrono::seconds handshake_timeout{10};
+
+enum class FrameType : std::uint16_t {
+    Hello = 1,
+    Job = 2,
+    Result = 3,
+    Bye = 4,
+    Challenge = 5,
+    Welcome = 6,
+};
+
+struct FrameHeader {
+    std::uint32_t magic;
+    FrameType type;
+    std::uint16_t version;
+    std::uint32_t bytes;     ///< Payload size.
+    std::uint32_t checksum;  ///< Low half of Fnv1a over the payload.
+};
+static_assert(sizeof(FrameHeader) == 16);
+
+using Nonce = std::array<unsigned char, 32>;
+
+struct HelloBody {
+    std::uint32_t capacity;
+    std::uint32_t reserved;
+    char name[32];
+    Nonce nonce;  ///< The worker's challenge to the coordinator.
+    Digest256 mac;  ///< See worker_mac().
+};
+static_assert(sizeof(HelloBody) == 104);
+
+struct JobBody {
+    std::uint64_t id;
+    double shift_hz;
+    double out_rate;
+    double min_hz;
+    double max_hz;
+    double dial_hz;
+    std::int64_t from_unix_ns;
+    std::int64_t to_unix_ns;
+};  // followed by the capture image
+static_assert(sizeof(JobBody) == 64);
+
+struct ResultBody {
+    std::uint64_t id;
+    std::uint32_t status;  ///< 0 decoded, else the job failed on the worker.
+    std::uint32_t records;
+};  // followed by the LogRecords
+static_assert(sizeof(ResultBody) == 16);
+
+struct Frame {
+    FrameType type;
+    std::vector<unsigned char> payload;
+};
+
+bool send_all(int fd, const void* data, std::size_t n) noexcept
+{
+    const auto* p = static_cast<const unsigned char*>(data);
+    while (n > 0) {
+        const ssize_t w = ::send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return false;
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+    return true;
+}
+
+bool recv_all(int fd, void* data, std::size_t n) noexcept
+{
+    auto* p = static_cast<unsigned char*>(data);
+    while (n > 0) {
+        const ssize_t r = ::recv(fd, p, n, 0);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        n -= static_cast<std::size_t>(r);
+    }
+    return true;
+}
+
+/// Sends a frame whose payload is head followed by tail (which is not
+/// copied: a job's capture image goes straight from its buffer).
+bool send_frame(int fd, FrameType type, const void* head, std::size_t head_bytes, const void* tail = nullptr,
+                std::size_t tail_bytes = 0) noexcept
+{
+    if (head_bytes + tail_bytes > max_payload)
+        return false;
+    FrameHeader h{};
+    h.magic = frame_magic;
+    h.type = type;
+    h.version = protocol_version;
+    h.bytes = static_cast<std::uint32_t>(head_bytes + tail_bytes);
+    h.checksum = static_cast<std::uint32_t>(Fnv1a().bytes(head, head_bytes).bytes(tail, tail_bytes).value());
+    return send_all(fd, &h, sizeof h) && send_all(fd, head, head_bytes) && send_all(fd, tail, tail_bytes);
+}
+
+/// The next frame, or nullopt on a closed connection, timeout or corrupt
+/// frame (after which the stream cannot be trusted).
+std::optional<Frame> recv_frame(int fd)
+{
+    FrameHeader h;
+    if (!recv_all(fd, &h, sizeof h) || h.magic != frame_magic || h.version != protocol_version
+        || h.bytes > max_payload)
+        return std::nullopt;
+    Frame f{h.type, std::vector<unsigned char>(h.bytes)};
+    if (!recv_all(fd, f.payload.data(), f.payload.size())
+        || h.checksum != static_cast<std::uint32_t>(Fnv1a().bytes(f.payload.data(), f.payload.size()).value()))
+        return std::nullopt;
+    return f;
+}
+
+// Zero timeouts block indefinitely.
+void tune_socket(int fd, std::chrono::milliseconds recv_timeout, std::chrono::milliseconds send_timeout) noexcept
+{
+    const auto tv = [](std::chrono::milliseconds t) {
+        return timeval{static_cast<time_t>(t.count() / 1000), static_cast<suseconds_t>(t.count() % 1000 * 1000)};
+    };
+    const timeval rcv = tv(recv_timeout);
+    const timeval snd = tv(send_timeout);
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &rcv, sizeof rcv);
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &snd, sizeof snd);
+    const int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+}
+
+Nonce make_nonce()
+{
+    Nonce n;
+    if (::getrandom(n.data(), n.size(), 0) != static_cast<ssize_t>(n.size()))
+        throw std::runtime_error(std::string("cannot read random bytes: ") + std::strerror(errno));
+    return n;
+}
+
+std::span<const unsigned char> secret_bytes(const std::string& secret) noexcept
+{
+    return {reinterpret_cast<const unsigned char*>(secret.data()), secret.size()};
+}
+
+// Both sides prove they hold the secret by keying a MAC over the other's
+// fresh nonce, so a recorded handshake cannot be replayed. The worker's
+// also covers the rest of its Hello.
+Digest256 worker_mac(const std::string& secret, const Nonce& challenge, const HelloBody& hello)
+{
+    std::vector<unsigned char> msg{'w', 'o', 'r', 'k', 'e', 'r'};
+    msg.insert(msg.end(), challenge.begin(), challenge.end());
+    const auto* body = reinterpret_cast<const unsigned char*>(&hello);
+    msg.insert(msg.end(), body, body + offsetof(HelloBody, mac));
+    return hmac_sha256(secret_bytes(secret), msg);
+}
+
+Digest256 coordinator_mac(const std::string& secret, const Nonce& challenge, const Nonce& worker_nonce)
+{
+    std::vector<unsigned char> msg{'c', 'o', 'o', 'r', 'd'};
+    msg.insert(msg.end(), worker_nonce.begin(), worker_nonce.end());
+    msg.insert(msg.end(), challenge.begin(), challenge.end());
+    return hmac_sha256(secret_bytes(secret), msg);
+}
+
+bool is_loopback(const sockaddr* a) noexcept
+{
+    if (a->sa_family == AF_INET)
+        return ntohl(reinterpret_cast<const sockaddr_in*>(a)->sin_addr.s_addr) >> 24 == 127;
+    if (a->sa_family != AF_INET6)
+        return false;
+    const in6_addr& v6 = reinterpret_cast<const sockaddr_in6*>(a)->sin6_addr;
+    return IN6_IS_ADDR_LOOPBACK(&v6) || (IN6_IS_ADDR_V4MAPPED(&v6) && v6.s6_addr[12] == 127);
+}
+
+template <std::size_t N>
+void copy_text(char (&out)[N], std::string_view text) noexcept
+{
+    std::memset(out, 0, N);
+    std::memcpy(out, text.data(), std::min(N, text.size()));
+}
+
+} // namespace
+
+// ---- decode and merge -----------------------------------------------------
+
+std::vector<LogRecord> decode_job(const DecodeJob& job)
+{
+    const CaptureReader reader{std::span<const unsigned char>(job.capture)};
+    auto source = std::make_unique<CaptureSource>(reader, job.from, job.to);
+    const double passband = 0.4 * job.out_rate;
+
+    std::vector<LogRecord> records;
+    BufferPool pool(8, 16384);
+    RxPipeline rx(pool, std::move(source));
+    rx.add(std::make_unique<FrontEndStage>(job.shift_hz, job.out_rate, passband, std::nullopt, 4096));
+    WsprSearchConfig config;
+    config.sample_rate = job.out_rate;
+    config.min_hz = job.min_hz;
+    config.max_hz = job.max_hz;
+    config.full_search_every = 1;  // a job is one slot: nothing to seed from
+    rx.add(std::make_unique<WsprDecodeStage>(config, [&](std::span<const WsprSpot> spots) {
+        for (const WsprSpot& s : spots)
+            records.push_back(spot_record(s, job.dial_hz));
+    }));
+    rx.run();
+    return records;
+}
+
+std::vector<LogRecord> merge_spots(std::vector<LogRecord> spots, double tolerance_hz)
+{
+    std::sort(spots.begin(), spots.end(), [](const LogRecord& a, const LogRecord& b) {
+        if (a.time_unix_ns != b.time_unix_ns)
+            return a.time_unix_ns < b.time_unix_ns;
+        const int c = a.callsign_view().compare(b.callsign_view());
+        if (c != 0)
+            return c < 0;
+        return a.freq_hz < b.freq_hz;
+    });
+    // Within one slot and callsign, runs of close frequencies are one
+    // transmission; keep the best-heard copy of each.
+    std::vector<LogRecord> merged;
+    for (std::size_t i = 0; i < spots.size();) {
+        std::size_t best = i;
+        std::size_t j = i + 1;
+        for (; j < spots.size() && spots[j].time_unix_ns == spots[i].time_unix_ns
+               && spots[j].callsign_view() == spots[i].callsign_view()
+               && spots[j].freq_hz - spots[j - 1].freq_hz <= tolerance_hz;
+             ++j)
+            if (spots[j].snr_db > spots[best].snr_db)
+                best = j;
+        merged.push_back(spots[best]);
+        i = j;
+    }
+    std::sort(merged.begin(), merged.end(), [](const LogRecord& a, const LogRecord& b) {
+        return a.time_unix_ns != b.time_unix_ns ? a.time_unix_ns < b.time_unix_ns : a.freq_hz < b.freq_hz;
+    });
+    return merged;
+}
+
+// ---- coordinator ----------------------------------------------------------
+
+Coordinator::Coordinator(CoordinatorOptions options) : options_(std::move(options))
+{
+    const double half = options_.span_hz / 2.0 / static_cast<double>(std::max<std::size_t>(options_.bands, 1));
+    if (options_.bands == 0 || !(options_.span_hz > 0.0) || !(options_.guard_hz >= 0.0)
+        || half + options_.guard_hz > 0.4 * options_.out_rate)
+        throw std::invalid_argument("sub-bands (span / bands + 2 guards) must fit in 0.8 x the baseband rate");
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+    addrinfo* list = nullptr;
+    const std::string where = options_.bind_address + " port " + std::to_string(options_.port);
+    if (::getaddrinfo(options_.bind_address.c_str(), std::to_string(options_.port).c_str(), &hints, &list) != 0
+        || !list)
+        throw std::invalid_argument("cannot resolve bind address '" + options_.bind_address + "'");
+    std::unique_ptr<addrinfo, void (*)(addrinfo*)> owner(list, ::freeaddrinfo);
+    if (options_.secret.empty() && !is_loopback(list->ai_addr))
+        throw std::invalid_argument("listening on " + options_.bind_address
+                                    + " needs a shared secret; only loopback is served without one");
+
+    listen_fd_ = ::socket(list->ai_family, list->ai_socktype | SOCK_CLOEXEC, list->ai_protocol);
+    if (listen_fd_ < 0)
+        throw std::runtime_error(std::string("cannot create socket: ") + std::strerror(errno));
+    const int one = 1;
+    const int zero = 0;
+    ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    if (list->ai_family == AF_INET6)
+        ::setsockopt(listen_fd_, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof zero);  // IPv4 workers on "::" too
+    sockaddr_storage addr{};
+    socklen_t len = sizeof addr;
+    if (::bind(listen_fd_, list->ai_addr, list->ai_addrlen) != 0 || ::listen(listen_fd_, 16) != 0
+        || ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        const int err = errno;
+        ::close(listen_fd_);
+        throw std::runtime_error("cannot listen on " + where + ": " + std::strerror(err));
+    }
+    port_ = ntohs(addr.ss_family == AF_INET6 ? reinterpret_cast<const sockaddr_in6&>(addr).sin6_port
+                                             : reinterpret_cast<const sockaddr_in&>(addr).sin_port);
+}
+
+Coordinator::~Coordinator()
+{
+    {
+        std::lock_guard lock(mutex_);
+        finished_ = plan_.size();
+        pending_.clear();
+    }
+    changed_.notify_all();
+    for (std::thread& t : threads_)
+        t.join();
+    ::close(listen_fd_);
+}
+
+void Coordinator::add_capture(const CaptureReader& reader)
+{
+    const auto chunks = reader.chunks();
+    if (chunks.empty())
+        return;
+    const std::int64_t begin = chunks.front().start_unix_ns;
+    const std::int64_t end = chunks.back().end().time_since_epoch().count();
+    const double dial = options_.dial_hz.value_or(chunks.front().centre_hz);
+    // Every even-minute slot that starts in the capture and is covered
+    // long enough to decode.
+    std::lock_guard lock(mutex_);
+    for (std::int64_t slot = (begin + slot_ns - 1) / slot_ns * slot_ns; slot + decodable_ns <= end; slot += slot_ns)
+        for (std::size_t band = 0; band < options_.bands; ++band) {
+            pending_.push_back(plan_.size());
+            plan_.push_back({&reader, TimePoint(std::chrono::nanoseconds(slot)), band, dial});
+            attempts_.push_back(0);
+        }
+}
+
+DecodeJob Coordinator::make_job(std::size_t index)
+{
+    // add_capture() may be growing plan_ on another thread; copy the entry
+    // under the lock and cut the window outside it.
+    Planned p;
+    {
+        std::lock_guard lock(mutex_);
+        p = plan_[index];
+    }
+    const double width = options_.span_hz / static_cast<double>(options_.bands);
+    DecodeJob job;
+    job.id = index;
+    job.shift_hz = options_.shift_hz - options_.span_hz / 2.0 + (static_cast<double>(p.band) + 0.5) * width;
+    job.out_rate = options_.out_rate;
+    job.max_hz = width / 2.0 + options_.guard_hz;
+    job.min_hz = -job.max_hz;
+    job.dial_hz = p.dial_hz + job.shift_hz;
+    job.from = p.slot - std::chrono::nanoseconds(lead_ns);
+    job.to = p.slot + std::chrono::nanoseconds(slot_ns);
+    job.capture = capture_window(*p.reader, job.from, job.to);
+    return job;
+}
+
+void Coordinator::retry(std::size_t index)
+{
+    // Called with mutex_ held.
+    if (++attempts_[index] < options_.max_attempts) {
+        pending_.push_front(index);
+    } else {
+        ++failed_;
+        ++finished_;
+    }
+}
+
+std::optional<Coordinator::Hello> Coordinator::authenticate(int fd)
+{
+    tune_socket(fd, handshake_timeout, handshake_timeout);
+    const Nonce challenge = make_nonce();
+    if (!send_frame(fd, FrameType::Challenge, challenge.data(), challenge.size()))
+        return std::nullopt;
+    const auto frame = recv_frame(fd);
+    if (!frame || frame->type != FrameType::Hello || frame->payload.size() != sizeof(HelloBody))
+        return std::nullopt;
+    HelloBody body;
+    std::memcpy(&body, frame->payload.data(), sizeof body);
+    if (!digest_equal(body.mac, worker_mac(options_.secret, challenge, body)))
+        return std::nullopt;
+    const Digest256 mac = coordinator_mac(options_.secret, challenge, body.nonce);
+    if (!send_frame(fd, FrameType::Welcome, mac.data(), mac.size()))
+        return std::nullopt;
+    return Hello{body.capacity};
+}
+
+void Coordinator::serve(int fd)
+{
+    static const metrics::CounterId jobs_sent = metrics::counter("dist.jobs_sent");
+    static const metrics::CounterId jobs_done = metrics::counter("dist.jobs_done");
+    static const metrics::CounterId rejected = metrics::counter("dist.rejected");
+
+    const auto hello = authenticate(fd);
+    if (!hello) {
+        metrics::add(rejected);
+        ::close(fd);
+        return;
+    }
+    const std::uint32_t capacity = std::clamp<std::uint32_t>(hello->capacity, 1, 64);
+    tune_socket(fd, options_.job_timeout, options_.job_timeout);
+    std::vector<std::size_t> inflight;
+    const auto give_back = [&] {
+        std::lock_guard lock(mutex_);
+        for (std::size_t index : inflight)
+            retry(index);
+        changed_.notify_all();
+    };
+
+    for (;;) {
+        std::vector<std::size_t> fresh;
+        {
+            std::unique_lock lock(mutex_);
+            while (inflight.size() + fresh.size() < capacity && !pending_.empty()) {
+                fresh.push_back(pending_.front());
+                pending_.pop_front();
+            }
+            if (inflight.empty() && fresh.empty()) {
+                if (finished_ == plan_.size())
+                    break;
+                // Everything left is in flight elsewhere; one of those may
+                // come back.
+                changed_.wait_for(lock, std::chrono::seconds(1));
+                continue;
+            }
+        }
+        for (std::size_t index : fresh) {
+            inflight.push_back(index);
+            const DecodeJob job = make_job(index);
+            const JobBody body{job.id,      job.shift_hz, job.out_rate,
+                               job.min_hz,  job.max_hz,   job.dial_hz,
+                               job.from.time_since_epoch().count(), job.to.time_since_epoch().count()};
+            if (!send_frame(fd, FrameType::Job, &body, sizeof body, job.capture.data(), job.capture.size())) {
+                give_back();
+                ::close(fd);
+                return;
+            }
+            metrics::add(jobs_sent);
+        }
+
+        const auto result = recv_frame(fd);
+        ResultBody body{};
+        if (result && result->type == FrameType::Result && result->payload.size() >= sizeof body)
+            std::memcpy(&body, result->payload.data(), sizeof body);
+        const auto it = std::find(inflight.begin(), inflight.end(), body.id);
+        if (!result || it == inflight.end()
+            || result->payload.size() != sizeof body + std::size_t{body.records} * sizeof(LogRecord)) {
+            give_back();
+            ::close(fd);
+            return;
+        }
+        inflight.erase(it);
+
+        std::lock_guard lock(mutex_);
+        if (body.status == 0) {
+            const std::size_t at = spots_.size();
+            spots_.resize(at + body.records);
+            std::memcpy(spots_.data() + at, result->payload.data() + sizeof body, body.records * sizeof(LogRecord));
+            ++finished_;
+            metrics::add(jobs_done);
+        } else {
+            retry(static_cast<std::size_t>(body.id));
+        }
+        changed_.notify_all();
+    }
+    send_frame(fd, FrameType::Bye, nullptr, 0);
+    ::close(fd);
+}
+
+std::vector<LogRecord> Coordinator::run()
+{
+    for (;;) {
+        {
+            std::lock_guard lock(mutex_);
+            if (finished_ == plan_.size())
+                break;
+        }
+        pollfd p{listen_fd_, POLLIN, 0};
+        if (::poll(&p, 1, 200) != 1)
+            continue;
+        const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+        std::lock_guard lock(mutex_);
+        ++workers_;
+        threads_.emplace_back([this, fd] { serve(fd); });
+    }
+    for (std::thread& t : threads_)
+        t.join();
+    threads_.clear();
+
+    std::lock_guard lock(mutex_);
+    return merge_spots(std::move(spots_));
+}
+
+// ---- worker ---------------------------------------------------------------
+
+std::size_t run_worker(const WorkerOptions& options)
+{
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* list = nullptr;
+    const std::string port = std::to_string(options.port);
+    if (::getaddrinfo(options.host.c_str(), port.c_str(), &hints, &list) != 0)
+        throw std::runtime_error("cannot resolve '" + options.host + "'");
+    int fd = -1;
+    for (addrinfo* a = list; a && fd < 0; a = a->ai_next) {
+        fd = ::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+        if (fd >= 0 && ::connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    ::freeaddrinfo(list);
+    if (fd < 0)
+        throw std::runtime_error("cannot connect to coordinator " + options.host + ":" + port);
+    const unsigned threads = std::max(1u, options.threads);
+    HelloBody hello{};
+    hello.capacity = threads;
+    std::string name = options.name;
+    if (name.empty()) {
+        char host[256] = {};
+        ::gethostname(host, sizeof host - 1);
+        name = host;
+    }
+    copy_text(hello.name, name);
+    hello.nonce = make_nonce();
+
+    tune_socket(fd, handshake_timeout, handshake_timeout);
+    const auto challenge = recv_frame(fd);
+    if (!challenge || challenge->type != FrameType::Challenge || challenge->payload.size() != sizeof(Nonce)) {
+        ::close(fd);
+        throw std::runtime_error("coordinator closed the connection");
+    }
+    Nonce nonce;
+    std::memcpy(nonce.data(), challenge->payload.data(), nonce.size());
+    hello.mac = worker_mac(options.secret, nonce, hello);
+    if (!send_frame(fd, FrameType::Hello, &hello, sizeof hello)) {
+        ::close(fd);
+        throw std::runtime_error("coordinator closed the connection");
+    }
+    const auto welcome = recv_frame(fd);
+    Digest256 mac{};
+    if (welcome && welcome->type == FrameType::Welcome && welcome->payload.size() == mac.size())
+        std::memcpy(mac.data(), welcome->payload.data(), mac.size());
+    if (!welcome || !digest_equal(mac, coordinator_mac(options.secret, nonce, hello.nonce))) {
+        ::close(fd);
+        throw std::runtime_error("authentication with coordinator " + options.host + ":" + port
+                                 + " failed (different secret?)");
+    }
+    // Jobs arrive whenever the coordinator has one, so receives do not time
+    // out; sends (results) do.
+    tune_socket(fd, std::chrono::milliseconds(0), std::chrono::seconds(60));
+
+    static const metrics::StageId decode_timer = metrics::stage("dist.job");
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<DecodeJob> queue;
+    bool closing = false;
+    std::mutex send_mutex;
+    std::size_t done = 0;
+
+    std::vector<std::thread> decoders;
+    for (unsigned t = 0; t < threads; ++t)
+        decoders.emplace_back([&] {
+            for (;;) {
+                DecodeJob job;
+                {
+                    std::unique_lock lock(mutex);
+                    ready.wait(lock, [&] { return closing || !queue.empty(); });
+                    if (queue.empty())
+                        return;
+                    job = std::move(queue.front());
+                    queue.pop_front();
+                }
+                ResultBody body{job.id, 0, 0};
+                std::vector<LogRecord> records;
+                try {
+                    metrics::ScopedTimer timer(decode_timer);
+                    records = decode_job(job);
+                } catch (const std::exception&) {
+                    body.status = 1;
+                    records.clear();
+                }
+                body.records = static_cast<std::uint32_t>(records.size());
+                std::lock_guard lock(send_mutex);
+                if (send_frame(fd, FrameType::Result, &body, sizeof body, records.data(),
+                               records.size() * sizeof(LogRecord))) {
+                    std::lock_guard count(mutex);
+                    ++done;
+                }
+            }
+        });
+
+    while (const auto frame = recv_frame(fd)) {
+        if (frame->type == FrameType::Bye)
+            break;
+        if (frame->type != FrameType::Job || frame->payload.size() < sizeof(JobBody))
+            continue;
+        JobBody body;
+        std::memcpy(&body, frame->payload.data(), sizeof body);
+        DecodeJob job;
+        job.id = body.id;
+        job.shift_hz = body.shift_hz;
+        job.out_rate = body.out_rate;
+        job.min_hz = body.min_hz;
+        job.max_hz = body.max_hz;
+        job.dial_hz = body.dial_hz;
+        job.from = TimePoint(std::chrono::nanoseconds(body.from_unix_ns));
+        job.to = TimePoint(std::chrono::nanoseconds(body.to_unix_ns));
+        job.capture.assign(frame->payload.begin() + sizeof body, frame->payload.end());
+        std::lock_guard lock(mutex);
+        queue.push_back(std::move(job));
+        ready.notify_one();
+    }
+
+    {
+        // Results can no longer be delivered once the coordinator is gone;
+        // after a Bye nothing is queued anyway.
+        std::lock_guard lock(mutex);
+        queue.clear();
+        closing = true;
+    }
+    ready.notify_all();
+    for (std::thread& t : decoders)
+        t.join();
+    ::close(fd);
+    return done;
+}
+
+} // namespace mprp
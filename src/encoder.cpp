@@ -0,0 +1,73 @@
+#include "mprp/encoder.hpp"
+
+#include "mprp/morse.hpp"
+
+#include <bit>
+
+namespace mprp {
+
+namespace {
+
+void push(std::vector<KeyElement>& out, bool on, std::uint16_t units)
+{
+    if (!out.empty() && out.back().on == on) {
+        if (!on && out.back().units < units)
+            out.back().units = units;  // a word gap absorbs the letter gap
+        else if (on)
+            out.back().units = static_cast<std::uint16_t>(out.back().units + units);
+        return;
+    }
+    out.push_back({on, units});
+}
+
+} // namespace
+
+std::vector<KeyElement> encode_morse(std::string_view text)
+{
+    std::vector<KeyElement> out;
+    for (char c : text) {
+        if (c == ' ') {
+            if (!out.empty())
+                push(out, false, 7);
+            continue;
+        }
+        const MorseSymbol sym = morse_lookup(c);
+        if (!sym.valid())
+            continue;
+        if (!out.empty())
+            push(out, false, 3);
+        for (unsigned i = 0; i < sym.length; ++i) {
+            if (i != 0)
+                push(out, false, 1);
+            push(out, true, sym.dah(i) ? 3 : 1);
+        }
+    }
+    while (!out.empty() && !out.back().on)
+        out.pop_back();
+    return out;
+}
+
+std::vector<std::uint8_t> encode_fsk(std::string_view text, unsigned tones)
+{
+    const unsigned bits = static_cast<unsigned>(std::countr_zero(tones));
+    std::vector<std::uint8_t> out;
+    if (bits == 0)
+        return out;
+    out.reserve((text.size() * 8 + bits - 1) / bits);
+
+    unsigned acc = 0;
+    unsigned have = 0;
+    for (unsigned char c : text) {
+        acc = (acc << 8) | c;
+        have += 8;
+        while (have >= bits) {
+            have -= bits;
+            out.push_back(static_cast<std::uint8_t>((acc >> have) & (tones - 1)));
+        }
+    }
+    if (have > 0)
+        out.push_back(static_cast<std::uint8_t>((acc << (bits - have)) & (tones - 1)));
+    return out;
+}
+
+} // namespace mprp
@@ -0,0 +1,136 @@
+#include "mprp/engine.hpp"
+
+#include "mprp/hash.hpp"
+#include "mprp/wspr.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace mprp {
+
+namespace {
+
+// Bump whenever a modulator change alters rendered samples, so cached
+// renders from an older build are not replayed.
+constexpr std::uint32_t render_format = 1;
+
+std::uint64_t content_key(const EngineConfig& config, const BeaconEntry& b)
+{
+    Fnv1a h;
+    h.add(render_format).add(config.sample_rate).add(b.mode).add(b.amplitude).add(b.audio_hz);
+    switch (b.mode) {
+    case Mode::Cw:
+        h.add(b.message).add(b.wpm).add(b.cw_rise_ms);
+        break;
+    case Mode::Fsk:
+        h.add(b.message).add(b.tones).add(b.tone_spacing_hz).add(b.baud);
+        break;
+    case Mode::Wspr:
+        h.add(b.callsign).add(b.grid).add(b.power_dbm);
+        break;
+    }
+    return h.value();
+}
+
+} // namespace
+
+Engine::Engine(EngineConfig config)
+    : config_((config.validate(), std::move(config))),
+      clock_(config_.slot_period_s, config_.slot_offset_s, config_.beacons.size())
+{
+    entries_.reserve(config_.beacons.size());
+    keys_.reserve(config_.beacons.size());
+    for (const auto& b : config_.beacons) {
+        entries_.push_back(prepare(config_, b));
+        keys_.push_back(content_key(config_, b));
+    }
+}
+
+Engine::Engine(EngineConfig config, const Engine& previous)
+    : config_((config.validate(), std::move(config))),
+      clock_(config_.slot_period_s, config_.slot_offset_s, config_.beacons.size())
+{
+    entries_.reserve(config_.beacons.size());
+    keys_.reserve(config_.beacons.size());
+    for (const auto& b : config_.beacons) {
+        const std::uint64_t key = content_key(config_, b);
+        const auto same = std::find(previous.keys_.begin(), previous.keys_.end(), key);
+        if (same != previous.keys_.end())
+            entries_.push_back(previous.entries_[static_cast<std::size_t>(same - previous.keys_.begin())]);
+        else
+            entries_.push_back(prepare(config_, b));
+        keys_.push_back(key);
+    }
+}
+
+Engine Engine::from_file(const std::string& path)
+{
+    return Engine(load_config(path));
+}
+
+Engine::Plan Engine::prepare(const EngineConfig& config, const BeaconEntry& b)
+{
+    switch (b.mode) {
+    case Mode::Cw: {
+        CwModulator mod(config.sample_rate, b.audio_hz, b.wpm, b.amplitude,
+                        b.cw_rise_ms / 1000.0);
+        auto keying = mod.plan(encode_morse(b.message));
+        return CwPlan{std::move(mod), std::move(keying)};
+    }
+    case Mode::Fsk:
+        return FskPlan{FskModulator(config.sample_rate, b.audio_hz, b.tone_spacing_hz, b.baud,
+                                    b.tones, b.amplitude),
+                       encode_fsk(b.message, b.tones)};
+    case Mode::Wspr: {
+        std::vector<std::uint8_t> symbols(wspr_symbol_count);
+        const auto st = wspr_encode({b.callsign, b.grid, b.power_dbm},
+                                    std::span<std::uint8_t, wspr_symbol_count>(symbols));
+        if (st != WsprStatus::Ok)
+            throw ConfigError((b.name.empty() ? std::string("beacon") : b.name) + ": "
+                              + to_string(st));
+        return FskPlan{FskModulator(config.sample_rate, b.audio_hz, wspr_tone_spacing_hz,
+                                    wspr_baud, 4, b.amplitude),
+                       std::move(symbols)};
+    }
+    }
+    throw ConfigError("unsupported mode");
+}
+
+const Engine::Plan& Engine::plan(std::size_t entry) const
+{
+    if (entry >= entries_.size())
+        throw std::out_of_range("beacon entry " + std::to_string(entry) + " does not exist");
+    return entries_[entry];
+}
+
+std::uint64_t Engine::render_key(std::size_t entry) const
+{
+    plan(entry);  // range check
+    return keys_[entry];
+}
+
+std::size_t Engine::transmission_samples(std::size_t entry) const
+{
+    return std::visit(
+        [](const auto& p) -> std::size_t {
+            if constexpr (std::is_same_v<std::decay_t<decltype(p)>, CwPlan>)
+                return p.keying.total;
+            else
+                return p.modulator.length(p.symbols.size());
+        },
+        plan(entry));
+}
+
+std::size_t Engine::render(std::size_t entry, std::span<float> out) const
+{
+    return std::visit(
+        [out](const auto& p) -> std::size_t {
+            if constexpr (std::is_same_v<std::decay_t<decltype(p)>, CwPlan>)
+                return p.modulator.render(p.keying, out);
+            else
+                return p.modulator.render(p.symbols, out);
+        },
+        plan(entry));
+}
+
+} // namespace mprp
@@ -0,0 +1,38 @@
+#include "mprp/envelope.hpp"
+
+#include "mprp/table_snapshot.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <numbers>
+
+namespace mprp {
+
+std::shared_ptr<const std::vector<float>> raised_cosine_edge(std::size_t samples)
+{
+    static std::mutex mutex;
+    static std::map<std::size_t, std::shared_ptr<const std::vector<float>>> cache;
+
+    std::lock_guard lock(mutex);
+    auto& slot = cache[samples];
+    if (!slot) {
+        auto table = std::make_shared<std::vector<float>>(samples);
+        if (const auto t = detail::snapshot_table(TableKind::RaisedCosine, samples); t.size() == samples * sizeof(float)) {
+            std::memcpy(table->data(), t.data(), t.size());
+            slot = std::move(table);
+            return slot;
+        }
+        for (std::size_t k = 0; k < samples; ++k) {
+            // Sample centres, so the edge is symmetric and never hits 0 or 1.
+            const double x = (static_cast<double>(k) + 0.5) / static_cast<double>(samples);
+            (*table)[k] = static_cast<float>(0.5 - 0.5 * std::cos(std::numbers::pi * x));
+        }
+        detail::note_table(TableKind::RaisedCosine, samples, std::as_bytes(std::span(*table)));
+        slot = std::move(table);
+    }
+    return slot;
+}
+
+} // namespace mprp
@@ -0,0 +1,417 @@
+#include "mprp/event_loop.hpp"
+
+#include "mprp/metrics.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <system_error>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace mprp {
+
+namespace {
+
+constexpr std::uint32_t read_events = EPOLLIN | EPOLLRDHUP;
+constexpr std::uint32_t write_events = EPOLLOUT;
+constexpr std::uint32_t error_events = EPOLLERR | EPOLLHUP;
+
+void signal_eventfd(int fd) noexcept
+{
+    const std::uint64_t one = 1;
+    while (::write(fd, &one, sizeof one) < 0 && errno == EINTR) {
+    }
+}
+
+bool drain_eventfd(int fd) noexcept
+{
+    std::uint64_t value = 0;
+    return ::read(fd, &value, sizeof value) == static_cast<ssize_t>(sizeof value);
+}
+
+/// A coroutine nobody awaits: starts at once and frees itself at the end.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+Detached run_detached(EventLoop& loop, Task<void> task)
+{
+    static const metrics::CounterId errors = metrics::counter("loop.task_errors");
+    co_await loop.schedule();
+    try {
+        co_await task;
+    } catch (...) {
+        metrics::add(errors);
+    }
+}
+
+/// getaddrinfo() on a helper thread, resuming the awaiter on the loop.
+class Resolve {
+public:
+    Resolve(EventLoop& loop, const std::string& host, const std::string& service) noexcept
+        : loop_(loop), host_(host), service_(service)
+    {
+    }
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        std::thread([this, h] {
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_flags = AI_NUMERICSERV;
+            if (::getaddrinfo(host_.c_str(), service_.c_str(), &hints, &result_) != 0)
+                result_ = nullptr;
+            loop_.post([h] { h.resume(); });
+        }).detach();
+    }
+    addrinfo* await_resume() const noexcept { return result_; }
+
+private:
+    EventLoop& loop_;
+    const std::string& host_;
+    const std::string& service_;
+    addrinfo* result_ = nullptr;
+};
+
+} // namespace
+
+EventLoop::EventLoop()
+{
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0)
+        throw std::system_error(errno, std::generic_category(), "epoll_create1");
+    wake_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = wake_fd_;
+    if (wake_fd_ < 0 || ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev) < 0) {
+        const int err = errno;
+        if (wake_fd_ >= 0)
+            ::close(wake_fd_);
+        ::close(epoll_fd_);
+        throw std::system_error(err, std::generic_category(), "eventfd");
+    }
+}
+
+EventLoop::~EventLoop()
+{
+    if (thread_.joinable()) {
+        stop();
+        thread_.join();
+    }
+    ::close(wake_fd_);
+    ::close(epoll_fd_);
+}
+
+void EventLoop::start()
+{
+    thread_ = std::thread([this] { run(); });
+}
+
+void EventLoop::stop() noexcept
+{
+    stopping_.store(true, std::memory_order_relaxed);
+    signal_eventfd(wake_fd_);
+}
+
+void EventLoop::post(std::function<void()> fn)
+{
+    {
+        std::lock_guard lock(posted_mutex_);
+        posted_.push_back(std::move(fn));
+    }
+    signal_eventfd(wake_fd_);
+}
+
+void EventLoop::run()
+{
+    thread_id_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    epoll_event events[64];
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        int timeout_ms = -1;
+        if (!timers_.empty()) {
+            const auto left = timers_.begin()->first - std::chrono::steady_clock::now();
+            // Round up: waking a little early would only spin another round.
+            const auto ms = std::chrono::ceil<std::chrono::milliseconds>(left).count();
+            timeout_ms = static_cast<int>(std::clamp<long long>(ms, 0, INT_MAX));
+        }
+        const int n = ::epoll_wait(epoll_fd_, events, 64, timeout_ms);
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.fd == wake_fd_)
+                drain_eventfd(wake_fd_);
+            else
+                fire_fd(events[i].data.fd, events[i].events);
+        }
+        fire_timers();
+        run_posted();
+    }
+    stopping_.store(false, std::memory_order_relaxed);
+    thread_id_.store({}, std::memory_order_relaxed);
+}
+
+bool EventLoop::arm(detail::LoopWait& wait, std::optional<detail::SteadyTime> deadline)
+{
+    if (wait.fd >= 0) {
+        FdWaiters& waiters = fds_[wait.fd];
+        detail::LoopWait*& slot = wait.write ? waiters.writer : waiters.reader;
+        if (slot) {
+            // One waiter per direction; a second one reads as a timeout.
+            wait.ready = false;
+            return false;
+        }
+        slot = &wait;
+        if (!update(wait.fd, waiters)) {
+            // Not pollable (a regular file): always ready.
+            slot = nullptr;
+            if (!waiters.reader && !waiters.writer)
+                fds_.erase(wait.fd);
+            wait.ready = true;
+            return false;
+        }
+    } else if (!deadline) {
+        return false;
+    }
+    if (deadline) {
+        wait.timer = timers_.emplace(*deadline, &wait);
+        wait.timed = true;
+    }
+    return true;
+}
+
+bool EventLoop::update(int fd, FdWaiters& waiters)
+{
+    const std::uint32_t want = (waiters.reader ? read_events : 0) | (waiters.writer ? write_events : 0);
+    if (want == waiters.armed)
+        return true;
+    if (want == 0) {
+        // Fails harmlessly if fd was closed (and so dropped by epoll) first.
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        waiters.armed = 0;
+        return true;
+    }
+    epoll_event ev{};
+    ev.events = want;
+    ev.data.fd = fd;
+    int rc = ::epoll_ctl(epoll_fd_, waiters.armed ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev);
+    if (rc < 0 && errno == ENOENT)
+        rc = ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);  // closed and reopened under the same number
+    else if (rc < 0 && errno == EEXIST)
+        rc = ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+    if (rc < 0)
+        return false;
+    waiters.armed = want;
+    return true;
+}
+
+void EventLoop::fire_fd(int fd, std::uint32_t events)
+{
+    const auto it = fds_.find(fd);
+    if (it == fds_.end())
+        return;
+    FdWaiters& waiters = it->second;
+    detail::LoopWait* reader = nullptr;
+    detail::LoopWait* writer = nullptr;
+    if (events & (read_events | error_events))
+        reader = std::exchange(waiters.reader, nullptr);
+    if (events & (write_events | error_events))
+        writer = std::exchange(waiters.writer, nullptr);
+    update(fd, waiters);
+    if (!waiters.reader && !waiters.writer)
+        fds_.erase(it);
+    if (reader)
+        resume(*reader, true);
+    if (writer)
+        resume(*writer, true);
+}
+
+void EventLoop::fire_timers()
+{
+    const auto now = std::chrono::steady_clock::now();
+    while (!timers_.empty() && timers_.begin()->first <= now) {
+        detail::LoopWait& wait = *timers_.begin()->second;
+        timers_.erase(timers_.begin());
+        wait.timed = false;
+        if (wait.fd >= 0) {
+            const auto it = fds_.find(wait.fd);
+            if (it != fds_.end()) {
+                (wait.write ? it->second.writer : it->second.reader) = nullptr;
+                update(wait.fd, it->second);
+                if (!it->second.reader && !it->second.writer)
+                    fds_.erase(it);
+            }
+        }
+        resume(wait, false);
+    }
+}
+
+void EventLoop::run_posted()
+{
+    {
+        std::lock_guard lock(posted_mutex_);
+        running_.swap(posted_);
+    }
+    for (auto& fn : running_)
+        fn();
+    running_.clear();
+}
+
+void EventLoop::resume(detail::LoopWait& wait, bool ready)
+{
+    if (wait.timed) {
+        timers_.erase(wait.timer);
+        wait.timed = false;
+    }
+    wait.ready = ready;
+    resumes_.fetch_add(1, std::memory_order_relaxed);
+    wait.handle.resume();
+}
+
+EventLoop& control_loop()
+{
+    static EventLoop loop;
+    static std::once_flag started;
+    std::call_once(started, [] { loop.start(); });
+    return loop;
+}
+
+void spawn(EventLoop& loop, Task<void> task)
+{
+    run_detached(loop, std::move(task));
+}
+
+AsyncEvent::AsyncEvent(EventLoop& loop) : loop_(loop)
+{
+    fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fd_ < 0)
+        throw std::system_error(errno, std::generic_category(), "eventfd");
+}
+
+AsyncEvent::~AsyncEvent()
+{
+    ::close(fd_);
+}
+
+void AsyncEvent::set() noexcept
+{
+    signal_eventfd(fd_);
+}
+
+bool AsyncEvent::consume() noexcept
+{
+    return drain_eventfd(fd_);
+}
+
+Task<bool> AsyncEvent::wait_until(detail::SteadyTime deadline)
+{
+    for (;;) {
+        if (consume())
+            co_return true;
+        const bool ready = co_await loop_.readable(fd_, deadline);
+        if (!ready)
+            co_return consume();
+    }
+}
+
+Task<void> AsyncEvent::wait()
+{
+    while (!consume())
+        co_await loop_.readable(fd_);
+}
+
+Task<int> tcp_connect(EventLoop& loop, std::string host, std::uint16_t port, std::chrono::milliseconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    const std::string service = std::to_string(port);
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    addrinfo* list = nullptr;
+    if (::getaddrinfo(host.c_str(), service.c_str(), &hints, &list) != 0)
+        list = co_await Resolve(loop, host, service);
+    if (!list)
+        co_return -1;
+
+    int fd = -1;
+    for (addrinfo* a = list; a && fd < 0; a = a->ai_next) {
+        const int s = ::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, a->ai_protocol);
+        if (s < 0)
+            continue;
+        bool ok = ::connect(s, a->ai_addr, a->ai_addrlen) == 0;
+        if (!ok && errno == EINPROGRESS) {
+            const bool ready = co_await loop.writable(s, deadline);
+            int err = 0;
+            socklen_t len = sizeof err;
+            ok = ready && ::getsockopt(s, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0;
+        }
+        if (!ok) {
+            ::close(s);
+            continue;
+        }
+        const int one = 1;
+        ::setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        fd = s;
+    }
+    ::freeaddrinfo(list);
+    co_return fd;
+}
+
+Task<std::ptrdiff_t> read_some(EventLoop& loop, int fd, std::span<char> buffer, std::chrono::milliseconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+        const ssize_t n = ::read(fd, buffer.data(), buffer.size());
+        if (n >= 0)
+            co_return n;
+        if (errno == EINTR)
+            continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            co_return -1;
+        const bool ready = co_await loop.readable(fd, deadline);
+        if (!ready)
+            co_return -1;
+    }
+}
+
+Task<bool> write_all(EventLoop& loop, int fd, std::string_view data, std::chrono::milliseconds timeout)
+{
+    bool socket = true;
+    while (!data.empty()) {
+        // send() for sockets so a dead peer is EPIPE rather than SIGPIPE;
+        // write() for ttys and pipes.
+        ssize_t n = socket ? ::send(fd, data.data(), data.size(), MSG_NOSIGNAL) : -1;
+        if (n < 0 && socket && errno == ENOTSOCK)
+            socket = false;
+        if (!socket)
+            n = ::write(fd, data.data(), data.size());
+        if (n > 0) {
+            data.remove_prefix(static_cast<std::size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+            co_return false;
+        const bool ready = co_await loop.writable(fd, std::chrono::steady_clock::now() + timeout);
+        if (!ready)
+            co_return false;
+    }
+    co_return true;
+}
+
+} // namespace mprp
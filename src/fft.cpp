@@ -0,0 +1,186 @@
+#include "mprp/fft.hpp"
+
+#include "mprp/table_snapshot.hpp"
+#include "mprp/task_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <numbers>
+#include <stdexcept>
+#include <utility>
+
+namespace mprp {
+
+FftPlan::FftPlan(std::size_t n) : n_(n)
+{
+    if (n < 2 || (n & (n - 1)) != 0 || n > (std::size_t{1} << 30))
+        throw std::invalid_argument("FftPlan: size must be a power of two");
+
+    const std::size_t bitrev_bytes = n * sizeof(std::uint32_t);
+    const std::size_t twiddle_bytes = (n - 1) * sizeof(Complex);
+    if (const auto t = detail::snapshot_table(TableKind::FftPlan, n); t.size() == bitrev_bytes + twiddle_bytes) {
+        bitrev_.resize(n);
+        twiddles_.resize(n - 1);
+        std::memcpy(bitrev_.data(), t.data(), bitrev_bytes);
+        std::memcpy(twiddles_.data(), t.data() + bitrev_bytes, twiddle_bytes);
+        return;
+    }
+
+    unsigned bits = 0;
+    while ((std::size_t{1} << bits) < n)
+        ++bits;
+    bitrev_.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        std::uint32_t r = 0;
+        for (unsigned b = 0; b < bits; ++b)
+            r |= static_cast<std::uint32_t>((i >> b) & 1u) << (bits - 1 - b);
+        bitrev_[i] = r;
+    }
+    twiddles_.reserve(n - 1);
+    for (std::size_t half = 1; half < n; half <<= 1)
+        for (std::size_t k = 0; k < half; ++k) {
+            const double a = -std::numbers::pi * static_cast<double>(k) / static_cast<double>(half);
+            twiddles_.emplace_back(static_cast<float>(std::cos(a)), static_cast<float>(std::sin(a)));
+        }
+
+    std::vector<std::byte> t(bitrev_bytes + twiddle_bytes);
+    std::memcpy(t.data(), bitrev_.data(), bitrev_bytes);
+    std::memcpy(t.data() + bitrev_bytes, twiddles_.data(), twiddle_bytes);
+    detail::note_table(TableKind::FftPlan, n, t);
+}
+
+template <bool Inverse>
+void FftPlan::transform(Complex* data) const noexcept
+{
+    for (std::size_t i = 0; i < n_; ++i) {
+        const std::size_t j = bitrev_[i];
+        if (i < j)
+            std::swap(data[i], data[j]);
+    }
+
+    const Complex* tw = twiddles_.data();
+    for (std::size_t half = 1; half < n_; half <<= 1) {
+        for (std::size_t base = 0; base < n_; base += 2 * half) {
+            Complex* a = data + base;
+            Complex* b = a + half;
+            for (std::size_t k = 0; k < half; ++k) {
+                const Complex w = Inverse ? std::conj(tw[k]) : tw[k];
+                // Spelled out: std::complex operator* carries NaN/Inf
+                // handling that blocks vectorisation.
+                const float br = b[k].real() * w.real() - b[k].imag() * w.imag();
+                const float bi = b[k].real() * w.imag() + b[k].imag() * w.real();
+                const Complex t(br, bi);
+                b[k] = a[k] - t;
+                a[k] += t;
+            }
+        }
+        tw += half;
+    }
+}
+
+void FftPlan::forward(std::span<Complex> data) const noexcept
+{
+    transform<false>(data.data());
+}
+
+void FftPlan::inverse(std::span<Complex> data) const noexcept
+{
+    transform<true>(data.data());
+}
+
+void FftPlan::forward_batch(std::span<Complex> frames, TaskPool* pool) const
+{
+    const std::size_t count = frames.size() / n_;
+    auto body = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t f = begin; f < end; ++f)
+            transform<false>(frames.data() + f * n_);
+    };
+    if (pool)
+        parallel_for(*pool, count, std::max<std::size_t>(1, 16384 / n_), body);
+    else
+        body(0, count);
+}
+
+std::shared_ptr<const FftPlan> fft_plan(std::size_t n)
+{
+    static std::mutex mutex;
+    static std::map<std::size_t, std::shared_ptr<const FftPlan>> cache;
+
+    std::lock_guard lock(mutex);
+    auto& slot = cache[n];
+    if (!slot)
+        slot = std::make_shared<const FftPlan>(n);
+    return slot;
+}
+
+namespace {
+
+WindowTable make_window(Window window, std::size_t n)
+{
+    WindowTable t;
+    t.values.resize(n);
+    const double denom = static_cast<double>(n);  // periodic form, for spectral use
+    for (std::size_t i = 0; i < n; ++i) {
+        const double x = 2.0 * std::numbers::pi * static_cast<double>(i) / denom;
+        double w = 1.0;
+        switch (window) {
+        case Window::Rectangular: w = 1.0; break;
+        case Window::Hann: w = 0.5 - 0.5 * std::cos(x); break;
+        case Window::BlackmanHarris:
+            w = 0.35875 - 0.48829 * std::cos(x) + 0.14128 * std::cos(2 * x)
+                - 0.01168 * std::cos(3 * x);
+            break;
+        }
+        t.values[i] = static_cast<float>(w);
+    }
+    double sum = 0.0;
+    double sum2 = 0.0;
+    for (float w : t.values) {
+        sum += w;
+        sum2 += static_cast<double>(w) * w;
+    }
+    t.coherent_gain = sum / static_cast<double>(n);
+    t.enbw_bins = static_cast<double>(n) * sum2 / (sum * sum);
+    return t;
+}
+
+// Gains first, so the values stay aligned in the snapshot.
+WindowTable snapshot_window(Window window, std::size_t n)
+{
+    const std::uint64_t key = static_cast<std::uint64_t>(window) << 32 | n;
+    const std::size_t bytes = 2 * sizeof(double) + n * sizeof(float);
+    WindowTable t;
+    if (const auto s = detail::snapshot_table(TableKind::Window, key); s.size() == bytes) {
+        t.values.resize(n);
+        std::memcpy(&t.coherent_gain, s.data(), sizeof(double));
+        std::memcpy(&t.enbw_bins, s.data() + sizeof(double), sizeof(double));
+        std::memcpy(t.values.data(), s.data() + 2 * sizeof(double), n * sizeof(float));
+        return t;
+    }
+    t = make_window(window, n);
+    std::vector<std::byte> s(bytes);
+    std::memcpy(s.data(), &t.coherent_gain, sizeof(double));
+    std::memcpy(s.data() + sizeof(double), &t.enbw_bins, sizeof(double));
+    std::memcpy(s.data() + 2 * sizeof(double), t.values.data(), n * sizeof(float));
+    detail::note_table(TableKind::Window, key, s);
+    return t;
+}
+
+} // namespace
+
+std::shared_ptr<const WindowTable> window_table(Window window, std::size_t n)
+{
+    static std::mutex mutex;
+    static std::map<std::pair<Window, std::size_t>, std::shared_ptr<const WindowTable>> cache;
+
+    std::lock_guard lock(mutex);
+    auto& slot = cache[{window, n}];
+    if (!slot)
+        slot = std::make_shared<const WindowTable>(snapshot_window(window, n));
+    return slot;
+}
+
+} // namespace mprp
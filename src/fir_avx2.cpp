@@ -0,0 +1,30 @@
+// AVX2 + FMA FIR dot product. Built with -mavx2 -mfma and only called
+// after isa_supported(Isa::Avx2) has confirmed the CPU.
+
+#include "fir_kernels.hpp"
+
+#include <immintrin.h>
+
+namespace mprp::detail {
+
+FirSum fir_dot_avx2(const float* taps, const float* x, std::size_t floats) noexcept
+{
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 16 <= floats; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(taps + i), _mm256_loadu_ps(x + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(taps + i + 8), _mm256_loadu_ps(x + i + 8), acc1);
+    }
+    for (; i + 8 <= floats; i += 8)
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(taps + i), _mm256_loadu_ps(x + i), acc0);
+
+    // Lanes alternate re, im: fold 8 -> 4 -> 2.
+    const __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 v = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    const FirSum tail = fir_dot_scalar(taps + i, x + i, floats - i);
+    return {_mm_cvtss_f32(v) + tail.re, _mm_cvtss_f32(_mm_shuffle_ps(v, v, 1)) + tail.im};
+}
+
+} // namespace mprp::detail
@@ -0,0 +1,83 @@
+#include "mprp/fir_design.hpp"
+
+#include "mprp/hash.hpp"
+#include "mprp/table_snapshot.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <stdexcept>
+
+namespace mprp {
+
+namespace {
+
+// Zeroth-order modified Bessel function of the first kind (series).
+double bessel_i0(double x) noexcept
+{
+    double sum = 1.0;
+    double term = 1.0;
+    const double q = x * x / 4.0;
+    for (int k = 1; k < 64; ++k) {
+        term *= q / (static_cast<double>(k) * k);
+        sum += term;
+        if (term < sum * 1e-12)
+            break;
+    }
+    return sum;
+}
+
+} // namespace
+
+double kaiser_beta(double atten_db) noexcept
+{
+    if (atten_db > 50.0)
+        return 0.1102 * (atten_db - 8.7);
+    if (atten_db >= 21.0)
+        return 0.5842 * std::pow(atten_db - 21.0, 0.4) + 0.07886 * (atten_db - 21.0);
+    return 0.0;
+}
+
+std::size_t kaiser_length(double transition, double atten_db) noexcept
+{
+    const double n = (atten_db - 7.95) / (14.36 * transition) + 1.0;
+    return static_cast<std::size_t>(std::ceil(std::max(n, 1.0)));
+}
+
+std::vector<float> design_lowpass(double cutoff, double transition, double atten_db,
+                                  std::size_t multiple)
+{
+    if (!(cutoff > 0.0 && cutoff < 0.5) || !(transition > 0.0) || multiple == 0)
+        throw std::invalid_argument("design_lowpass: unrealisable specification");
+
+    std::size_t taps = kaiser_length(transition, atten_db);
+    taps = (taps + multiple - 1) / multiple * multiple;
+
+    const std::uint64_t key = Fnv1a().add(cutoff).add(transition).add(atten_db).add(multiple).value();
+    if (const auto t = detail::snapshot_table(TableKind::Lowpass, key); t.size() == taps * sizeof(float)) {
+        std::vector<float> h(taps);
+        std::memcpy(h.data(), t.data(), t.size());
+        return h;
+    }
+
+    const double beta = kaiser_beta(atten_db);
+    const double mid = (static_cast<double>(taps) - 1.0) / 2.0;
+    const double norm = bessel_i0(beta);
+    std::vector<float> h(taps);
+    double sum = 0.0;
+    for (std::size_t i = 0; i < taps; ++i) {
+        const double x = static_cast<double>(i) - mid;
+        const double sinc = x == 0.0 ? 2.0 * cutoff
+                                     : std::sin(2.0 * std::numbers::pi * cutoff * x) / (std::numbers::pi * x);
+        const double r = mid > 0.0 ? x / mid : 0.0;
+        const double w = bessel_i0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / norm;
+        h[i] = static_cast<float>(sinc * w);
+        sum += sinc * w;
+    }
+    for (auto& v : h)
+        v = static_cast<float>(v / sum);
+    detail::note_table(TableKind::Lowpass, key, std::as_bytes(std::span(h)));
+    return h;
+}
+
+} // namespace mprp
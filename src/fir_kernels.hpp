@@ -0,0 +1,51 @@
+#pragma once
+
+// Private FIR dot-product kernels. taps and x both point at interleaved
+// float pairs (taps duplicated per lane), floats is their common length.
+
+#include "mprp/cpu.hpp"
+
+#include <cstddef>
+
+namespace mprp::detail {
+
+struct FirSum {
+    float re;
+    float im;
+};
+
+using FirDotKernel = FirSum (*)(const float* taps, const float* x, std::size_t floats) noexcept;
+
+inline FirSum fir_dot_scalar(const float* taps, const float* x, std::size_t floats) noexcept
+{
+    float re = 0.0f;
+    float im = 0.0f;
+    for (std::size_t i = 0; i + 1 < floats; i += 2) {
+        re += taps[i] * x[i];
+        im += taps[i + 1] * x[i + 1];
+    }
+    return {re, im};
+}
+
+#if defined(MPRP_HAVE_AVX2)
+FirSum fir_dot_avx2(const float* taps, const float* x, std::size_t floats) noexcept;
+#endif
+
+#if defined(MPRP_HAVE_NEON)
+FirSum fir_dot_neon(const float* taps, const float* x, std::size_t floats) noexcept;
+#endif
+
+inline FirDotKernel fir_dot_kernel(Isa isa) noexcept
+{
+    switch (isa) {
+#if defined(MPRP_HAVE_AVX2)
+    case Isa::Avx2: return &fir_dot_avx2;
+#endif
+#if defined(MPRP_HAVE_NEON)
+    case Isa::Neon: return &fir_dot_neon;
+#endif
+    default: return &fir_dot_scalar;
+    }
+}
+
+} // namespace mprp::detail
@@ -0,0 +1,29 @@
+// NEON FIR dot product. Only called after isa_supported(Isa::Neon) has
+// confirmed the CPU.
+
+#include "fir_kernels.hpp"
+
+#include <arm_neon.h>
+
+namespace mprp::detail {
+
+FirSum fir_dot_neon(const float* taps, const float* x, std::size_t floats) noexcept
+{
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    std::size_t i = 0;
+    for (; i + 8 <= floats; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(taps + i), vld1q_f32(x + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(taps + i + 4), vld1q_f32(x + i + 4));
+    }
+    for (; i + 4 <= floats; i += 4)
+        acc0 = vmlaq_f32(acc0, vld1q_f32(taps + i), vld1q_f32(x + i));
+
+    // Lanes alternate re, im.
+    const float32x4_t acc = vaddq_f32(acc0, acc1);
+    const float32x2_t v = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    const FirSum tail = fir_dot_scalar(taps + i, x + i, floats - i);
+    return {vget_lane_f32(v, 0) + tail.re, vget_lane_f32(v, 1) + tail.im};
+}
+
+} // namespace mprp::detail
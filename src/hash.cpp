@@ -0,0 +1,133 @@
+#include "mprp/hash.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mprp {
+
+namespace {
+
+constexpr std::uint32_t round_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+constexpr std::uint32_t rotr(std::uint32_t x, int n) noexcept { return (x >> n) | (x << (32 - n)); }
+
+class Sha256 {
+public:
+    Sha256& bytes(const unsigned char* p, std::size_t n) noexcept
+    {
+        length_ += n;
+        while (n > 0) {
+            const std::size_t take = std::min(n, sizeof block_ - used_);
+            std::memcpy(block_ + used_, p, take);
+            used_ += take;
+            p += take;
+            n -= take;
+            if (used_ == sizeof block_) {
+                compress();
+                used_ = 0;
+            }
+        }
+        return *this;
+    }
+
+    Digest256 finish() noexcept
+    {
+        const std::uint64_t bits = length_ * 8;
+        const unsigned char one = 0x80;
+        const unsigned char zero = 0;
+        bytes(&one, 1);
+        while (used_ != 56)
+            bytes(&zero, 1);
+        unsigned char tail[8];
+        for (int i = 0; i < 8; ++i)
+            tail[i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+        bytes(tail, sizeof tail);
+        Digest256 out;
+        for (int i = 0; i < 8; ++i)
+            for (int b = 0; b < 4; ++b)
+                out[static_cast<std::size_t>(4 * i + b)] = static_cast<unsigned char>(h_[i] >> (24 - 8 * b));
+        return out;
+    }
+
+private:
+    void compress() noexcept
+    {
+        std::uint32_t w[64];
+        for (int i = 0; i < 16; ++i)
+            w[i] = std::uint32_t{block_[4 * i]} << 24 | std::uint32_t{block_[4 * i + 1]} << 16
+                   | std::uint32_t{block_[4 * i + 2]} << 8 | std::uint32_t{block_[4 * i + 3]};
+        for (int i = 16; i < 64; ++i) {
+            const std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        std::uint32_t a = h_[0], b = h_[1], c = h_[2], d = h_[3], e = h_[4], f = h_[5], g = h_[6], h = h_[7];
+        for (int i = 0; i < 64; ++i) {
+            const std::uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g))
+                                     + round_constants[i] + w[i];
+            const std::uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        h_[0] += a;
+        h_[1] += b;
+        h_[2] += c;
+        h_[3] += d;
+        h_[4] += e;
+        h_[5] += f;
+        h_[6] += g;
+        h_[7] += h;
+    }
+
+    std::uint32_t h_[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                           0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    unsigned char block_[64] = {};
+    std::size_t used_ = 0;
+    std::uint64_t length_ = 0;
+};
+
+} // namespace
+
+Digest256 hmac_sha256(std::span<const unsigned char> key, std::span<const unsigned char> message)
+{
+    unsigned char pad[64] = {};
+    if (key.size() > sizeof pad) {
+        const Digest256 short_key = Sha256().bytes(key.data(), key.size()).finish();
+        std::memcpy(pad, short_key.data(), short_key.size());
+    } else if (!key.empty()) {
+        std::memcpy(pad, key.data(), key.size());
+    }
+    unsigned char inner[64];
+    unsigned char outer[64];
+    for (std::size_t i = 0; i < sizeof pad; ++i) {
+        inner[i] = static_cast<unsigned char>(pad[i] ^ 0x36);
+        outer[i] = static_cast<unsigned char>(pad[i] ^ 0x5c);
+    }
+    const Digest256 inner_hash = Sha256().bytes(inner, sizeof inner).bytes(message.data(), message.size()).finish();
+    return Sha256().bytes(outer, sizeof outer).bytes(inner_hash.data(), inner_hash.size()).finish();
+}
+
+bool digest_equal(const Digest256& a, const Digest256& b) noexcept
+{
+    unsigned char diff = 0;
+    for (std::size_t i = 0; i < a.size(); ++i)
+        diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+    return diff == 0;
+}
+
+} // namespace mprp
@@ -0,0 +1,56 @@
+#include "mprp/live_engine.hpp"
+
+#include "mprp/metrics.hpp"
+
+#include <utility>
+
+namespace mprp {
+
+namespace {
+
+void check_entries(const EngineConfig& config)
+{
+    if (config.beacons.empty())
+        throw ConfigError("no [beacon] entries");
+}
+
+} // namespace
+
+LiveEngine::LiveEngine(EngineConfig config)
+{
+    check_entries(config);
+    current_.store(std::make_shared<const EngineVersion>(EngineVersion{1, Engine(std::move(config))}));
+    version_.store(1, std::memory_order_release);
+}
+
+std::uint64_t LiveEngine::publish(EngineConfig config)
+{
+    std::lock_guard lock(writer_);
+    return publish_locked(std::move(config));
+}
+
+std::uint64_t LiveEngine::update(const std::function<void(EngineConfig&)>& edit)
+{
+    // Under the writer lock throughout, so that two edits cannot both start
+    // from the same version and one of them be lost.
+    std::lock_guard lock(writer_);
+    EngineConfig config = current_.load(std::memory_order_acquire)->engine.config();
+    edit(config);
+    return publish_locked(std::move(config));
+}
+
+std::uint64_t LiveEngine::publish_locked(EngineConfig config)
+{
+    check_entries(config);
+    const auto previous = current_.load(std::memory_order_acquire);
+    const std::uint64_t version = previous->version + 1;
+    auto next = std::make_shared<const EngineVersion>(EngineVersion{version, Engine(std::move(config), previous->engine)});
+    // Pointer first: a reader that sees the new number must find the new
+    // engine behind it.
+    current_.store(std::move(next), std::memory_order_release);
+    version_.store(version, std::memory_order_release);
+    metrics::add(metrics::counter("config.versions"));
+    return version;
+}
+
+} // namespace mprp
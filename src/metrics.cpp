@@ -0,0 +1,257 @@
+#include "mprp/metrics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mprp::metrics {
+
+namespace detail {
+
+std::atomic<Page*> page{nullptr};
+
+std::size_t thread_shard() noexcept
+{
+    static std::atomic<std::size_t> next{0};
+    thread_local const std::size_t shard = next.fetch_add(1, std::memory_order_relaxed) % shards;
+    return shard;
+}
+
+void record_slow(Page* p, StageId id, std::uint64_t ns) noexcept
+{
+    HistogramShard& h = p->stage[id].shard[thread_shard()];
+    h.count.fetch_add(1, std::memory_order_relaxed);
+    h.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+    h.buckets[bucket_index(ns)].fetch_add(1, std::memory_order_relaxed);
+    std::uint64_t seen = h.max_ns.load(std::memory_order_relaxed);
+    while (ns > seen && !h.max_ns.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace detail
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::string> stages;
+    std::vector<std::string> counters;
+    std::string shm_name;  // empty: anonymous mapping
+};
+
+Registry& registry()
+{
+    static Registry r;
+    return r;
+}
+
+void copy_name(char (&dst)[name_length], const std::string& src)
+{
+    std::memset(dst, 0, name_length);
+    std::memcpy(dst, src.data(), std::min(src.size(), name_length - 1));
+}
+
+std::uint32_t find_or_add(std::vector<std::string>& names, const std::string& name, std::size_t cap)
+{
+    const auto it = std::find(names.begin(), names.end(), name);
+    if (it != names.end())
+        return static_cast<std::uint32_t>(it - names.begin());
+    if (names.size() == cap)
+        return static_cast<std::uint32_t>(cap - 1);
+    names.push_back(name);
+    return static_cast<std::uint32_t>(names.size() - 1);
+}
+
+// Publishes registry names into the page; caller holds the registry lock.
+void publish(Page* p, const Registry& r)
+{
+    for (std::size_t i = p->stages.load(std::memory_order_relaxed); i < r.stages.size(); ++i)
+        copy_name(p->stage[i].name, r.stages[i]);
+    p->stages.store(static_cast<std::uint32_t>(r.stages.size()), std::memory_order_release);
+    for (std::size_t i = p->counters.load(std::memory_order_relaxed); i < r.counters.size(); ++i)
+        copy_name(p->counter[i].name, r.counters[i]);
+    p->counters.store(static_cast<std::uint32_t>(r.counters.size()), std::memory_order_release);
+}
+
+std::string shm_path(const std::string& name)
+{
+    return "/mprp-" + name;
+}
+
+std::uint64_t percentile(const std::vector<std::uint64_t>& buckets, std::uint64_t total, double q)
+{
+    if (total == 0)
+        return 0;
+    const auto target = static_cast<std::uint64_t>(q * static_cast<double>(total - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= target)
+            return i + 1 < histogram_buckets ? bucket_floor(i + 1) - 1 : bucket_floor(i);
+    }
+    return bucket_floor(histogram_buckets - 1);
+}
+
+} // namespace
+
+bool open(const std::string& name)
+{
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    if (detail::page.load(std::memory_order_relaxed))
+        return true;
+
+    void* mem = MAP_FAILED;
+    if (name.empty()) {
+        mem = ::mmap(nullptr, sizeof(Page), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    } else {
+        const std::string path = shm_path(name);
+        ::shm_unlink(path.c_str());
+        const int fd = ::shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0)
+            return false;
+        if (::ftruncate(fd, sizeof(Page)) == 0)
+            mem = ::mmap(nullptr, sizeof(Page), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mem == MAP_FAILED) {
+            ::shm_unlink(path.c_str());
+            return false;
+        }
+    }
+    if (mem == MAP_FAILED)
+        return false;
+
+    // Fresh mappings are zero-filled, which is a valid empty page.
+    auto* p = static_cast<Page*>(mem);
+    p->version = page_version;
+    p->pid = static_cast<std::uint32_t>(::getpid());
+    p->start_unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+    publish(p, r);
+    std::atomic_thread_fence(std::memory_order_release);
+    p->magic = page_magic;
+    r.shm_name = name;
+    detail::page.store(p, std::memory_order_release);
+    return true;
+}
+
+void close() noexcept
+{
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    Page* p = detail::page.exchange(nullptr, std::memory_order_acq_rel);
+    if (!p)
+        return;
+    // Threads that loaded the pointer just before the exchange may still
+    // write to it, and nothing tells when the last of them is done, so the
+    // mapping stays until exit (one page, only on close()); only the name
+    // goes now.
+    if (!r.shm_name.empty())
+        ::shm_unlink(shm_path(r.shm_name).c_str());
+}
+
+StageId stage(const std::string& name)
+{
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    const auto id = find_or_add(r.stages, name, max_stages);
+    if (Page* p = detail::page.load(std::memory_order_relaxed))
+        publish(p, r);
+    return id;
+}
+
+CounterId counter(const std::string& name)
+{
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    const auto id = find_or_add(r.counters, name, max_counters);
+    if (Page* p = detail::page.load(std::memory_order_relaxed))
+        publish(p, r);
+    return id;
+}
+
+Snapshot summarize(const Page& page)
+{
+    Snapshot snap;
+    snap.pid = page.pid;
+    snap.start_unix_ns = page.start_unix_ns;
+
+    const std::uint32_t stages = std::min<std::uint32_t>(page.stages.load(std::memory_order_acquire), max_stages);
+    std::vector<std::uint64_t> buckets(histogram_buckets);
+    for (std::uint32_t s = 0; s < stages; ++s) {
+        const StageSlot& slot = page.stage[s];
+        StageSummary sum;
+        sum.name.assign(slot.name, strnlen(slot.name, name_length));
+        std::fill(buckets.begin(), buckets.end(), 0);
+        std::uint64_t total_ns = 0;
+        for (const auto& h : slot.shard) {
+            sum.count += h.count.load(std::memory_order_relaxed);
+            total_ns += h.sum_ns.load(std::memory_order_relaxed);
+            sum.max_ns = std::max(sum.max_ns, h.max_ns.load(std::memory_order_relaxed));
+            for (std::size_t i = 0; i < histogram_buckets; ++i)
+                buckets[i] += h.buckets[i].load(std::memory_order_relaxed);
+        }
+        // Bucket totals are the consistent view; count may have moved on.
+        std::uint64_t total = 0;
+        for (auto b : buckets)
+            total += b;
+        sum.mean_ns = sum.count ? static_cast<double>(total_ns) / static_cast<double>(sum.count) : 0.0;
+        sum.p50_ns = percentile(buckets, total, 0.50);
+        sum.p90_ns = percentile(buckets, total, 0.90);
+        sum.p99_ns = percentile(buckets, total, 0.99);
+        sum.p999_ns = percentile(buckets, total, 0.999);
+        // Bucket upper bounds can overshoot the largest value actually seen.
+        for (auto* q : {&sum.p50_ns, &sum.p90_ns, &sum.p99_ns, &sum.p999_ns})
+            *q = std::min(*q, sum.max_ns);
+        snap.stages.push_back(std::move(sum));
+    }
+
+    const std::uint32_t counters =
+        std::min<std::uint32_t>(page.counters.load(std::memory_order_acquire), max_counters);
+    for (std::uint32_t c = 0; c < counters; ++c) {
+        const CounterSlot& slot = page.counter[c];
+        CounterSummary sum;
+        sum.name.assign(slot.name, strnlen(slot.name, name_length));
+        for (const auto& sh : slot.shard)
+            sum.value += sh.value.load(std::memory_order_relaxed);
+        snap.counters.push_back(std::move(sum));
+    }
+    return snap;
+}
+
+std::optional<Snapshot> read(const std::string& name)
+{
+    if (name.empty()) {
+        const Page* p = detail::page.load(std::memory_order_acquire);
+        if (!p)
+            return std::nullopt;
+        return summarize(*p);
+    }
+
+    const int fd = ::shm_open(shm_path(name).c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return std::nullopt;
+    struct stat st {};
+    void* mem = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(Page))
+        mem = ::mmap(nullptr, sizeof(Page), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED)
+        return std::nullopt;
+
+    const auto* p = static_cast<const Page*>(mem);
+    std::optional<Snapshot> out;
+    if (p->magic == page_magic && p->version == page_version)
+        out = summarize(*p);
+    ::munmap(mem, sizeof(Page));
+    return out;
+}
+
+} // namespace mprp::metrics
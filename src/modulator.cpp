@@ -0,0 +1,112 @@
+#include "mprp/modulator.hpp"
+
+#include "mprp/envelope.hpp"
+#include "mprp/nco.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mprp {
+
+CwModulator::CwModulator(double sample_rate, double tone_hz, double wpm, double amplitude,
+                         double rise_s)
+    : sample_rate_(sample_rate),
+      tone_hz_(tone_hz),
+      amplitude_(amplitude),
+      // PARIS timing: one dot unit is 1.2 / wpm seconds.
+      unit_(sample_rate * 1.2 / wpm),
+      // An edge may take at most half of the shortest (one-dot) run.
+      edge_(raised_cosine_edge(std::clamp<std::size_t>(
+          static_cast<std::size_t>(std::lround(sample_rate * rise_s)), 1,
+          std::max<std::size_t>(1, static_cast<std::size_t>(unit_ / 2.0)))))
+{
+}
+
+KeyingPlan CwModulator::plan(std::span<const KeyElement> elements) const
+{
+    KeyingPlan plan;
+    plan.runs.reserve(elements.size() / 2 + 1);
+    std::uint64_t units = 0;
+    auto boundary = [this](std::uint64_t u) {
+        return static_cast<std::size_t>(std::llround(static_cast<double>(u) * unit_));
+    };
+    for (const auto& e : elements) {
+        const std::size_t start = boundary(units);
+        units += e.units;
+        if (e.on)
+            plan.runs.push_back({start, boundary(units) - start});
+    }
+    plan.total = boundary(units);
+    return plan;
+}
+
+std::size_t CwModulator::render(const KeyingPlan& plan, std::span<float> out) const noexcept
+{
+    const std::size_t n = std::min(plan.total, out.size());
+    std::fill(out.begin(), out.begin() + n, 0.0f);
+
+    const std::uint32_t step = phase_step(tone_hz_, sample_rate_);
+    const float* edge = edge_->data();
+    const std::size_t edge_len = edge_->size();
+
+    for (const auto& run : plan.runs) {
+        if (run.start >= n)
+            break;
+        const std::size_t len = std::min(run.length, n - run.start);
+        float* dst = out.data() + run.start;
+        // Phase follows the absolute sample index, so the carrier is
+        // coherent across runs.
+        nco_accumulate(static_cast<std::uint32_t>(step * run.start), step,
+                       static_cast<float>(amplitude_), {dst, len});
+
+        const std::size_t rise = std::min(edge_len, len);
+        for (std::size_t k = 0; k < rise; ++k)
+            dst[k] *= edge[k];
+        const std::size_t fall_at = run.length > edge_len ? run.length - edge_len : rise;
+        for (std::size_t k = std::max(fall_at, rise); k < len; ++k)
+            dst[k] *= edge[run.length - 1 - k];
+    }
+    return n;
+}
+
+FskModulator::FskModulator(double sample_rate, double centre_hz, double spacing_hz,
+                           double baud, unsigned tones, double amplitude)
+    : sample_rate_(sample_rate),
+      centre_hz_(centre_hz),
+      spacing_hz_(spacing_hz),
+      baud_(baud),
+      tones_(tones),
+      amplitude_(amplitude)
+{
+}
+
+double FskModulator::tone_hz(unsigned k) const noexcept
+{
+    return centre_hz_ + (static_cast<double>(k) - (tones_ - 1) / 2.0) * spacing_hz_;
+}
+
+std::size_t FskModulator::length(std::size_t symbols) const noexcept
+{
+    return static_cast<std::size_t>(std::llround(symbols * sample_rate_ / baud_));
+}
+
+std::size_t FskModulator::render(std::span<const std::uint8_t> symbols,
+                                 std::span<float> out) const noexcept
+{
+    std::uint32_t phase = 0;
+    std::size_t n = 0;
+    const auto amplitude = static_cast<float>(amplitude_);
+    for (std::size_t s = 0; s < symbols.size() && n < out.size(); ++s) {
+        // Symbol boundaries are placed on the ideal timeline so fractional
+        // samples-per-symbol never accumulate drift.
+        const std::size_t end = std::min(out.size(), length(s + 1));
+        const auto segment = out.subspan(n, end - n);
+        std::fill(segment.begin(), segment.end(), 0.0f);
+        phase = nco_accumulate(phase, phase_step(tone_hz(symbols[s] % tones_), sample_rate_),
+                               amplitude, segment);
+        n = end;
+    }
+    return n;
+}
+
+} // namespace mprp
@@ -0,0 +1,143 @@
+#include "mprp/nco.hpp"
+
+#include "nco_kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mprp {
+
+namespace detail {
+
+void nco_accumulate_scalar(std::uint32_t phase, std::uint32_t step, float amplitude,
+                           float* out, std::size_t n) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i, phase += step)
+        out[i] += amplitude * nco_sin(phase);
+}
+
+void nco_accumulate_scalar(std::uint32_t phase, std::uint32_t step, float amplitude,
+                           std::complex<float>* out, std::size_t n) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i, phase += step)
+        out[i] += amplitude * std::complex<float>(nco_sin(phase + nco_quarter), nco_sin(phase));
+}
+
+} // namespace detail
+
+namespace {
+
+// Samples per inner block: small enough that the output stays in L1 while
+// every tone is accumulated into it.
+constexpr std::size_t block = 1024;
+
+template <typename T>
+using Kernel = void (*)(std::uint32_t, std::uint32_t, float, T*, std::size_t) noexcept;
+
+template <typename T>
+Kernel<T> kernel_for(Isa isa) noexcept
+{
+    switch (isa) {
+#if defined(MPRP_HAVE_AVX2)
+    case Isa::Avx2: return &detail::nco_accumulate_avx2;
+#endif
+#if defined(MPRP_HAVE_NEON)
+    case Isa::Neon: return &detail::nco_accumulate_neon;
+#endif
+    default: return &detail::nco_accumulate_scalar;
+    }
+}
+
+} // namespace
+
+std::uint32_t phase_from_turns(double turns) noexcept
+{
+    return static_cast<std::uint32_t>(
+        static_cast<std::int64_t>(std::llround((turns - std::floor(turns)) * 4294967296.0)));
+}
+
+std::uint32_t phase_step(double hz, double sample_rate) noexcept
+{
+    return phase_from_turns(hz / sample_rate);
+}
+
+std::uint32_t nco_accumulate(std::uint32_t phase, std::uint32_t step, float amplitude,
+                             std::span<float> out, Isa isa) noexcept
+{
+    kernel_for<float>(isa)(phase, step, amplitude, out.data(), out.size());
+    return phase + static_cast<std::uint32_t>(step * out.size());
+}
+
+std::uint32_t nco_accumulate(std::uint32_t phase, std::uint32_t step, float amplitude,
+                             std::span<std::complex<float>> out, Isa isa) noexcept
+{
+    kernel_for<std::complex<float>>(isa)(phase, step, amplitude, out.data(), out.size());
+    return phase + static_cast<std::uint32_t>(step * out.size());
+}
+
+NcoBank::NcoBank(double sample_rate, Isa isa)
+    : sample_rate_(sample_rate), isa_(isa_supported(isa) ? isa : Isa::Scalar)
+{
+}
+
+std::size_t NcoBank::add_tone(double hz, float amplitude, double phase_turns)
+{
+    phase_.push_back(phase_from_turns(phase_turns));
+    step_.push_back(phase_step(hz, sample_rate_));
+    amplitude_.push_back(amplitude);
+    return phase_.size() - 1;
+}
+
+void NcoBank::set_frequency(std::size_t tone, double hz) noexcept
+{
+    step_[tone] = phase_step(hz, sample_rate_);
+}
+
+void NcoBank::set_amplitude(std::size_t tone, float amplitude) noexcept
+{
+    amplitude_[tone] = amplitude;
+}
+
+void NcoBank::clear() noexcept
+{
+    phase_.clear();
+    step_.clear();
+    amplitude_.clear();
+}
+
+template <typename T>
+void NcoBank::render_sum(std::span<T> out) noexcept
+{
+    const auto kernel = kernel_for<T>(isa_);
+    for (std::size_t at = 0; at < out.size(); at += block) {
+        const std::size_t n = std::min(block, out.size() - at);
+        std::fill_n(out.data() + at, n, T{});
+        for (std::size_t t = 0; t < phase_.size(); ++t) {
+            kernel(phase_[t], step_[t], amplitude_[t], out.data() + at, n);
+            phase_[t] += static_cast<std::uint32_t>(step_[t] * n);
+        }
+    }
+}
+
+void NcoBank::render(std::span<float> out) noexcept
+{
+    render_sum(out);
+}
+
+void NcoBank::render(std::span<std::complex<float>> out) noexcept
+{
+    render_sum(out);
+}
+
+void NcoBank::render_channels(std::span<float* const> channels, std::size_t frames) noexcept
+{
+    const auto kernel = kernel_for<float>(isa_);
+    const std::size_t tones = std::min(channels.size(), phase_.size());
+    for (std::size_t t = 0; t < tones; ++t) {
+        std::fill_n(channels[t], frames, 0.0f);
+        kernel(phase_[t], step_[t], amplitude_[t], channels[t], frames);
+        phase_[t] += static_cast<std::uint32_t>(step_[t] * frames);
+    }
+}
+
+} // namespace mprp
@@ -0,0 +1,81 @@
+// AVX2 + FMA NCO kernels. Built with -mavx2 -mfma and only called after
+// isa_supported(Isa::Avx2) has confirmed the CPU.
+
+#include "nco_kernels.hpp"
+
+#include <immintrin.h>
+
+namespace mprp::detail {
+
+namespace {
+
+inline __m256 sin8(__m256i phase) noexcept
+{
+    const __m256 t = _mm256_mul_ps(_mm256_cvtepi32_ps(phase), _mm256_set1_ps(1.0f / 4294967296.0f));
+    const __m256 sign = _mm256_and_ps(t, _mm256_set1_ps(-0.0f));
+    const __m256 mag = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), t);
+    const __m256 folded = _mm256_sub_ps(_mm256_or_ps(_mm256_set1_ps(0.5f), sign), t);
+    const __m256 outer = _mm256_cmp_ps(mag, _mm256_set1_ps(0.25f), _CMP_GT_OQ);
+    const __m256 x = _mm256_mul_ps(_mm256_blendv_ps(t, folded, outer), _mm256_set1_ps(nco_two_pi));
+    const __m256 x2 = _mm256_mul_ps(x, x);
+
+    __m256 p = _mm256_set1_ps(nco_c11);
+    p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(nco_c9));
+    p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(nco_c7));
+    p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(nco_c5));
+    p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(nco_c3));
+    return _mm256_fmadd_ps(_mm256_mul_ps(x, x2), p, x);
+}
+
+inline __m256i lanes(std::uint32_t phase, std::uint32_t step) noexcept
+{
+    const __m256i k = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    return _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(phase)),
+                            _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(step)), k));
+}
+
+} // namespace
+
+void nco_accumulate_avx2(std::uint32_t phase, std::uint32_t step, float amplitude, float* out,
+                         std::size_t n) noexcept
+{
+    const __m256 amp = _mm256_set1_ps(amplitude);
+    const __m256i inc = _mm256_set1_epi32(static_cast<int>(step * 8u));
+    __m256i ph = lanes(phase, step);
+
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_fmadd_ps(sin8(ph), amp, _mm256_loadu_ps(out + i)));
+        ph = _mm256_add_epi32(ph, inc);
+    }
+    nco_accumulate_scalar(phase + static_cast<std::uint32_t>(step * i), step, amplitude, out + i,
+                          n - i);
+}
+
+void nco_accumulate_avx2(std::uint32_t phase, std::uint32_t step, float amplitude,
+                         std::complex<float>* out, std::size_t n) noexcept
+{
+    const __m256 amp = _mm256_set1_ps(amplitude);
+    const __m256i inc = _mm256_set1_epi32(static_cast<int>(step * 8u));
+    const __m256i quarter = _mm256_set1_epi32(static_cast<int>(nco_quarter));
+    __m256i ph = lanes(phase, step);
+    auto* f = reinterpret_cast<float*>(out);
+
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 re = _mm256_mul_ps(sin8(_mm256_add_epi32(ph, quarter)), amp);
+        const __m256 im = _mm256_mul_ps(sin8(ph), amp);
+        // Interleave to (re, im) pairs in sample order.
+        const __m256 lo = _mm256_unpacklo_ps(re, im);
+        const __m256 hi = _mm256_unpackhi_ps(re, im);
+        float* dst = f + 2 * i;
+        _mm256_storeu_ps(dst, _mm256_add_ps(_mm256_loadu_ps(dst), _mm256_permute2f128_ps(lo, hi, 0x20)));
+        _mm256_storeu_ps(dst + 8,
+                         _mm256_add_ps(_mm256_loadu_ps(dst + 8), _mm256_permute2f128_ps(lo, hi, 0x31)));
+        ph = _mm256_add_epi32(ph, inc);
+    }
+    nco_accumulate_scalar(phase + static_cast<std::uint32_t>(step * i), step, amplitude, out + i,
+                          n - i);
+}
+
+} // namespace mprp::detail
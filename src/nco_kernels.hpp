@@ -0,0 +1,65 @@
+#pragma once
+
+// Private NCO kernel interface. Every ISA implements the same two entry
+// points with the same sine approximation, so outputs agree to within
+// float rounding whichever kernel runs.
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+
+namespace mprp::detail {
+
+/// 2*pi and Taylor coefficients of sin(x) up to x^11; with the argument
+/// folded into [-pi/2, pi/2] the truncation error is below 6e-8.
+inline constexpr float nco_two_pi = 6.28318530717958647692f;
+inline constexpr float nco_c3 = -1.0f / 6.0f;
+inline constexpr float nco_c5 = 1.0f / 120.0f;
+inline constexpr float nco_c7 = -1.0f / 5040.0f;
+inline constexpr float nco_c9 = 1.0f / 362880.0f;
+inline constexpr float nco_c11 = -1.0f / 39916800.0f;
+
+/// sin(2*pi*phase/2^32).
+inline float nco_sin(std::uint32_t phase) noexcept
+{
+    // Signed phase maps to turns in [-0.5, 0.5); fold the outer quarters
+    // back onto [-0.25, 0.25] using sin(pi - x) = sin(x).
+    float t = static_cast<float>(static_cast<std::int32_t>(phase)) * (1.0f / 4294967296.0f);
+    if (t > 0.25f)
+        t = 0.5f - t;
+    else if (t < -0.25f)
+        t = -0.5f - t;
+    const float x = t * nco_two_pi;
+    const float x2 = x * x;
+    float p = nco_c11;
+    p = p * x2 + nco_c9;
+    p = p * x2 + nco_c7;
+    p = p * x2 + nco_c5;
+    p = p * x2 + nco_c3;
+    return x + x * x2 * p;
+}
+
+inline constexpr std::uint32_t nco_quarter = 0x40000000u;
+
+using NcoRealKernel = void (*)(std::uint32_t phase, std::uint32_t step, float amplitude,
+                               float* out, std::size_t n) noexcept;
+using NcoComplexKernel = void (*)(std::uint32_t phase, std::uint32_t step, float amplitude,
+                                  std::complex<float>* out, std::size_t n) noexcept;
+
+void nco_accumulate_scalar(std::uint32_t, std::uint32_t, float, float*, std::size_t) noexcept;
+void nco_accumulate_scalar(std::uint32_t, std::uint32_t, float, std::complex<float>*,
+                           std::size_t) noexcept;
+
+#if defined(MPRP_HAVE_AVX2)
+void nco_accumulate_avx2(std::uint32_t, std::uint32_t, float, float*, std::size_t) noexcept;
+void nco_accumulate_avx2(std::uint32_t, std::uint32_t, float, std::complex<float>*,
+                         std::size_t) noexcept;
+#endif
+
+#if defined(MPRP_HAVE_NEON)
+void nco_accumulate_neon(std::uint32_t, std::uint32_t, float, float*, std::size_t) noexcept;
+void nco_accumulate_neon(std::uint32_t, std::uint32_t, float, std::complex<float>*,
+                         std::size_t) noexcept;
+#endif
+
+} // namespace mprp::detail
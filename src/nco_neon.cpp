@@ -0,0 +1,85 @@
+// NEON NCO kernels for the ARM nodes. Only called after
+// isa_supported(Isa::Neon) has confirmed the CPU.
+
+#include "nco_kernels.hpp"
+
+#include <arm_neon.h>
+
+namespace mprp::detail {
+
+namespace {
+
+inline float32x4_t fma4(float32x4_t acc, float32x4_t a, float32x4_t b) noexcept
+{
+#if defined(__aarch64__)
+    return vfmaq_f32(acc, a, b);
+#else
+    return vmlaq_f32(acc, a, b);
+#endif
+}
+
+inline float32x4_t sin4(uint32x4_t phase) noexcept
+{
+    const float32x4_t t =
+        vmulq_n_f32(vcvtq_f32_s32(vreinterpretq_s32_u32(phase)), 1.0f / 4294967296.0f);
+    const uint32x4_t sign_mask = vdupq_n_u32(0x80000000u);
+    const uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(t), sign_mask);
+    const float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(0.5f)), sign));
+    const float32x4_t folded = vsubq_f32(half, t);
+    const uint32x4_t outer = vcgtq_f32(vabsq_f32(t), vdupq_n_f32(0.25f));
+    const float32x4_t x = vmulq_n_f32(vbslq_f32(outer, folded, t), nco_two_pi);
+    const float32x4_t x2 = vmulq_f32(x, x);
+
+    float32x4_t p = vdupq_n_f32(nco_c11);
+    p = fma4(vdupq_n_f32(nco_c9), p, x2);
+    p = fma4(vdupq_n_f32(nco_c7), p, x2);
+    p = fma4(vdupq_n_f32(nco_c5), p, x2);
+    p = fma4(vdupq_n_f32(nco_c3), p, x2);
+    return fma4(x, vmulq_f32(x, x2), p);
+}
+
+inline uint32x4_t lanes(std::uint32_t phase, std::uint32_t step) noexcept
+{
+    const std::uint32_t k[4] = {0, step, 2 * step, 3 * step};
+    return vaddq_u32(vdupq_n_u32(phase), vld1q_u32(k));
+}
+
+} // namespace
+
+void nco_accumulate_neon(std::uint32_t phase, std::uint32_t step, float amplitude, float* out,
+                         std::size_t n) noexcept
+{
+    const uint32x4_t inc = vdupq_n_u32(step * 4u);
+    uint32x4_t ph = lanes(phase, step);
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(out + i, fma4(vld1q_f32(out + i), sin4(ph), vdupq_n_f32(amplitude)));
+        ph = vaddq_u32(ph, inc);
+    }
+    nco_accumulate_scalar(phase + static_cast<std::uint32_t>(step * i), step, amplitude, out + i,
+                          n - i);
+}
+
+void nco_accumulate_neon(std::uint32_t phase, std::uint32_t step, float amplitude,
+                         std::complex<float>* out, std::size_t n) noexcept
+{
+    const uint32x4_t inc = vdupq_n_u32(step * 4u);
+    const uint32x4_t quarter = vdupq_n_u32(nco_quarter);
+    const float32x4_t amp = vdupq_n_f32(amplitude);
+    uint32x4_t ph = lanes(phase, step);
+    auto* f = reinterpret_cast<float*>(out);
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4x2_t acc = vld2q_f32(f + 2 * i);
+        acc.val[0] = fma4(acc.val[0], sin4(vaddq_u32(ph, quarter)), amp);
+        acc.val[1] = fma4(acc.val[1], sin4(ph), amp);
+        vst2q_f32(f + 2 * i, acc);
+        ph = vaddq_u32(ph, inc);
+    }
+    nco_accumulate_scalar(phase + static_cast<std::uint32_t>(step * i), step, amplitude, out + i,
+                          n - i);
+}
+
+} // namespace mprp::detail
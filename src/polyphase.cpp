@@ -0,0 +1,201 @@
+#include "mprp/polyphase.hpp"
+
+#include "mprp/fir_design.hpp"
+
+#include "fir_kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace mprp {
+
+namespace {
+
+// Inputs handled per inner pass; bounds the delay-line allocation.
+constexpr std::size_t chunk = 2048;
+
+} // namespace
+
+PolyphaseResampler::PolyphaseResampler(unsigned interp, unsigned decim,
+                                       std::vector<float> prototype, Isa isa)
+    : interp_(interp), decim_(decim), isa_(isa_supported(isa) ? isa : Isa::Scalar)
+{
+    if (interp == 0 || decim == 0 || prototype.empty())
+        throw std::invalid_argument("PolyphaseResampler: invalid ratio or empty prototype");
+
+    taps_ = (prototype.size() + interp - 1) / interp;
+    prototype.resize(taps_ * interp, 0.0f);
+
+    // Phase p, reversed: bank[p][j] = L * h[p + (K-1-j) L], duplicated for
+    // the re and im lanes.
+    bank_.assign(std::size_t{interp} * 2 * taps_, 0.0f);
+    const auto gain = static_cast<float>(interp);
+    for (unsigned p = 0; p < interp; ++p) {
+        float* g = bank_.data() + std::size_t{p} * 2 * taps_;
+        for (std::size_t j = 0; j < taps_; ++j) {
+            const float h = gain * prototype[p + (taps_ - 1 - j) * interp];
+            g[2 * j] = h;
+            g[2 * j + 1] = h;
+        }
+    }
+    delay_.assign(taps_ - 1 + chunk, Complex{});
+}
+
+PolyphaseResampler PolyphaseResampler::design(unsigned interp, unsigned decim, double passband,
+                                              double stopband, double atten_db, Isa isa)
+{
+    if (!(stopband > passband && passband > 0.0))
+        throw std::invalid_argument("PolyphaseResampler: stop band must lie above pass band");
+    const double l = interp;
+    const double cutoff = std::min((passband + stopband) / 2.0, 0.5 * l) / l;
+    auto taps = design_lowpass(std::min(cutoff, 0.4999), (stopband - passband) / l, atten_db,
+                               interp);
+    return PolyphaseResampler(interp, decim, std::move(taps), isa);
+}
+
+std::size_t PolyphaseResampler::max_output(std::size_t n) const noexcept
+{
+    const std::size_t span = n * interp_;
+    return span > next_ ? (span - next_ + decim_ - 1) / decim_ : 0;
+}
+
+std::size_t PolyphaseResampler::process_chunk(std::size_t n, Complex* out) noexcept
+{
+    const auto dot = detail::fir_dot_kernel(isa_);
+    const std::size_t span = n * interp_;
+    const std::size_t floats = 2 * taps_;
+    const auto* x = reinterpret_cast<const float*>(delay_.data());
+
+    std::size_t produced = 0;
+    for (; next_ < span; next_ += decim_) {
+        // delay_[i] holds input i - (K-1), so the K inputs ending at
+        // floor(next / L) start at delay_[floor(next / L)].
+        const std::size_t base = next_ / interp_;
+        const std::size_t phase = next_ - base * interp_;
+        const auto sum = dot(bank_.data() + phase * floats, x + 2 * base, floats);
+        out[produced++] = {sum.re, sum.im};
+    }
+    next_ -= span;
+    std::copy(delay_.begin() + static_cast<std::ptrdiff_t>(n),
+              delay_.begin() + static_cast<std::ptrdiff_t>(n + taps_ - 1), delay_.begin());
+    return produced;
+}
+
+std::size_t PolyphaseResampler::process(std::span<const Complex> in, std::span<Complex> out) noexcept
+{
+    std::size_t written = 0;
+    for (std::size_t at = 0; at < in.size(); at += chunk) {
+        const std::size_t n = std::min(chunk, in.size() - at);
+        std::copy_n(in.begin() + static_cast<std::ptrdiff_t>(at), n,
+                    delay_.begin() + static_cast<std::ptrdiff_t>(taps_ - 1));
+        written += process_chunk(n, out.data() + written);
+    }
+    return written;
+}
+
+void PolyphaseResampler::reset() noexcept
+{
+    std::fill(delay_.begin(), delay_.end(), Complex{});
+    next_ = 0;
+}
+
+std::vector<unsigned> plan_decimation(unsigned factor, unsigned max_stage)
+{
+    std::vector<unsigned> primes;
+    for (unsigned p = 2; factor > 1 && p * p <= factor; ++p)
+        while (factor % p == 0) {
+            primes.push_back(p);
+            factor /= p;
+        }
+    if (factor > 1)
+        primes.push_back(factor);
+
+    // Pack the largest primes first so the early (full-rate) stages get
+    // the biggest reduction.
+    std::sort(primes.rbegin(), primes.rend());
+    std::vector<unsigned> stages;
+    for (unsigned p : primes) {
+        auto it = std::find_if(stages.begin(), stages.end(),
+                               [&](unsigned s) { return s * p <= max_stage; });
+        if (it != stages.end())
+            *it *= p;
+        else
+            stages.push_back(p);
+    }
+    std::sort(stages.rbegin(), stages.rend());
+    return stages;
+}
+
+ResamplerCascade::ResamplerCascade(double in_rate, double out_rate, double passband_hz,
+                                   double atten_db, Isa isa)
+    : in_rate_(in_rate), out_rate_(out_rate)
+{
+    const auto in = static_cast<unsigned long>(std::llround(in_rate));
+    const auto out = static_cast<unsigned long>(std::llround(out_rate));
+    if (in == 0 || out == 0 || std::abs(in_rate - in) > 1e-6 || std::abs(out_rate - out) > 1e-6)
+        throw std::invalid_argument("ResamplerCascade: rates must be positive integers (Hz)");
+    if (!(passband_hz > 0.0 && passband_hz < std::min(in_rate, out_rate) / 2.0))
+        throw std::invalid_argument("ResamplerCascade: pass band must be below Nyquist");
+
+    const unsigned long g = std::gcd(in, out);
+    const auto interp = static_cast<unsigned>(out / g);
+    const auto decim = static_cast<unsigned>(in / g);
+    // Pure decimation is split into stages; a rational ratio runs as one
+    // L/M stage, since decimating first would discard the pass band.
+    std::vector<unsigned> factors;
+    if (interp == 1)
+        factors = plan_decimation(decim);
+    else
+        factors.push_back(decim);
+
+    double rate = in_rate;
+    for (std::size_t i = 0; i < factors.size(); ++i) {
+        const bool last = i + 1 == factors.size();
+        const unsigned l = last ? interp : 1;
+        const unsigned m = factors[i];
+        const double next = rate * l / m;
+        // Intermediate stages only need to keep aliases out of the final
+        // pass band; the last one must also clear its own Nyquist zone.
+        const double stop_hz = last ? std::min(rate, next) / 2.0 : next - passband_hz;
+        stages_.push_back(PolyphaseResampler::design(l, m, passband_hz / rate, stop_hz / rate,
+                                                     atten_db, isa));
+        rate = next;
+    }
+    for (std::size_t i = 0; i + 1 < stages_.size(); ++i)
+        scratch_.emplace_back(stages_[i].max_output(chunk) + 1);
+}
+
+std::size_t ResamplerCascade::max_output(std::size_t n) const noexcept
+{
+    for (const auto& s : stages_)
+        n = s.max_output(n);
+    return n;
+}
+
+std::size_t ResamplerCascade::process(std::span<const Complex> in, std::span<Complex> out) noexcept
+{
+    if (stages_.empty()) {
+        std::copy(in.begin(), in.end(), out.begin());
+        return in.size();
+    }
+    std::size_t written = 0;
+    for (std::size_t at = 0; at < in.size(); at += chunk) {
+        std::span<const Complex> x = in.subspan(at, std::min(chunk, in.size() - at));
+        for (std::size_t s = 0; s + 1 < stages_.size(); ++s) {
+            const std::size_t n = stages_[s].process(x, scratch_[s]);
+            x = std::span<const Complex>(scratch_[s].data(), n);
+        }
+        written += stages_.back().process(x, out.subspan(written));
+    }
+    return written;
+}
+
+void ResamplerCascade::reset() noexcept
+{
+    for (auto& s : stages_)
+        s.reset();
+}
+
+} // namespace mprp
@@ -0,0 +1,73 @@
+#include "mprp/power.hpp"
+
+#include <cstdio>
+#include <ctime>
+
+namespace mprp {
+
+namespace {
+
+constexpr const char* rapl_dir = "/sys/class/powercap/intel-rapl:0/";
+
+std::int64_t read_number(const std::string& path) noexcept
+{
+    std::FILE* f = std::fopen(path.c_str(), "r");
+    if (!f)
+        return -1;
+    long long v = -1;
+    if (std::fscanf(f, "%lld", &v) != 1)
+        v = -1;
+    std::fclose(f);
+    return v;
+}
+
+} // namespace
+
+std::chrono::nanoseconds process_cpu_time() noexcept
+{
+    timespec ts{};
+    ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+PowerMeter::PowerMeter(PowerModel model)
+    : model_(model), wall_(std::chrono::steady_clock::now()), cpu_(process_cpu_time())
+{
+    if (model_.measure) {
+        counter_ = std::string(rapl_dir) + "energy_uj";
+        counter_range_ = read_number(std::string(rapl_dir) + "max_energy_range_uj");
+        energy_uj_ = read_counter();
+        if (energy_uj_ < 0 || counter_range_ <= 0)
+            counter_.clear();
+    }
+}
+
+std::int64_t PowerMeter::read_counter() const noexcept
+{
+    return counter_.empty() ? -1 : read_number(counter_);
+}
+
+PowerSample PowerMeter::lap() noexcept
+{
+    const auto now = std::chrono::steady_clock::now();
+    const auto cpu = process_cpu_time();
+    PowerSample s;
+    s.wall = std::chrono::duration_cast<std::chrono::nanoseconds>(now - wall_);
+    s.cpu = cpu - cpu_;
+    wall_ = now;
+    cpu_ = cpu;
+
+    const std::int64_t uj = read_counter();
+    if (uj >= 0 && energy_uj_ >= 0) {
+        const std::int64_t delta = uj >= energy_uj_ ? uj - energy_uj_ : uj + counter_range_ - energy_uj_;
+        s.energy_j = static_cast<double>(delta) * 1e-6;
+        s.measured = true;
+    } else {
+        s.energy_j = model_.idle_w * std::chrono::duration<double>(s.wall).count()
+                     + model_.core_w * std::chrono::duration<double>(s.cpu).count();
+    }
+    energy_uj_ = uj;
+    return s;
+}
+
+} // namespace mprp
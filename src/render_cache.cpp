@@ -0,0 +1,216 @@
+#include "mprp/render_cache.hpp"
+
+#include "mprp/hash.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mprp {
+
+namespace {
+
+constexpr std::uint64_t file_magic = 0x52444e5250525050ull;  // "PPRPRNDR"
+constexpr std::uint32_t file_version = 1;
+
+// Fixed 64-byte header so the samples that follow stay aligned.
+struct FileHeader {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t key;
+    std::uint64_t samples;
+    std::uint64_t checksum;  ///< Fnv1a over the sample bytes.
+    std::uint8_t pad[24];
+};
+static_assert(sizeof(FileHeader) == 64);
+
+class HeapBuffer final : public RenderedBuffer {
+public:
+    explicit HeapBuffer(std::vector<float> samples) : samples_(std::move(samples)) {}
+    std::span<const float> samples() const noexcept override { return samples_; }
+
+private:
+    std::vector<float> samples_;
+};
+
+class MappedBuffer final : public RenderedBuffer {
+public:
+    MappedBuffer(void* base, std::size_t length, std::size_t samples)
+        : base_(base), length_(length), samples_(samples)
+    {
+    }
+    ~MappedBuffer() override { ::munmap(base_, length_); }
+    std::span<const float> samples() const noexcept override
+    {
+        return {reinterpret_cast<const float*>(static_cast<const char*>(base_) + sizeof(FileHeader)),
+                samples_};
+    }
+
+private:
+    void* base_;
+    std::size_t length_;
+    std::size_t samples_;
+};
+
+std::uint64_t checksum(std::span<const float> s) noexcept
+{
+    return Fnv1a().bytes(s.data(), s.size_bytes()).value();
+}
+
+std::shared_ptr<const RenderedBuffer> map_file(const std::string& path, std::uint64_t key)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+    struct stat st {};
+    void* base = MAP_FAILED;
+    const bool sized = ::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(FileHeader);
+    if (sized)
+        base = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+        return nullptr;
+
+    const auto length = static_cast<std::size_t>(st.st_size);
+    const auto* h = static_cast<const FileHeader*>(base);
+    auto buffer = std::make_shared<MappedBuffer>(base, length, static_cast<std::size_t>(h->samples));
+    if (h->magic != file_magic || h->version != file_version || h->key != key
+        || length != sizeof(FileHeader) + h->samples * sizeof(float)
+        || checksum(buffer->samples()) != h->checksum)
+        return nullptr;  // stale or torn; the caller re-renders and replaces it
+    return buffer;
+}
+
+void write_file(const std::string& path, std::uint64_t key, std::span<const float> samples)
+{
+    FileHeader h{};
+    h.magic = file_magic;
+    h.version = file_version;
+    h.key = key;
+    h.samples = samples.size();
+    h.checksum = checksum(samples);
+
+    // Write beside the target and rename, so readers only ever map
+    // complete files.
+    const std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f)
+        return;
+    const bool ok = std::fwrite(&h, sizeof h, 1, f) == 1
+                    && std::fwrite(samples.data(), sizeof(float), samples.size(), f) == samples.size();
+    if (std::fclose(f) != 0 || !ok || std::rename(tmp.c_str(), path.c_str()) != 0)
+        std::remove(tmp.c_str());
+}
+
+} // namespace
+
+RenderCache::RenderCache(std::size_t memory_bytes, std::string directory)
+    : capacity_(memory_bytes), directory_(std::move(directory))
+{
+    if (!directory_.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory_, ec);
+        if (!std::filesystem::is_directory(directory_))
+            throw std::runtime_error("cannot create render cache directory " + directory_);
+    }
+}
+
+std::string RenderCache::path(std::uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof name, "/%016llx.f32", static_cast<unsigned long long>(key));
+    return directory_ + name;
+}
+
+std::shared_ptr<const RenderedBuffer> RenderCache::find_locked(std::uint64_t key)
+{
+    const auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        ++hits_;
+        return it->second.buffer;
+    }
+    if (directory_.empty())
+        return nullptr;
+    auto mapped = map_file(path(key), key);
+    if (mapped) {
+        ++disk_hits_;
+        insert_locked(key, mapped);
+    }
+    return mapped;
+}
+
+void RenderCache::insert_locked(std::uint64_t key, std::shared_ptr<const RenderedBuffer> buffer)
+{
+    const std::size_t size = buffer->samples().size_bytes();
+    if (size > capacity_)
+        return;  // still served to this caller, just not kept
+    lru_.push_front(key);
+    entries_[key] = Entry{std::move(buffer), lru_.begin()};
+    bytes_ += size;
+    while (bytes_ > capacity_) {
+        const auto victim = entries_.find(lru_.back());
+        bytes_ -= victim->second.buffer->samples().size_bytes();
+        entries_.erase(victim);
+        lru_.pop_back();
+    }
+}
+
+std::shared_ptr<const RenderedBuffer> RenderCache::find(std::uint64_t key)
+{
+    std::lock_guard lock(mutex_);
+    return find_locked(key);
+}
+
+std::shared_ptr<const RenderedBuffer> RenderCache::get(std::uint64_t key, std::size_t max_samples,
+                                                       const Render& render)
+{
+    {
+        std::lock_guard lock(mutex_);
+        if (auto hit = find_locked(key))
+            return hit;
+        ++misses_;
+    }
+
+    // Render outside the lock; a racing renderer of the same key just wins.
+    std::vector<float> samples(max_samples);
+    samples.resize(render(samples));
+    if (!directory_.empty())
+        write_file(path(key), key, samples);
+    auto buffer = std::make_shared<const HeapBuffer>(std::move(samples));
+
+    std::lock_guard lock(mutex_);
+    if (const auto it = entries_.find(key); it != entries_.end())
+        return it->second.buffer;
+    insert_locked(key, buffer);
+    return buffer;
+}
+
+void RenderCache::retain(std::span<const std::uint64_t> keep)
+{
+    if (directory_.empty())
+        return;
+    std::error_code ec;
+    for (const auto& f : std::filesystem::directory_iterator(directory_, ec)) {
+        const std::string name = f.path().filename().string();
+        if (name.size() != 20 || f.path().extension() != ".f32")
+            continue;
+        const std::uint64_t key = std::strtoull(name.c_str(), nullptr, 16);
+        bool wanted = false;
+        for (auto k : keep)
+            wanted = wanted || k == key;
+        if (!wanted)
+            std::filesystem::remove(f.path(), ec);
+    }
+}
+
+} // namespace mprp
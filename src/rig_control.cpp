@@ -0,0 +1,508 @@
+#include "mprp/rig_control.hpp"
+
+#include "mprp/metrics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace mprp {
+
+namespace {
+
+// Pause before retrying a batch the rig refused or did not answer.
+constexpr auto retry_pause = std::chrono::milliseconds(100);
+
+constexpr char civ_preamble = '\xfe';
+constexpr char civ_end = '\xfd';
+constexpr char civ_controller = '\xe0';
+constexpr char civ_ok = '\xfb';
+constexpr char civ_ng = '\xfa';
+
+speed_t baud_constant(unsigned baud)
+{
+    switch (baud) {
+    case 1200: return B1200;
+    case 2400: return B2400;
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    }
+    throw std::invalid_argument("RigControl: unsupported baud rate " + std::to_string(baud));
+}
+
+/// Opens a serial port raw, 8N1, non-blocking.
+int open_port(const std::string& device, unsigned baud)
+{
+    const speed_t speed = baud_constant(baud);
+    const int fd = ::open(device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("cannot open rig port " + device + ": " + std::strerror(errno));
+    termios tio{};
+    if (::tcgetattr(fd, &tio) != 0) {
+        const int err = errno;
+        ::close(fd);
+        throw std::runtime_error(device + " is not a serial port: " + std::strerror(err));
+    }
+    ::cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~static_cast<tcflag_t>(CSTOPB | CRTSCTS);
+    ::cfsetispeed(&tio, speed);
+    ::cfsetospeed(&tio, speed);
+    if (::tcsetattr(fd, TCSANOW, &tio) != 0) {
+        const int err = errno;
+        ::close(fd);
+        throw std::runtime_error("cannot set up rig port " + device + ": " + std::strerror(err));
+    }
+    ::tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+char kenwood_mode(RigMode mode) noexcept
+{
+    switch (mode) {
+    case RigMode::Lsb: return '1';
+    case RigMode::Usb: return '2';
+    case RigMode::Cw: return '3';
+    case RigMode::Fm: return '4';
+    case RigMode::Am: return '5';
+    }
+    return '2';
+}
+
+char civ_mode(RigMode mode) noexcept
+{
+    switch (mode) {
+    case RigMode::Lsb: return '\x00';
+    case RigMode::Usb: return '\x01';
+    case RigMode::Am: return '\x02';
+    case RigMode::Cw: return '\x03';
+    case RigMode::Fm: return '\x05';
+    }
+    return '\x01';
+}
+
+char bcd(unsigned tens, unsigned units) noexcept
+{
+    return static_cast<char>(((tens % 10) << 4) | (units % 10));
+}
+
+/// CI-V frequency: five BCD bytes, least significant pair first.
+std::string civ_frequency(std::uint64_t hz)
+{
+    std::string body(1, '\x05');
+    for (int i = 0; i < 5; ++i) {
+        const auto units = static_cast<unsigned>(hz % 10);
+        const auto tens = static_cast<unsigned>(hz / 10 % 10);
+        body.push_back(bcd(tens, units));
+        hz /= 100;
+    }
+    return body;
+}
+
+/// CI-V RF power: level 0..255 as four BCD digits.
+std::string civ_power(unsigned watts, unsigned max_watts)
+{
+    const unsigned level = max_watts ? std::min<unsigned>(255, (watts * 255 + max_watts / 2) / max_watts) : 255;
+    std::string body = "\x14\x0a";
+    body.push_back(bcd(0, level / 100));
+    body.push_back(bcd(level / 10, level));
+    return body;
+}
+
+bool empty(const RigState& s) noexcept
+{
+    return !s.frequency_hz && !s.mode && !s.power_w && !s.ptt;
+}
+
+} // namespace
+
+RigProtocol parse_rig_protocol(std::string_view name)
+{
+    if (name == "kenwood")
+        return RigProtocol::Kenwood;
+    if (name == "civ")
+        return RigProtocol::Civ;
+    throw std::invalid_argument("unknown rig protocol '" + std::string(name) + "'");
+}
+
+const char* to_string(RigProtocol protocol) noexcept
+{
+    switch (protocol) {
+    case RigProtocol::Kenwood: return "kenwood";
+    case RigProtocol::Civ: return "civ";
+    }
+    return "?";
+}
+
+/// What one round with the rig changes, in the order it is sent: an unkey
+/// first, then setup, then a key-up last.
+struct RigControl::Batch {
+    bool unkey = false;
+    std::optional<std::uint64_t> frequency_hz;
+    std::optional<RigMode> mode;
+    std::optional<unsigned> power_w;
+    bool key = false;
+    unsigned skipped = 0;  ///< Wanted values that were already the rig's.
+
+    unsigned size() const noexcept
+    {
+        return unsigned(unkey) + unsigned(frequency_hz.has_value()) + unsigned(mode.has_value())
+               + unsigned(power_w.has_value()) + unsigned(key);
+    }
+};
+
+RigControl::RigControl(RigControlOptions options)
+    : options_(std::move(options)),
+      loop_(options_.loop ? *options_.loop : control_loop()),
+      wake_(loop_)
+{
+    options_.max_attempts = std::max(options_.max_attempts, 1u);
+    fd_ = open_port(options_.device, options_.baud);
+    spawn(loop_, run());
+}
+
+RigControl::~RigControl()
+{
+    std::unique_lock lock(mutex_);
+    wanted_ = {};
+    release_.reset();
+    if (state_.ptt != false)
+        wanted_.ptt = false;
+    stopping_ = true;
+    wake_.set();
+    idle_.wait(lock, [this] { return done_; });
+    ::close(fd_);
+}
+
+void RigControl::request(const RigState& wanted)
+{
+    {
+        std::lock_guard lock(mutex_);
+        if (wanted.frequency_hz)
+            wanted_.frequency_hz = wanted.frequency_hz;
+        if (wanted.mode)
+            wanted_.mode = wanted.mode;
+        if (wanted.power_w)
+            wanted_.power_w = wanted.power_w;
+        if (wanted.ptt) {
+            wanted_.ptt = wanted.ptt;
+            release_.reset();
+        }
+    }
+    wake_.set();
+}
+
+void RigControl::release_at(std::chrono::steady_clock::time_point when)
+{
+    {
+        std::lock_guard lock(mutex_);
+        release_ = when;
+    }
+    wake_.set();
+}
+
+bool RigControl::sync(std::chrono::milliseconds timeout)
+{
+    std::unique_lock lock(mutex_);
+    wake_.set();
+    return idle_.wait_for(lock, timeout, [this] { return done_ || (!busy_ && empty(wanted_)); });
+}
+
+RigState RigControl::state() const
+{
+    std::lock_guard lock(mutex_);
+    return state_;
+}
+
+void RigControl::invalidate()
+{
+    std::lock_guard lock(mutex_);
+    state_ = {};
+}
+
+std::chrono::nanoseconds RigControl::ptt_latency() const noexcept
+{
+    // "TX;" or FE FE addr E0 1C 00 01 FD, ten bit times a byte.
+    const std::int64_t bytes = options_.protocol == RigProtocol::Kenwood ? 3 : 8;
+    return std::chrono::nanoseconds(bytes * 10 * 1'000'000'000 / options_.baud) + options_.ptt_delay;
+}
+
+RigControl::Batch RigControl::take_locked()
+{
+    Batch b;
+    const auto take = [&b](auto& want, const auto& have, auto& out) {
+        if (!want)
+            return;
+        if (want != have)
+            out = want;
+        else
+            ++b.skipped;
+        want.reset();
+    };
+
+    if (wanted_.ptt == false) {
+        if (state_.ptt != false)
+            b.unkey = true;
+        else
+            ++b.skipped;
+        wanted_.ptt.reset();
+    }
+    // An unknown PTT state counts as unkeyed, or nothing could ever be set.
+    if (!state_.ptt.value_or(false) || b.unkey) {
+        take(wanted_.frequency_hz, state_.frequency_hz, b.frequency_hz);
+        take(wanted_.mode, state_.mode, b.mode);
+        take(wanted_.power_w, state_.power_w, b.power_w);
+    }
+    if (wanted_.ptt == true) {
+        if (state_.ptt != true)
+            b.key = true;
+        else
+            ++b.skipped;
+        wanted_.ptt.reset();
+    }
+    return b;
+}
+
+Task<bool> RigControl::fill()
+{
+    std::array<char, 256> buf;
+    const std::ptrdiff_t got = co_await read_some(loop_, fd_, buf, options_.timeout);
+    if (got <= 0)
+        co_return false;
+    in_.append(buf.data(), static_cast<std::size_t>(got));
+    co_return true;
+}
+
+Task<bool> RigControl::send_kenwood(const Batch& b)
+{
+    // Sets are not acknowledged (only refused, with "?;"), so the batch is
+    // written in one go and a frequency query behind it says when the rig
+    // has worked through it.
+    std::string out;
+    char field[24];
+    if (b.unkey)
+        out.append("RX;");
+    if (b.frequency_hz) {
+        std::snprintf(field, sizeof field, "FA%011llu;", static_cast<unsigned long long>(*b.frequency_hz));
+        out.append(field);
+    }
+    if (b.mode)
+        out.append("MD").append(1, kenwood_mode(*b.mode)).append(";");
+    if (b.power_w) {
+        std::snprintf(field, sizeof field, "PC%03u;", std::min(*b.power_w, 999u));
+        out.append(field);
+    }
+    if (b.key)
+        out.append("TX;");
+    out.append("FA;");
+
+    reported_hz_.reset();
+    ::tcflush(fd_, TCIFLUSH);  // late replies from an earlier, timed-out batch
+    in_.clear();
+    const bool written = co_await write_all(loop_, fd_, out, options_.timeout);
+    if (!written)
+        co_return false;
+
+    bool refused = false;
+    for (;;) {
+        const auto end = in_.find(';');
+        if (end == std::string::npos) {
+            const bool more = co_await fill();
+            if (!more)
+                co_return false;
+            continue;
+        }
+        const std::string_view token(in_.data(), end);
+        if (token == "?" || token == "E" || token == "O") {
+            refused = true;
+        } else if (token.size() == 13 && token.starts_with("FA")) {
+            std::uint64_t hz = 0;
+            for (const char c : token.substr(2))
+                hz = hz * 10 + static_cast<std::uint64_t>(c - '0');
+            reported_hz_ = hz;
+            in_.erase(0, end + 1);
+            co_return !refused;
+        }
+        // Anything else is auto-information the rig volunteered.
+        in_.erase(0, end + 1);
+    }
+}
+
+Task<bool> RigControl::civ_command(std::string_view body)
+{
+    std::string frame{civ_preamble, civ_preamble, static_cast<char>(options_.civ_address), civ_controller};
+    frame.append(body);
+    frame.push_back(civ_end);
+
+    ::tcflush(fd_, TCIFLUSH);
+    in_.clear();
+    const bool written = co_await write_all(loop_, fd_, frame, options_.timeout);
+    if (!written)
+        co_return false;
+
+    // The bus echoes our own frame; the answer is the frame addressed to
+    // the controller from the rig.
+    for (;;) {
+        const auto start = in_.find("\xfe\xfe");
+        const auto end = start == std::string::npos ? start : in_.find(civ_end, start);
+        if (end == std::string::npos) {
+            const bool more = co_await fill();
+            if (!more)
+                co_return false;
+            continue;
+        }
+        const std::string_view reply(in_.data() + start, end - start);
+        if (reply.size() >= 5 && reply[2] == civ_controller && reply[3] == static_cast<char>(options_.civ_address)
+            && (reply[4] == civ_ok || reply[4] == civ_ng)) {
+            const bool ok = reply[4] == civ_ok;
+            in_.erase(0, end + 1);
+            co_return ok;
+        }
+        in_.erase(0, end + 1);
+    }
+}
+
+Task<bool> RigControl::send_civ(const Batch& b)
+{
+    // Every command is acknowledged and the bus is half duplex: one at a
+    // time.
+    std::string commands[5];
+    std::size_t n = 0;
+    if (b.unkey)
+        commands[n++] = std::string("\x1c\x00\x00", 3);
+    if (b.frequency_hz)
+        commands[n++] = civ_frequency(*b.frequency_hz);
+    if (b.mode)
+        commands[n++] = std::string{'\x06', civ_mode(*b.mode), '\x01'};
+    if (b.power_w)
+        commands[n++] = civ_power(*b.power_w, options_.civ_max_power_w);
+    if (b.key)
+        commands[n++] = std::string("\x1c\x00\x01", 3);
+    for (std::size_t i = 0; i < n; ++i) {
+        const bool ok = co_await civ_command(commands[i]);
+        if (!ok)
+            co_return false;
+    }
+    co_return true;
+}
+
+Task<bool> RigControl::send(const Batch& b)
+{
+    if (options_.protocol == RigProtocol::Civ) {
+        const bool ok = co_await send_civ(b);
+        co_return ok;
+    }
+    const bool ok = co_await send_kenwood(b);
+    co_return ok;
+}
+
+Task<void> RigControl::run()
+{
+    const auto batch_timer = metrics::stage("rig.batch");
+    const auto command_counter = metrics::counter("rig.commands");
+    const auto skipped_counter = metrics::counter("rig.skipped");
+    const auto error_counter = metrics::counter("rig.errors");
+
+    // As in SpotUploader::run(), the lock is only held between awaits.
+    std::unique_lock lock(mutex_);
+    unsigned attempt = 0;
+    for (;;) {
+        if (release_ && *release_ <= std::chrono::steady_clock::now()) {
+            wanted_.ptt = false;
+            release_.reset();
+        }
+        const Batch batch = take_locked();
+        if (batch.skipped) {
+            skipped_.fetch_add(batch.skipped, std::memory_order_relaxed);
+            metrics::add(skipped_counter, batch.skipped);
+        }
+        if (batch.size() == 0) {
+            busy_ = false;
+            idle_.notify_all();
+            if (stopping_)
+                break;
+            const auto release = release_;
+            lock.unlock();
+            if (release) {
+                const bool woken = co_await wake_.wait_until(*release);
+                (void)woken;
+            } else {
+                co_await wake_.wait();
+            }
+            lock.lock();
+            continue;
+        }
+        busy_ = true;
+        lock.unlock();
+
+        bool ok = false;
+        {
+            metrics::ScopedTimer t(batch_timer);
+            ok = co_await send(batch);
+        }
+        commands_.fetch_add(batch.size(), std::memory_order_relaxed);
+        metrics::add(command_counter, batch.size());
+
+        lock.lock();
+        if (ok) {
+            batches_.fetch_add(1, std::memory_order_relaxed);
+            attempt = 0;
+            if (batch.unkey)
+                state_.ptt = false;
+            if (batch.frequency_hz)
+                state_.frequency_hz = batch.frequency_hz;
+            if (batch.mode)
+                state_.mode = batch.mode;
+            if (batch.power_w)
+                state_.power_w = batch.power_w;
+            if (batch.key)
+                state_.ptt = true;
+            if (reported_hz_)
+                state_.frequency_hz = reported_hz_;
+            continue;
+        }
+
+        errors_.fetch_add(1, std::memory_order_relaxed);
+        metrics::add(error_counter);
+        // The rig may have taken some of it: those settings are unknown now.
+        if (batch.unkey || batch.key)
+            state_.ptt.reset();
+        if (batch.frequency_hz)
+            state_.frequency_hz.reset();
+        if (batch.mode)
+            state_.mode.reset();
+        if (batch.power_w)
+            state_.power_w.reset();
+        if (++attempt >= options_.max_attempts) {
+            attempt = 0;
+            continue;
+        }
+        // Retry what has not been superseded meanwhile.
+        if (!wanted_.ptt && (batch.unkey || batch.key))
+            wanted_.ptt = batch.key;
+        if (!wanted_.frequency_hz)
+            wanted_.frequency_hz = batch.frequency_hz;
+        if (!wanted_.mode)
+            wanted_.mode = batch.mode;
+        if (!wanted_.power_w)
+            wanted_.power_w = batch.power_w;
+        lock.unlock();
+        co_await loop_.sleep_for(retry_pause);
+        lock.lock();
+    }
+    done_ = true;
+    idle_.notify_all();
+}
+
+} // namespace mprp
@@ -0,0 +1,162 @@
+#include "mprp/rx_pipeline.hpp"
+
+#include "mprp/metrics.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace mprp {
+
+void BlockQueue::post(Block* block) noexcept
+{
+    // The ring is at least as large as the pool, so it can only be full
+    // transiently; yield rather than drop.
+    while (ring_.write_region(1).empty())
+        std::this_thread::yield();
+    ring_.write_region(1).first[0] = block;
+    ring_.commit(1);
+    posted_.fetch_add(1, std::memory_order_release);
+    posted_.notify_one();
+}
+
+void BlockQueue::push(BufferRef block) noexcept
+{
+    post(block.detach());
+}
+
+void BlockQueue::push_end() noexcept
+{
+    post(nullptr);
+}
+
+BufferRef BlockQueue::pop() noexcept
+{
+    for (;;) {
+        const std::uint32_t seen = posted_.load(std::memory_order_acquire);
+        const auto region = ring_.read_region(1);
+        if (!region.empty()) {
+            Block* b = region.first[0];
+            ring_.release(1);
+            return BufferRef::adopt(b);
+        }
+        posted_.wait(seen, std::memory_order_acquire);
+    }
+}
+
+bool pin_current_thread(int cpu) noexcept
+{
+    if (cpu < 0)
+        return true;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+BufferRef Source::next(BufferPool& pool)
+{
+    BufferRef block = pool.acquire();
+    block->size = read(block.storage());
+    return block;
+}
+
+RxPipeline::RxPipeline(BufferPool& pool, std::unique_ptr<Source> source)
+    : pool_(pool), source_(std::move(source))
+{
+    if (!source_)
+        throw std::invalid_argument("RxPipeline needs a source");
+}
+
+RxPipeline::~RxPipeline()
+{
+    stop();
+    wait();
+}
+
+RxPipeline& RxPipeline::add(std::unique_ptr<Stage> stage, int cpu)
+{
+    if (!threads_.empty())
+        throw std::logic_error("RxPipeline: cannot add stages while running");
+    stages_.push_back(std::move(stage));
+    cpus_.push_back(cpu);
+    // +1 so the end-of-stream marker always fits behind a full pool.
+    queues_.push_back(std::make_unique<BlockQueue>(pool_.blocks() + 1));
+    stats_.push_back(std::make_unique<StageStats>());
+    return *this;
+}
+
+void RxPipeline::start()
+{
+    if (!threads_.empty())
+        throw std::logic_error("RxPipeline already started");
+    stopping_.store(false, std::memory_order_relaxed);
+    source_->set_raw(!stages_.empty() && stages_.front()->accepts_raw());
+    for (std::size_t i = 0; i < stages_.size(); ++i)
+        threads_.emplace_back(&RxPipeline::stage_loop, this, i);
+    threads_.emplace_back(&RxPipeline::source_loop, this);
+}
+
+void RxPipeline::wait()
+{
+    for (auto& t : threads_)
+        if (t.joinable())
+            t.join();
+    threads_.clear();
+}
+
+void RxPipeline::source_loop()
+{
+    pin_current_thread(source_cpu_);
+    const Emitter emit(queues_.empty() ? nullptr : queues_.front().get());
+    const double rate = source_->sample_rate();
+    std::uint64_t sequence = 0;
+    std::uint64_t position = 0;
+
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        BufferRef block = source_->next(pool_);
+        if (!block || block->size == 0)
+            break;
+        const std::size_t n = block->size;
+        block->sample_rate = rate;
+        block->sequence = sequence++;
+        block->first_sample = position;
+        position += n;
+        source_samples_.store(position, std::memory_order_relaxed);
+        emit(std::move(block));
+    }
+    if (!queues_.empty())
+        queues_.front()->push_end();
+}
+
+void RxPipeline::stage_loop(std::size_t index)
+{
+    pin_current_thread(cpus_[index]);
+    Stage& stage = *stages_[index];
+    StageStats& stats = *stats_[index];
+    BlockQueue& in = *queues_[index];
+    const Emitter emit(index + 1 < queues_.size() ? queues_[index + 1].get() : nullptr);
+    const metrics::StageId timer = metrics::stage(std::string("rx.") + stage.name());
+    const metrics::CounterId counted = metrics::counter(std::string("rx.") + stage.name() + ".samples");
+
+    while (BufferRef block = in.pop()) {
+        const auto t0 = std::chrono::steady_clock::now();
+        const std::size_t n = block->size;
+        stage.process(std::move(block), emit);
+        const auto dt = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+        stats.blocks.fetch_add(1, std::memory_order_relaxed);
+        stats.samples.fetch_add(n, std::memory_order_relaxed);
+        stats.busy_ns.fetch_add(dt, std::memory_order_relaxed);
+        metrics::record(timer, dt);
+        metrics::add(counted, n);
+    }
+    stage.finish(emit);
+    if (index + 1 < queues_.size())
+        queues_[index + 1]->push_end();
+}
+
+} // namespace mprp
@@ -0,0 +1,428 @@
+#include "mprp/rx_stages.hpp"
+
+#include "mprp/nco.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numbers>
+#include <stdexcept>
+
+namespace mprp {
+
+IqFormat parse_iq_format(const std::string& name)
+{
+    if (name == "cf32")
+        return IqFormat::Cf32;
+    if (name == "cs16")
+        return IqFormat::Cs16;
+    if (name == "cu8")
+        return IqFormat::Cu8;
+    if (name == "cs8")
+        return IqFormat::Cs8;
+    throw std::invalid_argument("unknown IQ format '" + name + "'");
+}
+
+std::size_t iq_sample_bytes(IqFormat format) noexcept
+{
+    switch (format) {
+    case IqFormat::Cf32: return 8;
+    case IqFormat::Cs16: return 4;
+    case IqFormat::Cu8: return 2;
+    case IqFormat::Cs8: return 2;
+    }
+    return 8;
+}
+
+void decode_iq(IqFormat format, const void* raw, std::span<Complex> out) noexcept
+{
+    with_sample_type(format, [&]<typename T>(std::type_identity<T>) {
+        convert_frames<T>(static_cast<const unsigned char*>(raw), out.size(), {out.data()});
+    });
+}
+
+void encode_iq(IqFormat format, std::span<const Complex> samples, void* raw) noexcept
+{
+    auto* bytes = static_cast<unsigned char*>(raw);
+    const std::size_t n = samples.size();
+    switch (format) {
+    case IqFormat::Cf32:
+        std::memcpy(bytes, samples.data(), n * sizeof(Complex));
+        break;
+    case IqFormat::Cs16:
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::int16_t iq[2] = {
+                static_cast<std::int16_t>(std::lrint(std::clamp(samples[i].real() * 32768.0f, -32768.0f, 32767.0f))),
+                static_cast<std::int16_t>(std::lrint(std::clamp(samples[i].imag() * 32768.0f, -32768.0f, 32767.0f)))};
+            std::memcpy(bytes + i * 4, iq, 4);
+        }
+        break;
+    case IqFormat::Cu8:
+        for (std::size_t i = 0; i < n; ++i) {
+            bytes[2 * i] = static_cast<unsigned char>(
+                std::lrint(std::clamp(samples[i].real() * 128.0f + 127.5f, 0.0f, 255.0f)));
+            bytes[2 * i + 1] = static_cast<unsigned char>(
+                std::lrint(std::clamp(samples[i].imag() * 128.0f + 127.5f, 0.0f, 255.0f)));
+        }
+        break;
+    case IqFormat::Cs8:
+        for (std::size_t i = 0; i < n; ++i) {
+            bytes[2 * i] = static_cast<unsigned char>(static_cast<std::int8_t>(
+                std::lrint(std::clamp(samples[i].real() * 128.0f, -128.0f, 127.0f))));
+            bytes[2 * i + 1] = static_cast<unsigned char>(static_cast<std::int8_t>(
+                std::lrint(std::clamp(samples[i].imag() * 128.0f, -128.0f, 127.0f))));
+        }
+        break;
+    }
+}
+
+namespace {
+
+// A block from a stage's private two-block pool (created on first need)
+// carrying like's metadata, for stages that would otherwise write into a
+// shared or read-only block.
+BufferRef spare_block(const Block& like, std::unique_ptr<BufferPool>& spare)
+{
+    if (!spare)
+        spare = std::make_unique<BufferPool>(2, like.capacity);
+    BufferRef out = spare->acquire();
+    out->size = like.size;
+    out->sample_rate = like.sample_rate;
+    out->sequence = like.sequence;
+    out->first_sample = like.first_sample;
+    out->start = like.start;
+    return out;
+}
+
+} // namespace
+
+FileSource::FileSource(const std::string& path, IqFormat format, double sample_rate)
+    : file_(std::fopen(path.c_str(), "rb")), format_(format), sample_rate_(sample_rate)
+{
+    if (!file_)
+        throw std::runtime_error("cannot open IQ file '" + path + "'");
+}
+
+FileSource::~FileSource()
+{
+    std::fclose(file_);
+}
+
+std::size_t FileSource::read(std::span<Complex> out)
+{
+    const std::size_t width = iq_sample_bytes(format_);
+    if (format_ == IqFormat::Cf32)
+        return std::fread(out.data(), width, out.size(), file_);
+
+    raw_.resize(out.size() * width);
+    const std::size_t n = std::fread(raw_.data(), width, out.size(), file_);
+    decode_iq(format_, raw_.data(), out.first(n));
+    return n;
+}
+
+BufferRef FileSource::next(BufferPool& pool)
+{
+    if (!raw_mode_ || format_ == IqFormat::Cf32)
+        return Source::next(pool);
+    // Raw samples are narrower than Complex, so a block's worth fits its storage.
+    BufferRef block = pool.acquire();
+    block->size = std::fread(block->data, iq_sample_bytes(format_), block->capacity, file_);
+    block->format = format_;
+    return block;
+}
+
+MixerStage::MixerStage(double shift_hz) : shift_hz_(shift_hz) {}
+
+void MixerStage::process(BufferRef block, const Emitter& emit)
+{
+    const std::size_t n = block->size;
+    if (lo_.size() < block->capacity)
+        lo_.resize(block->capacity);  // once, on the first block
+    const std::uint32_t step = phase_step(-shift_hz_, block->sample_rate);
+    std::fill_n(lo_.begin(), n, Complex{});
+    phase_ = nco_accumulate(phase_, step, 1.0f, std::span(lo_.data(), n));
+
+    BufferRef out = block.unique() ? block : spare_block(*block, spare_);
+    const auto* src = reinterpret_cast<const unsigned char*>(block->data);
+    with_sample_type(block->format, [&]<typename T>(std::type_identity<T>) {
+        mix_frames<T>(src, n, lo_.data(), {out->data});
+    });
+    out->format = IqFormat::Cf32;
+    block.reset();
+    emit(std::move(out));
+}
+
+ResamplerStage::ResamplerStage(double out_rate, double passband_hz,
+                               std::size_t out_block_samples, std::size_t out_blocks)
+    : out_rate_(out_rate), passband_hz_(passband_hz), pool_(out_blocks, out_block_samples)
+{
+}
+
+void ResamplerStage::flush(const Emitter& emit)
+{
+    if (out_ && out_->size > 0) {
+        out_->sequence = out_sequence_++;
+        out_position_ += out_->size;
+        emit(std::move(out_));
+    }
+    out_.reset();
+}
+
+void ResamplerStage::process(BufferRef block, const Emitter& emit)
+{
+    if (!cascade_ || cascade_->in_rate() != block->sample_rate) {
+        cascade_.emplace(block->sample_rate, out_rate_, passband_hz_);
+        scratch_.resize(cascade_->max_output(block->capacity) + 1);
+    }
+
+    const std::size_t n = cascade_->process(block.samples(), scratch_);
+    for (std::size_t i = 0; i < n;) {
+        if (!out_) {
+            out_ = pool_.acquire();
+            out_->sample_rate = out_rate_;
+            out_->first_sample = out_position_;
+            out_->start = block->start;
+        }
+        const std::size_t take = std::min(n - i, out_->capacity - out_->size);
+        std::copy_n(scratch_.begin() + static_cast<std::ptrdiff_t>(i), take, out_->data + out_->size);
+        out_->size += take;
+        i += take;
+        if (out_->size == out_->capacity)
+            flush(emit);
+    }
+}
+
+void ResamplerStage::finish(const Emitter& emit)
+{
+    flush(emit);
+}
+
+FrontEndStage::FrontEndStage(double shift_hz, double out_rate, double passband_hz, std::optional<AgcConfig> agc,
+                             std::size_t out_block_samples, std::size_t out_blocks)
+    : shift_hz_(shift_hz), out_rate_(out_rate), passband_hz_(passband_hz), agc_(agc),
+      // The oscillator and mixed tiles take half of L1; the cascade's delay
+      // lines and the raw input share the rest.
+      tile_(std::clamp<std::size_t>(std::bit_floor(l1_data_cache_bytes() / (4 * sizeof(Complex))), kernel_chunk,
+                                    2048)),
+      pool_(out_blocks, out_block_samples), lo_(tile_), mixed_(tile_)
+{
+    if (agc_) {
+        if (!(agc_->target_rms > 0.0 && agc_->attack_s > 0.0 && agc_->decay_s > 0.0))
+            throw std::invalid_argument("invalid AGC settings");
+        agc_attack_ = static_cast<float>(1.0 - std::exp(-1.0 / (agc_->attack_s * out_rate_)));
+        agc_decay_ = static_cast<float>(1.0 - std::exp(-1.0 / (agc_->decay_s * out_rate_)));
+        agc_max_gain_ = static_cast<float>(std::pow(10.0, agc_->max_gain_db / 20.0));
+    }
+}
+
+void FrontEndStage::flush(const Emitter& emit)
+{
+    if (out_ && out_->size > 0) {
+        out_->sequence = out_sequence_++;
+        out_position_ += out_->size;
+        emit(std::move(out_));
+    }
+    out_.reset();
+}
+
+void FrontEndStage::apply_agc(std::span<Complex> y) noexcept
+{
+    const auto target = static_cast<float>(agc_->target_rms);
+    float level = agc_level_;
+    for (Complex& v : y) {
+        const float p = v.real() * v.real() + v.imag() * v.imag();
+        level += (p > level ? agc_attack_ : agc_decay_) * (p - level);
+        const float gain = std::min(agc_max_gain_, target / std::sqrt(level + 1e-30f));
+        v = {v.real() * gain, v.imag() * gain};
+    }
+    agc_level_ = level;
+}
+
+template <typename T>
+void FrontEndStage::run(const unsigned char* in, std::size_t n, const Block& like, const Emitter& emit)
+{
+    const std::uint32_t step = phase_step(-shift_hz_, like.sample_rate);
+    for (std::size_t at = 0; at < n; at += tile_) {
+        const std::size_t m = std::min(tile_, n - at);
+        std::fill_n(lo_.begin(), m, Complex{});
+        phase_ = nco_accumulate(phase_, step, 1.0f, std::span(lo_.data(), m));
+        mix_frames<T>(in + at * sizeof(T), m, lo_.data(), {mixed_.data()});
+        const std::size_t k = cascade_->process(std::span<const Complex>(mixed_.data(), m), scratch_);
+        const std::span<Complex> y(scratch_.data(), k);
+        if (agc_)
+            apply_agc(y);
+
+        for (std::size_t i = 0; i < k;) {
+            if (!out_) {
+                out_ = pool_.acquire();
+                out_->sample_rate = out_rate_;
+                out_->first_sample = out_position_;
+                out_->start = like.start;
+            }
+            const std::size_t take = std::min(k - i, out_->capacity - out_->size);
+            std::copy_n(y.begin() + static_cast<std::ptrdiff_t>(i), take, out_->data + out_->size);
+            out_->size += take;
+            i += take;
+            if (out_->size == out_->capacity)
+                flush(emit);
+        }
+    }
+}
+
+void FrontEndStage::process(BufferRef block, const Emitter& emit)
+{
+    if (!cascade_ || cascade_->in_rate() != block->sample_rate) {
+        cascade_.emplace(block->sample_rate, out_rate_, passband_hz_);
+        scratch_.resize(cascade_->max_output(tile_) + 1);
+    }
+    const auto* in = reinterpret_cast<const unsigned char*>(block->data);
+    with_sample_type(block->format,
+                     [&]<typename T>(std::type_identity<T>) { run<T>(in, block->size, *block, emit); });
+}
+
+void FrontEndStage::finish(const Emitter& emit)
+{
+    flush(emit);
+}
+
+FirStage::FirStage(std::vector<float> taps) : taps_(std::move(taps))
+{
+    if (taps_.empty())
+        throw std::invalid_argument("FIR needs at least one tap");
+    history_.assign(taps_.size() - 1, Complex{});
+    next_history_.assign(taps_.size() - 1, Complex{});
+}
+
+template <typename T>
+void FirStage::filter_raw(Block& block) noexcept
+{
+    const std::size_t n = block.size;
+    const std::size_t l = taps_.size();
+    const auto keep = static_cast<std::ptrdiff_t>(l - 1);
+    const auto* raw = reinterpret_cast<const unsigned char*>(block.data);
+    // Converted x[j] for j >= 0, else the previous block's tail.
+    auto input = [&](std::ptrdiff_t j) {
+        return j >= 0 ? SampleTraits<T>::load(raw + static_cast<std::size_t>(j) * sizeof(T))
+                      : history_[static_cast<std::size_t>(keep + j)];
+    };
+    for (std::ptrdiff_t k = 0; k < keep; ++k)
+        next_history_[static_cast<std::size_t>(k)] = input(static_cast<std::ptrdiff_t>(n) + k - keep);
+
+    // Back to front a chunk at a time: convert the chunk and the taps-1
+    // inputs before it into window_, filter, and write the chunk's output
+    // over raw samples that are no longer needed.
+    window_.resize(l - 1 + kernel_chunk);
+    Complex out[kernel_chunk];
+    for (std::size_t end = n; end > 0;) {
+        const std::size_t begin = end > kernel_chunk ? end - kernel_chunk : 0;
+        const std::size_t m = end - begin;
+        for (std::ptrdiff_t j = 0; j < keep + static_cast<std::ptrdiff_t>(m); ++j)
+            window_[static_cast<std::size_t>(j)] = input(static_cast<std::ptrdiff_t>(begin) - keep + j);
+        for (std::size_t i = 0; i < m; ++i) {
+            Complex acc{};
+            const Complex* xi = window_.data() + (l - 1) + i;
+            for (std::size_t k = 0; k < l; ++k)
+                acc += taps_[k] * xi[-static_cast<std::ptrdiff_t>(k)];
+            out[i] = acc;
+        }
+        std::memcpy(block.data + begin, out, m * sizeof(Complex));
+        end = begin;
+    }
+    history_.swap(next_history_);
+    block.format = IqFormat::Cf32;
+}
+
+std::vector<float> FirStage::lowpass(std::size_t taps, double cutoff)
+{
+    if (taps == 0 || !(cutoff > 0.0 && cutoff < 0.5))
+        throw std::invalid_argument("invalid low-pass design");
+    std::vector<float> h(taps);
+    const double mid = (static_cast<double>(taps) - 1.0) / 2.0;
+    double sum = 0.0;
+    for (std::size_t i = 0; i < taps; ++i) {
+        const double x = static_cast<double>(i) - mid;
+        const double sinc = x == 0.0 ? 2.0 * cutoff
+                                     : std::sin(2.0 * std::numbers::pi * cutoff * x) / (std::numbers::pi * x);
+        const double w = taps == 1 ? 1.0
+                                   : 0.54 - 0.46 * std::cos(2.0 * std::numbers::pi * i / (taps - 1));
+        h[i] = static_cast<float>(sinc * w);
+        sum += h[i];
+    }
+    for (auto& v : h)
+        v = static_cast<float>(v / sum);
+    return h;
+}
+
+void FirStage::process(BufferRef block, const Emitter& emit)
+{
+    if (!block.unique()) {
+        BufferRef copy = spare_block(*block, spare_);
+        std::memcpy(copy->data, block->data, block->size * iq_sample_bytes(block->format));
+        copy->format = block->format;
+        block = std::move(copy);
+    }
+    if (block->format != IqFormat::Cf32) {
+        with_sample_type(block->format, [&]<typename T>(std::type_identity<T>) { filter_raw<T>(*block); });
+        emit(std::move(block));
+        return;
+    }
+    const std::size_t n = block->size;
+    const std::size_t l = taps_.size();
+    const std::size_t keep = l - 1;
+    Complex* x = block->data;
+
+    // x[j] for j >= 0, else the previous block's tail.
+    auto input = [&](std::ptrdiff_t j) {
+        return j >= 0 ? x[j] : history_[static_cast<std::size_t>(static_cast<std::ptrdiff_t>(keep) + j)];
+    };
+
+    // Capture the tail before it is overwritten; it is the next history.
+    for (std::size_t k = 0; k < keep; ++k)
+        next_history_[k] = input(static_cast<std::ptrdiff_t>(n + k) - static_cast<std::ptrdiff_t>(keep));
+
+    // Filter back to front: y[i] depends only on x[<= i], so writing y[i]
+    // over x[i] never clobbers an input still needed.
+    for (std::size_t i = n; i-- > keep;) {
+        Complex acc{};
+        const Complex* xi = x + i;
+        for (std::size_t k = 0; k < l; ++k)
+            acc += taps_[k] * xi[-static_cast<std::ptrdiff_t>(k)];
+        x[i] = acc;
+    }
+    for (std::size_t i = std::min(n, keep); i-- > 0;) {
+        Complex acc{};
+        for (std::size_t k = 0; k < l; ++k)
+            acc += taps_[k] * input(static_cast<std::ptrdiff_t>(i) - static_cast<std::ptrdiff_t>(k));
+        x[i] = acc;
+    }
+    history_.swap(next_history_);
+    emit(std::move(block));
+}
+
+EnergyDetector::EnergyDetector(double threshold_db, Callback callback)
+    : threshold_db_(threshold_db), callback_(std::move(callback))
+{
+}
+
+void EnergyDetector::process(BufferRef block, const Emitter& emit)
+{
+    if (block->size == 0)
+        return;
+    const double power = mean_power<Complex>(reinterpret_cast<const unsigned char*>(block->data), block->size)[0];
+
+    if (!primed_) {
+        floor_ = power;
+        primed_ = true;
+    }
+    const double power_db = 10.0 * std::log10(power + 1e-20);
+    const double floor_db = 10.0 * std::log10(floor_ + 1e-20);
+    if (power_db - floor_db >= threshold_db_ && callback_)
+        callback_({block->first_sample, block->sample_rate, power_db, floor_db});
+    else
+        floor_ += 0.05 * (power - floor_);  // only learn the floor from quiet blocks
+    emit(std::move(block));
+}
+
+} // namespace mprp
@@ -0,0 +1,95 @@
+// AVX2 spot store column filters. Built with -mavx2 -mfma and only called
+// after isa_supported(Isa::Avx2) has confirmed the CPU.
+
+#include "scan_kernels.hpp"
+
+#include <immintrin.h>
+
+namespace mprp::detail {
+
+namespace {
+
+void range_i64_avx2(const std::int64_t* v, std::size_t n, std::int64_t lo, std::int64_t hi,
+                    std::uint64_t* mask) noexcept
+{
+    const __m256i vlo = _mm256_set1_epi64x(lo);
+    const __m256i vhi = _mm256_set1_epi64x(hi);
+    const std::size_t whole = n / 64;
+    for (std::size_t w = 0; w < whole; ++w) {
+        std::uint64_t bits = 0;
+        for (unsigned j = 0; j < 64; j += 4) {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + w * 64 + j));
+            // lo <= x < hi  ==  !(lo > x) && hi > x
+            const __m256i ok = _mm256_andnot_si256(_mm256_cmpgt_epi64(vlo, x), _mm256_cmpgt_epi64(vhi, x));
+            bits |= static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(ok))) << j;
+        }
+        mask[w] &= bits;
+    }
+    if (whole * 64 < n)
+        scan_range_scalar(v + whole * 64, n - whole * 64, lo, hi, mask + whole);
+}
+
+void range_f64_avx2(const double* v, std::size_t n, double lo, double hi, std::uint64_t* mask) noexcept
+{
+    const __m256d vlo = _mm256_set1_pd(lo);
+    const __m256d vhi = _mm256_set1_pd(hi);
+    const std::size_t whole = n / 64;
+    for (std::size_t w = 0; w < whole; ++w) {
+        std::uint64_t bits = 0;
+        for (unsigned j = 0; j < 64; j += 4) {
+            const __m256d x = _mm256_loadu_pd(v + w * 64 + j);
+            const __m256d ok = _mm256_and_pd(_mm256_cmp_pd(x, vlo, _CMP_GE_OQ), _mm256_cmp_pd(x, vhi, _CMP_LT_OQ));
+            bits |= static_cast<std::uint64_t>(_mm256_movemask_pd(ok)) << j;
+        }
+        mask[w] &= bits;
+    }
+    if (whole * 64 < n)
+        scan_range_scalar(v + whole * 64, n - whole * 64, lo, hi, mask + whole);
+}
+
+void range_f32_avx2(const float* v, std::size_t n, float lo, float hi, std::uint64_t* mask) noexcept
+{
+    const __m256 vlo = _mm256_set1_ps(lo);
+    const __m256 vhi = _mm256_set1_ps(hi);
+    const std::size_t whole = n / 64;
+    for (std::size_t w = 0; w < whole; ++w) {
+        std::uint64_t bits = 0;
+        for (unsigned j = 0; j < 64; j += 8) {
+            const __m256 x = _mm256_loadu_ps(v + w * 64 + j);
+            const __m256 ok = _mm256_and_ps(_mm256_cmp_ps(x, vlo, _CMP_GE_OQ), _mm256_cmp_ps(x, vhi, _CMP_LT_OQ));
+            bits |= static_cast<std::uint64_t>(_mm256_movemask_ps(ok)) << j;
+        }
+        mask[w] &= bits;
+    }
+    if (whole * 64 < n)
+        scan_range_scalar(v + whole * 64, n - whole * 64, lo, hi, mask + whole);
+}
+
+void equal_u32_avx2(const std::uint32_t* v, std::size_t n, std::uint32_t value, std::uint64_t* mask) noexcept
+{
+    const __m256i want = _mm256_set1_epi32(static_cast<int>(value));
+    const std::size_t whole = n / 64;
+    for (std::size_t w = 0; w < whole; ++w) {
+        std::uint64_t bits = 0;
+        for (unsigned j = 0; j < 64; j += 8) {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + w * 64 + j));
+            const __m256i ok = _mm256_cmpeq_epi32(x, want);
+            bits |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(ok))))
+                    << j;
+        }
+        mask[w] &= bits;
+    }
+    if (whole * 64 < n)
+        scan_equal_u32_scalar(v + whole * 64, n - whole * 64, value, mask + whole);
+}
+
+} // namespace
+
+const ScanKernels scan_kernels_avx2{
+    &range_i64_avx2,
+    &range_f64_avx2,
+    &range_f32_avx2,
+    &equal_u32_avx2,
+};
+
+} // namespace mprp::detail
@@ -0,0 +1,82 @@
+#pragma once
+
+// Private column filter kernels for the spot store.
+//
+// Each kernel tests n values of one column against a predicate and ANDs
+// the outcome into mask, bit j of mask[j / 64] for value j, so successive
+// calls narrow one selection. n need not be a multiple of 64; bits of the
+// last word past n are cleared.
+
+#include "mprp/cpu.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mprp::detail {
+
+struct ScanKernels {
+    /// lo <= v < hi.
+    void (*range_i64)(const std::int64_t* v, std::size_t n, std::int64_t lo, std::int64_t hi,
+                      std::uint64_t* mask) noexcept;
+    void (*range_f64)(const double* v, std::size_t n, double lo, double hi, std::uint64_t* mask) noexcept;
+    void (*range_f32)(const float* v, std::size_t n, float lo, float hi, std::uint64_t* mask) noexcept;
+    /// v == value.
+    void (*equal_u32)(const std::uint32_t* v, std::size_t n, std::uint32_t value, std::uint64_t* mask) noexcept;
+};
+
+// The scalar kernels build each word branch-free, which compilers also
+// vectorise for the baseline instruction set.
+template <class T>
+void scan_range_scalar(const T* v, std::size_t n, T lo, T hi, std::uint64_t* mask) noexcept
+{
+    for (std::size_t w = 0; w * 64 < n; ++w) {
+        const std::size_t m = n - w * 64 < 64 ? n - w * 64 : 64;
+        std::uint64_t bits = 0;
+        for (std::size_t j = 0; j < m; ++j)
+            bits |= static_cast<std::uint64_t>((v[w * 64 + j] >= lo) & (v[w * 64 + j] < hi)) << j;
+        mask[w] &= bits;
+    }
+}
+
+inline void scan_equal_u32_scalar(const std::uint32_t* v, std::size_t n, std::uint32_t value,
+                                  std::uint64_t* mask) noexcept
+{
+    for (std::size_t w = 0; w * 64 < n; ++w) {
+        const std::size_t m = n - w * 64 < 64 ? n - w * 64 : 64;
+        std::uint64_t bits = 0;
+        for (std::size_t j = 0; j < m; ++j)
+            bits |= static_cast<std::uint64_t>(v[w * 64 + j] == value) << j;
+        mask[w] &= bits;
+    }
+}
+
+inline constexpr ScanKernels scan_kernels_scalar{
+    &scan_range_scalar<std::int64_t>,
+    &scan_range_scalar<double>,
+    &scan_range_scalar<float>,
+    &scan_equal_u32_scalar,
+};
+
+#if defined(MPRP_HAVE_AVX2)
+extern const ScanKernels scan_kernels_avx2;
+#endif
+
+#if defined(MPRP_HAVE_NEON)
+/// 32-bit lanes only; the 64-bit columns use the scalar kernels.
+extern const ScanKernels scan_kernels_neon;
+#endif
+
+inline const ScanKernels& scan_kernels(Isa isa) noexcept
+{
+    switch (isa) {
+#if defined(MPRP_HAVE_AVX2)
+    case Isa::Avx2: return scan_kernels_avx2;
+#endif
+#if defined(MPRP_HAVE_NEON)
+    case Isa::Neon: return scan_kernels_neon;
+#endif
+    default: return scan_kernels_scalar;
+    }
+}
+
+} // namespace mprp::detail
@@ -0,0 +1,59 @@
+// NEON spot store column filters over 32-bit lanes. Only called after
+// isa_supported(Isa::Neon) has confirmed the CPU.
+
+#include "scan_kernels.hpp"
+
+#include <arm_neon.h>
+
+namespace mprp::detail {
+
+namespace {
+
+// One bit per lane of four all-ones / all-zeros lanes.
+std::uint64_t lane_bits(uint32x4_t ok) noexcept
+{
+    return (vgetq_lane_u32(ok, 0) & 1u) | (vgetq_lane_u32(ok, 1) & 2u) | (vgetq_lane_u32(ok, 2) & 4u)
+           | (vgetq_lane_u32(ok, 3) & 8u);
+}
+
+void range_f32_neon(const float* v, std::size_t n, float lo, float hi, std::uint64_t* mask) noexcept
+{
+    const float32x4_t vlo = vdupq_n_f32(lo);
+    const float32x4_t vhi = vdupq_n_f32(hi);
+    const std::size_t whole = n / 64;
+    for (std::size_t w = 0; w < whole; ++w) {
+        std::uint64_t bits = 0;
+        for (unsigned j = 0; j < 64; j += 4) {
+            const float32x4_t x = vld1q_f32(v + w * 64 + j);
+            bits |= lane_bits(vandq_u32(vcgeq_f32(x, vlo), vcltq_f32(x, vhi))) << j;
+        }
+        mask[w] &= bits;
+    }
+    if (whole * 64 < n)
+        scan_range_scalar(v + whole * 64, n - whole * 64, lo, hi, mask + whole);
+}
+
+void equal_u32_neon(const std::uint32_t* v, std::size_t n, std::uint32_t value, std::uint64_t* mask) noexcept
+{
+    const uint32x4_t want = vdupq_n_u32(value);
+    const std::size_t whole = n / 64;
+    for (std::size_t w = 0; w < whole; ++w) {
+        std::uint64_t bits = 0;
+        for (unsigned j = 0; j < 64; j += 4)
+            bits |= lane_bits(vceqq_u32(vld1q_u32(v + w * 64 + j), want)) << j;
+        mask[w] &= bits;
+    }
+    if (whole * 64 < n)
+        scan_equal_u32_scalar(v + whole * 64, n - whole * 64, value, mask + whole);
+}
+
+} // namespace
+
+const ScanKernels scan_kernels_neon{
+    &scan_range_scalar<std::int64_t>,
+    &scan_range_scalar<double>,
+    &range_f32_neon,
+    &equal_u32_neon,
+};
+
+} // namespace mprp::detail
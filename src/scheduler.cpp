@@ -0,0 +1,47 @@
+#include "mprp/scheduler.hpp"
+
+#include <cmath>
+
+namespace mprp {
+
+namespace {
+
+std::chrono::nanoseconds to_ns(double seconds)
+{
+    return std::chrono::nanoseconds(std::llround(seconds * 1e9));
+}
+
+std::int64_t floor_div(std::int64_t a, std::int64_t b)
+{
+    std::int64_t q = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0)))
+        --q;
+    return q;
+}
+
+} // namespace
+
+SlotClock::SlotClock(double period_s, double offset_s, std::size_t entries)
+    : period_(to_ns(period_s)), offset_(to_ns(offset_s)), entries_(entries == 0 ? 1 : entries)
+{
+}
+
+SlotPlan SlotClock::at(std::int64_t index) const noexcept
+{
+    const auto start = TimePoint(period_ * index + offset_);
+    const auto rot = static_cast<std::size_t>(
+        ((index % static_cast<std::int64_t>(entries_)) + static_cast<std::int64_t>(entries_))
+        % static_cast<std::int64_t>(entries_));
+    return {index, start, rot};
+}
+
+SlotPlan SlotClock::next(TimePoint now) const noexcept
+{
+    const auto since = (now.time_since_epoch() - offset_).count();
+    std::int64_t index = floor_div(since, period_.count());
+    if (at(index).start < now)
+        ++index;
+    return at(index);
+}
+
+} // namespace mprp
@@ -0,0 +1,170 @@
+#include "mprp/spectrum.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace mprp {
+
+SpectrumMonitor::SpectrumMonitor(SpectrumConfig config, Callback callback)
+    : config_(std::move(config)),
+      callback_(std::move(callback)),
+      n_(config_.fft_size),
+      hop_(config_.hop ? config_.hop : config_.fft_size / 2),
+      plan_(fft_plan(n_)),
+      window_(window_table(config_.window, n_))
+{
+    if (config_.history_rows == 0 || !(config_.sample_rate > 0.0))
+        throw std::invalid_argument("SpectrumMonitor: invalid configuration");
+
+    // Normalise so a full-scale complex tone centred on a bin reads 0 dB.
+    const double tone = static_cast<double>(n_) * window_->coherent_gain;
+    scale_db_ = static_cast<float>(-20.0 * std::log10(tone));
+
+    carry_.resize(n_);
+    work_.resize(n_);
+    waterfall_.assign(config_.history_rows * n_, -200.0f);
+    readings_.resize(config_.channels.size());
+
+    const double bin = bin_hz();
+    std::size_t widest = 1;
+    for (const auto& ch : config_.channels) {
+        const double lo = (ch.offset_hz - ch.bandwidth_hz / 2.0) / bin + static_cast<double>(n_) / 2.0;
+        const double hi = (ch.offset_hz + ch.bandwidth_hz / 2.0) / bin + static_cast<double>(n_) / 2.0;
+        const auto first = static_cast<std::size_t>(std::clamp(std::floor(lo), 0.0, static_cast<double>(n_ - 1)));
+        const auto last = static_cast<std::size_t>(std::clamp(std::ceil(hi), 0.0, static_cast<double>(n_ - 1)));
+        channel_bins_.emplace_back(first, std::max(first, last) + 1);
+        widest = std::max(widest, channel_bins_.back().second - first);
+    }
+    scratch_.resize(widest);
+}
+
+std::size_t SpectrumMonitor::rows() const noexcept
+{
+    return static_cast<std::size_t>(std::min<std::uint64_t>(frames_, config_.history_rows));
+}
+
+std::span<const float> SpectrumMonitor::row(std::size_t age) const noexcept
+{
+    const std::size_t r = static_cast<std::size_t>((frames_ - 1 - age) % config_.history_rows);
+    return {waterfall_.data() + r * n_, n_};
+}
+
+std::size_t SpectrumMonitor::push(std::span<const Complex> samples)
+{
+    const std::uint64_t begin = consumed_;
+    const std::uint64_t end = begin + samples.size();
+    const std::uint64_t carry_begin = begin - carry_size_;
+    std::size_t produced = 0;
+
+    while (next_frame_ + n_ <= end) {
+        // Frame = tail of the carried samples (if it starts before this
+        // block) followed by samples straight out of the caller's block.
+        std::span<const Complex> carry;
+        std::span<const Complex> fresh;
+        if (next_frame_ < begin) {
+            carry = std::span<const Complex>(carry_.data() + (next_frame_ - carry_begin),
+                                             static_cast<std::size_t>(begin - next_frame_));
+            fresh = samples.first(n_ - carry.size());
+        } else {
+            fresh = samples.subspan(static_cast<std::size_t>(next_frame_ - begin), n_);
+        }
+        transform_frame(carry, fresh);
+        next_frame_ += hop_;
+        ++produced;
+    }
+
+    // Keep whatever the next frame still needs (fewer than n_ samples).
+    const std::uint64_t keep_from = std::max<std::uint64_t>(next_frame_, carry_begin);
+    std::size_t kept = 0;
+    if (keep_from < end) {
+        kept = static_cast<std::size_t>(end - keep_from);
+        if (keep_from < begin) {
+            // Part of the old carry survives; slide it to the front first.
+            const std::size_t old = static_cast<std::size_t>(begin - keep_from);
+            std::copy_n(carry_.begin() + static_cast<std::ptrdiff_t>(keep_from - carry_begin), old,
+                        carry_.begin());
+            std::copy(samples.begin(), samples.end(), carry_.begin() + static_cast<std::ptrdiff_t>(old));
+        } else {
+            std::copy(samples.end() - static_cast<std::ptrdiff_t>(kept), samples.end(), carry_.begin());
+        }
+    }
+    carry_size_ = kept;
+    consumed_ = end;
+    return produced;
+}
+
+void SpectrumMonitor::transform_frame(std::span<const Complex> carry, std::span<const Complex> fresh)
+{
+    const float* w = window_->values.data();
+    std::size_t i = 0;
+    for (const Complex x : carry) {
+        work_[i] = x * w[i];
+        ++i;
+    }
+    for (const Complex x : fresh) {
+        work_[i] = x * w[i];
+        ++i;
+    }
+    plan_->forward(work_);
+
+    const std::size_t r = static_cast<std::size_t>(frames_ % config_.history_rows);
+    float* power = waterfall_.data() + r * n_;
+    const std::size_t half = n_ / 2;
+    for (std::size_t k = 0; k < n_; ++k) {
+        // fftshift: negative frequencies first.
+        const std::size_t out = k < half ? k + half : k - half;
+        power[out] = 10.0f * std::log10(std::norm(work_[k]) + 1e-30f) + scale_db_;
+    }
+    read_channels(power);
+
+    if (callback_)
+        callback_({frames_, next_frame_, {power, n_}, readings_});
+    ++frames_;
+}
+
+void SpectrumMonitor::read_channels(const float* power)
+{
+    const double bin = bin_hz();
+    for (std::size_t c = 0; c < channel_bins_.size(); ++c) {
+        const auto [first, last] = channel_bins_[c];
+        const float* p = power + first;
+        const std::size_t width = last - first;
+        const std::size_t peak = static_cast<std::size_t>(std::max_element(p, p + width) - p);
+
+        // Parabolic interpolation on the dB values around the peak.
+        double delta = 0.0;
+        if (peak > 0 && peak + 1 < width) {
+            const double a = p[peak - 1];
+            const double b = p[peak];
+            const double d = p[peak + 1];
+            const double denom = a - 2.0 * b + d;
+            if (denom < 0.0)
+                delta = 0.5 * (a - d) / denom;
+        }
+
+        std::copy_n(p, width, scratch_.begin());
+        const auto mid = scratch_.begin() + static_cast<std::ptrdiff_t>(width / 2);
+        std::nth_element(scratch_.begin(), mid, scratch_.begin() + static_cast<std::ptrdiff_t>(width));
+
+        auto& r = readings_[c];
+        r.channel = c;
+        r.peak_hz = (static_cast<double>(first + peak) + delta - static_cast<double>(n_ / 2)) * bin;
+        r.peak_db = p[peak];
+        r.noise_db = *mid;
+        r.snr_db = r.peak_db - r.noise_db;
+    }
+}
+
+SpectrumStage::SpectrumStage(SpectrumConfig config, SpectrumMonitor::Callback callback)
+    : monitor_(std::move(config), std::move(callback))
+{
+}
+
+void SpectrumStage::process(BufferRef block, const Emitter& emit)
+{
+    monitor_.push(block.samples());
+    emit(std::move(block));
+}
+
+} // namespace mprp
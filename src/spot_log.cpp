@@ -0,0 +1,445 @@
+#include "mprp/spot_log.hpp"
+
+#include "mprp/hash.hpp"
+#include "mprp/wspr_search.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mprp {
+
+namespace {
+
+constexpr std::uint64_t log_magic = 0x00474f4c5052504dull;  // "MPRPLOG\0"
+constexpr std::uint32_t log_version = 1;
+
+struct LogHeader {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t record_size;
+    std::int64_t created_unix_ns;
+    std::uint8_t reserved[104];
+};
+static_assert(sizeof(LogHeader) == sizeof(LogRecord));
+
+std::uint32_t record_checksum(const LogRecord& r) noexcept
+{
+    return static_cast<std::uint32_t>(Fnv1a().bytes(&r, offsetof(LogRecord, checksum)).value());
+}
+
+template <std::size_t N>
+void copy_text(char (&field)[N], std::string_view s) noexcept
+{
+    const std::size_t n = std::min(N, s.size());
+    std::memcpy(field, s.data(), n);
+    std::memset(field + n, 0, N - n);
+}
+
+template <std::size_t N>
+std::string_view text_of(const char (&field)[N]) noexcept
+{
+    return {field, static_cast<std::size_t>(std::find(field, field + N, '\0') - field)};
+}
+
+bool write_all(int fd, const void* data, std::size_t n) noexcept
+{
+    const auto* p = static_cast<const unsigned char*>(data);
+    while (n > 0) {
+        const ssize_t w = ::write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+    return true;
+}
+
+// ---- export ---------------------------------------------------------------
+
+// 2026-10-14T04:02:00.000Z without gmtime (days-to-civil, proleptic Gregorian).
+std::size_t format_time(std::int64_t unix_ns, char (&out)[64]) noexcept
+{
+    const std::int64_t ms = unix_ns >= 0 ? unix_ns / 1'000'000 : -((-unix_ns + 999'999) / 1'000'000);
+    std::int64_t days = ms >= 0 ? ms / 86'400'000 : -((-ms + 86'399'999) / 86'400'000);
+    const std::int64_t in_day = ms - days * 86'400'000;
+    days += 719468;
+    const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const std::int64_t doe = days - era * 146097;
+    const std::int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const std::int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const std::int64_t mp = (5 * doy + 2) / 153;
+    const std::int64_t d = doy - (153 * mp + 2) / 5 + 1;
+    const std::int64_t m = mp < 10 ? mp + 3 : mp - 9;
+    const std::int64_t y = yoe + era * 400 + (m <= 2);
+    const int n = std::snprintf(out, sizeof out, "%04lld-%02lld-%02lldT%02lld:%02lld:%02lld.%03lldZ", static_cast<long long>(y),
+                                static_cast<long long>(m), static_cast<long long>(d),
+                                static_cast<long long>(in_day / 3'600'000), static_cast<long long>(in_day / 60'000 % 60),
+                                static_cast<long long>(in_day / 1000 % 60), static_cast<long long>(in_day % 1000));
+    return n > 0 ? static_cast<std::size_t>(n) : 0;
+}
+
+// Batches formatted lines into large fwrite() calls.
+class LineBuffer {
+public:
+    explicit LineBuffer(std::FILE* out) : out_(out) {}
+    ~LineBuffer() { drain(); }
+
+    /// Room for one line (lines are bounded; see reserve below).
+    char* reserve() noexcept
+    {
+        if (used_ + max_line > sizeof buf_)
+            drain();
+        return buf_ + used_;
+    }
+    void commit(std::size_t n) noexcept { used_ += std::min(n, max_line - 1); }
+    void drain() noexcept
+    {
+        if (used_)
+            std::fwrite(buf_, 1, used_, out_);
+        used_ = 0;
+    }
+
+    static constexpr std::size_t max_line = 512;
+
+private:
+    std::FILE* out_;
+    char buf_[1 << 16];
+    std::size_t used_ = 0;
+};
+
+// JSON string body for a NUL-padded field (escapes quotes, backslashes,
+// control characters).
+std::string json_text(std::string_view s)
+{
+    std::string out;
+    for (const char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char esc[8];
+            std::snprintf(esc, sizeof esc, "\\u%04x", static_cast<unsigned>(c));
+            out += esc;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+// CSV field; quoted only when it needs to be.
+std::string csv_text(std::string_view s)
+{
+    if (s.find_first_of(",\"\n") == std::string_view::npos)
+        return std::string(s);
+    std::string out = "\"";
+    for (const char c : s) {
+        if (c == '"')
+            out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+} // namespace
+
+const char* to_string(LogKind kind) noexcept
+{
+    switch (kind) {
+    case LogKind::Spot: return "spot";
+    case LogKind::Tx: return "tx";
+    }
+    return "?";
+}
+
+std::string_view LogRecord::callsign_view() const noexcept
+{
+    return text_of(callsign);
+}
+
+std::string_view LogRecord::grid_view() const noexcept
+{
+    return text_of(grid);
+}
+
+std::string_view LogRecord::name_view() const noexcept
+{
+    return text_of(name);
+}
+
+bool verify(const LogRecord& record) noexcept
+{
+    return record_checksum(record) == record.checksum;
+}
+
+void seal(LogRecord& record) noexcept
+{
+    record.checksum = record_checksum(record);
+}
+
+LogRecord spot_record(const WsprSpot& spot, double dial_hz) noexcept
+{
+    LogRecord r{};
+    r.time_unix_ns = spot.slot.time_since_epoch().count();
+    r.kind = LogKind::Spot;
+    r.power_dbm = static_cast<std::int16_t>(spot.report.power_dbm);
+    r.mode = static_cast<std::uint8_t>(Mode::Wspr);
+    r.freq_hz = dial_hz + spot.freq_hz;
+    r.snr_db = static_cast<float>(spot.snr_db);
+    r.drift_hz = static_cast<float>(spot.drift_hz);
+    r.dt_s = static_cast<float>(spot.dt_s);
+    r.sync = static_cast<float>(spot.sync);
+    copy_text(r.callsign, spot.report.callsign);
+    copy_text(r.grid, spot.report.grid);
+    return r;
+}
+
+LogRecord tx_record(const SlotPlan& plan, const BeaconEntry& entry, TimeLock lock, std::chrono::nanoseconds late,
+                    std::size_t samples) noexcept
+{
+    LogRecord r{};
+    r.time_unix_ns = plan.start.time_since_epoch().count();
+    r.kind = LogKind::Tx;
+    r.entry = static_cast<std::uint16_t>(plan.entry);
+    r.mode = static_cast<std::uint8_t>(entry.mode);
+    r.lock = static_cast<std::uint8_t>(lock);
+    r.freq_hz = entry.audio_hz;
+    r.late_us = static_cast<float>(static_cast<double>(late.count()) / 1e3);
+    r.samples = static_cast<std::uint32_t>(std::min<std::size_t>(samples, UINT32_MAX));
+    if (entry.mode == Mode::Wspr) {
+        r.power_dbm = static_cast<std::int16_t>(entry.power_dbm);
+        copy_text(r.callsign, entry.callsign);
+        copy_text(r.grid, entry.grid);
+    }
+    copy_text(r.name, entry.name);
+    return r;
+}
+
+// ---- writer ---------------------------------------------------------------
+
+SpotLogWriter::SpotLogWriter(const std::string& path, SpotLogOptions options) : options_(options)
+{
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+        throw std::runtime_error("cannot open log '" + path + "'");
+    struct stat st {};
+    bool ok = ::fstat(fd_, &st) == 0;
+    const auto size = static_cast<std::uint64_t>(st.st_size);
+    if (ok && size == 0) {
+        LogHeader h{};
+        h.magic = log_magic;
+        h.version = log_version;
+        h.record_size = sizeof(LogRecord);
+        h.created_unix_ns = Clock::now().time_since_epoch().count();
+        ok = write_all(fd_, &h, sizeof h);
+    } else if (ok) {
+        LogHeader h{};
+        ok = size >= sizeof h && ::pread(fd_, &h, sizeof h, 0) == static_cast<ssize_t>(sizeof h)
+             && h.magic == log_magic && h.version == log_version && h.record_size == sizeof(LogRecord);
+        // Continue after the last whole record; cut a torn tail.
+        const std::uint64_t whole = ok ? (size - sizeof h) / sizeof(LogRecord) : 0;
+        ok = ok && ::ftruncate(fd_, static_cast<off_t>(sizeof h + whole * sizeof(LogRecord))) == 0;
+        next_sequence_.store(whole, std::memory_order_relaxed);
+    }
+    if (!ok || ::lseek(fd_, 0, SEEK_END) < 0) {
+        ::close(fd_);
+        throw std::runtime_error("'" + path + "' is not a version " + std::to_string(log_version) + " log file");
+    }
+    queue_.reserve(options_.batch_records);
+    thread_ = std::thread(&SpotLogWriter::commit_loop, this);
+}
+
+SpotLogWriter::~SpotLogWriter()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+    ::close(fd_);
+}
+
+bool SpotLogWriter::append(LogRecord record)
+{
+    bool wake = false;
+    {
+        std::lock_guard lock(mutex_);
+        if (queue_.size() >= options_.max_queued) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        record.sequence = next_sequence_.fetch_add(1, std::memory_order_relaxed);
+        record.checksum = record_checksum(record);
+        queue_.push_back(record);
+        ++queued_total_;
+        // The first record starts the commit interval; a full batch ends it.
+        wake = queue_.size() == 1 || queue_.size() == options_.batch_records;
+    }
+    if (wake)
+        wake_.notify_one();
+    return true;
+}
+
+void SpotLogWriter::flush()
+{
+    std::unique_lock lock(mutex_);
+    const std::uint64_t target = queued_total_;
+    flush_requested_ = true;
+    wake_.notify_one();
+    committed_.wait(lock, [&] { return committed_total_ >= target; });
+}
+
+void SpotLogWriter::commit_loop()
+{
+    std::vector<LogRecord> batch;
+    batch.reserve(options_.batch_records);
+    std::unique_lock lock(mutex_);
+    for (;;) {
+        // Asleep while nothing is queued, so a quiet log costs no wake-ups;
+        // then at most commit_interval until the commit.
+        wake_.wait(lock, [this] { return stopping_ || flush_requested_ || !queue_.empty(); });
+        wake_.wait_for(lock, options_.commit_interval, [this] {
+            return stopping_ || flush_requested_ || queue_.size() >= options_.batch_records;
+        });
+        // Group commit: everything queued so far goes out in one write.
+        batch.swap(queue_);
+        flush_requested_ = false;
+        const bool last = stopping_;
+        lock.unlock();
+        const std::size_t n = batch.size();
+        commit(batch);
+        lock.lock();
+        committed_total_ += n;
+        committed_.notify_all();
+        if (last && queue_.empty())
+            return;
+    }
+}
+
+void SpotLogWriter::commit(std::vector<LogRecord>& batch) noexcept
+{
+    if (batch.empty())
+        return;
+    // A write that fails part-way (ENOSPC, EIO) leaves a torn record in
+    // the file; cut back to where the batch began so that later commits
+    // stay record-aligned. The batch itself is lost and counted.
+    const off_t start = ::lseek(fd_, 0, SEEK_CUR);
+    bool ok = write_all(fd_, batch.data(), batch.size() * sizeof(LogRecord));
+    if (!ok && start >= 0 && ::ftruncate(fd_, start) == 0)
+        ::lseek(fd_, start, SEEK_SET);
+    if (ok && options_.sync)
+        ok = ::fdatasync(fd_) == 0;
+    (ok ? commits_ : errors_).fetch_add(1, std::memory_order_relaxed);
+    batch.clear();
+}
+
+// ---- reader ---------------------------------------------------------------
+
+SpotLogReader::SpotLogReader(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("cannot open log '" + path + "'");
+    struct stat st {};
+    void* base = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(LogHeader))
+        base = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+        throw std::runtime_error("'" + path + "' is not a log file");
+    base_ = static_cast<const unsigned char*>(base);
+    length_ = static_cast<std::size_t>(st.st_size);
+
+    LogHeader h;
+    std::memcpy(&h, base_, sizeof h);
+    if (h.magic != log_magic || h.version != log_version || h.record_size != sizeof(LogRecord)) {
+        ::munmap(base, length_);
+        throw std::runtime_error("'" + path + "' is not a version " + std::to_string(log_version) + " log file");
+    }
+    created_unix_ns_ = h.created_unix_ns;
+    records_ = {reinterpret_cast<const LogRecord*>(base_ + sizeof h), (length_ - sizeof h) / sizeof(LogRecord)};
+}
+
+SpotLogReader::~SpotLogReader()
+{
+    ::munmap(const_cast<unsigned char*>(base_), length_);
+}
+
+std::size_t SpotLogReader::find(TimePoint t) const noexcept
+{
+    const std::int64_t ns = t.time_since_epoch().count();
+    const auto it = std::partition_point(records_.begin(), records_.end(),
+                                         [ns](const LogRecord& r) { return r.time_unix_ns < ns; });
+    return static_cast<std::size_t>(it - records_.begin());
+}
+
+// ---- export ---------------------------------------------------------------
+
+std::size_t export_records(std::span<const LogRecord> records, ExportFormat format, std::FILE* out)
+{
+    LineBuffer buf(out);
+    if (format == ExportFormat::Csv) {
+        char* p = buf.reserve();
+        buf.commit(static_cast<std::size_t>(std::snprintf(
+            p, LineBuffer::max_line,
+            "seq,kind,time,freq_hz,snr_db,drift_hz,dt_s,sync,callsign,grid,power_dbm,mode,entry,name,lock,late_us,samples\n")));
+    }
+
+    std::size_t written = 0;
+    char time[64];
+    for (const LogRecord& r : records) {
+        if (!verify(r))
+            continue;
+        format_time(r.time_unix_ns, time);
+        const char* mode = to_string(static_cast<Mode>(r.mode));
+        const char* lock = r.kind == LogKind::Tx ? to_string(static_cast<TimeLock>(r.lock)) : "";
+        char* p = buf.reserve();
+        int n;
+        if (format == ExportFormat::Csv) {
+            n = std::snprintf(p, LineBuffer::max_line, "%llu,%s,%s,%.3f,%.1f,%.2f,%.2f,%.3f,%s,%s,%d,%s,%u,%s,%s,%.1f,%u\n",
+                              static_cast<unsigned long long>(r.sequence), to_string(r.kind), time, r.freq_hz,
+                              static_cast<double>(r.snr_db), static_cast<double>(r.drift_hz), static_cast<double>(r.dt_s),
+                              static_cast<double>(r.sync), csv_text(r.callsign_view()).c_str(),
+                              csv_text(r.grid_view()).c_str(), r.power_dbm, mode, r.entry,
+                              csv_text(r.name_view()).c_str(), lock, static_cast<double>(r.late_us), r.samples);
+        } else if (r.kind == LogKind::Spot) {
+            n = std::snprintf(p, LineBuffer::max_line,
+                              "{\"seq\":%llu,\"kind\":\"spot\",\"time\":\"%s\",\"freq_hz\":%.3f,\"snr_db\":%.1f,"
+                              "\"drift_hz\":%.2f,\"dt_s\":%.2f,\"sync\":%.3f,\"callsign\":\"%s\",\"grid\":\"%s\","
+                              "\"power_dbm\":%d,\"mode\":\"%s\"}\n",
+                              static_cast<unsigned long long>(r.sequence), time, r.freq_hz,
+                              static_cast<double>(r.snr_db), static_cast<double>(r.drift_hz),
+                              static_cast<double>(r.dt_s), static_cast<double>(r.sync),
+                              json_text(r.callsign_view()).c_str(), json_text(r.grid_view()).c_str(), r.power_dbm,
+                              mode);
+        } else {
+            n = std::snprintf(p, LineBuffer::max_line,
+                              "{\"seq\":%llu,\"kind\":\"%s\",\"time\":\"%s\",\"entry\":%u,\"name\":\"%s\","
+                              "\"mode\":\"%s\",\"freq_hz\":%.3f,\"callsign\":\"%s\",\"grid\":\"%s\",\"power_dbm\":%d,"
+                              "\"lock\":\"%s\",\"late_us\":%.1f,\"samples\":%u}\n",
+                              static_cast<unsigned long long>(r.sequence), to_string(r.kind), time, r.entry,
+                              json_text(r.name_view()).c_str(), mode, r.freq_hz, json_text(r.callsign_view()).c_str(),
+                              json_text(r.grid_view()).c_str(), r.power_dbm, lock, static_cast<double>(r.late_us),
+                              r.samples);
+        }
+        if (n > 0) {
+            buf.commit(static_cast<std::size_t>(n));
+            ++written;
+        }
+    }
+    return written;
+}
+
+} // namespace mprp
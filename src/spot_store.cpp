@@ -0,0 +1,578 @@
+#include "mprp/spot_store.hpp"
+
+#include "mprp/hash.hpp"
+
+#include "scan_kernels.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mprp {
+
+namespace {
+
+constexpr std::uint64_t store_magic = 0x004244535052504dull;  // "MPRPSDB\0"
+constexpr std::uint32_t store_version = 1;
+constexpr std::size_t section_alignment = 64;
+
+enum Section : unsigned {
+    TimeColumn,
+    FreqColumn,
+    CallColumn,
+    GridColumn,
+    SnrColumn,
+    DriftColumn,
+    DtColumn,
+    SyncColumn,
+    PowerColumn,
+    ModeColumn,
+    Zones,
+    Calls,
+    Grids,
+    section_count,
+};
+
+struct SectionRef {
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+
+struct StoreHeader {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t block_rows;
+    std::uint64_t rows;
+    std::uint32_t blocks;
+    std::uint32_t callsigns;
+    std::uint32_t grids;
+    std::uint32_t cluster_s;
+    SectionRef sections[section_count];
+    std::uint64_t checksum;  ///< Over the bytes before it, the zone maps and the dictionaries.
+};
+static_assert(sizeof(StoreHeader) == 256);
+
+std::uint64_t metadata_checksum(const StoreHeader& h, const unsigned char* base) noexcept
+{
+    Fnv1a f;
+    f.bytes(&h, offsetof(StoreHeader, checksum));
+    for (const Section s : {Zones, Calls, Grids})
+        f.bytes(base + h.sections[s].offset, h.sections[s].size);
+    return f.value();
+}
+
+// True if every id is below count. The columns are outside the checksum,
+// so this is what keeps a damaged store from indexing past a dictionary;
+// a max reduction rather than an early exit, so it vectorises.
+bool ids_below(const std::uint32_t* ids, std::size_t n, std::uint32_t count) noexcept
+{
+    std::uint32_t top = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        top = std::max(top, ids[i]);
+    return n == 0 || top < count;
+}
+
+template <std::size_t N>
+void copy_text(char (&field)[N], std::string_view s) noexcept
+{
+    const std::size_t n = std::min(N, s.size());
+    std::memcpy(field, s.data(), n);
+    std::memset(field + n, 0, N - n);
+}
+
+std::string upper(std::string_view s)
+{
+    std::string out(s);
+    for (char& c : out)
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return out;
+}
+
+// Sorted distinct strings, serialised as count + 1 offsets and the text.
+std::vector<unsigned char> dictionary_bytes(const std::vector<std::string_view>& words)
+{
+    std::vector<std::uint32_t> offsets{0};
+    std::size_t text = 0;
+    for (const std::string_view w : words)
+        offsets.push_back(static_cast<std::uint32_t>(text += w.size()));
+    std::vector<unsigned char> out(offsets.size() * sizeof(std::uint32_t) + text);
+    std::memcpy(out.data(), offsets.data(), offsets.size() * sizeof(std::uint32_t));
+    unsigned char* p = out.data() + offsets.size() * sizeof(std::uint32_t);
+    for (const std::string_view w : words) {
+        std::memcpy(p, w.data(), w.size());
+        p += w.size();
+    }
+    return out;
+}
+
+std::vector<std::string_view> distinct(std::vector<std::string_view> words)
+{
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+std::uint32_t index_of(const std::vector<std::string_view>& words, std::string_view w) noexcept
+{
+    return static_cast<std::uint32_t>(std::lower_bound(words.begin(), words.end(), w) - words.begin());
+}
+
+struct Band {
+    const char* name;
+    double lo, hi;
+};
+
+constexpr Band bands[] = {
+    {"2200m", 135.7e3, 137.8e3}, {"630m", 472e3, 479e3},    {"160m", 1.8e6, 2.0e6},
+    {"80m", 3.5e6, 4.0e6},       {"60m", 5.25e6, 5.45e6},   {"40m", 7.0e6, 7.3e6},
+    {"30m", 10.1e6, 10.15e6},    {"20m", 14.0e6, 14.35e6},  {"17m", 18.068e6, 18.168e6},
+    {"15m", 21.0e6, 21.45e6},    {"12m", 24.89e6, 24.99e6}, {"10m", 28.0e6, 29.7e6},
+    {"6m", 50e6, 54e6},          {"4m", 70e6, 70.5e6},      {"2m", 144e6, 148e6},
+};
+
+// Index into bands, or its size outside all of them.
+std::size_t band_index(double hz) noexcept
+{
+    std::size_t i = 0;
+    while (i < std::size(bands) && !(hz >= bands[i].lo && hz < bands[i].hi))
+        ++i;
+    return i;
+}
+
+std::int64_t floor_div(std::int64_t a, std::int64_t b) noexcept
+{
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+// Storage order: time cluster, band, callsign, then time. The spot fields
+// a store keeps follow, so equal keys are one spot.
+auto spot_key(const LogRecord& r, std::int64_t cluster_ns) noexcept
+{
+    return std::make_tuple(floor_div(r.time_unix_ns, cluster_ns), band_index(r.freq_hz), r.callsign_view(),
+                           r.time_unix_ns, r.freq_hz, r.grid_view(), r.snr_db, r.drift_hz, r.dt_s, r.sync,
+                           r.power_dbm, r.mode);
+}
+
+class SectionWriter {
+public:
+    explicit SectionWriter(std::FILE* f) : f_(f) {}
+
+    /// Appends a section at the next aligned offset.
+    SectionRef write(const void* data, std::size_t n)
+    {
+        static const unsigned char zeros[section_alignment] = {};
+        const std::uint64_t at = (offset_ + section_alignment - 1) / section_alignment * section_alignment;
+        ok_ = ok_ && std::fwrite(zeros, 1, at - offset_, f_) == at - offset_;
+        ok_ = ok_ && (n == 0 || std::fwrite(data, 1, n, f_) == n);
+        offset_ = at + n;
+        return {at, n};
+    }
+    template <class T>
+    SectionRef write(const std::vector<T>& v)
+    {
+        return write(v.data(), v.size() * sizeof(T));
+    }
+
+    bool ok() const noexcept { return ok_; }
+
+private:
+    std::FILE* f_;
+    std::uint64_t offset_ = sizeof(StoreHeader);
+    bool ok_ = true;
+};
+
+} // namespace
+
+// ---- build ----------------------------------------------------------------
+
+SpotStoreBuildStats build_spot_store(std::span<const std::string> logs, const std::string& path,
+                                     SpotStoreOptions options)
+{
+    if (options.block_rows == 0 || options.block_rows % 64 != 0 || options.block_rows > UINT32_MAX)
+        throw std::invalid_argument("block_rows must be a positive multiple of 64");
+    if (options.cluster.count() <= 0 || options.cluster.count() > UINT32_MAX)
+        throw std::invalid_argument("cluster must be positive");
+    const std::int64_t cluster_ns = std::chrono::nanoseconds(options.cluster).count();
+
+    SpotStoreBuildStats stats;
+    std::vector<std::unique_ptr<SpotLogReader>> readers;
+    std::vector<const LogRecord*> spots;
+    for (const std::string& log : logs) {
+        readers.push_back(std::make_unique<SpotLogReader>(log));
+        for (const LogRecord& r : readers.back()->records()) {
+            ++stats.records;
+            if (!verify(r))
+                ++stats.invalid;
+            else if (r.kind == LogKind::Spot)
+                spots.push_back(&r);
+        }
+    }
+    stats.logs = logs.size();
+
+    std::sort(spots.begin(), spots.end(), [cluster_ns](const LogRecord* a, const LogRecord* b) {
+        return spot_key(*a, cluster_ns) < spot_key(*b, cluster_ns);
+    });
+    const auto last = std::unique(spots.begin(), spots.end(), [cluster_ns](const LogRecord* a, const LogRecord* b) {
+        return spot_key(*a, cluster_ns) == spot_key(*b, cluster_ns);
+    });
+    stats.duplicates = static_cast<std::size_t>(spots.end() - last);
+    spots.erase(last, spots.end());
+
+    std::vector<std::string_view> calls, grids;
+    calls.reserve(spots.size());
+    grids.reserve(spots.size());
+    for (const LogRecord* r : spots) {
+        calls.push_back(r->callsign_view());
+        grids.push_back(r->grid_view());
+    }
+    calls = distinct(std::move(calls));
+    grids = distinct(std::move(grids));
+
+    const std::size_t rows = spots.size();
+    std::vector<std::int64_t> time(rows);
+    std::vector<double> freq(rows);
+    std::vector<std::uint32_t> call(rows), grid(rows);
+    std::vector<float> snr(rows), drift(rows), dt(rows), sync(rows);
+    std::vector<std::int16_t> power(rows);
+    std::vector<std::uint8_t> mode(rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+        const LogRecord& r = *spots[i];
+        time[i] = r.time_unix_ns;
+        freq[i] = r.freq_hz;
+        call[i] = index_of(calls, r.callsign_view());
+        grid[i] = index_of(grids, r.grid_view());
+        snr[i] = r.snr_db;
+        drift[i] = r.drift_hz;
+        dt[i] = r.dt_s;
+        sync[i] = r.sync;
+        power[i] = r.power_dbm;
+        mode[i] = r.mode;
+    }
+
+    using Zone = SpotStore::Zone;
+    std::vector<Zone> zones;
+    for (std::size_t b = 0; b < rows; b += options.block_rows) {
+        const std::size_t e = std::min(rows, b + options.block_rows);
+        Zone z{time[b], time[b], freq[b], freq[b], call[b], call[b], snr[b], snr[b]};
+        for (std::size_t i = b; i < e; ++i) {
+            z.min_time_ns = std::min(z.min_time_ns, time[i]);
+            z.max_time_ns = std::max(z.max_time_ns, time[i]);
+            z.min_hz = std::min(z.min_hz, freq[i]);
+            z.max_hz = std::max(z.max_hz, freq[i]);
+            z.min_call = std::min(z.min_call, call[i]);
+            z.max_call = std::max(z.max_call, call[i]);
+            z.min_snr_db = std::min(z.min_snr_db, snr[i]);
+            z.max_snr_db = std::max(z.max_snr_db, snr[i]);
+        }
+        zones.push_back(z);
+    }
+    static_assert(sizeof(Zone) == 48);
+    stats.spots = rows;
+    stats.blocks = zones.size();
+    stats.callsigns = calls.size();
+
+    const std::vector<unsigned char> call_dict = dictionary_bytes(calls);
+    const std::vector<unsigned char> grid_dict = dictionary_bytes(grids);
+
+    const std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f)
+        throw std::runtime_error("cannot write '" + tmp + "'");
+    StoreHeader h{};
+    h.magic = store_magic;
+    h.version = store_version;
+    h.block_rows = static_cast<std::uint32_t>(options.block_rows);
+    h.rows = rows;
+    h.blocks = static_cast<std::uint32_t>(zones.size());
+    h.callsigns = static_cast<std::uint32_t>(calls.size());
+    h.grids = static_cast<std::uint32_t>(grids.size());
+    h.cluster_s = static_cast<std::uint32_t>(options.cluster.count());
+    // Header last, once the section table is known.
+    bool ok = std::fwrite(&h, sizeof h, 1, f) == 1;
+    SectionWriter w(f);
+    h.sections[TimeColumn] = w.write(time);
+    h.sections[FreqColumn] = w.write(freq);
+    h.sections[CallColumn] = w.write(call);
+    h.sections[GridColumn] = w.write(grid);
+    h.sections[SnrColumn] = w.write(snr);
+    h.sections[DriftColumn] = w.write(drift);
+    h.sections[DtColumn] = w.write(dt);
+    h.sections[SyncColumn] = w.write(sync);
+    h.sections[PowerColumn] = w.write(power);
+    h.sections[ModeColumn] = w.write(mode);
+    h.sections[Zones] = w.write(zones);
+    h.sections[Calls] = w.write(call_dict);
+    h.sections[Grids] = w.write(grid_dict);
+
+    Fnv1a sum;
+    sum.bytes(&h, offsetof(StoreHeader, checksum));
+    sum.bytes(zones.data(), zones.size() * sizeof(Zone)).bytes(call_dict.data(), call_dict.size());
+    sum.bytes(grid_dict.data(), grid_dict.size());
+    h.checksum = sum.value();
+
+    ok = ok && w.ok() && std::fseek(f, 0, SEEK_SET) == 0 && std::fwrite(&h, sizeof h, 1, f) == 1;
+    ok = std::fflush(f) == 0 && ok && ::fsync(::fileno(f)) == 0;
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("cannot write spot store '" + path + "'");
+    }
+    return stats;
+}
+
+// ---- bands ----------------------------------------------------------------
+
+bool set_band(SpotQuery& query, std::string_view band)
+{
+    for (const Band& b : bands) {
+        if (band == b.name) {
+            query.min_hz = b.lo;
+            query.max_hz = b.hi;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ---- store ----------------------------------------------------------------
+
+SpotStore::SpotStore(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("cannot open spot store '" + path + "'");
+    struct stat st {};
+    void* base = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(StoreHeader))
+        base = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+        throw std::runtime_error("'" + path + "' is not a spot store");
+    base_ = static_cast<const unsigned char*>(base);
+    length_ = static_cast<std::size_t>(st.st_size);
+
+    StoreHeader h;
+    std::memcpy(&h, base_, sizeof h);
+    auto fits = [&](Section s, std::uint64_t size) {
+        const SectionRef& r = h.sections[s];
+        return r.offset % section_alignment == 0 && r.offset <= length_ && r.size <= length_ - r.offset
+               && (size == UINT64_MAX ? r.size >= sizeof(std::uint32_t) : r.size == size);
+    };
+    const std::uint64_t rows = h.rows;
+    bool ok = h.magic == store_magic && h.version == store_version && h.block_rows != 0 && h.block_rows % 64 == 0
+              && h.cluster_s != 0 && rows <= length_ && h.blocks == (rows + h.block_rows - 1) / h.block_rows;
+    ok = ok && fits(TimeColumn, rows * 8) && fits(FreqColumn, rows * 8) && fits(CallColumn, rows * 4)
+         && fits(GridColumn, rows * 4) && fits(SnrColumn, rows * 4) && fits(DriftColumn, rows * 4)
+         && fits(DtColumn, rows * 4) && fits(SyncColumn, rows * 4) && fits(PowerColumn, rows * 2)
+         && fits(ModeColumn, rows) && fits(Zones, std::uint64_t{h.blocks} * sizeof(Zone)) && fits(Calls, UINT64_MAX)
+         && fits(Grids, UINT64_MAX) && h.checksum == metadata_checksum(h, base_);
+
+    auto dictionary = [&](Section s, std::uint32_t count, Dictionary& d) {
+        const SectionRef& r = h.sections[s];
+        const std::uint64_t table = (std::uint64_t{count} + 1) * sizeof(std::uint32_t);
+        if (r.size < table)
+            return false;
+        d.offsets = reinterpret_cast<const std::uint32_t*>(base_ + r.offset);
+        d.text = reinterpret_cast<const char*>(base_ + r.offset + table);
+        d.count = count;
+        if (d.offsets[0] != 0 || d.offsets[count] != r.size - table)
+            return false;
+        for (std::uint32_t i = 0; i < count; ++i)
+            if (d.offsets[i] > d.offsets[i + 1])
+                return false;
+        return true;
+    };
+    ok = ok && dictionary(Calls, h.callsigns, calls_) && dictionary(Grids, h.grids, grids_);
+    auto ids = [&](Section s) { return reinterpret_cast<const std::uint32_t*>(base_ + h.sections[s].offset); };
+    ok = ok && ids_below(ids(CallColumn), static_cast<std::size_t>(rows), h.callsigns)
+         && ids_below(ids(GridColumn), static_cast<std::size_t>(rows), h.grids);
+    if (!ok) {
+        ::munmap(base, length_);
+        throw std::runtime_error("'" + path + "' is not a version " + std::to_string(store_version)
+                                 + " spot store, or it is damaged");
+    }
+
+    rows_ = static_cast<std::size_t>(rows);
+    block_rows_ = h.block_rows;
+    cluster_ns_ = std::int64_t{h.cluster_s} * 1'000'000'000;
+    auto column = [&](Section s) { return base_ + h.sections[s].offset; };
+    time_ = reinterpret_cast<const std::int64_t*>(column(TimeColumn));
+    freq_ = reinterpret_cast<const double*>(column(FreqColumn));
+    call_ = reinterpret_cast<const std::uint32_t*>(column(CallColumn));
+    grid_ = reinterpret_cast<const std::uint32_t*>(column(GridColumn));
+    snr_ = reinterpret_cast<const float*>(column(SnrColumn));
+    drift_ = reinterpret_cast<const float*>(column(DriftColumn));
+    dt_ = reinterpret_cast<const float*>(column(DtColumn));
+    sync_ = reinterpret_cast<const float*>(column(SyncColumn));
+    power_ = reinterpret_cast<const std::int16_t*>(column(PowerColumn));
+    mode_ = column(ModeColumn);
+    zones_ = {reinterpret_cast<const Zone*>(column(Zones)), h.blocks};
+}
+
+SpotStore::~SpotStore()
+{
+    ::munmap(const_cast<unsigned char*>(base_), length_);
+}
+
+std::uint32_t SpotStore::Dictionary::find(std::string_view s) const noexcept
+{
+    std::uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+        const std::uint32_t mid = lo + (hi - lo) / 2;
+        if (at(mid) < s)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < count && at(lo) == s ? lo : count;
+}
+
+LogRecord SpotStore::record(std::size_t row) const noexcept
+{
+    LogRecord r{};
+    r.time_unix_ns = time_[row];
+    r.sequence = row;
+    r.kind = LogKind::Spot;
+    r.power_dbm = power_[row];
+    r.mode = mode_[row];
+    r.freq_hz = freq_[row];
+    r.snr_db = snr_[row];
+    r.drift_hz = drift_[row];
+    r.dt_s = dt_[row];
+    r.sync = sync_[row];
+    copy_text(r.callsign, callsign(row));
+    copy_text(r.grid, grid(row));
+    seal(r);
+    return r;
+}
+
+// A query with its unset fields widened to everything.
+struct SpotStore::Filter {
+    std::int64_t from_ns = std::numeric_limits<std::int64_t>::min();
+    std::int64_t to_ns = std::numeric_limits<std::int64_t>::max();
+    double min_hz = -std::numeric_limits<double>::infinity();
+    double max_hz = std::numeric_limits<double>::infinity();
+    float min_snr_db = -std::numeric_limits<float>::infinity();
+    bool by_call = false;
+    std::uint32_t call = 0;
+    const detail::ScanKernels* kernels = nullptr;
+    mutable std::vector<std::uint64_t> mask;
+};
+
+std::vector<std::size_t> SpotStore::query(const SpotQuery& query, SpotQueryStats* stats, Isa isa) const
+{
+    Filter f;
+    if (query.from)
+        f.from_ns = query.from->time_since_epoch().count();
+    if (query.to)
+        f.to_ns = query.to->time_since_epoch().count();
+    if (query.min_hz)
+        f.min_hz = *query.min_hz;
+    if (query.max_hz)
+        f.max_hz = *query.max_hz;
+    if (query.min_snr_db)
+        f.min_snr_db = static_cast<float>(*query.min_snr_db);
+    f.kernels = &detail::scan_kernels(isa_supported(isa) ? isa : Isa::Scalar);
+    f.mask.resize(block_rows_ / 64);
+
+    SpotQueryStats local;
+    SpotQueryStats& st = stats ? *stats : local;
+    st = {};
+    std::vector<std::size_t> out;
+    if (!query.callsign.empty()) {
+        f.by_call = true;
+        f.call = calls_.find(upper(query.callsign));
+        if (f.call == calls_.count)
+            return out;  // never heard
+    }
+
+    if (f.from_ns >= f.to_ns)
+        return out;
+
+    // Rows are in cluster order, so the blocks of the clusters [from, to)
+    // touches are contiguous.
+    const std::int64_t first_cluster = floor_div(f.from_ns, cluster_ns_);
+    const std::int64_t last_cluster = floor_div(f.to_ns - 1, cluster_ns_);
+    const auto first = std::partition_point(zones_.begin(), zones_.end(), [&](const Zone& z) {
+        return floor_div(z.max_time_ns, cluster_ns_) < first_cluster;
+    });
+    const auto last = std::partition_point(first, zones_.end(), [&](const Zone& z) {
+        return floor_div(z.min_time_ns, cluster_ns_) <= last_cluster;
+    });
+    for (auto it = first; it != last; ++it)
+        scan(static_cast<std::size_t>(it - zones_.begin()), f, out, st);
+    st.matched = out.size();
+    // Clusters are in time order; within one, rows go by band and
+    // callsign first. Sorting copies of the keys keeps the comparisons
+    // off the mapping.
+    std::vector<std::pair<std::int64_t, std::size_t>> keyed;
+    for (auto run = out.begin(); run != out.end();) {
+        const std::int64_t cluster = floor_div(time_[*run], cluster_ns_);
+        keyed.clear();
+        auto end = run;
+        for (; end != out.end() && floor_div(time_[*end], cluster_ns_) == cluster; ++end)
+            keyed.emplace_back(time_[*end], *end);
+        std::sort(keyed.begin(), keyed.end());
+        for (const auto& [t, row] : keyed)
+            *run++ = row;
+    }
+    return out;
+}
+
+void SpotStore::scan(std::size_t block, const Filter& f, std::vector<std::size_t>& out, SpotQueryStats& stats) const
+{
+    const Zone& z = zones_[block];
+    ++stats.blocks;
+    if (z.max_time_ns < f.from_ns || z.min_time_ns >= f.to_ns || z.max_hz < f.min_hz || z.min_hz >= f.max_hz
+        || z.max_snr_db < f.min_snr_db
+        || (f.by_call && (f.call < z.min_call || f.call > z.max_call))) {
+        ++stats.pruned;
+        return;
+    }
+
+    const std::size_t begin = block * block_rows_;
+    const std::size_t n = std::min(block_rows_, rows_ - begin);
+    // Only columns whose zone map leaves the outcome open are tested.
+    const bool test_call = f.by_call && (z.min_call != f.call || z.max_call != f.call);
+    const bool test_time = z.min_time_ns < f.from_ns || z.max_time_ns >= f.to_ns;
+    const bool test_hz = z.min_hz < f.min_hz || z.max_hz >= f.max_hz;
+    const bool test_snr = z.min_snr_db < f.min_snr_db;
+    if (!test_call && !test_time && !test_hz && !test_snr) {
+        for (std::size_t i = 0; i < n; ++i)
+            out.push_back(begin + i);
+        return;
+    }
+
+    stats.scanned += n;
+    std::uint64_t* mask = f.mask.data();
+    const std::size_t words = (n + 63) / 64;
+    std::fill(mask, mask + words, ~std::uint64_t{0});
+    auto any = [&] { return std::any_of(mask, mask + words, [](std::uint64_t m) { return m != 0; }); };
+    // Most selective first; stop once nothing is left.
+    if (test_call)
+        f.kernels->equal_u32(call_ + begin, n, f.call, mask);
+    if (test_time && any())
+        f.kernels->range_i64(time_ + begin, n, f.from_ns, f.to_ns, mask);
+    if (test_hz && any())
+        f.kernels->range_f64(freq_ + begin, n, f.min_hz, f.max_hz, mask);
+    if (test_snr && any())
+        f.kernels->range_f32(snr_ + begin, n, f.min_snr_db, std::numeric_limits<float>::infinity(), mask);
+
+    for (std::size_t w = 0; w < words; ++w) {
+        for (std::uint64_t m = mask[w]; m; m &= m - 1)
+            out.push_back(begin + w * 64 + static_cast<std::size_t>(__builtin_ctzll(m)));
+    }
+}
+
+} // namespace mprp
@@ -0,0 +1,435 @@
+#include "mprp/spot_upload.hpp"
+
+#include "mprp/metrics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+namespace mprp {
+
+namespace {
+
+constexpr std::string_view boundary = "mprp-spots-7d1f2a9c";
+
+/// Outcome of one request; status is the HTTP status when one was read.
+struct Exchange {
+    bool ok = false;         ///< A whole response was read.
+    bool stale = false;      ///< A reused connection died before any reply.
+    int status = 0;
+};
+
+bool iequals_prefix(std::string_view line, std::string_view name) noexcept
+{
+    if (line.size() < name.size())
+        return false;
+    for (std::size_t i = 0; i < name.size(); ++i)
+        if (std::tolower(static_cast<unsigned char>(line[i])) != name[i])
+            return false;
+    return true;
+}
+
+std::string_view header_value(std::string_view line, std::size_t name_size) noexcept
+{
+    line.remove_prefix(name_size);
+    while (!line.empty() && (line.front() == ' ' || line.front() == '\t'))
+        line.remove_prefix(1);
+    return line;
+}
+
+// Kept-alive HTTP/1.1 connection with non-blocking, timed I/O on the
+// uploader's event loop.
+class Connection {
+public:
+    Connection(EventLoop& loop, const SpotUploadOptions& options, std::atomic<std::uint64_t>& opened)
+        : loop_(loop), options_(options), opened_(opened)
+    {
+    }
+    ~Connection() { close(); }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    /// request must stay alive until the exchange completes.
+    Task<Exchange> exchange(const std::string& request)
+    {
+        const bool reused = fd_ >= 0;
+        if (!reused) {
+            const bool connected = co_await connect();
+            if (!connected)
+                co_return Exchange{};
+        }
+        Exchange x;
+        const bool sent = co_await write_all(loop_, fd_, request, options_.timeout);
+        if (!sent) {
+            x.stale = reused;
+            close();
+            co_return x;
+        }
+        x = co_await read_response(reused);
+        if (!x.ok)
+            close();
+        co_return x;
+    }
+
+    void close() noexcept
+    {
+        if (fd_ >= 0)
+            ::close(fd_);
+        fd_ = -1;
+        in_.clear();
+    }
+
+private:
+    Task<bool> connect()
+    {
+        fd_ = co_await tcp_connect(loop_, options_.host, options_.port, options_.timeout);
+        if (fd_ >= 0)
+            opened_.fetch_add(1, std::memory_order_relaxed);
+        co_return fd_ >= 0;
+    }
+
+    /// Appends more input; false on EOF, error or timeout.
+    Task<bool> fill()
+    {
+        const std::ptrdiff_t n = co_await read_some(loop_, fd_, buf_, options_.timeout);
+        if (n <= 0)
+            co_return false;
+        in_.append(buf_.data(), static_cast<std::size_t>(n));
+        co_return true;
+    }
+
+    /// Consumes one CRLF-terminated line from the input.
+    Task<bool> line(std::string& out)
+    {
+        std::size_t end;
+        while ((end = in_.find("\r\n")) == std::string::npos) {
+            const bool more = co_await fill();
+            if (!more)
+                co_return false;
+        }
+        out.assign(in_, 0, end);
+        in_.erase(0, end + 2);
+        co_return true;
+    }
+
+    Task<bool> skip(std::size_t n)
+    {
+        while (in_.size() < n) {
+            const bool more = co_await fill();
+            if (!more)
+                co_return false;
+        }
+        in_.erase(0, n);
+        co_return true;
+    }
+
+    Task<Exchange> read_response(bool reused)
+    {
+        Exchange x;
+        std::string l;
+        bool got = co_await line(l);
+        if (!got) {
+            x.stale = reused && in_.empty();
+            co_return x;
+        }
+        // "HTTP/1.1 200 OK"
+        if (l.size() < 12 || l.compare(0, 5, "HTTP/") != 0)
+            co_return x;
+        x.status = std::atoi(l.c_str() + 9);
+
+        long long length = -1;
+        bool chunked = false;
+        bool keep_alive = l.compare(0, 8, "HTTP/1.1") == 0;
+        for (;;) {
+            got = co_await line(l);
+            if (!got)
+                co_return x;
+            if (l.empty())
+                break;
+            if (iequals_prefix(l, "content-length:"))
+                length = std::atoll(std::string(header_value(l, 15)).c_str());
+            else if (iequals_prefix(l, "transfer-encoding:"))
+                chunked = header_value(l, 18).find("chunked") != std::string_view::npos;
+            else if (iequals_prefix(l, "connection:"))
+                keep_alive = iequals_prefix(header_value(l, 11), "keep-alive");
+        }
+
+        // The body is not needed, only consumed so the connection can be reused.
+        if (chunked) {
+            for (;;) {
+                got = co_await line(l);
+                if (!got)
+                    co_return x;
+                const std::size_t size = std::strtoull(l.c_str(), nullptr, 16);
+                if (size == 0) {
+                    // Trailer lines up to the blank one.
+                    do
+                        got = co_await line(l);
+                    while (got && !l.empty());
+                    break;
+                }
+                got = co_await skip(size + 2);
+                if (!got)
+                    co_return x;
+            }
+        } else if (length >= 0) {
+            got = co_await skip(static_cast<std::size_t>(length));
+            if (!got)
+                co_return x;
+        } else {
+            for (;;) {
+                got = co_await fill();
+                if (!got)
+                    break;
+                in_.clear();
+            }
+            keep_alive = false;
+        }
+        x.ok = true;
+        if (!keep_alive)
+            close();
+        co_return x;
+    }
+
+    EventLoop& loop_;
+    const SpotUploadOptions& options_;
+    std::atomic<std::uint64_t>& opened_;
+    int fd_ = -1;
+    std::string in_;
+    std::array<char, 4096> buf_;
+};
+
+// One line of wsprd's spot file, the format WSPRnet's bulk upload takes:
+// date time sync snr dt freq(MHz) "call grid power" drift cycles jitter.
+void append_spot_line(std::string& out, const LogRecord& r)
+{
+    const std::time_t t = static_cast<std::time_t>(r.time_unix_ns / 1'000'000'000);
+    std::tm utc{};
+    gmtime_r(&t, &utc);
+    char message[40];
+    std::snprintf(message, sizeof message, "%.*s %.*s %d", static_cast<int>(r.callsign_view().size()),
+                  r.callsign_view().data(), static_cast<int>(r.grid_view().size()), r.grid_view().data(),
+                  r.power_dbm);
+    char buf[160];
+    const int n = std::snprintf(buf, sizeof buf, "%02d%02d%02d %02d%02d %3d %3.0f %5.2f %11.7f  %-22s %2.0f %5u %4d\n",
+                                utc.tm_year % 100, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min,
+                                static_cast<int>(10.0f * r.sync), static_cast<double>(r.snr_db),
+                                static_cast<double>(r.dt_s), r.freq_hz / 1e6, message,
+                                static_cast<double>(r.drift_hz), 0u, 0);
+    if (n > 0)
+        out.append(buf, std::min(static_cast<std::size_t>(n), sizeof buf - 1));
+}
+
+void append_field(std::string& body, std::string_view name, std::string_view value)
+{
+    body.append("--").append(boundary).append("\r\n");
+    body.append("Content-Disposition: form-data; name=\"").append(name).append("\"\r\n\r\n");
+    body.append(value).append("\r\n");
+}
+
+/// POST of one batch as multipart/form-data: call, grid and the spot file
+/// in the "allmept" field.
+std::string build_request(const SpotUploadOptions& options, std::span<const LogRecord> batch)
+{
+    std::string spots;
+    spots.reserve(batch.size() * 80);
+    for (const LogRecord& r : batch)
+        append_spot_line(spots, r);
+
+    std::string body;
+    body.reserve(spots.size() + 512);
+    append_field(body, "call", options.reporter_call);
+    append_field(body, "grid", options.reporter_grid);
+    body.append("--").append(boundary).append("\r\n");
+    body.append("Content-Disposition: form-data; name=\"allmept\"; filename=\"wspr_spots.txt\"\r\n");
+    body.append("Content-Type: text/plain\r\n\r\n");
+    body.append(spots).append("\r\n");
+    body.append("--").append(boundary).append("--\r\n");
+
+    std::string request;
+    request.reserve(body.size() + 256);
+    request.append("POST ").append(options.path).append(" HTTP/1.1\r\n");
+    request.append("Host: ").append(options.host).append("\r\n");
+    request.append("User-Agent: libmprp\r\n");
+    request.append("Connection: keep-alive\r\n");
+    request.append("Content-Type: multipart/form-data; boundary=").append(boundary).append("\r\n");
+    request.append("Content-Length: ").append(std::to_string(body.size())).append("\r\n\r\n");
+    request.append(body);
+    return request;
+}
+
+/// Statuses worth retrying: no response at all, timeouts, throttling and
+/// server errors. Other 4xx mean the batch itself was refused.
+bool transient(int status) noexcept
+{
+    return status == 0 || status == 408 || status == 429 || status >= 500;
+}
+
+} // namespace
+
+SpotUploader::SpotUploader(SpotUploadOptions options)
+    : options_(std::move(options)),
+      loop_(options_.loop ? *options_.loop : control_loop()),
+      wake_(loop_)
+{
+    if (options_.reporter_call.empty() || options_.reporter_grid.empty())
+        throw std::invalid_argument("spot upload needs the reporter's call and grid");
+    options_.batch_spots = std::max<std::size_t>(options_.batch_spots, 1);
+    options_.max_attempts = std::max(options_.max_attempts, 1u);
+    spawn(loop_, run());
+}
+
+SpotUploader::~SpotUploader()
+{
+    std::unique_lock lock(mutex_);
+    stopping_ = true;
+    wake_.set();
+    idle_.wait(lock, [this] { return done_; });
+}
+
+bool SpotUploader::submit(const LogRecord& spot)
+{
+    if (spot.kind != LogKind::Spot)
+        return true;
+    bool wake = false;
+    {
+        std::lock_guard lock(mutex_);
+        if (queue_.size() >= options_.max_queued) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (queue_.empty())
+            oldest_ = std::chrono::steady_clock::now();
+        queue_.push_back(spot);
+        wake = queue_.size() == 1 || queue_.size() == options_.batch_spots;
+    }
+    if (wake)
+        wake_.set();
+    return true;
+}
+
+void SpotUploader::submit(std::span<const LogRecord> spots)
+{
+    for (const LogRecord& r : spots)
+        submit(r);
+}
+
+bool SpotUploader::flush(std::chrono::milliseconds timeout)
+{
+    std::unique_lock lock(mutex_);
+    flushing_ = true;
+    wake_.set();
+    const bool done = idle_.wait_for(lock, timeout, [this] { return queue_.empty() && !busy_; });
+    flushing_ = false;
+    return done;
+}
+
+Task<void> SpotUploader::run()
+{
+    const auto post_timer = metrics::stage("upload.post");
+    const auto sent_counter = metrics::counter("upload.sent");
+    const auto failed_counter = metrics::counter("upload.failed");
+    const auto retry_counter = metrics::counter("upload.retries");
+
+    Connection connection(loop_, options_, connections_);
+    std::minstd_rand jitter(static_cast<unsigned>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    std::vector<LogRecord> batch;
+    batch.reserve(options_.batch_spots);
+
+    // The lock is only held between awaits: every resumption is on the
+    // loop thread, which is the one that locked it.
+    std::unique_lock lock(mutex_);
+    for (;;) {
+        idle_.notify_all();
+        if (queue_.empty()) {
+            if (stopping_)
+                break;
+            lock.unlock();
+            co_await wake_.wait();
+            lock.lock();
+            continue;
+        }
+        // Let the batch fill, unless it's time to go.
+        const auto due = oldest_ + options_.batch_delay;
+        if (!stopping_ && !flushing_ && queue_.size() < options_.batch_spots
+            && std::chrono::steady_clock::now() < due) {
+            lock.unlock();
+            co_await wake_.wait_until(due);
+            lock.lock();
+            continue;
+        }
+        const std::size_t n = std::min(queue_.size(), options_.batch_spots);
+        batch.assign(queue_.begin(), queue_.begin() + static_cast<std::ptrdiff_t>(n));
+        queue_.erase(queue_.begin(), queue_.begin() + static_cast<std::ptrdiff_t>(n));
+        // Whatever is left has waited long enough already.
+        if (!queue_.empty())
+            oldest_ = std::chrono::steady_clock::now() - options_.batch_delay;
+        busy_ = true;
+        bool last = stopping_;
+        lock.unlock();
+
+        const std::string request = build_request(options_, batch);
+        auto backoff = options_.retry_initial;
+        for (unsigned attempt = 1;; ++attempt) {
+            Exchange x;
+            {
+                metrics::ScopedTimer t(post_timer);
+                x = co_await connection.exchange(request);
+                // The server may have dropped an idle kept-alive connection;
+                // that's not a failure of the batch.
+                if (x.stale)
+                    x = co_await connection.exchange(request);
+            }
+            if (x.ok && x.status >= 200 && x.status < 300) {
+                sent_.fetch_add(n, std::memory_order_relaxed);
+                batches_.fetch_add(1, std::memory_order_relaxed);
+                metrics::add(sent_counter, n);
+                break;
+            }
+            if (!transient(x.ok ? x.status : 0) || attempt >= options_.max_attempts || last) {
+                failed_.fetch_add(n, std::memory_order_relaxed);
+                metrics::add(failed_counter, n);
+                break;
+            }
+            retries_.fetch_add(1, std::memory_order_relaxed);
+            metrics::add(retry_counter);
+            connection.close();
+
+            std::uniform_real_distribution<double> spread(0.75, 1.25);
+            const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(backoff * spread(jitter));
+            backoff = std::min(backoff * 2, options_.retry_max);
+            // Sleep out the backoff, waking early only to stop.
+            const auto until = std::chrono::steady_clock::now() + wait;
+            for (;;) {
+                lock.lock();
+                last = stopping_;
+                lock.unlock();
+                if (last)
+                    break;
+                const bool woken = co_await wake_.wait_until(until);
+                if (!woken)
+                    break;
+            }
+        }
+
+        lock.lock();
+        busy_ = false;
+    }
+    connection.close();
+    done_ = true;
+    idle_.notify_all();
+}
+
+} // namespace mprp
@@ -0,0 +1,15 @@
+#pragma once
+
+// Internal: accelerator sync-search backends, built per configuration.
+
+#include "mprp/sync_search.hpp"
+
+#include <memory>
+
+namespace mprp::detail {
+
+/// The OpenCL backend, or null if this build has no OpenCL support, the
+/// runtime cannot be loaded or it offers no GPU/accelerator device.
+std::unique_ptr<SyncSearchBackend> make_opencl_sync_backend();
+
+} // namespace mprp::detail
@@ -0,0 +1,362 @@
+// OpenCL sync-search backend. The handful of OpenCL 1.2 entry points it
+// needs are resolved from the ICD loader at run time, so neither the
+// headers nor the library are needed to build, and a node without them
+// simply gets the CPU backend.
+
+#include "sync_kernels.hpp"
+
+#include "mprp/metrics.hpp"
+#include "mprp/wspr.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include <dlfcn.h>
+
+namespace mprp::detail {
+
+namespace {
+
+using cl_int = std::int32_t;
+using cl_uint = std::uint32_t;
+using cl_bitfield = std::uint64_t;
+using cl_platform_id = struct _cl_platform_id*;
+using cl_device_id = struct _cl_device_id*;
+using cl_context = struct _cl_context*;
+using cl_command_queue = struct _cl_command_queue*;
+using cl_program = struct _cl_program*;
+using cl_kernel = struct _cl_kernel*;
+using cl_mem = struct _cl_mem*;
+using cl_event = struct _cl_event*;
+
+constexpr cl_int cl_success = 0;
+constexpr cl_bitfield cl_device_type_cpu = 1 << 1;
+constexpr cl_bitfield cl_device_type_gpu = 1 << 2;
+constexpr cl_bitfield cl_device_type_accelerator = 1 << 3;
+constexpr cl_bitfield cl_mem_read_only = 1 << 2;
+constexpr cl_bitfield cl_mem_write_only = 1 << 1;
+constexpr cl_uint cl_true = 1;
+constexpr cl_uint cl_false = 0;
+
+constexpr std::size_t group_size = 64;
+
+struct ClApi {
+    cl_int (*GetPlatformIDs)(cl_uint, cl_platform_id*, cl_uint*);
+    cl_int (*GetDeviceIDs)(cl_platform_id, cl_bitfield, cl_uint, cl_device_id*, cl_uint*);
+    cl_context (*CreateContext)(const std::intptr_t*, cl_uint, const cl_device_id*,
+                                void (*)(const char*, const void*, std::size_t, void*), void*, cl_int*);
+    cl_command_queue (*CreateCommandQueue)(cl_context, cl_device_id, cl_bitfield, cl_int*);
+    cl_program (*CreateProgramWithSource)(cl_context, cl_uint, const char**, const std::size_t*, cl_int*);
+    cl_int (*BuildProgram)(cl_program, cl_uint, const cl_device_id*, const char*, void (*)(cl_program, void*),
+                           void*);
+    cl_kernel (*CreateKernel)(cl_program, const char*, cl_int*);
+    cl_mem (*CreateBuffer)(cl_context, cl_bitfield, std::size_t, void*, cl_int*);
+    cl_int (*ReleaseMemObject)(cl_mem);
+    cl_int (*SetKernelArg)(cl_kernel, cl_uint, std::size_t, const void*);
+    cl_int (*EnqueueWriteBuffer)(cl_command_queue, cl_mem, cl_uint, std::size_t, std::size_t, const void*, cl_uint,
+                                 const cl_event*, cl_event*);
+    cl_int (*EnqueueReadBuffer)(cl_command_queue, cl_mem, cl_uint, std::size_t, std::size_t, void*, cl_uint,
+                                const cl_event*, cl_event*);
+    cl_int (*EnqueueNDRangeKernel)(cl_command_queue, cl_kernel, cl_uint, const std::size_t*, const std::size_t*,
+                                   const std::size_t*, cl_uint, const cl_event*, cl_event*);
+
+    bool load() noexcept
+    {
+        void* lib = ::dlopen("libOpenCL.so.1", RTLD_NOW | RTLD_LOCAL);
+        if (!lib)
+            lib = ::dlopen("libOpenCL.so", RTLD_NOW | RTLD_LOCAL);
+        if (!lib)
+            return false;
+        const auto get = [lib](auto& fn, const char* name) {
+            fn = reinterpret_cast<std::remove_reference_t<decltype(fn)>>(::dlsym(lib, name));
+            return fn != nullptr;
+        };
+        // The loader stays open for the process's life.
+        return get(GetPlatformIDs, "clGetPlatformIDs") && get(GetDeviceIDs, "clGetDeviceIDs")
+               && get(CreateContext, "clCreateContext") && get(CreateCommandQueue, "clCreateCommandQueue")
+               && get(CreateProgramWithSource, "clCreateProgramWithSource") && get(BuildProgram, "clBuildProgram")
+               && get(CreateKernel, "clCreateKernel") && get(CreateBuffer, "clCreateBuffer")
+               && get(ReleaseMemObject, "clReleaseMemObject") && get(SetKernelArg, "clSetKernelArg")
+               && get(EnqueueWriteBuffer, "clEnqueueWriteBuffer") && get(EnqueueReadBuffer, "clEnqueueReadBuffer")
+               && get(EnqueueNDRangeKernel, "clEnqueueNDRangeKernel");
+    }
+};
+
+// One work-group per query: each item scans a strided share of the box,
+// then the group reduces to the first best cell in (drift, bin, lag)
+// order, matching sync_search_cpu().
+constexpr const char* kernel_source = R"CL(
+__kernel void sync_search(__global const float* power, const uint width, const uint steps,
+                          const int lag_origin, __global const short* offsets, const int drift_steps,
+                          __global const uchar* sync_vector, __global const int* queries,
+                          __global int* best_cell, __global float* best_sync,
+                          __local float* sync, __local int* cell)
+{
+    const int q = get_group_id(0);
+    const int lid = get_local_id(0);
+    const int lsize = get_local_size(0);
+    __global const int* r = queries + 6 * q;
+    const int nb = r[1] - r[0] + 1;
+    const int nl = r[3] - r[2] + 1;
+    const int nd = r[5] - r[4] + 1;
+    const int cells = nb * nl * nd;
+
+    float best = -2.0f;
+    int best_at = -1;
+    for (int c = lid; c < cells; c += lsize) {
+        const int lag = r[2] + c % nl;
+        const int bin = r[0] + (c / nl) % nb;
+        const int drift = r[4] + c / (nl * nb);
+        __global const short* off = offsets + (drift + drift_steps) * 162;
+        __global const float* first = power + (lag - lag_origin) * (int)width + bin;
+        float num = 0.0f;
+        float den = 0.0f;
+        for (int i = 0; i < 162; ++i) {
+            __global const float* p = first + i * (int)steps * (int)width + off[i];
+            const float odd = p[2] + p[6];
+            const float even = p[0] + p[4];
+            num += sync_vector[i] ? odd - even : even - odd;
+            den += odd + even;
+        }
+        const float s = den > 0.0f ? num / den : 0.0f;
+        if (s > best) {
+            best = s;
+            best_at = c;
+        }
+    }
+    sync[lid] = best;
+    cell[lid] = best_at;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (int stride = lsize / 2; stride > 0; stride /= 2) {
+        if (lid < stride) {
+            const float s = sync[lid + stride];
+            const int at = cell[lid + stride];
+            if (at >= 0 && (cell[lid] < 0 || s > sync[lid] || (s == sync[lid] && at < cell[lid]))) {
+                sync[lid] = s;
+                cell[lid] = at;
+            }
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+    if (lid == 0) {
+        best_cell[q] = cell[0];
+        best_sync[q] = sync[0];
+    }
+}
+)CL";
+
+/// The process's OpenCL device, context and compiled kernel, shared by
+/// every backend instance (searches are serialised on it).
+class Device {
+public:
+    /// The shared device, initialised on first use; null if there is none.
+    static Device* get()
+    {
+        static Device* device = [] {
+            auto* d = new Device;  // lives for the process; buffers are never worth tearing down
+            if (d->init())
+                return d;
+            delete d;
+            return static_cast<Device*>(nullptr);
+        }();
+        return device;
+    }
+
+    bool run(const SyncTile& tile, std::span<const SyncQuery> queries, std::span<SyncHit> hits)
+    {
+        std::lock_guard lock(mutex_);
+        const std::size_t n = queries.size();
+        words_.resize(6 * n);
+        for (std::size_t q = 0; q < n; ++q) {
+            const SyncQuery& r = queries[q];
+            const std::ptrdiff_t box[6] = {r.bin_lo, r.bin_hi, r.lag_lo, r.lag_hi, r.drift_lo, r.drift_hi};
+            for (std::size_t k = 0; k < 6; ++k)
+                words_[6 * q + k] = static_cast<cl_int>(box[k]);
+        }
+        cells_.resize(n);
+        syncs_.resize(n);
+
+        if (!reserve(power_, tile.power.size_bytes(), cl_mem_read_only)
+            || !reserve(offsets_, tile.offsets.size_bytes(), cl_mem_read_only)
+            || !reserve(queries_, words_.size() * sizeof(cl_int), cl_mem_read_only)
+            || !reserve(cells_mem_, n * sizeof(cl_int), cl_mem_write_only)
+            || !reserve(syncs_mem_, n * sizeof(float), cl_mem_write_only))
+            return false;
+
+        const auto width = static_cast<cl_uint>(tile.width);
+        const auto steps = static_cast<cl_uint>(tile.steps);
+        const auto origin = static_cast<cl_int>(tile.lag_origin);
+        const auto drift_steps = static_cast<cl_int>(tile.drift_steps);
+        bool ok = cl_.EnqueueWriteBuffer(queue_, power_.mem, cl_false, 0, tile.power.size_bytes(), tile.power.data(),
+                                         0, nullptr, nullptr) == cl_success
+                  && cl_.EnqueueWriteBuffer(queue_, offsets_.mem, cl_false, 0, tile.offsets.size_bytes(),
+                                            tile.offsets.data(), 0, nullptr, nullptr) == cl_success
+                  && cl_.EnqueueWriteBuffer(queue_, queries_.mem, cl_false, 0, words_.size() * sizeof(cl_int),
+                                            words_.data(), 0, nullptr, nullptr) == cl_success;
+        ok = ok && cl_.SetKernelArg(kernel_, 0, sizeof(cl_mem), &power_.mem) == cl_success
+             && cl_.SetKernelArg(kernel_, 1, sizeof width, &width) == cl_success
+             && cl_.SetKernelArg(kernel_, 2, sizeof steps, &steps) == cl_success
+             && cl_.SetKernelArg(kernel_, 3, sizeof origin, &origin) == cl_success
+             && cl_.SetKernelArg(kernel_, 4, sizeof(cl_mem), &offsets_.mem) == cl_success
+             && cl_.SetKernelArg(kernel_, 5, sizeof drift_steps, &drift_steps) == cl_success
+             && cl_.SetKernelArg(kernel_, 6, sizeof(cl_mem), &sync_vector_) == cl_success
+             && cl_.SetKernelArg(kernel_, 7, sizeof(cl_mem), &queries_.mem) == cl_success
+             && cl_.SetKernelArg(kernel_, 8, sizeof(cl_mem), &cells_mem_.mem) == cl_success
+             && cl_.SetKernelArg(kernel_, 9, sizeof(cl_mem), &syncs_mem_.mem) == cl_success
+             && cl_.SetKernelArg(kernel_, 10, group_size * sizeof(float), nullptr) == cl_success
+             && cl_.SetKernelArg(kernel_, 11, group_size * sizeof(cl_int), nullptr) == cl_success;
+        const std::size_t global = n * group_size;
+        const std::size_t local = group_size;
+        // The in-order queue runs the writes, the kernel and the reads in
+        // turn; the blocking last read is the only wait.
+        ok = ok
+             && cl_.EnqueueNDRangeKernel(queue_, kernel_, 1, nullptr, &global, &local, 0, nullptr, nullptr)
+                    == cl_success
+             && cl_.EnqueueReadBuffer(queue_, cells_mem_.mem, cl_false, 0, n * sizeof(cl_int), cells_.data(), 0,
+                                      nullptr, nullptr)
+                    == cl_success
+             && cl_.EnqueueReadBuffer(queue_, syncs_mem_.mem, cl_true, 0, n * sizeof(float), syncs_.data(), 0,
+                                      nullptr, nullptr)
+                    == cl_success;
+        if (!ok)
+            return false;
+
+        for (std::size_t q = 0; q < n; ++q) {
+            const SyncQuery& r = queries[q];
+            const cl_int c = cells_[q];
+            if (c < 0) {
+                hits[q] = {0, 0, 0, -1.0};
+                continue;
+            }
+            const std::ptrdiff_t nl = r.lag_hi - r.lag_lo + 1;
+            const std::ptrdiff_t nb = r.bin_hi - r.bin_lo + 1;
+            hits[q] = {r.bin_lo + (c / nl) % nb, r.lag_lo + c % nl, r.drift_lo + c / (nl * nb),
+                       static_cast<double>(syncs_[q])};
+        }
+        return true;
+    }
+
+private:
+    struct Buffer {
+        cl_mem mem = nullptr;
+        std::size_t capacity = 0;
+    };
+
+    bool init()
+    {
+        if (!cl_.load())
+            return false;
+        cl_uint platforms = 0;
+        if (cl_.GetPlatformIDs(0, nullptr, &platforms) != cl_success || platforms == 0)
+            return false;
+        std::vector<cl_platform_id> ids(platforms);
+        if (cl_.GetPlatformIDs(platforms, ids.data(), nullptr) != cl_success)
+            return false;
+        // A GPU or accelerator; OpenCL CPU devices (e.g. POCL) only on
+        // request, since they compete with the SIMD path for the same cores.
+        cl_bitfield types = cl_device_type_gpu | cl_device_type_accelerator;
+        if (std::getenv("MPRP_OPENCL_CPU"))
+            types |= cl_device_type_cpu;
+        cl_device_id device = nullptr;
+        for (cl_platform_id p : ids)
+            if (cl_.GetDeviceIDs(p, types, 1, &device, nullptr) == cl_success && device)
+                break;
+        if (!device)
+            return false;
+
+        cl_int err = 0;
+        context_ = cl_.CreateContext(nullptr, 1, &device, nullptr, nullptr, &err);
+        if (err != cl_success)
+            return false;
+        queue_ = cl_.CreateCommandQueue(context_, device, 0, &err);
+        if (err != cl_success)
+            return false;
+        const char* source = kernel_source;
+        cl_program program = cl_.CreateProgramWithSource(context_, 1, &source, nullptr, &err);
+        if (err != cl_success || cl_.BuildProgram(program, 1, &device, "", nullptr, nullptr) != cl_success)
+            return false;
+        kernel_ = cl_.CreateKernel(program, "sync_search", &err);
+        if (err != cl_success)
+            return false;
+        sync_vector_ = cl_.CreateBuffer(context_, cl_mem_read_only, wspr_sync_vector.size(), nullptr, &err);
+        return err == cl_success
+               && cl_.EnqueueWriteBuffer(queue_, sync_vector_, cl_true, 0, wspr_sync_vector.size(),
+                                         wspr_sync_vector.data(), 0, nullptr, nullptr)
+                      == cl_success;
+    }
+
+    /// Grows a device buffer to hold bytes.
+    bool reserve(Buffer& b, std::size_t bytes, cl_bitfield flags)
+    {
+        if (b.capacity >= bytes && b.mem)
+            return true;
+        if (b.mem)
+            cl_.ReleaseMemObject(b.mem);
+        cl_int err = 0;
+        const std::size_t capacity = std::max<std::size_t>(bytes, 4096) * 2;
+        b.mem = cl_.CreateBuffer(context_, flags, capacity, nullptr, &err);
+        b.capacity = err == cl_success ? capacity : 0;
+        if (err != cl_success)
+            b.mem = nullptr;
+        return b.mem != nullptr;
+    }
+
+    ClApi cl_{};
+    std::mutex mutex_;
+    cl_context context_ = nullptr;
+    cl_command_queue queue_ = nullptr;
+    cl_kernel kernel_ = nullptr;
+    cl_mem sync_vector_ = nullptr;
+    Buffer power_;
+    Buffer offsets_;
+    Buffer queries_;
+    Buffer cells_mem_;
+    Buffer syncs_mem_;
+    std::vector<cl_int> words_;
+    std::vector<cl_int> cells_;
+    std::vector<float> syncs_;
+};
+
+class OpenClSyncBackend final : public SyncSearchBackend {
+public:
+    explicit OpenClSyncBackend(Device& device) noexcept : device_(device) {}
+
+    const char* name() const noexcept override { return failed_ ? "opencl (failed, cpu)" : "opencl"; }
+
+    void search(const SyncTile& tile, std::span<const SyncQuery> queries, std::span<SyncHit> hits) override
+    {
+        static const metrics::CounterId offloaded = metrics::counter("wspr.offload");
+        static const metrics::CounterId fallbacks = metrics::counter("wspr.offload_fallback");
+        if (queries.empty())
+            return;
+        if (!failed_ && device_.run(tile, queries, hits)) {
+            metrics::add(offloaded);
+            return;
+        }
+        // A device that failed once (lost, out of memory) is not retried
+        // in the middle of a slot budget.
+        failed_ = true;
+        metrics::add(fallbacks);
+        sync_search_cpu(tile, queries, hits);
+    }
+
+private:
+    Device& device_;
+    bool failed_ = false;
+};
+
+} // namespace
+
+std::unique_ptr<SyncSearchBackend> make_opencl_sync_backend()
+{
+    Device* device = Device::get();
+    if (!device)
+        return nullptr;
+    return std::make_unique<OpenClSyncBackend>(*device);
+}
+
+} // namespace mprp::detail
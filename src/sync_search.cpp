@@ -0,0 +1,79 @@
+#include "mprp/sync_search.hpp"
+
+#include "mprp/wspr.hpp"
+
+#include "sync_kernels.hpp"
+
+namespace mprp {
+
+namespace {
+
+constexpr std::ptrdiff_t symbols = static_cast<std::ptrdiff_t>(wspr_symbol_count);
+
+class CpuSyncBackend final : public SyncSearchBackend {
+public:
+    const char* name() const noexcept override { return "cpu"; }
+    void search(const SyncTile& tile, std::span<const SyncQuery> queries, std::span<SyncHit> hits) override
+    {
+        sync_search_cpu(tile, queries, hits);
+    }
+};
+
+double sync_at(const SyncTile& tile, std::ptrdiff_t bin, std::ptrdiff_t lag, const std::int16_t* offsets) noexcept
+{
+    const auto steps = static_cast<std::ptrdiff_t>(tile.steps);
+    const float* first = tile.power.data() + (lag - tile.lag_origin) * static_cast<std::ptrdiff_t>(tile.width);
+    double num = 0.0;
+    double den = 0.0;
+    for (std::ptrdiff_t i = 0; i < symbols; ++i) {
+        const float* p = first + i * steps * static_cast<std::ptrdiff_t>(tile.width) + bin + offsets[i];
+        const float odd = p[2] + p[6];  // tones 1 and 3: sync bit set
+        const float even = p[0] + p[4];
+        num += wspr_sync_vector[static_cast<std::size_t>(i)] ? odd - even : even - odd;
+        den += odd + even;
+    }
+    return den > 0.0 ? num / den : 0.0;
+}
+
+} // namespace
+
+const char* to_string(SearchDevice device) noexcept
+{
+    switch (device) {
+    case SearchDevice::Cpu: return "cpu";
+    case SearchDevice::OpenCl: return "opencl";
+    }
+    return "?";
+}
+
+void sync_search_cpu(const SyncTile& tile, std::span<const SyncQuery> queries, std::span<SyncHit> hits) noexcept
+{
+    for (std::size_t q = 0; q < queries.size(); ++q) {
+        const SyncQuery& r = queries[q];
+        SyncHit best{0, 0, 0, -1.0};
+        for (std::ptrdiff_t d = r.drift_lo; d <= r.drift_hi; ++d) {
+            const std::int16_t* off = tile.offsets.data() + (d + tile.drift_steps) * symbols;
+            for (std::ptrdiff_t b = r.bin_lo; b <= r.bin_hi; ++b)
+                for (std::ptrdiff_t lag = r.lag_lo; lag <= r.lag_hi; ++lag) {
+                    const double s = sync_at(tile, b, lag, off);
+                    if (s > best.sync)
+                        best = {b, lag, d, s};
+                }
+        }
+        hits[q] = best;
+    }
+}
+
+std::unique_ptr<SyncSearchBackend> make_sync_backend(SearchDevice device)
+{
+#if MPRP_HAVE_OPENCL
+    if (device == SearchDevice::OpenCl)
+        if (auto backend = detail::make_opencl_sync_backend())
+            return backend;
+#else
+    (void)device;
+#endif
+    return std::make_unique<CpuSyncBackend>();
+}
+
+} // namespace mprp
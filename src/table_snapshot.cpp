@@ -0,0 +1,226 @@
+#include "mprp/table_snapshot.hpp"
+
+#include "mprp/hash.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mprp {
+
+namespace {
+
+constexpr std::uint64_t snapshot_magic = 0x004241545052504dull;  // "MPRPTAB\0"
+constexpr std::uint32_t snapshot_version = 1;
+// Bump whenever a table generator changes its output (or a table's layout),
+// so snapshots written by an older build are regenerated, not trusted.
+constexpr std::uint32_t table_format = 1;
+constexpr std::size_t data_alignment = 64;
+
+struct SnapshotHeader {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t table_format;
+    std::uint32_t tables;
+    std::uint32_t checksum;  ///< Low half of Fnv1a over everything after the header.
+    std::uint64_t bytes;     ///< Whole file.
+    std::uint8_t reserved[32];
+};
+static_assert(sizeof(SnapshotHeader) == 64);
+
+struct IndexEntry {
+    TableKind kind;
+    std::uint32_t reserved;
+    std::uint64_t key;
+    std::uint64_t offset;  ///< From the start of the file.
+    std::uint64_t bytes;
+};
+static_assert(sizeof(IndexEntry) == 32);
+
+using TableId = std::pair<TableKind, std::uint64_t>;
+
+struct State {
+    std::mutex mutex;
+    const unsigned char* base = nullptr;
+    std::size_t length = 0;
+    std::span<const IndexEntry> index;
+    std::map<TableId, std::vector<std::byte>> computed;
+    std::uint64_t notes = 0;        ///< note_table() calls so far.
+    std::uint64_t saved_notes = 0;  ///< notes as of the last successful save.
+    std::size_t hits = 0;
+};
+
+State& state()
+{
+    static State s;
+    return s;
+}
+
+std::uint32_t payload_checksum(const unsigned char* base, std::size_t length) noexcept
+{
+    return static_cast<std::uint32_t>(
+        Fnv1a().bytes(base + sizeof(SnapshotHeader), length - sizeof(SnapshotHeader)).value());
+}
+
+std::span<const std::byte> body(const State& s, const IndexEntry& e) noexcept
+{
+    return {reinterpret_cast<const std::byte*>(s.base + e.offset), static_cast<std::size_t>(e.bytes)};
+}
+
+bool write_all(int fd, const void* data, std::size_t n) noexcept
+{
+    const auto* p = static_cast<const unsigned char*>(data);
+    while (n > 0) {
+        const ssize_t w = ::write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+    return true;
+}
+
+} // namespace
+
+bool load_table_snapshot(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct stat st {};
+    void* base = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(SnapshotHeader))
+        base = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+        return false;
+    const auto* p = static_cast<const unsigned char*>(base);
+    const auto length = static_cast<std::size_t>(st.st_size);
+
+    SnapshotHeader h;
+    std::memcpy(&h, p, sizeof h);
+    bool ok = h.magic == snapshot_magic && h.version == snapshot_version && h.table_format == table_format
+              && h.bytes == length && sizeof h + std::size_t{h.tables} * sizeof(IndexEntry) <= length
+              && h.checksum == payload_checksum(p, length);
+    const std::span<const IndexEntry> index(reinterpret_cast<const IndexEntry*>(p + sizeof h), ok ? h.tables : 0);
+    for (const IndexEntry& e : index)
+        ok = ok && e.offset <= length && e.bytes <= length - e.offset;
+    if (!ok) {
+        ::munmap(base, length);
+        return false;
+    }
+
+    // A replaced mapping is not unmapped: a builder may still be copying
+    // from it.
+    State& s = state();
+    std::lock_guard lock(s.mutex);
+    s.base = p;
+    s.length = length;
+    s.index = index;
+    return true;
+}
+
+bool save_table_snapshot(const std::string& path)
+{
+    State& s = state();
+    std::lock_guard lock(s.mutex);
+
+    // Everything mapped, with tables computed this run taking precedence.
+    std::map<TableId, std::span<const std::byte>> tables;
+    for (const IndexEntry& e : s.index)
+        tables[{e.kind, e.key}] = body(s, e);
+    for (const auto& [id, bytes] : s.computed)
+        tables[id] = bytes;
+
+    std::vector<IndexEntry> index;
+    index.reserve(tables.size());
+    std::uint64_t offset = sizeof(SnapshotHeader) + tables.size() * sizeof(IndexEntry);
+    for (const auto& [id, bytes] : tables) {
+        offset = (offset + data_alignment - 1) / data_alignment * data_alignment;
+        index.push_back({id.first, 0, id.second, offset, bytes.size()});
+        offset += bytes.size();
+    }
+
+    std::vector<unsigned char> file(offset);
+    std::memcpy(file.data() + sizeof(SnapshotHeader), index.data(), index.size() * sizeof(IndexEntry));
+    std::size_t i = 0;
+    for (const auto& [id, bytes] : tables)
+        std::memcpy(file.data() + index[i++].offset, bytes.data(), bytes.size());
+    SnapshotHeader h{};
+    h.magic = snapshot_magic;
+    h.version = snapshot_version;
+    h.table_format = table_format;
+    h.tables = static_cast<std::uint32_t>(index.size());
+    h.bytes = file.size();
+    h.checksum = payload_checksum(file.data(), file.size());
+    std::memcpy(file.data(), &h, sizeof h);
+
+    const std::string tmp = path + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+    const bool ok = write_all(fd, file.data(), file.size()) && ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    // Still kept in computed: the next save writes them again alongside
+    // whatever else is computed by then.
+    s.saved_notes = s.notes;
+    return true;
+}
+
+bool table_snapshot_dirty() noexcept
+{
+    State& s = state();
+    std::lock_guard lock(s.mutex);
+    return s.notes != s.saved_notes;
+}
+
+TableSnapshotStats table_snapshot_stats() noexcept
+{
+    State& s = state();
+    std::lock_guard lock(s.mutex);
+    return {s.index.size(), s.hits, s.computed.size()};
+}
+
+namespace detail {
+
+std::span<const std::byte> snapshot_table(TableKind kind, std::uint64_t key) noexcept
+{
+    State& s = state();
+    std::lock_guard lock(s.mutex);
+    const auto it = std::lower_bound(s.index.begin(), s.index.end(), TableId{kind, key},
+                                     [](const IndexEntry& e, const TableId& id) {
+                                         return TableId{e.kind, e.key} < id;
+                                     });
+    if (it == s.index.end() || it->kind != kind || it->key != key)
+        return {};
+    ++s.hits;
+    return body(s, *it);
+}
+
+void note_table(TableKind kind, std::uint64_t key, std::span<const std::byte> bytes)
+{
+    State& s = state();
+    std::lock_guard lock(s.mutex);
+    s.computed[{kind, key}].assign(bytes.begin(), bytes.end());
+    ++s.notes;
+}
+
+} // namespace detail
+
+} // namespace mprp
@@ -0,0 +1,209 @@
+#include "mprp/task_pool.hpp"
+
+#include "mprp/metrics.hpp"
+#include "mprp/rx_pipeline.hpp"
+
+#include <algorithm>
+
+namespace mprp {
+
+namespace {
+
+// Which pool and deque the current thread works for (-1: not a worker).
+thread_local const TaskPool* current_pool = nullptr;
+thread_local std::ptrdiff_t current_index = -1;
+
+std::ptrdiff_t self_index(const TaskPool* pool) noexcept
+{
+    return current_pool == pool ? current_index : -1;
+}
+
+} // namespace
+
+TaskPool::TaskPool(std::size_t threads, bool pin)
+{
+    const std::size_t hw = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    const std::size_t n = threads == 0 ? hw : std::min(threads, hw);
+    queues_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        queues_.push_back(std::make_unique<Queue>());
+    threads_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        threads_.emplace_back(&TaskPool::worker_loop, this, i, pin);
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard lock(sleep_mutex_);
+        stopping_.store(true, std::memory_order_relaxed);
+    }
+    wake_.notify_all();
+    for (auto& t : threads_)
+        t.join();
+}
+
+void TaskPool::push(Task task)
+{
+    const std::ptrdiff_t self = self_index(this);
+    Queue& q = self >= 0 ? *queues_[static_cast<std::size_t>(self)] : injected_;
+    {
+        std::lock_guard lock(q.mutex);
+        q.tasks.push_back(std::move(task));
+    }
+    // seq_cst on both sides: a worker going to sleep must see this task,
+    // or this push must see the sleeper.
+    queued_.fetch_add(1);
+    if (sleeping_.load() > 0) {
+        std::lock_guard lock(sleep_mutex_);
+        wake_.notify_one();
+    }
+}
+
+bool TaskPool::pop_local(std::size_t self, Task& out)
+{
+    Queue& q = *queues_[self];
+    std::lock_guard lock(q.mutex);
+    if (q.tasks.empty())
+        return false;
+    out = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+bool TaskPool::steal(std::ptrdiff_t self, Task& out)
+{
+    const std::size_t n = queues_.size();
+    const std::size_t first = self >= 0 ? static_cast<std::size_t>(self) + 1 : 0;
+    for (std::size_t k = 0; k < n; ++k) {
+        const std::size_t victim = (first + k) % n;
+        if (static_cast<std::ptrdiff_t>(victim) == self)
+            continue;
+        Queue& q = *queues_[victim];
+        std::unique_lock lock(q.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || q.tasks.empty())
+            continue;
+        out = std::move(q.tasks.front());  // oldest: usually the biggest chunk
+        q.tasks.pop_front();
+        steals_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    std::lock_guard lock(injected_.mutex);
+    if (injected_.tasks.empty())
+        return false;
+    out = std::move(injected_.tasks.front());
+    injected_.tasks.pop_front();
+    return true;
+}
+
+void TaskPool::run(Task& task) noexcept
+{
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    std::exception_ptr error;
+    try {
+        task.fn();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    task.group->finish(error);
+}
+
+bool TaskPool::try_run_one(std::ptrdiff_t self)
+{
+    Task task;
+    if ((self >= 0 && pop_local(static_cast<std::size_t>(self), task)) || steal(self, task)) {
+        run(task);
+        return true;
+    }
+    return false;
+}
+
+void TaskPool::worker_loop(std::size_t index, bool pin)
+{
+    if (pin)
+        pin_current_thread(static_cast<int>(index));
+    current_pool = this;
+    current_index = static_cast<std::ptrdiff_t>(index);
+    const auto tasks = metrics::counter("pool.tasks");
+
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        if (try_run_one(current_index)) {
+            metrics::add(tasks);
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex_);
+        sleeping_.fetch_add(1);
+        wake_.wait(lock, [this] { return stopping_.load(std::memory_order_relaxed) || queued_.load() > 0; });
+        sleeping_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+TaskGroup::~TaskGroup()
+{
+    try {
+        wait();
+    } catch (...) {
+    }
+}
+
+void TaskGroup::run(std::function<void()> fn)
+{
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    pool_.push({std::move(fn), this});
+}
+
+void TaskGroup::finish(std::exception_ptr error) noexcept
+{
+    if (error) {
+        std::lock_guard lock(error_mutex_);
+        if (!error_)
+            error_ = std::move(error);
+    }
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        pending_.notify_all();
+}
+
+void TaskGroup::wait()
+{
+    const std::ptrdiff_t self = self_index(&pool_);
+    for (;;) {
+        const std::uint32_t left = pending_.load(std::memory_order_acquire);
+        if (left == 0)
+            break;
+        // Help rather than block; sleep only when the rest of this group is
+        // already running elsewhere.
+        if (!pool_.try_run_one(self))
+            pending_.wait(left, std::memory_order_acquire);
+    }
+    std::lock_guard lock(error_mutex_);
+    if (error_)
+        std::rethrow_exception(std::exchange(error_, nullptr));
+}
+
+void parallel_for(TaskPool& pool, std::size_t n, std::size_t grain,
+                  const std::function<void(std::size_t, std::size_t)>& body)
+{
+    if (n == 0)
+        return;
+    grain = std::max<std::size_t>(grain, 1);
+    // A few chunks per worker so stealing can even out uneven items.
+    const std::size_t chunks = std::min((n + grain - 1) / grain, pool.workers() * 4);
+    if (chunks <= 1) {
+        body(0, n);
+        return;
+    }
+    const std::size_t step = (n + chunks - 1) / chunks;
+    TaskGroup group(pool);
+    for (std::size_t begin = step; begin < n; begin += step)
+        group.run([&body, begin, end = std::min(n, begin + step)] { body(begin, end); });
+    body(0, std::min(n, step));
+    group.wait();
+}
+
+TaskPool& default_task_pool()
+{
+    static TaskPool pool;
+    return pool;
+}
+
+} // namespace mprp
@@ -0,0 +1,208 @@
+#include "mprp/timing.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <ctime>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <linux/pps.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/timex.h>
+#include <unistd.h>
+
+namespace mprp {
+
+namespace {
+
+using std::chrono::nanoseconds;
+
+std::int64_t realtime_ns() noexcept
+{
+    timespec ts{};
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+std::int64_t monotonic_ns() noexcept
+{
+    timespec ts{};
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+timespec to_timespec(std::int64_t ns) noexcept
+{
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(ns / 1'000'000'000);
+    ts.tv_nsec = static_cast<long>(ns % 1'000'000'000);
+    return ts;
+}
+
+// PPS edges older than this no longer count as a lock.
+constexpr std::int64_t pps_holdover_ns = 3'000'000'000;
+
+} // namespace
+
+const char* to_string(TimeLock lock) noexcept
+{
+    switch (lock) {
+    case TimeLock::Unsynchronised:
+        return "unsynchronised";
+    case TimeLock::Ntp:
+        return "ntp";
+    case TimeLock::Pps:
+        return "pps";
+    }
+    return "?";
+}
+
+TimePoint SystemTime::now() const noexcept
+{
+    return TimePoint(nanoseconds(realtime_ns()));
+}
+
+TimeLock SystemTime::lock() const noexcept
+{
+    timex tx{};
+    const int state = ::adjtimex(&tx);
+    if (state < 0 || state == TIME_ERROR || (tx.status & STA_UNSYNC))
+        return TimeLock::Unsynchronised;
+    return TimeLock::Ntp;
+}
+
+nanoseconds SystemTime::uncertainty() const noexcept
+{
+    timex tx{};
+    if (::adjtimex(&tx) < 0 || (tx.status & STA_UNSYNC))
+        return nanoseconds(-1);
+    return std::chrono::microseconds(tx.esterror);
+}
+
+PpsTime::PpsTime(const std::string& device)
+{
+    fd_ = ::open(device.c_str(), O_RDWR);
+    if (fd_ < 0)
+        fd_ = ::open(device.c_str(), O_RDONLY);
+    if (fd_ < 0)
+        throw std::runtime_error("cannot open PPS device " + device);
+
+    int caps = 0;
+    if (::ioctl(fd_, PPS_GETCAP, &caps) < 0 || !(caps & PPS_CAPTUREASSERT)) {
+        ::close(fd_);
+        throw std::runtime_error(device + " is not a PPS device with assert capture");
+    }
+    pps_kparams params{};
+    if (::ioctl(fd_, PPS_GETPARAMS, &params) == 0) {
+        params.mode |= PPS_CAPTUREASSERT;
+        ::ioctl(fd_, PPS_SETPARAMS, &params);  // needs write access; defaults usually suffice
+    }
+    thread_ = std::thread(&PpsTime::fetch_loop, this);
+}
+
+PpsTime::~PpsTime()
+{
+    stopping_.store(true, std::memory_order_relaxed);
+    if (thread_.joinable())
+        thread_.join();
+    ::close(fd_);
+}
+
+void PpsTime::fetch_loop()
+{
+    std::uint32_t last_sequence = 0;
+    bool first = true;
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        pps_fdata data{};
+        data.timeout.sec = 1;
+        data.timeout.nsec = 0;
+        data.timeout.flags = 0;
+        if (::ioctl(fd_, PPS_FETCH, &data) < 0) {
+            if (errno == ETIMEDOUT || errno == EINTR)
+                continue;
+            return;
+        }
+        if (!first && data.info.assert_sequence == last_sequence)
+            continue;
+        first = false;
+        last_sequence = data.info.assert_sequence;
+
+        // The edge marks a whole UTC second; what CLOCK_REALTIME read at that
+        // instant beyond the nearest second is the clock's offset.
+        std::int64_t frac = data.info.assert_tu.nsec;
+        if (frac >= 500'000'000)
+            frac -= 1'000'000'000;
+
+        const std::uint64_t n = edges_.fetch_add(1, std::memory_order_relaxed);
+        const std::int64_t prev = offset_ns_.load(std::memory_order_relaxed);
+        // Track quickly at first, then average out interrupt latency.
+        const std::int64_t shift = n < 4 ? 0 : 3;
+        const std::int64_t next = n == 0 ? frac : prev + ((frac - prev) >> shift);
+        const std::int64_t dev = std::llabs(frac - next);
+        const std::int64_t jitter = jitter_ns_.load(std::memory_order_relaxed);
+        jitter_ns_.store(jitter < 0 ? dev : jitter + ((dev - jitter) >> 3), std::memory_order_relaxed);
+        offset_ns_.store(next, std::memory_order_relaxed);
+        last_edge_ns_.store(monotonic_ns(), std::memory_order_relaxed);
+    }
+}
+
+TimePoint PpsTime::now() const noexcept
+{
+    return TimePoint(nanoseconds(realtime_ns() - offset_ns_.load(std::memory_order_relaxed)));
+}
+
+nanoseconds PpsTime::correction() const noexcept
+{
+    return nanoseconds(-offset_ns_.load(std::memory_order_relaxed));
+}
+
+TimeLock PpsTime::lock() const noexcept
+{
+    const std::int64_t last = last_edge_ns_.load(std::memory_order_relaxed);
+    if (edges() > 0 && monotonic_ns() - last < pps_holdover_ns)
+        return TimeLock::Pps;
+    return system_.lock();
+}
+
+nanoseconds PpsTime::uncertainty() const noexcept
+{
+    if (lock() != TimeLock::Pps)
+        return system_.uncertainty();
+    return nanoseconds(jitter_ns_.load(std::memory_order_relaxed));
+}
+
+nanoseconds wait_until(const TimeSource& time, TimePoint target, nanoseconds spin) noexcept
+{
+    // Coarse part: an absolute sleep on CLOCK_REALTIME, so a clock step by
+    // the NTP daemon moves the wake-up with it.
+    const std::int64_t wake = (target.time_since_epoch() - time.correction() - spin).count();
+    const timespec ts = to_timespec(wake);
+    while (realtime_ns() < wake) {
+        if (::clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &ts, nullptr) != EINTR)
+            break;
+    }
+    // Fine part: spin on the disciplined clock.
+    TimePoint now = time.now();
+    while (now < target)
+        now = time.now();
+    return now - target;
+}
+
+bool set_realtime_priority(int priority) noexcept
+{
+    if (priority <= 0)
+        return true;
+    sched_param param{};
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+bool lock_memory() noexcept
+{
+    return ::mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+}
+
+} // namespace mprp
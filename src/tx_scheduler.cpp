@@ -0,0 +1,347 @@
+#include "mprp/tx_scheduler.hpp"
+
+#include "mprp/metrics.hpp"
+#include "mprp/rx_pipeline.hpp"
+#include "mprp/task_pool.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace mprp {
+
+namespace {
+
+// The interruptible sleep hands over to wait_until() this long before its
+// own coarse wake-up, to absorb condition-variable wake-up slack.
+constexpr auto handover = std::chrono::milliseconds(2);
+
+// A render the scheduler owns when there is no cache.
+class OwnedBuffer final : public RenderedBuffer {
+public:
+    explicit OwnedBuffer(std::vector<float> samples) noexcept : samples_(std::move(samples)) {}
+    std::span<const float> samples() const noexcept override { return samples_; }
+
+private:
+    std::vector<float> samples_;
+};
+
+std::size_t longest_transmission(const Engine& engine)
+{
+    if (engine.entries() == 0)
+        throw std::invalid_argument("TxScheduler: engine has no entries");
+    std::size_t longest = 0;
+    for (std::size_t e = 0; e < engine.entries(); ++e)
+        longest = std::max(longest, engine.transmission_samples(e));
+    return longest;
+}
+
+} // namespace
+
+TxScheduler::TxScheduler(const Engine& engine, const TimeSource& time, TxSchedulerOptions options)
+    : engine_(std::shared_ptr<const Engine>(), &engine), time_(time), options_(std::move(options))
+{
+    const std::size_t longest = longest_transmission(engine);
+    if (!options_.cache && !options_.low_power)
+        for (auto& b : buffers_)
+            b.samples.resize(longest);
+}
+
+TxScheduler::TxScheduler(const LiveEngine& live, const TimeSource& time, TxSchedulerOptions options)
+    : live_(&live), time_(time), options_(std::move(options))
+{
+    adopt();
+    // Later versions may need more; the render thread grows the buffers.
+    const std::size_t longest = longest_transmission(*engine_);
+    if (!options_.cache && !options_.low_power)
+        for (auto& b : buffers_)
+            b.samples.resize(longest);
+}
+
+TxScheduler::~TxScheduler()
+{
+    stop();
+    if (renderer_.joinable())
+        renderer_.join();
+}
+
+void TxScheduler::stop() noexcept
+{
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+}
+
+void TxScheduler::request(std::size_t buffer, const SlotPlan& plan)
+{
+    {
+        std::lock_guard lock(mutex_);
+        buffers_[buffer].plan = plan;
+        buffers_[buffer].engine = engine_;
+        ++buffers_[buffer].ticket;
+        buffers_[buffer].ready = false;
+        buffers_[buffer].queued = true;
+        pending_ = static_cast<std::ptrdiff_t>(buffer);
+    }
+    cv_.notify_all();
+}
+
+bool TxScheduler::want(std::size_t buffer, const SlotPlan& plan)
+{
+    // Only this thread writes plan and engine, so they are read unlocked.
+    Buffer& b = buffers_[buffer];
+    if (!b.engine || b.engine->render_key(b.plan.entry) != engine_->render_key(plan.entry)) {
+        request(buffer, plan);
+        return true;
+    }
+    std::lock_guard lock(mutex_);
+    b.plan = plan;
+    b.engine = engine_;
+    return false;
+}
+
+bool TxScheduler::wait_ready(std::size_t buffer)
+{
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, [&] { return stopping_ || buffers_[buffer].ready; });
+    return !stopping_;
+}
+
+bool TxScheduler::stopping()
+{
+    std::lock_guard lock(mutex_);
+    return stopping_;
+}
+
+bool TxScheduler::sleep_until(TimePoint target)
+{
+    const auto wake = Clock::time_point(std::chrono::duration_cast<Clock::duration>(
+        (target - time_.correction() - options_.spin - handover).time_since_epoch()));
+    std::unique_lock lock(mutex_);
+    cv_.wait_until(lock, wake, [&] { return stopping_; });
+    return !stopping_;
+}
+
+void TxScheduler::render_loop()
+{
+    const auto render_timer = metrics::stage("tx.render");
+    std::unique_lock lock(mutex_);
+    for (;;) {
+        cv_.wait(lock, [&] { return stopping_ || buffers_[0].queued || buffers_[1].queued; });
+        if (stopping_)
+            return;
+        // Both are queued when a re-plan re-requests the current slot after
+        // the next was asked for; the latest request is the more urgent.
+        const std::size_t pick = pending_ >= 0 && buffers_[pending_].queued ? static_cast<std::size_t>(pending_)
+                                                                            : buffers_[0].queued ? 0 : 1;
+        Buffer& b = buffers_[pick];
+        b.queued = false;
+        pending_ = -1;
+        const std::size_t entry = b.plan.entry;
+        const std::uint64_t ticket = b.ticket;
+        const std::shared_ptr<const Engine> engine = b.engine;
+        lock.unlock();
+        std::size_t n = 0;
+        std::shared_ptr<const RenderedBuffer> cached;
+        {
+            metrics::ScopedTimer t(render_timer);
+            if (options_.cache) {
+                cached = render_entry(*engine, entry);
+                n = cached->samples().size();
+            } else {
+                if (b.samples.size() < engine->transmission_samples(entry))
+                    b.samples.resize(engine->transmission_samples(entry));
+                n = engine->render(entry, b.samples);
+            }
+        }
+        lock.lock();
+        // Re-requested while rendering: the pending request renders again.
+        if (b.ticket != ticket)
+            continue;
+        b.cached = std::move(cached);
+        b.size = n;
+        b.ready = true;
+        cv_.notify_all();
+    }
+}
+
+std::shared_ptr<const RenderedBuffer> TxScheduler::render_entry(const Engine& engine, std::size_t entry) const
+{
+    if (options_.cache)
+        return options_.cache->get(engine.render_key(entry), engine.transmission_samples(entry),
+                                   [&](std::span<float> out) { return engine.render(entry, out); });
+    std::vector<float> samples(engine.transmission_samples(entry));
+    samples.resize(engine.render(entry, samples));
+    return std::make_shared<OwnedBuffer>(std::move(samples));
+}
+
+void TxScheduler::prerender(const Engine* previous)
+{
+    const auto burst_timer = metrics::stage("power.burst");
+    metrics::ScopedTimer t(burst_timer);
+    const Engine& engine = *engine_;
+    const auto kept = std::move(prerendered_);
+    prerendered_.assign(engine.entries(), nullptr);
+    std::vector<std::size_t> missing;
+    for (std::size_t e = 0; e < engine.entries(); ++e) {
+        for (std::size_t p = 0; previous && p < previous->entries() && !prerendered_[e]; ++p)
+            if (previous->render_key(p) == engine.render_key(e))
+                prerendered_[e] = kept[p];
+        if (!prerendered_[e])
+            missing.push_back(e);
+    }
+    if (missing.empty())
+        return;
+    // A pool of its own: its workers exist for the burst only.
+    const std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    TaskPool pool(std::min({options_.burst_threads ? options_.burst_threads : cores, cores, missing.size()}));
+    TaskGroup group(pool);
+    for (const std::size_t e : missing)
+        group.run([this, &engine, e] { prerendered_[e] = render_entry(engine, e); });
+    group.wait();
+}
+
+std::shared_ptr<const Engine> TxScheduler::adopt()
+{
+    if (!live_ || live_->version() == version_)
+        return nullptr;
+    const auto latest = live_->current();
+    auto previous = std::exchange(engine_, std::shared_ptr<const Engine>(latest, &latest->engine));
+    version_ = latest->version;
+    return previous;
+}
+
+void TxScheduler::run(const Callback& callback)
+{
+    if (!pin_current_thread(options_.cpu))
+        throw std::runtime_error("TxScheduler: cannot pin to cpu " + std::to_string(options_.cpu));
+    if (options_.lock_memory && !lock_memory())
+        throw std::runtime_error("TxScheduler: mlockall failed");
+    if (!set_realtime_priority(options_.realtime_priority))
+        throw std::runtime_error("TxScheduler: SCHED_FIFO refused (needs CAP_SYS_NICE)");
+
+    const auto late_timer = metrics::stage("tx.start_late");
+    const auto skipped_counter = metrics::counter("tx.skipped");
+    const auto cpu_timer = metrics::stage("power.slot_cpu");
+    const auto cpu_counter = metrics::counter("power.cpu_us");
+    const auto wall_counter = metrics::counter("power.wall_ms");
+    const auto energy_counter = metrics::counter("power.energy_mj");
+    const auto replan_counter = metrics::counter("tx.replanned");
+
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = false;
+        pending_ = -1;
+        for (Buffer& b : buffers_)
+            b.queued = false;
+    }
+    PowerMeter meter(options_.power);
+    const bool burst = options_.low_power;
+    if (burst)
+        prerender(nullptr);
+    else
+        renderer_ = std::thread(&TxScheduler::render_loop, this);
+
+    std::size_t current = 0;
+    SlotPlan plan = engine_->next_slot(time_.now() + options_.lead);
+    if (!burst)
+        request(current, plan);
+    // Both carry over a re-plan, so a slot gets one prepare() and one
+    // power period however often it is re-planned.
+    bool prepared = false;
+    std::optional<PowerSample> power;
+
+    const auto key_lead = options_.key ? options_.key_lead : std::chrono::nanoseconds(0);
+    while (burst ? !stopping() : wait_ready(current)) {
+        if (const auto previous = adopt()) {
+            // A new configuration: this slot (the first one of the new
+            // clock at or after it) comes from the new rotation, and is
+            // rendered again only if its samples changed.
+            metrics::add(replan_counter);
+            const SlotPlan old = plan;
+            plan = engine_->next_slot(old.start);
+            prepared = prepared && plan.index == old.index && plan.start == old.start
+                       && engine_->config().beacons[plan.entry] == previous->config().beacons[old.entry];
+            if (burst)
+                prerender(previous.get());
+            else if (want(current, plan))
+                continue;
+        }
+        if (time_.now() + options_.spin + key_lead > plan.start) {
+            // Render or the previous callback ran into this slot.
+            skipped_.fetch_add(1, std::memory_order_relaxed);
+            metrics::add(skipped_counter);
+            plan = engine_->next_slot(time_.now() + options_.lead);
+            prepared = false;
+            if (!burst)
+                want(current, plan);
+            continue;
+        }
+
+        // After a re-plan the next buffer is only rendered again if the
+        // change reached its samples.
+        const SlotPlan next = engine_->clock().at(plan.index + 1);
+        if (!burst)
+            want(current ^ 1, next);
+        if (!prepared && options_.prepare)
+            options_.prepare(plan, *engine_);
+        prepared = true;
+
+        if (!power) {
+            // The period ends here, off the hand-off path (reading an energy
+            // counter is a file read).
+            power = meter.lap();
+            metrics::record(cpu_timer, static_cast<std::uint64_t>(power->cpu.count()));
+            metrics::add(cpu_counter, static_cast<std::uint64_t>(power->cpu.count() / 1000));
+            metrics::add(wall_counter, static_cast<std::uint64_t>(power->wall.count() / 1'000'000));
+            metrics::add(energy_counter, static_cast<std::uint64_t>(power->energy_j * 1e3 + 0.5));
+        }
+
+        if (live_) {
+            // The last chance for a change to make this slot: lead before
+            // its start, as late as a new render can still be fitted in.
+            // The top of the loop re-plans it.
+            if (!sleep_until(plan.start - options_.lead))
+                break;
+            if (live_->version() != version_)
+                continue;
+        }
+
+        if (options_.key) {
+            const TimePoint key_at = plan.start - key_lead;
+            if (!sleep_until(key_at))
+                break;
+            wait_until(time_, key_at, options_.spin);
+            options_.key(plan);
+        }
+        if (!sleep_until(plan.start))
+            break;
+        const auto late = wait_until(time_, plan.start, options_.spin);
+        metrics::record(late_timer, static_cast<std::uint64_t>(late.count()));
+
+        std::span<const float> samples;
+        if (burst) {
+            samples = prerendered_[plan.entry]->samples();
+        } else {
+            const Buffer& b = buffers_[current];
+            samples = {b.cached ? b.cached->samples().data() : b.samples.data(), b.size};
+        }
+        const TxSlot slot{plan, *engine_, version_, samples, late, time_.lock(), *power};
+        if (!callback(slot))
+            break;
+        current ^= 1;
+        plan = next;
+        prepared = false;
+        power.reset();
+    }
+
+    stop();
+    if (renderer_.joinable())
+        renderer_.join();
+    prerendered_.clear();
+}
+
+} // namespace mprp
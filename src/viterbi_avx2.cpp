@@ -0,0 +1,51 @@
+// AVX2 Viterbi add-compare-select. Built with -mavx2 -mfma and only called
+// after isa_supported(Isa::Avx2) has confirmed the CPU.
+
+#include "viterbi_kernels.hpp"
+
+#include <immintrin.h>
+
+namespace mprp::detail {
+
+void viterbi_step_avx2(const std::int32_t* old_metrics, std::int32_t* new_metrics, std::size_t half,
+                       const std::int32_t* signs, std::int32_t r0, std::int32_t r1,
+                       std::uint8_t* decisions) noexcept
+{
+    const __m256i vr0 = _mm256_set1_epi32(r0);
+    const __m256i vr1 = _mm256_set1_epi32(r1);
+    auto cost = [&](unsigned b, unsigned h, std::size_t j) {
+        const __m256i s0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(viterbi_signs(signs, half, 0, b, h) + j));
+        const __m256i s1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(viterbi_signs(signs, half, 1, b, h) + j));
+        return _mm256_add_epi32(_mm256_sign_epi32(vr0, s0), _mm256_sign_epi32(vr1, s1));
+    };
+
+    for (std::size_t j = 0; j < half; j += 8) {
+        const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(old_metrics + j));
+        const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(old_metrics + j + half));
+
+        const __m256i lo0 = _mm256_add_epi32(lo, cost(0, 0, j));
+        const __m256i hi0 = _mm256_add_epi32(hi, cost(0, 1, j));
+        const __m256i lo1 = _mm256_add_epi32(lo, cost(1, 0, j));
+        const __m256i hi1 = _mm256_add_epi32(hi, cost(1, 1, j));
+        const __m256i m0 = _mm256_min_epi32(lo0, hi0);  // new states 2j + 0
+        const __m256i m1 = _mm256_min_epi32(lo1, hi1);  // new states 2j + 1
+        const __m256i d0 = _mm256_cmpgt_epi32(lo0, hi0);
+        const __m256i d1 = _mm256_cmpgt_epi32(lo1, hi1);
+
+        // Interleave even/odd states back into state order.
+        const __m256i ml = _mm256_unpacklo_epi32(m0, m1);
+        const __m256i mh = _mm256_unpackhi_epi32(m0, m1);
+        const __m256i dl = _mm256_unpacklo_epi32(d0, d1);
+        const __m256i dh = _mm256_unpackhi_epi32(d0, d1);
+        const __m256i ma = _mm256_permute2x128_si256(ml, mh, 0x20);
+        const __m256i mb = _mm256_permute2x128_si256(ml, mh, 0x31);
+        const __m256i da = _mm256_permute2x128_si256(dl, dh, 0x20);
+        const __m256i db = _mm256_permute2x128_si256(dl, dh, 0x31);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(new_metrics + 2 * j), ma);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(new_metrics + 2 * j + 8), mb);
+        decisions[2 * j / 8] = static_cast<std::uint8_t>(_mm256_movemask_ps(_mm256_castsi256_ps(da)));
+        decisions[2 * j / 8 + 1] = static_cast<std::uint8_t>(_mm256_movemask_ps(_mm256_castsi256_ps(db)));
+    }
+}
+
+} // namespace mprp::detail
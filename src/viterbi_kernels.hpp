@@ -0,0 +1,89 @@
+#pragma once
+
+// Private Viterbi add-compare-select kernels.
+//
+// One trellis step over states = 2 * half path metrics. New state 2j + b
+// is reached from old states j and j + half by input bit b; its metric is
+// the smaller of the two candidates, and decision bit 2j + b records
+// whether the upper one (j + half) won. signs holds, per output o, input
+// b and half h, the lane vector s[j] = +1 / -1 for an expected 0 / 1, at
+// signs[((o * 2 + b) * 2 + h) * half + j]; a branch costs s0 * r0 + s1 * r1.
+
+#include "mprp/cpu.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mprp::detail {
+
+using ViterbiStepKernel = void (*)(const std::int32_t* old_metrics, std::int32_t* new_metrics,
+                                   std::size_t half, const std::int32_t* signs, std::int32_t r0,
+                                   std::int32_t r1, std::uint8_t* decisions) noexcept;
+
+inline const std::int32_t* viterbi_signs(const std::int32_t* signs, std::size_t half, unsigned o, unsigned b,
+                                         unsigned h) noexcept
+{
+    return signs + ((o * 2 + b) * 2 + h) * half;
+}
+
+inline void viterbi_step_scalar(const std::int32_t* old_metrics, std::int32_t* new_metrics, std::size_t half,
+                                const std::int32_t* signs, std::int32_t r0, std::int32_t r1,
+                                std::uint8_t* decisions) noexcept
+{
+    for (std::size_t i = 0; i < (2 * half + 7) / 8; ++i)
+        decisions[i] = 0;
+    for (unsigned b = 0; b < 2; ++b) {
+        const std::int32_t* s0lo = viterbi_signs(signs, half, 0, b, 0);
+        const std::int32_t* s1lo = viterbi_signs(signs, half, 1, b, 0);
+        const std::int32_t* s0hi = viterbi_signs(signs, half, 0, b, 1);
+        const std::int32_t* s1hi = viterbi_signs(signs, half, 1, b, 1);
+        for (std::size_t j = 0; j < half; ++j) {
+            const std::int32_t lo = old_metrics[j] + s0lo[j] * r0 + s1lo[j] * r1;
+            const std::int32_t hi = old_metrics[j + half] + s0hi[j] * r0 + s1hi[j] * r1;
+            const std::size_t s = 2 * j + b;
+            const bool upper = hi < lo;
+            new_metrics[s] = upper ? hi : lo;
+            decisions[s / 8] = static_cast<std::uint8_t>(decisions[s / 8] | (upper << (s % 8)));
+        }
+    }
+}
+
+#if defined(MPRP_HAVE_AVX2)
+/// half must be a multiple of 8.
+void viterbi_step_avx2(const std::int32_t* old_metrics, std::int32_t* new_metrics, std::size_t half,
+                       const std::int32_t* signs, std::int32_t r0, std::int32_t r1,
+                       std::uint8_t* decisions) noexcept;
+#endif
+
+#if defined(MPRP_HAVE_NEON)
+/// half must be a multiple of 4.
+void viterbi_step_neon(const std::int32_t* old_metrics, std::int32_t* new_metrics, std::size_t half,
+                       const std::int32_t* signs, std::int32_t r0, std::int32_t r1,
+                       std::uint8_t* decisions) noexcept;
+#endif
+
+/// The kernel for isa, falling back to scalar when half is too small for
+/// the vector width.
+inline ViterbiStepKernel viterbi_step_kernel(Isa isa, std::size_t half) noexcept
+{
+    switch (isa) {
+#if defined(MPRP_HAVE_AVX2)
+    case Isa::Avx2:
+        if (half % 8 == 0)
+            return &viterbi_step_avx2;
+        break;
+#endif
+#if defined(MPRP_HAVE_NEON)
+    case Isa::Neon:
+        if (half % 4 == 0)
+            return &viterbi_step_neon;
+        break;
+#endif
+    default:
+        break;
+    }
+    (void)half;
+    return &viterbi_step_scalar;
+}
+
+} // namespace mprp::detail
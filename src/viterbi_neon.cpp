@@ -0,0 +1,51 @@
+// NEON Viterbi add-compare-select. Only called after
+// isa_supported(Isa::Neon) has confirmed the CPU.
+
+#include "viterbi_kernels.hpp"
+
+#include <arm_neon.h>
+
+namespace mprp::detail {
+
+namespace {
+
+// Decision bits of four state-ordered lanes (all-ones = upper survivor).
+std::uint8_t lane_bits(uint32x4_t d) noexcept
+{
+    return static_cast<std::uint8_t>((vgetq_lane_u32(d, 0) & 1u) | (vgetq_lane_u32(d, 1) & 2u)
+                                     | (vgetq_lane_u32(d, 2) & 4u) | (vgetq_lane_u32(d, 3) & 8u));
+}
+
+} // namespace
+
+void viterbi_step_neon(const std::int32_t* old_metrics, std::int32_t* new_metrics, std::size_t half,
+                       const std::int32_t* signs, std::int32_t r0, std::int32_t r1,
+                       std::uint8_t* decisions) noexcept
+{
+    const int32x4_t vr0 = vdupq_n_s32(r0);
+    const int32x4_t vr1 = vdupq_n_s32(r1);
+    auto cost = [&](unsigned b, unsigned h, std::size_t j) {
+        const int32x4_t s0 = vld1q_s32(viterbi_signs(signs, half, 0, b, h) + j);
+        const int32x4_t s1 = vld1q_s32(viterbi_signs(signs, half, 1, b, h) + j);
+        return vmlaq_s32(vmulq_s32(vr0, s0), vr1, s1);
+    };
+
+    for (std::size_t j = 0; j < half; j += 4) {
+        const int32x4_t lo = vld1q_s32(old_metrics + j);
+        const int32x4_t hi = vld1q_s32(old_metrics + j + half);
+
+        const int32x4_t lo0 = vaddq_s32(lo, cost(0, 0, j));
+        const int32x4_t hi0 = vaddq_s32(hi, cost(0, 1, j));
+        const int32x4_t lo1 = vaddq_s32(lo, cost(1, 0, j));
+        const int32x4_t hi1 = vaddq_s32(hi, cost(1, 1, j));
+        const int32x4x2_t m = vzipq_s32(vminq_s32(lo0, hi0), vminq_s32(lo1, hi1));
+        const uint32x4x2_t d = vzipq_u32(vcgtq_s32(lo0, hi0), vcgtq_s32(lo1, hi1));
+        vst1q_s32(new_metrics + 2 * j, m.val[0]);
+        vst1q_s32(new_metrics + 2 * j + 4, m.val[1]);
+
+        // New states 2j .. 2j + 7 fill one decision byte.
+        decisions[2 * j / 8] = static_cast<std::uint8_t>(lane_bits(d.val[0]) | (lane_bits(d.val[1]) << 4));
+    }
+}
+
+} // namespace mprp::detail
@@ -0,0 +1,282 @@
+#include "mprp/wspr.hpp"
+
+#include "mprp/arena.hpp"
+#include "mprp/task_pool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace mprp {
+
+const std::array<std::uint8_t, wspr_symbol_count> wspr_sync_vector = {
+    1, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1, 0, 1, 1, 1, 1, 0, 0, 0, 0,
+    0, 0, 0, 1, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1, 1, 0,
+    1, 0, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0, 1,
+    0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0,
+    0, 1, 1, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 0, 1, 1, 0,
+    0, 0, 1, 1, 0, 0, 0,
+};
+
+namespace {
+
+constexpr std::uint32_t poly0 = wspr_code.polys[0];
+constexpr std::uint32_t poly1 = wspr_code.polys[1];
+
+/// Source bits including the 31-bit zero tail that flushes the encoder.
+constexpr std::size_t coded_bits = 81;
+
+// Position of the i-th coded bit after interleaving (8-bit bit reversal,
+// skipping indices >= 162).
+constexpr std::array<std::uint8_t, wspr_symbol_count> make_interleave()
+{
+    std::array<std::uint8_t, wspr_symbol_count> perm{};
+    std::size_t p = 0;
+    for (unsigned i = 0; i < 256 && p < wspr_symbol_count; ++i) {
+        unsigned j = 0;
+        for (unsigned b = 0; b < 8; ++b)
+            j |= ((i >> b) & 1u) << (7 - b);
+        if (j < wspr_symbol_count)
+            perm[p++] = static_cast<std::uint8_t>(j);
+    }
+    return perm;
+}
+
+constexpr auto interleave = make_interleave();
+
+// 0-9 -> 0-9, A-Z -> 10-35, space -> 36; -1 otherwise.
+constexpr int char_value(char c) noexcept
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 10;
+    if (c == ' ')
+        return 36;
+    return -1;
+}
+
+bool pack_callsign(std::string_view call, std::uint32_t& n) noexcept
+{
+    if (call.empty() || call.size() > 6)
+        return false;
+    // Align so the call area digit lands in position 2.
+    char c[6] = {' ', ' ', ' ', ' ', ' ', ' '};
+    const bool shift = call.size() >= 2 && char_value(call[1]) >= 0 && char_value(call[1]) < 10
+                       && (call.size() < 3 || char_value(call[2]) >= 10);
+    if (shift && call.size() > 5)
+        return false;
+    std::copy(call.begin(), call.end(), c + (shift ? 1 : 0));
+
+    const int v0 = char_value(c[0]);
+    const int v1 = char_value(c[1]);
+    const int v2 = char_value(c[2]);
+    if (v0 < 0 || v1 < 0 || v1 == 36 || v2 < 0 || v2 > 9)
+        return false;
+    std::uint32_t acc = static_cast<std::uint32_t>(v0);
+    acc = acc * 36 + static_cast<std::uint32_t>(v1);
+    acc = acc * 10 + static_cast<std::uint32_t>(v2);
+    for (int i = 3; i < 6; ++i) {
+        const int v = char_value(c[i]);
+        if (v < 10)  // suffix is letters or trailing spaces only
+            return false;
+        acc = acc * 27 + static_cast<std::uint32_t>(v - 10);
+    }
+    n = acc;
+    return true;
+}
+
+bool pack_grid(std::string_view grid, int power, std::uint32_t& m) noexcept
+{
+    if (grid.size() != 4)
+        return false;
+    const int g0 = char_value(grid[0]) - 10;
+    const int g1 = char_value(grid[1]) - 10;
+    const int g2 = char_value(grid[2]);
+    const int g3 = char_value(grid[3]);
+    if (g0 < 0 || g0 > 17 || g1 < 0 || g1 > 17 || g2 < 0 || g2 > 9 || g3 < 0 || g3 > 9)
+        return false;
+    const auto m1 = static_cast<std::uint32_t>((179 - 10 * g0 - g2) * 180 + 10 * g1 + g3);
+    m = m1 * 128 + static_cast<std::uint32_t>(power + 64);
+    return true;
+}
+
+bool valid_power(int dbm) noexcept
+{
+    const int last = dbm % 10;
+    return dbm >= 0 && dbm <= 60 && (last == 0 || last == 3 || last == 7);
+}
+
+constexpr char value_char(unsigned v) noexcept
+{
+    return v < 10 ? static_cast<char>('0' + v) : v < 36 ? static_cast<char>('A' + v - 10) : ' ';
+}
+
+std::string trimmed(const char* c, std::size_t n)
+{
+    std::string_view v(c, n);
+    v.remove_prefix(std::min(v.find_first_not_of(' '), v.size()));
+    v.remove_suffix(v.size() - (v.find_last_not_of(' ') + 1));
+    return std::string(v);
+}
+
+} // namespace
+
+const char* to_string(WsprStatus status) noexcept
+{
+    switch (status) {
+    case WsprStatus::Ok: return "ok";
+    case WsprStatus::BadCallsign: return "bad callsign";
+    case WsprStatus::BadGrid: return "bad grid";
+    case WsprStatus::BadPower: return "bad power";
+    }
+    return "?";
+}
+
+WsprStatus wspr_pack(const WsprMessage& message, std::array<std::uint8_t, 11>& packed) noexcept
+{
+    std::uint32_t n = 0;
+    std::uint32_t m = 0;
+    if (!pack_callsign(message.callsign, n))
+        return WsprStatus::BadCallsign;
+    if (!valid_power(message.power_dbm))
+        return WsprStatus::BadPower;
+    if (!pack_grid(message.grid, message.power_dbm, m))
+        return WsprStatus::BadGrid;
+
+    packed.fill(0);
+    packed[0] = static_cast<std::uint8_t>(n >> 20);
+    packed[1] = static_cast<std::uint8_t>(n >> 12);
+    packed[2] = static_cast<std::uint8_t>(n >> 4);
+    packed[3] = static_cast<std::uint8_t>(((n & 0x0f) << 4) | ((m >> 18) & 0x0f));
+    packed[4] = static_cast<std::uint8_t>(m >> 10);
+    packed[5] = static_cast<std::uint8_t>(m >> 2);
+    packed[6] = static_cast<std::uint8_t>((m & 0x03) << 6);
+    return WsprStatus::Ok;
+}
+
+WsprStatus wspr_encode(const WsprMessage& message,
+                       std::span<std::uint8_t, wspr_symbol_count> out) noexcept
+{
+    std::array<std::uint8_t, 11> packed;
+    if (const auto st = wspr_pack(message, packed); st != WsprStatus::Ok)
+        return st;
+
+    std::uint32_t reg = 0;
+    for (std::size_t i = 0; i < coded_bits; ++i) {
+        const unsigned bit = (packed[i / 8] >> (7 - i % 8)) & 1u;
+        reg = (reg << 1) | bit;
+        const auto s0 = static_cast<std::uint8_t>(std::popcount(reg & poly0) & 1);
+        const auto s1 = static_cast<std::uint8_t>(std::popcount(reg & poly1) & 1);
+        const std::size_t p0 = interleave[2 * i];
+        const std::size_t p1 = interleave[2 * i + 1];
+        out[p0] = static_cast<std::uint8_t>(wspr_sync_vector[p0] + 2 * s0);
+        out[p1] = static_cast<std::uint8_t>(wspr_sync_vector[p1] + 2 * s1);
+    }
+    return WsprStatus::Ok;
+}
+
+std::size_t wspr_encode_batch(std::span<const WsprMessage> messages, std::span<WsprSymbols> out,
+                              std::span<WsprStatus> status) noexcept
+{
+    const std::size_t n = std::min(messages.size(), out.size());
+    std::size_t ok = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto st = wspr_encode(messages[i], out[i]);
+        if (i < status.size())
+            status[i] = st;
+        ok += st == WsprStatus::Ok;
+    }
+    return ok;
+}
+
+std::optional<WsprReport> wspr_unpack(const std::array<std::uint8_t, 11>& packed)
+{
+    std::uint32_t n = (std::uint32_t{packed[0]} << 20) | (std::uint32_t{packed[1]} << 12)
+                      | (std::uint32_t{packed[2]} << 4) | (packed[3] >> 4);
+    const std::uint32_t m = (std::uint32_t{packed[3] & 0x0fu} << 18) | (std::uint32_t{packed[4]} << 10)
+                            | (std::uint32_t{packed[5]} << 2) | (packed[6] >> 6);
+
+    char c[6];
+    for (int i = 5; i >= 3; --i) {
+        c[i] = value_char(n % 27 + 10);
+        n /= 27;
+    }
+    c[2] = value_char(n % 10);
+    n /= 10;
+    c[1] = value_char(n % 36);
+    n /= 36;
+    if (n > 36)
+        return std::nullopt;
+    c[0] = value_char(n);
+
+    const int power = static_cast<int>(m & 0x7f) - 64;
+    const std::uint32_t m1 = m >> 7;
+    const std::uint32_t q = m1 / 180;
+    const std::uint32_t r = m1 % 180;
+    if (q > 179 || r / 10 > 17 || !valid_power(power))
+        return std::nullopt;
+    const char grid[4] = {static_cast<char>('A' + (179 - q) / 10), static_cast<char>('A' + r / 10),
+                          value_char((179 - q) % 10), value_char(r % 10)};
+    if (grid[0] > 'R')
+        return std::nullopt;
+
+    WsprReport report;
+    report.callsign = trimmed(c, 6);
+    report.grid.assign(grid, 4);
+    report.power_dbm = power;
+    return report;
+}
+
+void wspr_soft_symbols(const WsprTonePowers& powers, WsprSoftSymbols& soft) noexcept
+{
+    std::array<float, wspr_symbol_count> diff;
+    double energy = 0.0;
+    for (std::size_t i = 0; i < wspr_symbol_count; ++i) {
+        const auto& p = powers[i];
+        const unsigned sync = wspr_sync_vector[i];
+        diff[i] = p[sync + 2] - p[sync];
+        energy += static_cast<double>(diff[i]) * diff[i];
+    }
+    const double rms = std::sqrt(energy / wspr_symbol_count);
+    const float scale = rms > 0.0 ? static_cast<float>(50.0 / rms) : 0.0f;
+    for (std::size_t i = 0; i < wspr_symbol_count; ++i)
+        soft[i] = static_cast<std::int8_t>(std::clamp(std::lround(diff[i] * scale), -127L, 127L));
+}
+
+std::optional<WsprReport> wspr_decode(const WsprSoftSymbols& soft, FanoDecoder& fano, DecodeResult* info)
+{
+    std::array<std::int8_t, wspr_symbol_count> coded;
+    for (std::size_t i = 0; i < wspr_symbol_count; ++i)
+        coded[i] = soft[interleave[i]];
+
+    std::array<std::uint8_t, coded_bits> bits;
+    const DecodeResult result = fano.decode(coded, bits);
+    if (info)
+        *info = result;
+    if (result.status != DecodeStatus::Ok)
+        return std::nullopt;
+
+    std::array<std::uint8_t, 11> packed{};
+    for (std::size_t i = 0; i < 50; ++i)
+        packed[i / 8] = static_cast<std::uint8_t>(packed[i / 8] | (bits[i] << (7 - i % 8)));
+    return wspr_unpack(packed);
+}
+
+std::size_t wspr_decode_batch(TaskPool& pool, std::span<const WsprSoftSymbols> candidates,
+                              std::span<std::optional<WsprReport>> out, FanoOptions options, Arena* arena)
+{
+    const std::size_t n = std::min(candidates.size(), out.size());
+    std::pmr::memory_resource* resource = arena ? arena : std::pmr::get_default_resource();
+    parallel_for(pool, n, 1, [&](std::size_t begin, std::size_t end) {
+        FanoDecoder fano(wspr_code, options, resource);
+        for (std::size_t i = begin; i < end; ++i)
+            out[i] = wspr_decode(candidates[i], fano);
+    });
+    return static_cast<std::size_t>(
+        std::count_if(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(n), [](const auto& r) { return r.has_value(); }));
+}
+
+} // namespace mprp
@@ -0,0 +1,441 @@
+#include "mprp/wspr_search.hpp"
+
+#include "mprp/metrics.hpp"
+#include "mprp/task_pool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+namespace mprp {
+
+namespace {
+
+constexpr double slot_seconds = 120.0;
+constexpr double nominal_start_s = 1.0;  // transmissions start one second into the slot
+constexpr std::ptrdiff_t symbols = static_cast<std::ptrdiff_t>(wspr_symbol_count);
+
+// Bin offset of symbol i for a drift of drift_hz over the transmission
+// (zero at mid-transmission).
+std::ptrdiff_t drift_offset(double drift_hz, std::ptrdiff_t i, double bin_hz) noexcept
+{
+    return std::lround(drift_hz * (static_cast<double>(i) - 80.5) / 161.0 / bin_hz);
+}
+
+double snr_2500(double comb, double noise) noexcept
+{
+    // A tone's bin collects its whole power; noise per bin spans the
+    // symbol-matched bandwidth (one tone spacing).
+    const double ratio = noise > 0.0 ? (comb - 4.0 * noise) / noise : 0.0;
+    return 10.0 * std::log10(std::max(ratio, 1e-4)) + 10.0 * std::log10(wspr_tone_spacing_hz / 2500.0);
+}
+
+} // namespace
+
+WsprSearch::WsprSearch(WsprSearchConfig config, std::pmr::memory_resource* resource)
+    : config_(std::move(config)),
+      carry_(resource ? resource : &default_pool_resource()),
+      work_(carry_.get_allocator()),
+      ring_(carry_.get_allocator()),
+      candidates_(carry_.get_allocator()),
+      seeds_(carry_.get_allocator())
+{
+    const double symbol = config_.sample_rate / wspr_baud;
+    symbol_ = static_cast<std::size_t>(std::lround(symbol));
+    if (std::abs(symbol - static_cast<double>(symbol_)) > 1e-6 || !std::has_single_bit(symbol_) || symbol_ < 16)
+        throw std::invalid_argument("WsprSearch: sample rate must be 375 Hz times a power of two");
+    if (config_.steps_per_symbol == 0 || symbol_ % config_.steps_per_symbol != 0)
+        throw std::invalid_argument("WsprSearch: steps_per_symbol must divide the symbol length");
+    if (!(config_.max_hz > config_.min_hz) || !(config_.max_lag_s >= config_.min_lag_s) || config_.max_candidates == 0)
+        throw std::invalid_argument("WsprSearch: empty search range");
+
+    nfft_ = 2 * symbol_;
+    hop_ = symbol_ / config_.steps_per_symbol;
+    bin_hz_ = config_.sample_rate / static_cast<double>(nfft_);
+    plan_ = fft_plan(nfft_);
+
+    // Store the band plus room for the top tone and the drift at either end.
+    const double margin = std::ceil(config_.max_drift_hz / 2.0 / bin_hz_) + 1.0;
+    const double centre = static_cast<double>(nfft_ / 2);
+    const double lo = std::floor((config_.min_hz - 1.5 * wspr_tone_spacing_hz) / bin_hz_ + centre - margin);
+    const double hi = std::ceil((config_.max_hz + 1.5 * wspr_tone_spacing_hz) / bin_hz_ + centre + margin);
+    band_lo_ = static_cast<std::ptrdiff_t>(std::clamp(lo, 0.0, static_cast<double>(nfft_ - 1)));
+    const auto band_hi = static_cast<std::ptrdiff_t>(std::clamp(hi, 0.0, static_cast<double>(nfft_ - 1)));
+    width_ = static_cast<std::size_t>(band_hi - band_lo_ + 1);
+    if (width_ < 8 + 2 * static_cast<std::size_t>(margin))
+        throw std::invalid_argument("WsprSearch: band too narrow for the drift range");
+
+    const double cols_per_second = config_.sample_rate / static_cast<double>(hop_);
+    lag_lo_ = static_cast<std::ptrdiff_t>(std::floor(config_.min_lag_s * cols_per_second));
+    lag_hi_ = static_cast<std::ptrdiff_t>(std::ceil(config_.max_lag_s * cols_per_second));
+    drift_steps_ = config_.drift_step_hz > 0.0
+                       ? static_cast<std::ptrdiff_t>(std::floor(config_.max_drift_hz / config_.drift_step_hz))
+                       : 0;
+    const auto steps = static_cast<std::ptrdiff_t>(config_.steps_per_symbol);
+    ring_columns_ = static_cast<std::size_t>(lag_hi_ - lag_lo_ + (symbols - 1) * steps + 1 + 2 * steps);
+
+    carry_.resize(symbol_);
+    work_.resize(nfft_);
+    ring_.resize(ring_columns_ * width_);
+    backend_ = make_sync_backend(config_.device);
+    candidates_.reserve(config_.max_candidates);
+    seeds_.reserve(config_.max_candidates);
+}
+
+std::size_t WsprSearch::push(std::span<const Complex> samples)
+{
+    // Same carry/fresh split as SpectrumMonitor: a column takes the tail of
+    // the carried samples, then samples straight from the caller's block.
+    const std::uint64_t begin = consumed_;
+    const std::uint64_t end = begin + samples.size();
+    const std::uint64_t carry_begin = begin - carry_size_;
+    std::size_t produced = 0;
+
+    for (std::uint64_t next = columns_ * hop_; next + symbol_ <= end; next = columns_ * hop_) {
+        std::span<const Complex> carry;
+        std::span<const Complex> fresh;
+        if (next < begin) {
+            carry = std::span<const Complex>(carry_.data() + (next - carry_begin), static_cast<std::size_t>(begin - next));
+            fresh = samples.first(symbol_ - carry.size());
+        } else {
+            fresh = samples.subspan(static_cast<std::size_t>(next - begin), symbol_);
+        }
+        transform_column(carry, fresh);
+        ++produced;
+    }
+
+    const std::uint64_t keep_from = std::max<std::uint64_t>(columns_ * hop_, carry_begin);
+    std::size_t kept = 0;
+    if (keep_from < end) {
+        kept = static_cast<std::size_t>(end - keep_from);
+        if (keep_from < begin) {
+            const std::size_t old = static_cast<std::size_t>(begin - keep_from);
+            std::copy_n(carry_.begin() + static_cast<std::ptrdiff_t>(keep_from - carry_begin), old, carry_.begin());
+            std::copy(samples.begin(), samples.end(), carry_.begin() + static_cast<std::ptrdiff_t>(old));
+        } else {
+            std::copy(samples.end() - static_cast<std::ptrdiff_t>(kept), samples.end(), carry_.begin());
+        }
+    }
+    carry_size_ = kept;
+    consumed_ = end;
+    return produced;
+}
+
+void WsprSearch::transform_column(std::span<const Complex> carry, std::span<const Complex> fresh)
+{
+    // Rectangular window one symbol long (the matched filter for a
+    // constant tone), zero-padded to two symbols for half-spacing bins.
+    auto out = std::copy(carry.begin(), carry.end(), work_.begin());
+    out = std::copy(fresh.begin(), fresh.end(), out);
+    std::fill(out, work_.end(), Complex{});
+    plan_->forward(work_);
+
+    float* row = ring_.data() + (columns_ % ring_columns_) * width_;
+    for (std::size_t b = 0; b < width_; ++b) {
+        const std::size_t k = (static_cast<std::size_t>(band_lo_) + b + nfft_ / 2) % nfft_;
+        row[b] = std::norm(work_[k]);
+    }
+    ++columns_;
+}
+
+const float* WsprSearch::column(std::uint64_t index) const noexcept
+{
+    return ring_.data() + (index % ring_columns_) * width_;
+}
+
+std::uint64_t WsprSearch::first_column(std::uint64_t window_start) const noexcept
+{
+    return (window_start + hop_ - 1) / hop_;
+}
+
+bool WsprSearch::ready(std::uint64_t window_start) const noexcept
+{
+    const auto c0 = static_cast<std::int64_t>(first_column(window_start));
+    const std::int64_t first = c0 + lag_lo_;
+    const std::int64_t last = c0 + lag_hi_ + (symbols - 1) * static_cast<std::int64_t>(config_.steps_per_symbol);
+    const auto have = static_cast<std::int64_t>(columns_);
+    return first >= 0 && first + static_cast<std::int64_t>(ring_columns_) >= have && last < have;
+}
+
+WsprCandidate WsprSearch::candidate_at(std::uint64_t window_start, std::uint64_t col0, const SyncHit& hit,
+                                       std::span<const float> comb, double noise) const noexcept
+{
+    WsprCandidate c;
+    const double tone0 = static_cast<double>(band_lo_ + hit.bin) - static_cast<double>(nfft_ / 2);
+    c.freq_hz = tone0 * bin_hz_ + 1.5 * wspr_tone_spacing_hz;
+    c.drift_hz = static_cast<double>(hit.drift) * config_.drift_step_hz;
+    c.lag_s = (static_cast<double>(static_cast<std::int64_t>((col0 * hop_)) + hit.lag * static_cast<std::ptrdiff_t>(hop_))
+               - static_cast<double>(window_start))
+              / config_.sample_rate;
+    c.sync = hit.sync;
+    c.snr_db = snr_2500(comb[static_cast<std::size_t>(hit.bin)], noise);
+    return c;
+}
+
+std::span<const WsprCandidate> WsprSearch::search(std::uint64_t window_start, Arena& arena)
+{
+    const std::uint64_t col0 = first_column(window_start);
+    const auto steps = static_cast<std::ptrdiff_t>(config_.steps_per_symbol);
+    const bool full = force_full_ || seeds_.empty() || !last_window_ || config_.full_search_every <= 1
+                      || since_full_ + 1 >= config_.full_search_every;
+
+    // Mean power per bin over the window: noise floor and peak picking.
+    const std::uint64_t first = col0 + static_cast<std::uint64_t>(lag_lo_);
+    const std::uint64_t last = col0 + static_cast<std::uint64_t>(lag_hi_ + (symbols - 1) * steps);
+    auto avg = arena.make_span<float>(width_);
+    for (std::uint64_t c = first; c <= last; ++c) {
+        const float* row = column(c);
+        for (std::size_t b = 0; b < width_; ++b)
+            avg[b] += row[b];
+    }
+    const auto count = static_cast<float>(last - first + 1);
+    for (float& v : avg)
+        v /= count;
+    auto sorted = arena.make_span<float>(width_);
+    std::copy(avg.begin(), avg.end(), sorted.begin());
+    const auto pct = sorted.begin() + static_cast<std::ptrdiff_t>(width_ * 3 / 10);
+    std::nth_element(sorted.begin(), pct, sorted.end());
+    const double noise = *pct;
+
+    // Energy of the four-tone group starting at each bin.
+    auto comb = arena.make_span<float>(width_);
+    for (std::size_t b = 0; b + 6 < width_; ++b)
+        comb[b] = avg[b] + avg[b + 2] + avg[b + 4] + avg[b + 6];
+
+    auto offsets = arena.make_span<std::int16_t>(static_cast<std::size_t>((2 * drift_steps_ + 1) * symbols));
+    std::ptrdiff_t margin = 0;
+    for (std::ptrdiff_t d = -drift_steps_; d <= drift_steps_; ++d)
+        for (std::ptrdiff_t i = 0; i < symbols; ++i) {
+            const std::ptrdiff_t o = drift_offset(static_cast<double>(d) * config_.drift_step_hz, i, bin_hz_);
+            offsets[static_cast<std::size_t>((d + drift_steps_) * symbols + i)] = static_cast<std::int16_t>(o);
+            margin = std::max(margin, std::abs(o));
+        }
+    const std::ptrdiff_t bin_min = margin;
+    const std::ptrdiff_t bin_max = static_cast<std::ptrdiff_t>(width_) - 7 - margin;
+
+    // The window's columns, unwrapped from the ring, for the backends.
+    auto power = arena.make_span<float>(static_cast<std::size_t>(last - first + 1) * width_);
+    for (std::uint64_t c = first; c <= last; ++c)
+        std::copy_n(column(c), width_, power.begin() + static_cast<std::ptrdiff_t>((c - first) * width_));
+    const SyncTile tile{power, width_, config_.steps_per_symbol, lag_lo_, offsets, drift_steps_};
+
+    auto hits = arena.make_span<SyncHit>(config_.max_candidates);
+    std::size_t found = 0;
+    if (full) {
+        // Local maxima of the tone-group energy above the SNR floor,
+        // strongest first.
+        auto peaks = arena.make_span<std::ptrdiff_t>(width_);
+        std::size_t n = 0;
+        for (std::ptrdiff_t b = bin_min; b <= bin_max; ++b) {
+            const float v = comb[static_cast<std::size_t>(b)];
+            bool peak = snr_2500(v, noise) >= config_.min_snr_db;
+            for (std::ptrdiff_t k = std::max(bin_min, b - 3); peak && k <= std::min(bin_max, b + 3); ++k)
+                peak = k == b || comb[static_cast<std::size_t>(k)] < v || (comb[static_cast<std::size_t>(k)] == v && k > b);
+            if (peak)
+                peaks[n++] = b;
+        }
+        std::sort(peaks.begin(), peaks.begin() + static_cast<std::ptrdiff_t>(n), [&](std::ptrdiff_t a, std::ptrdiff_t b) {
+            return comb[static_cast<std::size_t>(a)] > comb[static_cast<std::size_t>(b)];
+        });
+        // One query per peak, batched to the backend as many at a time as
+        // could still be kept, so the CPU does no more work than peak by
+        // peak and a device gets whole batches.
+        auto queries = arena.make_span<SyncQuery>(std::min(n, hits.size()));
+        auto batch = arena.make_span<SyncHit>(queries.size());
+        for (std::size_t p = 0; p < n && found < hits.size();) {
+            const std::size_t take = std::min(n - p, hits.size() - found);
+            for (std::size_t q = 0; q < take; ++q) {
+                const std::ptrdiff_t b = peaks[p + q];
+                queries[q] = {std::max(bin_min, b - 1), std::min(bin_max, b + 1), lag_lo_, lag_hi_, -drift_steps_,
+                              drift_steps_};
+            }
+            backend_->search(tile, queries.first(take), batch);
+            for (std::size_t q = 0; q < take && found < hits.size(); ++q)
+                if (batch[q].sync >= config_.min_sync)
+                    hits[found++] = batch[q];
+            p += take;
+        }
+        ++full_searches_;
+        since_full_ = 0;
+    } else {
+        // Narrow search around where each tracked station should be now.
+        const double gap_s = static_cast<double>(window_start - std::min(window_start, *last_window_)) / config_.sample_rate;
+        const double tx_s = static_cast<double>(wspr_symbol_count) / wspr_baud;
+        const double cols_per_second = config_.sample_rate / static_cast<double>(hop_);
+        const auto bin_range = static_cast<std::ptrdiff_t>(std::ceil(config_.seed_range_hz / bin_hz_));
+        const auto lag_range = static_cast<std::ptrdiff_t>(std::ceil(config_.seed_lag_s * cols_per_second));
+        const auto drift_range = config_.drift_step_hz > 0.0
+                                     ? static_cast<std::ptrdiff_t>(std::ceil(config_.seed_drift_hz / config_.drift_step_hz))
+                                     : 0;
+        for (const WsprCandidate& seed : seeds_) {
+            if (found == hits.size())
+                break;
+            const double freq = seed.freq_hz + seed.drift_hz * gap_s / tx_s;
+            const std::ptrdiff_t b = std::lround((freq - 1.5 * wspr_tone_spacing_hz) / bin_hz_)
+                                     + static_cast<std::ptrdiff_t>(nfft_ / 2) - band_lo_;
+            const std::ptrdiff_t lag = std::lround((seed.lag_s * config_.sample_rate + static_cast<double>(window_start))
+                                                   / static_cast<double>(hop_))
+                                       - static_cast<std::ptrdiff_t>(col0);
+            const std::ptrdiff_t drift = config_.drift_step_hz > 0.0 ? std::lround(seed.drift_hz / config_.drift_step_hz) : 0;
+            const std::ptrdiff_t b_lo = std::max(bin_min, b - bin_range);
+            const std::ptrdiff_t b_hi = std::min(bin_max, b + bin_range);
+            const std::ptrdiff_t l_lo = std::max(lag_lo_, lag - lag_range);
+            const std::ptrdiff_t l_hi = std::min(lag_hi_, lag + lag_range);
+            if (b_lo > b_hi || l_lo > l_hi)
+                continue;
+            const SyncQuery query{b_lo, b_hi, l_lo, l_hi, std::max(-drift_steps_, drift - drift_range),
+                                  std::min(drift_steps_, drift + drift_range)};
+            SyncHit h;
+            sync_search_cpu(tile, {&query, 1}, {&h, 1});
+            if (h.sync >= config_.min_sync)
+                hits[found++] = h;
+        }
+        ++seeded_searches_;
+        ++since_full_;
+    }
+
+    // Neighbouring peaks (and seeds) can land on the same signal; keep the
+    // best-correlating hit within a tone of each other.
+    std::sort(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(found),
+              [](const SyncHit& a, const SyncHit& b) { return a.sync > b.sync; });
+    candidates_.clear();
+    for (std::size_t i = 0; i < found; ++i) {
+        const bool duplicate = std::any_of(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(i), [&](const SyncHit& h) {
+            return std::abs(h.bin - hits[i].bin) <= 2 && std::abs(h.lag - hits[i].lag) <= steps;
+        });
+        if (!duplicate)
+            candidates_.push_back(candidate_at(window_start, col0, hits[i], comb, noise));
+    }
+    std::sort(candidates_.begin(), candidates_.end(),
+              [](const WsprCandidate& a, const WsprCandidate& b) { return a.snr_db > b.snr_db; });
+
+    seeds_.assign(candidates_.begin(), candidates_.end());
+    last_window_ = window_start;
+    last_full_ = full;
+    force_full_ = false;
+    return candidates_;
+}
+
+void WsprSearch::extract(const WsprCandidate& candidate, std::uint64_t window_start, WsprTonePowers& out) const noexcept
+{
+    const std::uint64_t col0 = first_column(window_start);
+    const auto steps = static_cast<std::ptrdiff_t>(config_.steps_per_symbol);
+    const std::ptrdiff_t bin = std::lround((candidate.freq_hz - 1.5 * wspr_tone_spacing_hz) / bin_hz_)
+                               + static_cast<std::ptrdiff_t>(nfft_ / 2) - band_lo_;
+    const std::ptrdiff_t lag = std::lround((candidate.lag_s * config_.sample_rate + static_cast<double>(window_start))
+                                           / static_cast<double>(hop_))
+                               - static_cast<std::ptrdiff_t>(col0);
+    for (std::ptrdiff_t i = 0; i < symbols; ++i) {
+        auto& tones = out[static_cast<std::size_t>(i)];
+        const std::ptrdiff_t b = bin + drift_offset(candidate.drift_hz, i, bin_hz_);
+        const std::int64_t c = static_cast<std::int64_t>(col0) + lag + i * steps;
+        if (b < 0 || b + 6 >= static_cast<std::ptrdiff_t>(width_) || c < 0) {
+            tones.fill(0.0f);
+            continue;
+        }
+        const float* p = column(static_cast<std::uint64_t>(c)) + b;
+        tones = {p[0], p[2], p[4], p[6]};
+    }
+}
+
+void WsprSearch::set_seeds(std::span<const WsprCandidate> seeds)
+{
+    seeds_.assign(seeds.begin(), seeds.begin() + static_cast<std::ptrdiff_t>(std::min(seeds.size(), config_.max_candidates)));
+}
+
+// ---- WsprDecodeStage --------------------------------------------------------
+
+WsprDecodeStage::WsprDecodeStage(WsprSearchConfig config, Callback callback, TaskPool* pool, FanoOptions fano)
+    : search_(std::move(config)), callback_(std::move(callback)), pool_(pool ? pool : &default_task_pool()), fano_(fano)
+{
+    const std::size_t n = search_.config().max_candidates;
+    reports_.resize(n);
+    spots_.reserve(n);
+    decoded_.reserve(n);
+}
+
+void WsprDecodeStage::process(BufferRef block, const Emitter& emit)
+{
+    const double rate = search_.config().sample_rate;
+    if (!stream_start_) {
+        // Time of stream sample 0, then the first slot boundary at or after it.
+        const auto offset = std::chrono::nanoseconds(
+            std::llround(static_cast<double>(block->first_sample) / block->sample_rate * 1e9));
+        const TimePoint t0 = block->start == TimePoint{} ? TimePoint{} : block->start - offset;
+        const std::int64_t slot_ns = std::llround(slot_seconds * 1e9);
+        const std::int64_t since = t0.time_since_epoch().count();
+        const std::int64_t first = (since + slot_ns - 1) / slot_ns * slot_ns;
+        next_slot_ = TimePoint(std::chrono::nanoseconds(first));
+        next_window_ = static_cast<std::uint64_t>(std::llround(static_cast<double>(first - since) * 1e-9 * rate));
+        stream_start_ = t0;
+    }
+
+    // A stream at another rate passes through undecoded rather than
+    // taking the pipeline down.
+    if (std::abs(block->sample_rate - rate) < 1e-6 * rate) {
+        // Symbol-sized steps, so a window is searched before a large block
+        // pushes its first columns out of the ring.
+        const auto samples = block.samples();
+        for (std::size_t i = 0; i < samples.size(); i += search_.symbol_samples()) {
+            search_.push(samples.subspan(i, std::min(search_.symbol_samples(), samples.size() - i)));
+            while (search_.ready(next_window_)) {
+                decode_slot();
+                next_window_ += static_cast<std::uint64_t>(std::llround(slot_seconds * rate));
+                next_slot_ += std::chrono::nanoseconds(std::llround(slot_seconds * 1e9));
+            }
+        }
+    }
+    emit(std::move(block));
+}
+
+void WsprDecodeStage::decode_slot()
+{
+    static const metrics::StageId search_timer = metrics::stage("wspr.search");
+    static const metrics::StageId decode_timer = metrics::stage("wspr.decode");
+
+    std::span<const WsprCandidate> candidates;
+    {
+        metrics::ScopedTimer timer(search_timer);
+        candidates = search_.search(next_window_, arena_);
+    }
+    spots_.clear();
+    decoded_.clear();
+    {
+        metrics::ScopedTimer timer(decode_timer);
+        auto soft = arena_.make_span<WsprSoftSymbols>(candidates.size());
+        parallel_for(*pool_, candidates.size(), 1, [&](std::size_t begin, std::size_t end) {
+            WsprTonePowers powers;
+            for (std::size_t i = begin; i < end; ++i) {
+                search_.extract(candidates[i], next_window_, powers);
+                wspr_soft_symbols(powers, soft[i]);
+            }
+        });
+        const std::span<std::optional<WsprReport>> reports(reports_.data(), candidates.size());
+        wspr_decode_batch(*pool_, soft, reports, fano_, &arena_);
+
+        for (std::size_t i = 0; i < candidates.size(); ++i) {
+            if (!reports[i])
+                continue;
+            // Strongest first, so a repeat of a message is a weaker copy.
+            const bool repeat = std::any_of(spots_.begin(), spots_.end(), [&](const WsprSpot& s) {
+                return s.report.callsign == reports[i]->callsign && s.report.grid == reports[i]->grid
+                       && s.report.power_dbm == reports[i]->power_dbm;
+            });
+            if (repeat)
+                continue;
+            const WsprCandidate& c = candidates[i];
+            spots_.push_back({next_slot_, c.freq_hz, c.drift_hz, c.lag_s - nominal_start_s, c.snr_db, c.sync,
+                              std::move(*reports[i])});
+            decoded_.push_back(c);
+        }
+    }
+    // Track only what decoded into the next slot.
+    search_.set_seeds(decoded_);
+    ++slots_;
+    if (callback_ && !spots_.empty())
+        callback_(spots_);
+    arena_.reset();
+}
+
+} // namespace mprp
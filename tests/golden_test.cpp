@@ -0,0 +1,389 @@
+// mprp-golden: golden-vector regression suite.
+//
+// Checks the encoder, the modulators and the receive chain against vectors
+// stored in tests/golden/ (or --data DIR):
+//
+//   symbols.txt    WSPR channel symbols of a set of messages, exact;
+//   waveforms.txt  every entry of beacon.conf rendered by the engine: the
+//                  length exactly, the RMS level and 64 evenly spaced
+//                  samples within 1e-3, so the SIMD and scalar NCOs both
+//                  pass;
+//   spots.txt      spots decoded from the reference capture (reference.hpp)
+//                  written as a .mprpcap and read back through the receive
+//                  pipeline: messages exactly, frequency, drift, dt and SNR
+//                  within tolerances.
+//
+// Writes a PASS/FAIL line per check and a summary to test_output.txt (or
+// --out FILE) and exits 1 if anything failed. --update rewrites the vectors
+// from this build instead, for deliberate changes of output.
+
+#include "reference.hpp"
+
+#include "mprp/capture.hpp"
+#include "mprp/engine.hpp"
+#include "mprp/wspr.hpp"
+#include "mprp/wspr_search.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace mprp;
+
+constexpr std::size_t waveform_points = 64;
+constexpr double waveform_tolerance = 1e-3;
+
+struct Options {
+    std::string data = "tests/golden";
+    std::string out = "test_output.txt";
+    std::string work = ".";  ///< Where the reference capture is written.
+    bool update = false;
+};
+
+class Report {
+public:
+    explicit Report(std::FILE* out) : out_(out) {}
+
+    void check(bool ok, const std::string& what, const std::string& detail = {})
+    {
+        ++(ok ? passed_ : failed_);
+        std::fprintf(out_, "%s %s%s%s\n", ok ? "PASS" : "FAIL", what.c_str(), detail.empty() ? "" : ": ",
+                     detail.c_str());
+        if (!ok)
+            std::fprintf(stderr, "mprp-golden: FAIL %s%s%s\n", what.c_str(), detail.empty() ? "" : ": ",
+                         detail.c_str());
+    }
+
+    unsigned failed() const noexcept { return failed_; }
+    unsigned passed() const noexcept { return passed_; }
+
+private:
+    std::FILE* out_;
+    unsigned passed_ = 0;
+    unsigned failed_ = 0;
+};
+
+/// Non-empty, non-comment lines of a vector file; empty if it is missing.
+std::vector<std::string> read_lines(const std::string& path)
+{
+    std::vector<std::string> lines;
+    std::ifstream in(path);
+    for (std::string line; std::getline(in, line);)
+        if (!line.empty() && line[0] != '#')
+            lines.push_back(line);
+    return lines;
+}
+
+void write_lines(const std::string& path, const char* header, const std::vector<std::string>& lines)
+{
+    std::ofstream out(path);
+    out << header;
+    for (const auto& l : lines)
+        out << l << '\n';
+    if (!out)
+        throw std::runtime_error("cannot write " + path);
+}
+
+std::string format(const char* fmt, auto... args)
+{
+    char buf[256];
+    std::snprintf(buf, sizeof buf, fmt, args...);
+    return buf;
+}
+
+// --- WSPR symbols -----------------------------------------------------------
+
+struct SymbolCase {
+    const char* callsign;
+    const char* grid;
+    int power_dbm;
+};
+
+constexpr SymbolCase symbol_cases[] = {
+    {"K1ABC", "FN42", 37}, {"KI5UXW", "EM10", 23}, {"G4XYZ", "IO91", 23}, {"VK2AB", "QF56", 10},
+    {"W5XYZ", "EM12", 30}, {"W1AW", "FN31", 0},    {"JA1ZZZ", "PM95", 60}, {"3D2AG", "RH91", 7},
+};
+
+std::vector<std::string> current_symbols()
+{
+    std::vector<std::string> lines;
+    for (const auto& c : symbol_cases) {
+        WsprSymbols s{};
+        if (wspr_encode({c.callsign, c.grid, c.power_dbm}, s) != WsprStatus::Ok)
+            throw std::runtime_error(std::string("cannot encode ") + c.callsign);
+        std::string line = format("%s %s %d ", c.callsign, c.grid, c.power_dbm);
+        for (std::uint8_t v : s)
+            line.push_back(static_cast<char>('0' + v));
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+void check_symbols(Report& report, const std::vector<std::string>& golden)
+{
+    const auto now = current_symbols();
+    report.check(now.size() == golden.size(), "symbols: case count",
+                 format("%zu golden, %zu now", golden.size(), now.size()));
+    for (std::size_t i = 0; i < std::min(now.size(), golden.size()); ++i) {
+        const auto name = now[i].substr(0, now[i].rfind(' '));
+        std::string detail;
+        if (now[i] != golden[i]) {
+            const auto a = golden[i].substr(golden[i].rfind(' ') + 1);
+            const auto b = now[i].substr(now[i].rfind(' ') + 1);
+            std::size_t k = 0;
+            while (k < a.size() && k < b.size() && a[k] == b[k])
+                ++k;
+            detail = format("first difference at symbol %zu", k);
+        }
+        report.check(now[i] == golden[i], "symbols " + name, detail);
+    }
+}
+
+// --- Rendered waveforms -----------------------------------------------------
+
+struct Waveform {
+    std::string name;
+    std::size_t samples = 0;
+    double rms = 0.0;
+    std::vector<double> points;
+};
+
+std::vector<Waveform> current_waveforms(const std::string& config)
+{
+    const Engine engine = Engine::from_file(config);
+    std::vector<Waveform> out;
+    std::vector<float> buf;
+    for (std::size_t e = 0; e < engine.entries(); ++e) {
+        buf.assign(engine.transmission_samples(e), 0.0f);
+        const std::size_t n = engine.render(e, buf);
+        Waveform w{engine.config().beacons[e].name, n, 0.0, {}};
+        double energy = 0.0;
+        for (std::size_t i = 0; i < n; ++i)
+            energy += static_cast<double>(buf[i]) * buf[i];
+        w.rms = n ? std::sqrt(energy / static_cast<double>(n)) : 0.0;
+        for (std::size_t p = 0; p < waveform_points; ++p)
+            w.points.push_back(n ? buf[p * (n - 1) / (waveform_points - 1)] : 0.0);
+        out.push_back(std::move(w));
+    }
+    return out;
+}
+
+std::string to_line(const Waveform& w)
+{
+    std::string line = format("%s %zu %.6f", w.name.c_str(), w.samples, w.rms);
+    for (double v : w.points)
+        line += format(" %.6f", v);
+    return line;
+}
+
+Waveform parse_waveform(const std::string& line)
+{
+    std::istringstream in(line);
+    Waveform w;
+    in >> w.name >> w.samples >> w.rms;
+    for (double v; in >> v;)
+        w.points.push_back(v);
+    return w;
+}
+
+void check_waveforms(Report& report, const std::vector<std::string>& golden, const std::string& config)
+{
+    const auto now = current_waveforms(config);
+    report.check(now.size() == golden.size(), "waveforms: entry count",
+                 format("%zu golden, %zu now", golden.size(), now.size()));
+    for (std::size_t i = 0; i < std::min(now.size(), golden.size()); ++i) {
+        const Waveform g = parse_waveform(golden[i]);
+        const Waveform& w = now[i];
+        double worst = 0.0;
+        std::size_t at = 0;
+        for (std::size_t p = 0; p < std::min(g.points.size(), w.points.size()); ++p)
+            if (std::abs(g.points[p] - w.points[p]) > worst) {
+                worst = std::abs(g.points[p] - w.points[p]);
+                at = p;
+            }
+        const bool ok = g.name == w.name && g.samples == w.samples && g.points.size() == w.points.size()
+                        && worst <= waveform_tolerance && std::abs(g.rms - w.rms) <= waveform_tolerance;
+        report.check(ok, "waveform " + w.name,
+                     ok ? format("%zu samples, max error %.1e", w.samples, worst)
+                        : format("%zu samples (golden %zu), rms %.6f (golden %.6f), error %.2e at point %zu",
+                                 w.samples, g.samples, w.rms, g.rms, worst, at));
+    }
+}
+
+// --- Decoded spots ----------------------------------------------------------
+
+struct Spot {
+    std::string slot;  ///< HHMM UTC.
+    std::string callsign;
+    std::string grid;
+    int power_dbm = 0;
+    double freq_hz = 0.0;
+    double drift_hz = 0.0;
+    double dt_s = 0.0;
+    double snr_db = 0.0;
+};
+
+constexpr double freq_tolerance_hz = 0.3;
+constexpr double drift_tolerance_hz = 0.6;
+constexpr double dt_tolerance_s = 0.2;
+constexpr double snr_tolerance_db = 1.5;
+
+std::vector<Spot> current_spots(const std::string& work)
+{
+    // Write the reference signal as a capture, ten seconds a chunk, and
+    // decode it the way mprp-rx does.
+    const std::string path = work + "/golden_reference.mprpcap";
+    {
+        const auto x = test::wspr_reference(2);
+        CaptureWriter writer(path, IqFormat::Cf32);
+        const std::size_t chunk = static_cast<std::size_t>(10.0 * test::reference_rate);
+        for (std::size_t at = 0; at < x.size(); at += chunk) {
+            const auto start = TimePoint(std::chrono::seconds(test::reference_epoch_s))
+                               + std::chrono::nanoseconds(static_cast<std::int64_t>(
+                                   static_cast<double>(at) / test::reference_rate * 1e9));
+            writer.append(std::span<const Complex>(x).subspan(at, std::min(chunk, x.size() - at)), start, 14095600.0,
+                          test::reference_rate);
+        }
+        writer.close();
+    }
+
+    std::vector<Spot> spots;
+    {
+        CaptureReader reader(path);
+        BufferPool pool(8, 4096);
+        RxPipeline rx(pool, std::make_unique<CaptureSource>(reader));
+        WsprSearchConfig config;
+        config.sample_rate = test::reference_rate;
+        rx.add(std::make_unique<WsprDecodeStage>(config, [&](std::span<const WsprSpot> decoded) {
+            for (const WsprSpot& s : decoded) {
+                const std::time_t t = std::chrono::duration_cast<std::chrono::seconds>(s.slot.time_since_epoch()).count();
+                std::tm utc{};
+                gmtime_r(&t, &utc);
+                spots.push_back({format("%02d%02d", utc.tm_hour, utc.tm_min), s.report.callsign, s.report.grid,
+                                 s.report.power_dbm, s.freq_hz, s.drift_hz, s.dt_s, s.snr_db});
+            }
+        }));
+        rx.run();
+    }
+    std::remove(path.c_str());
+    std::sort(spots.begin(), spots.end(), [](const Spot& a, const Spot& b) {
+        return a.slot != b.slot ? a.slot < b.slot : a.callsign < b.callsign;
+    });
+    return spots;
+}
+
+std::string to_line(const Spot& s)
+{
+    return format("%s %s %s %d %.2f %.1f %.2f %.1f", s.slot.c_str(), s.callsign.c_str(), s.grid.c_str(), s.power_dbm,
+                  s.freq_hz, s.drift_hz, s.dt_s, s.snr_db);
+}
+
+Spot parse_spot(const std::string& line)
+{
+    std::istringstream in(line);
+    Spot s;
+    in >> s.slot >> s.callsign >> s.grid >> s.power_dbm >> s.freq_hz >> s.drift_hz >> s.dt_s >> s.snr_db;
+    return s;
+}
+
+void check_spots(Report& report, const std::vector<std::string>& golden, const std::string& work)
+{
+    const auto now = current_spots(work);
+    report.check(now.size() == golden.size(), "spots: count", format("%zu golden, %zu now", golden.size(), now.size()));
+    for (const auto& line : golden) {
+        const Spot g = parse_spot(line);
+        const std::string what = "spot " + g.slot + " " + g.callsign;
+        const auto it = std::find_if(now.begin(), now.end(), [&](const Spot& s) {
+            return s.slot == g.slot && s.callsign == g.callsign;
+        });
+        if (it == now.end()) {
+            report.check(false, what, "not decoded");
+            continue;
+        }
+        const bool ok = it->grid == g.grid && it->power_dbm == g.power_dbm
+                        && std::abs(it->freq_hz - g.freq_hz) <= freq_tolerance_hz
+                        && std::abs(it->drift_hz - g.drift_hz) <= drift_tolerance_hz
+                        && std::abs(it->dt_s - g.dt_s) <= dt_tolerance_s
+                        && std::abs(it->snr_db - g.snr_db) <= snr_tolerance_db;
+        report.check(ok, what, ok ? std::string() : "got " + to_line(*it) + ", golden " + line);
+    }
+}
+
+bool parse_args(int argc, char** argv, Options& opt)
+{
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--data") == 0 && has_value) {
+            opt.data = argv[++i];
+        } else if (std::strcmp(argv[i], "--out") == 0 && has_value) {
+            opt.out = argv[++i];
+        } else if (std::strcmp(argv[i], "--work") == 0 && has_value) {
+            opt.work = argv[++i];
+        } else if (std::strcmp(argv[i], "--update") == 0) {
+            opt.update = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::fprintf(stderr, "usage: mprp-golden [--data DIR] [--out FILE|-] [--work DIR] [--update]\n");
+        return 2;
+    }
+    const std::string config = opt.data + "/beacon.conf";
+
+    try {
+        if (opt.update) {
+            write_lines(opt.data + "/symbols.txt", "# callsign grid power_dbm symbols (tone 0-3 per symbol)\n",
+                        current_symbols());
+            std::vector<std::string> lines;
+            for (const auto& w : current_waveforms(config))
+                lines.push_back(to_line(w));
+            write_lines(opt.data + "/waveforms.txt", "# entry samples rms, then 64 evenly spaced samples\n", lines);
+            lines.clear();
+            for (const auto& s : current_spots(opt.work))
+                lines.push_back(to_line(s));
+            write_lines(opt.data + "/spots.txt", "# slot callsign grid power_dbm freq_hz drift_hz dt_s snr_db\n",
+                        lines);
+            std::fprintf(stderr, "mprp-golden: rewrote vectors in %s\n", opt.data.c_str());
+            return 0;
+        }
+
+        std::FILE* out = opt.out == "-" ? stdout : std::fopen(opt.out.c_str(), "w");
+        if (!out) {
+            std::fprintf(stderr, "mprp-golden: cannot open %s\n", opt.out.c_str());
+            return 1;
+        }
+        std::fprintf(out, "# mprp-golden best_isa=%s\n", to_string(best_isa()));
+        Report report(out);
+        check_symbols(report, read_lines(opt.data + "/symbols.txt"));
+        check_waveforms(report, read_lines(opt.data + "/waveforms.txt"), config);
+        check_spots(report, read_lines(opt.data + "/spots.txt"), opt.work);
+        std::fprintf(out, "golden: %u passed, %u failed\n", report.passed(), report.failed());
+        if (out != stdout)
+            std::fclose(out);
+        std::fprintf(stderr, "mprp-golden: %u passed, %u failed\n", report.passed(), report.failed());
+        return report.failed() ? 1 : 0;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "mprp-golden: %s\n", e.what());
+        return 1;
+    }
+}
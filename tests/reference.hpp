@@ -0,0 +1,99 @@
+#pragma once
+
+// Reference receive data shared by the golden suite and the decode-window
+// benchmark: a few WSPR stations at known frequency, drift, timing and SNR
+// over white noise, as complex baseband at 375 Hz. Everything is derived
+// from a fixed LCG (not <random>'s distributions, whose output differs
+// between standard libraries), so every build sees the same capture.
+
+#include "mprp/sample_format.hpp"
+#include "mprp/wspr.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace mprp::test {
+
+struct ReferenceStation {
+    const char* callsign;
+    const char* grid;
+    int power_dbm;
+    double freq_hz;   ///< Tone centre at mid-transmission, relative to the stream centre.
+    double drift_hz;  ///< First symbol to last.
+    double dt_s;      ///< Start after the nominal slot start + 1 s.
+    double snr_db;    ///< 2500 Hz reference bandwidth.
+};
+
+inline constexpr ReferenceStation reference_stations[] = {
+    {"K1ABC", "FN42", 37, -50.3, 0.0, 0.0, -12.0},
+    {"G4XYZ", "IO91", 23, 20.7, 1.5, 0.5, -18.0},
+    {"VK2AB", "QF56", 10, 88.0, -2.0, -0.5, -22.0},
+};
+
+inline constexpr double reference_rate = 375.0;
+/// An even UTC minute, so the stream starts on a slot.
+inline constexpr std::int64_t reference_epoch_s = 1759996800;
+
+/// Deterministic unit-variance Gaussian pairs (Box-Muller over an LCG).
+class ReferenceNoise {
+public:
+    explicit ReferenceNoise(std::uint64_t seed) noexcept : state_(seed) {}
+
+    Complex next() noexcept
+    {
+        const double u1 = (static_cast<double>(step() >> 11) + 1.0) * 0x1p-53;
+        const double u2 = static_cast<double>(step() >> 11) * 0x1p-53;
+        const double r = std::sqrt(-2.0 * std::log(u1));
+        const double a = 2.0 * 3.14159265358979323846 * u2;
+        return {static_cast<float>(r * std::cos(a)), static_cast<float>(r * std::sin(a))};
+    }
+
+private:
+    std::uint64_t step() noexcept
+    {
+        state_ = state_ * 6364136223846793005ull + 1442695040888963407ull;
+        return state_;
+    }
+
+    std::uint64_t state_;
+};
+
+/// slots two-minute slots of every reference station over noise of unit
+/// power per complex sample.
+inline std::vector<Complex> wspr_reference(std::size_t slots)
+{
+    constexpr double two_pi = 2.0 * 3.14159265358979323846;
+    const std::size_t slot_samples = static_cast<std::size_t>(120.0 * reference_rate);
+    const std::size_t symbol = static_cast<std::size_t>(reference_rate / wspr_baud + 0.5);  // 256
+    const std::size_t length = wspr_symbol_count * symbol;
+
+    std::vector<Complex> x(slots * slot_samples);
+    ReferenceNoise noise(0x6d707270);
+    const float sigma = static_cast<float>(std::sqrt(0.5));
+    for (Complex& v : x)
+        v = sigma * noise.next();
+
+    for (const ReferenceStation& st : reference_stations) {
+        WsprSymbols symbols;
+        wspr_encode({st.callsign, st.grid, st.power_dbm}, symbols);
+        // Noise power 1 over the full rate, so the 2500 Hz SNR fixes the
+        // amplitude.
+        const double amplitude = std::sqrt(std::pow(10.0, st.snr_db / 10.0) * 2500.0 / reference_rate);
+        for (std::size_t slot = 0; slot < slots; ++slot) {
+            const auto start = static_cast<std::size_t>(
+                std::lround((static_cast<double>(slot) * 120.0 + 1.0 + st.dt_s) * reference_rate));
+            double phase = 0.0;
+            for (std::size_t i = 0; i < length; ++i) {
+                const double progress = static_cast<double>(i) / static_cast<double>(length) - 0.5;
+                const double f = st.freq_hz + (symbols[i / symbol] - 1.5) * wspr_tone_spacing_hz + st.drift_hz * progress;
+                phase = std::fmod(phase + two_pi * f / reference_rate, two_pi);
+                x[start + i] += Complex(static_cast<float>(amplitude * std::cos(phase)),
+                                        static_cast<float>(amplitude * std::sin(phase)));
+            }
+        }
+    }
+    return x;
+}
+
+} // namespace mprp::test
@@ -0,0 +1,160 @@
+// mprp-cap: packs raw IQ recordings into the chunked capture format and
+// lists a capture's chunk index.
+//
+//   mprp-cap pack --rate 2400000 --format cu8 --centre 14095600 rec.iq rec.mprpcap
+//   mprp-cap info rec.mprpcap
+
+#include "mprp/capture.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace {
+
+struct PackOptions {
+    std::string in;
+    std::string out;
+    std::string format = "cf32";
+    double rate = 0.0;
+    double centre_hz = 0.0;
+    double start_s = -1.0;
+    double chunk_s = 1.0;
+    bool zlib = false;
+};
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: mprp-cap pack --rate HZ [--format cf32|cs16|cu8|cs8] [--centre HZ] [--start UNIX_S]\n"
+                 "                     [--chunk-s S] [--zlib] IN OUT\n"
+                 "       mprp-cap info FILE\n");
+}
+
+bool parse_pack(int argc, char** argv, PackOptions& opt)
+{
+    for (int i = 2; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(a, "--rate") == 0 && has_value)
+            opt.rate = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--format") == 0 && has_value)
+            opt.format = argv[++i];
+        else if (std::strcmp(a, "--centre") == 0 && has_value)
+            opt.centre_hz = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--start") == 0 && has_value)
+            opt.start_s = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--chunk-s") == 0 && has_value)
+            opt.chunk_s = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--zlib") == 0)
+            opt.zlib = true;
+        else if (a[0] == '-')
+            return false;
+        else if (opt.in.empty())
+            opt.in = a;
+        else if (opt.out.empty())
+            opt.out = a;
+        else
+            return false;
+    }
+    return !opt.out.empty() && opt.rate > 0.0 && opt.chunk_s > 0.0;
+}
+
+std::string utc(mprp::TimePoint t)
+{
+    const auto ns = t.time_since_epoch().count();
+    const std::time_t s = static_cast<std::time_t>(ns / 1'000'000'000);
+    std::tm tm{};
+    gmtime_r(&s, &tm);
+    char buf[48];
+    std::snprintf(buf, sizeof buf, "%04d-%02d-%02d %02d:%02d:%02d.%03lld", tm.tm_year + 1900, tm.tm_mon + 1,
+                  tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+                  static_cast<long long>(ns % 1'000'000'000 / 1'000'000));
+    return buf;
+}
+
+int pack(const PackOptions& opt)
+{
+    const auto format = mprp::parse_iq_format(opt.format);
+    const std::size_t width = mprp::iq_sample_bytes(format);
+    std::FILE* in = std::fopen(opt.in.c_str(), "rb");
+    if (!in) {
+        std::fprintf(stderr, "mprp-cap: cannot open %s\n", opt.in.c_str());
+        return 1;
+    }
+
+    // rtl_sdr and friends write sequentially, so the file's mtime is close
+    // to the end of the recording.
+    double start_s = opt.start_s;
+    if (start_s < 0.0) {
+        struct stat st {};
+        ::stat(opt.in.c_str(), &st);
+        start_s = static_cast<double>(st.st_mtime) - static_cast<double>(st.st_size / width) / opt.rate;
+    }
+
+    mprp::CaptureWriter writer(opt.out, format, opt.zlib ? mprp::CaptureCodec::Zlib : mprp::CaptureCodec::None);
+    const auto chunk = static_cast<std::size_t>(opt.chunk_s * opt.rate);
+    std::vector<unsigned char> raw(chunk * width);
+    std::uint64_t done = 0;
+    for (;;) {
+        const std::size_t n = std::fread(raw.data(), width, chunk, in);
+        if (n == 0)
+            break;
+        const auto start = mprp::TimePoint(std::chrono::nanoseconds(
+            std::llround((start_s + static_cast<double>(done) / opt.rate) * 1e9)));
+        writer.append_raw(raw.data(), n, start, opt.centre_hz, opt.rate);
+        done += n;
+    }
+    std::fclose(in);
+    writer.close();
+    std::fprintf(stderr, "mprp-cap: %zu chunks, %llu samples\n", writer.chunks(),
+                 static_cast<unsigned long long>(done));
+    return 0;
+}
+
+int info(const std::string& path)
+{
+    const mprp::CaptureReader reader(path);
+    const char* formats[] = {"cf32", "cs16", "cu8", "cs8"};
+    std::printf("format %s, %zu chunks%s\n", formats[static_cast<int>(reader.format())], reader.chunks().size(),
+                reader.indexed() ? "" : " (index rebuilt: capture was not closed or index damaged)");
+    std::printf("%6s  %-23s  %12s  %10s  %10s  %10s  %s\n", "chunk", "start (UTC)", "centre_hz", "rate",
+                "samples", "stored", "ok");
+    for (std::size_t i = 0; i < reader.chunks().size(); ++i) {
+        const auto& c = reader.chunks()[i];
+        std::printf("%6zu  %-23s  %12.0f  %10.0f  %10llu  %10llu  %s\n", i, utc(c.start()).c_str(), c.centre_hz,
+                    c.sample_rate, static_cast<unsigned long long>(c.samples),
+                    static_cast<unsigned long long>(c.stored_bytes), reader.verify(i) ? "yes" : "CHECKSUM");
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        if (argc >= 2 && std::strcmp(argv[1], "pack") == 0) {
+            PackOptions opt;
+            if (!parse_pack(argc, argv, opt)) {
+                usage();
+                return 2;
+            }
+            return pack(opt);
+        }
+        if (argc == 3 && std::strcmp(argv[1], "info") == 0)
+            return info(argv[2]);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "mprp-cap: %s\n", e.what());
+        return 1;
+    }
+    usage();
+    return 2;
+}
@@ -0,0 +1,178 @@
+// mprp-dist: WSPR decode spread over several nodes.
+//
+//   mprp-dist coordinate --shift 1500 --bands 4 --log spots.mprplog a.mprpcap b.mprpcap
+//   mprp-dist worker --threads 4 coordinator.local
+//
+// The coordinator turns every slot of every capture (e.g. one per antenna)
+// into jobs, one per sub-band, and waits for workers to connect; each
+// worker decodes as many jobs at once as it has --threads. Spots heard in
+// more than one sub-band or capture are merged, then printed and, with
+// --log, appended to a spot log. A worker exits when the coordinator is
+// done.
+//
+// The coordinator listens on loopback unless given --bind ADDR; any other
+// address needs --secret-file, and workers must pass the same file.
+
+#include "mprp/capture.hpp"
+#include "mprp/distributed.hpp"
+#include "mprp/spot_log.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct CoordinateOptions {
+    mprp::CoordinatorOptions dist;
+    std::vector<std::string> captures;
+    std::string log;
+};
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: mprp-dist coordinate [--bind ADDR] [--port N] [--secret-file FILE] [--shift HZ]\n"
+                 "                            [--span HZ] [--bands N] [--guard HZ] [--out-rate HZ] [--dial HZ]\n"
+                 "                            [--log FILE] CAPTURE...\n"
+                 "       mprp-dist worker [--threads N] [--name NAME] [--secret-file FILE] HOST[:PORT]\n");
+}
+
+// The first line of path, so that the secret stays out of ps and shell history.
+std::string read_secret(const char* path)
+{
+    std::ifstream in(path);
+    std::string secret;
+    if (!in || !std::getline(in, secret) || secret.empty())
+        throw std::runtime_error(std::string("cannot read a secret from ") + path);
+    return secret;
+}
+
+bool parse_coordinate(int argc, char** argv, CoordinateOptions& opt)
+{
+    for (int i = 2; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(a, "--port") == 0 && has_value)
+            opt.dist.port = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+        else if (std::strcmp(a, "--bind") == 0 && has_value)
+            opt.dist.bind_address = argv[++i];
+        else if (std::strcmp(a, "--secret-file") == 0 && has_value)
+            opt.dist.secret = read_secret(argv[++i]);
+        else if (std::strcmp(a, "--shift") == 0 && has_value)
+            opt.dist.shift_hz = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--span") == 0 && has_value)
+            opt.dist.span_hz = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--bands") == 0 && has_value)
+            opt.dist.bands = static_cast<std::size_t>(std::atol(argv[++i]));
+        else if (std::strcmp(a, "--guard") == 0 && has_value)
+            opt.dist.guard_hz = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--out-rate") == 0 && has_value)
+            opt.dist.out_rate = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--dial") == 0 && has_value)
+            opt.dist.dial_hz = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--log") == 0 && has_value)
+            opt.log = argv[++i];
+        else if (a[0] == '-')
+            return false;
+        else
+            opt.captures.emplace_back(a);
+    }
+    return !opt.captures.empty();
+}
+
+bool parse_worker(int argc, char** argv, mprp::WorkerOptions& opt)
+{
+    bool have_host = false;
+    for (int i = 2; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(a, "--threads") == 0 && has_value)
+            opt.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (std::strcmp(a, "--name") == 0 && has_value)
+            opt.name = argv[++i];
+        else if (std::strcmp(a, "--secret-file") == 0 && has_value)
+            opt.secret = read_secret(argv[++i]);
+        else if (a[0] == '-' || have_host)
+            return false;
+        else {
+            const std::string host = a;
+            const auto colon = host.rfind(':');
+            opt.host = host.substr(0, colon);
+            if (colon != std::string::npos)
+                opt.port = static_cast<std::uint16_t>(std::atoi(host.c_str() + colon + 1));
+            have_host = true;
+        }
+    }
+    return have_host && opt.threads > 0;
+}
+
+int coordinate(const CoordinateOptions& opt)
+{
+    std::vector<std::unique_ptr<mprp::CaptureReader>> readers;
+    mprp::Coordinator coordinator(opt.dist);
+    for (const auto& path : opt.captures) {
+        readers.push_back(std::make_unique<mprp::CaptureReader>(path));
+        coordinator.add_capture(*readers.back());
+    }
+    std::fprintf(stderr, "mprp-dist: %zu jobs, waiting for workers on %s port %u\n", coordinator.jobs(),
+                 opt.dist.bind_address.c_str(), static_cast<unsigned>(coordinator.port()));
+
+    const auto spots = coordinator.run();
+    std::unique_ptr<mprp::SpotLogWriter> log;
+    if (!opt.log.empty())
+        log = std::make_unique<mprp::SpotLogWriter>(opt.log);
+    for (const auto& s : spots) {
+        if (log)
+            log->append(s);
+        const std::time_t t = s.time_unix_ns / 1'000'000'000;
+        std::tm utc{};
+        gmtime_r(&t, &utc);
+        std::printf("%02d%02d  %5.1f dB  dt %+5.2f  %12.1f Hz  drift %+4.1f  %-6.*s %.*s %2d\n", utc.tm_hour,
+                    utc.tm_min, static_cast<double>(s.snr_db), static_cast<double>(s.dt_s), s.freq_hz,
+                    static_cast<double>(s.drift_hz), static_cast<int>(s.callsign_view().size()),
+                    s.callsign_view().data(), static_cast<int>(s.grid_view().size()), s.grid_view().data(),
+                    s.power_dbm);
+    }
+    std::fprintf(stderr, "mprp-dist: %zu spots from %zu jobs on %zu workers (%zu jobs failed)\n", spots.size(),
+                 coordinator.jobs(), coordinator.workers(), coordinator.failed());
+    return coordinator.failed() == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        if (argc >= 2 && std::strcmp(argv[1], "coordinate") == 0) {
+            CoordinateOptions opt;
+            if (!parse_coordinate(argc, argv, opt)) {
+                usage();
+                return 2;
+            }
+            return coordinate(opt);
+        }
+        if (argc >= 2 && std::strcmp(argv[1], "worker") == 0) {
+            mprp::WorkerOptions opt;
+            if (!parse_worker(argc, argv, opt)) {
+                usage();
+                return 2;
+            }
+            const std::size_t done = mprp::run_worker(opt);
+            std::fprintf(stderr, "mprp-dist: decoded %zu jobs\n", done);
+            return 0;
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "mprp-dist: %s\n", e.what());
+        return 1;
+    }
+    usage();
+    return 2;
+}
@@ -0,0 +1,327 @@
+// mprp-log: summarises and exports spot/telemetry logs written by
+// `mprpd --log` and `mprp-rx --log`, and builds and queries spot stores
+// (mprp/spot_store.hpp) for propagation analysis.
+//
+//   mprp-log info spots.mprplog
+//   mprp-log export --json --kind spot --from 1791950400 spots.mprplog
+//   mprp-log build --out spots.mprpdb node1/*.mprplog node2/*.mprplog
+//   mprp-log query --call K1ABC --band 20m --from 2026-06-01 --to 2026-09-01 spots.mprpdb
+
+#include "mprp/spot_log.hpp"
+#include "mprp/spot_store.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct ExportOptions {
+    std::string in;
+    std::string out;
+    mprp::ExportFormat format = mprp::ExportFormat::Csv;
+    std::optional<mprp::LogKind> kind;
+    double from_s = -1.0;
+    double to_s = -1.0;
+};
+
+struct BuildOptions {
+    std::vector<std::string> logs;
+    std::string out;
+    mprp::SpotStoreOptions store;
+};
+
+struct QueryOptions {
+    std::string in;
+    std::string out;
+    mprp::ExportFormat format = mprp::ExportFormat::Csv;
+    mprp::SpotQuery query;
+    bool stats = false;
+};
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: mprp-log info FILE\n"
+                 "       mprp-log export [--csv|--json] [--kind spot|tx] [--from TIME] [--to TIME]\n"
+                 "                       [--out FILE] FILE\n"
+                 "       mprp-log build --out STORE [--block-rows N] LOG...\n"
+                 "       mprp-log query [--csv|--json] [--call CALL] [--band NAME | --min-hz HZ --max-hz HZ]\n"
+                 "                      [--from TIME] [--to TIME] [--min-snr DB] [--stats] [--out FILE] STORE\n"
+                 "TIME is UNIX seconds or a UTC date, YYYY-MM-DD[THH:MM[:SS]].\n");
+}
+
+// UNIX seconds, or a UTC date (and time); -1 if neither.
+double parse_time(const char* s)
+{
+    if (!std::strchr(s, '-'))
+        return std::atof(s);
+    std::tm tm{};
+    int n = 0;
+    if (std::sscanf(s, "%d-%d-%d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &n) != 3)
+        return -1.0;
+    if (s[n] == 'T' || s[n] == ' ') {
+        if (std::sscanf(s + n + 1, "%d:%d:%d", &tm.tm_hour, &tm.tm_min, &tm.tm_sec) < 2)
+            return -1.0;
+    } else if (s[n] != '\0') {
+        return -1.0;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    return static_cast<double>(timegm(&tm));
+}
+
+bool parse_export(int argc, char** argv, ExportOptions& opt)
+{
+    for (int i = 2; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(a, "--csv") == 0)
+            opt.format = mprp::ExportFormat::Csv;
+        else if (std::strcmp(a, "--json") == 0)
+            opt.format = mprp::ExportFormat::Json;
+        else if (std::strcmp(a, "--kind") == 0 && has_value) {
+            const char* k = argv[++i];
+            if (std::strcmp(k, "spot") == 0)
+                opt.kind = mprp::LogKind::Spot;
+            else if (std::strcmp(k, "tx") == 0)
+                opt.kind = mprp::LogKind::Tx;
+            else
+                return false;
+        } else if (std::strcmp(a, "--from") == 0 && has_value) {
+            opt.from_s = parse_time(argv[++i]);
+            if (opt.from_s < 0.0)
+                return false;
+        } else if (std::strcmp(a, "--to") == 0 && has_value) {
+            opt.to_s = parse_time(argv[++i]);
+            if (opt.to_s < 0.0)
+                return false;
+        } else if (std::strcmp(a, "--out") == 0 && has_value)
+            opt.out = argv[++i];
+        else if (a[0] == '-')
+            return false;
+        else if (opt.in.empty())
+            opt.in = a;
+        else
+            return false;
+    }
+    return !opt.in.empty();
+}
+
+mprp::TimePoint unix_time(double s)
+{
+    return mprp::TimePoint(std::chrono::nanoseconds(std::llround(s * 1e9)));
+}
+
+bool parse_build(int argc, char** argv, BuildOptions& opt)
+{
+    for (int i = 2; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(a, "--out") == 0 && has_value)
+            opt.out = argv[++i];
+        else if (std::strcmp(a, "--block-rows") == 0 && has_value)
+            opt.store.block_rows = static_cast<std::size_t>(std::atol(argv[++i]));
+        else if (a[0] == '-')
+            return false;
+        else
+            opt.logs.push_back(a);
+    }
+    return !opt.out.empty() && !opt.logs.empty();
+}
+
+bool parse_query(int argc, char** argv, QueryOptions& opt)
+{
+    for (int i = 2; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(a, "--csv") == 0)
+            opt.format = mprp::ExportFormat::Csv;
+        else if (std::strcmp(a, "--json") == 0)
+            opt.format = mprp::ExportFormat::Json;
+        else if (std::strcmp(a, "--call") == 0 && has_value)
+            opt.query.callsign = argv[++i];
+        else if (std::strcmp(a, "--band") == 0 && has_value) {
+            if (!mprp::set_band(opt.query, argv[++i])) {
+                std::fprintf(stderr, "mprp-log: unknown band %s\n", argv[i]);
+                return false;
+            }
+        } else if (std::strcmp(a, "--min-hz") == 0 && has_value)
+            opt.query.min_hz = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--max-hz") == 0 && has_value)
+            opt.query.max_hz = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--from") == 0 && has_value) {
+            const double s = parse_time(argv[++i]);
+            if (s < 0.0)
+                return false;
+            opt.query.from = unix_time(s);
+        } else if (std::strcmp(a, "--to") == 0 && has_value) {
+            const double s = parse_time(argv[++i]);
+            if (s < 0.0)
+                return false;
+            opt.query.to = unix_time(s);
+        } else if (std::strcmp(a, "--min-snr") == 0 && has_value)
+            opt.query.min_snr_db = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--stats") == 0)
+            opt.stats = true;
+        else if (std::strcmp(a, "--out") == 0 && has_value)
+            opt.out = argv[++i];
+        else if (a[0] == '-')
+            return false;
+        else if (opt.in.empty())
+            opt.in = a;
+        else
+            return false;
+    }
+    return !opt.in.empty();
+}
+
+std::string utc(std::int64_t ns)
+{
+    const std::time_t s = static_cast<std::time_t>(ns / 1'000'000'000);
+    std::tm tm{};
+    gmtime_r(&s, &tm);
+    char buf[64];
+    std::snprintf(buf, sizeof buf, "%04d-%02d-%02d %02d:%02d:%02d", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                  tm.tm_hour, tm.tm_min, tm.tm_sec);
+    return buf;
+}
+
+int info(const std::string& path)
+{
+    const mprp::SpotLogReader reader(path);
+    const auto records = reader.records();
+    std::size_t spots = 0, tx = 0, invalid = 0;
+    for (const auto& r : records) {
+        if (!mprp::verify(r))
+            ++invalid;
+        else if (r.kind == mprp::LogKind::Spot)
+            ++spots;
+        else if (r.kind == mprp::LogKind::Tx)
+            ++tx;
+    }
+    std::printf("created %s UTC, %zu records (%zu spot, %zu tx, %zu invalid)\n",
+                utc(reader.created_unix_ns()).c_str(), records.size(), spots, tx, invalid);
+    if (!records.empty())
+        std::printf("first %s UTC, last %s UTC\n", utc(records.front().time_unix_ns).c_str(),
+                    utc(records.back().time_unix_ns).c_str());
+    return invalid ? 1 : 0;
+}
+
+int export_log(const ExportOptions& opt)
+{
+    const mprp::SpotLogReader reader(opt.in);
+    auto records = reader.records();
+    if (opt.from_s >= 0.0)
+        records = records.subspan(reader.find(unix_time(opt.from_s)));
+    if (opt.to_s >= 0.0) {
+        const std::int64_t to_ns = unix_time(opt.to_s).time_since_epoch().count();
+        std::size_t n = 0;
+        while (n < records.size() && records[n].time_unix_ns < to_ns)
+            ++n;
+        records = records.first(n);
+    }
+
+    std::vector<mprp::LogRecord> selected;
+    if (opt.kind) {
+        for (const auto& r : records)
+            if (r.kind == *opt.kind)
+                selected.push_back(r);
+        records = selected;
+    }
+
+    std::FILE* out = opt.out.empty() ? stdout : std::fopen(opt.out.c_str(), "w");
+    if (!out) {
+        std::fprintf(stderr, "mprp-log: cannot write %s\n", opt.out.c_str());
+        return 1;
+    }
+    const std::size_t written = mprp::export_records(records, opt.format, out);
+    if (out != stdout)
+        std::fclose(out);
+    if (written != records.size())
+        std::fprintf(stderr, "mprp-log: skipped %zu records failing their checksum\n", records.size() - written);
+    return 0;
+}
+
+int build(const BuildOptions& opt)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    const mprp::SpotStoreBuildStats s = mprp::build_spot_store(opt.logs, opt.out, opt.store);
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("%zu logs, %zu records: %zu spots in %zu blocks, %zu callsigns (%zu duplicate, %zu invalid) "
+                "in %.2f s\n",
+                s.logs, s.records, s.spots, s.blocks, s.callsigns, s.duplicates, s.invalid, secs);
+    return 0;
+}
+
+int query(const QueryOptions& opt)
+{
+    const mprp::SpotStore store(opt.in);
+    const auto t0 = std::chrono::steady_clock::now();
+    mprp::SpotQueryStats stats;
+    const std::vector<std::size_t> rows = store.query(opt.query, &stats);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::FILE* out = opt.out.empty() ? stdout : std::fopen(opt.out.c_str(), "w");
+    if (!out) {
+        std::fprintf(stderr, "mprp-log: cannot write %s\n", opt.out.c_str());
+        return 1;
+    }
+    std::vector<mprp::LogRecord> records;
+    records.reserve(rows.size());
+    for (const std::size_t row : rows)
+        records.push_back(store.record(row));
+    mprp::export_records(records, opt.format, out);
+    if (out != stdout)
+        std::fclose(out);
+    if (opt.stats)
+        std::fprintf(stderr, "mprp-log: %zu of %zu spots in %.3f ms; %zu blocks in range, %zu pruned, %zu rows scanned\n",
+                     stats.matched, store.rows(), ms, stats.blocks, stats.pruned, stats.scanned);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        if (argc >= 2 && std::strcmp(argv[1], "export") == 0) {
+            ExportOptions opt;
+            if (!parse_export(argc, argv, opt)) {
+                usage();
+                return 2;
+            }
+            return export_log(opt);
+        }
+        if (argc >= 2 && std::strcmp(argv[1], "build") == 0) {
+            BuildOptions opt;
+            if (!parse_build(argc, argv, opt)) {
+                usage();
+                return 2;
+            }
+            return build(opt);
+        }
+        if (argc >= 2 && std::strcmp(argv[1], "query") == 0) {
+            QueryOptions opt;
+            if (!parse_query(argc, argv, opt)) {
+                usage();
+                return 2;
+            }
+            return query(opt);
+        }
+        if (argc == 3 && std::strcmp(argv[1], "info") == 0)
+            return info(argv[2]);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "mprp-log: %s\n", e.what());
+        return 1;
+    }
+    usage();
+    return 2;
+}
@@ -0,0 +1,314 @@
+// mprp-rx: streams a raw IQ capture through the receive pipeline and
+// prints the blocks where the energy detector fired, plus per-channel
+// peak/SNR readings for every --channel watched by the spectrum monitor.
+//
+//   mprp-rx --rate 2400000 --format cu8 --shift 120000 --out-rate 48000 capture.iq
+//   mprp-rx --from 14:02 --to 14:04 --shift 120000 --out-rate 48000 rec.mprpcap
+//
+// .mprpcap files (see mprp-cap) carry their own rate and format and are read
+// straight from the mapping; --from/--to take Unix seconds or HH:MM[:SS]
+// UTC on the capture's first day.
+//
+// --wspr decodes every two-minute slot of the (resampled) stream, which must
+// then run at 375 Hz times a power of two, e.g. --out-rate 375. With --log
+// the spots are also appended to a binary spot log (see mprp-log), at
+// --dial plus their audio offset, and --upload CALL GRID reports them to
+// WSPRnet in the background.
+//
+// Shifting, resampling and --agc run as one fused front-end stage.
+// --wspr-device opencl moves the full-band candidate search to a GPU when
+// one is available.
+
+#include "mprp/capture.hpp"
+#include "mprp/metrics.hpp"
+#include "mprp/rx_stages.hpp"
+#include "mprp/spectrum.hpp"
+#include "mprp/spot_log.hpp"
+#include "mprp/spot_upload.hpp"
+#include "mprp/table_snapshot.hpp"
+#include "mprp/wspr_search.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string path;
+    std::string format = "cf32";
+    double rate = 0.0;
+    double shift_hz = 0.0;
+    double out_rate = 0.0;
+    double passband_hz = 0.0;
+    std::size_t taps = 63;
+    double cutoff = 0.2;
+    double threshold_db = 6.0;
+    std::size_t block = 65536;
+    std::size_t blocks = 16;
+    std::size_t fft = 4096;
+    std::vector<double> channels;
+    double channel_bw = 200.0;
+    std::string metrics;
+    std::string from;
+    std::string to;
+    bool wspr = false;
+    bool agc = false;
+    unsigned wspr_full_every = 10;
+    mprp::SearchDevice wspr_device = mprp::SearchDevice::Cpu;
+    std::string log;
+    double dial_hz = 0.0;
+    std::string upload_call;
+    std::string upload_grid;
+    std::string upload_host;
+    std::string tables;
+};
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: mprp-rx --rate HZ [--format cf32|cs16|cu8|cs8] [--shift HZ] [--out-rate HZ]\n"
+                 "               [--agc] [--passband HZ] [--taps N] [--cutoff F] [--threshold DB] [--block N]\n"
+                 "               [--blocks N] [--fft N] [--channel HZ]... [--channel-bw HZ]\n"
+                 "               [--metrics NAME] [--from T] [--to T] [--wspr] [--wspr-full-every N]\n"
+                 "               [--wspr-device cpu|opencl] [--log FILE] [--dial HZ] [--upload CALL GRID] [--upload-host HOST[:PORT]]\n"
+                 "               [--tables FILE] FILE\n");
+}
+
+bool is_capture(const std::string& path)
+{
+    const std::string ext = ".mprpcap";
+    return path.size() > ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+// Unix seconds, or HH:MM[:SS] UTC on the day containing day.
+mprp::TimePoint parse_time(const std::string& text, mprp::TimePoint day, mprp::TimePoint fallback)
+{
+    if (text.empty())
+        return fallback;
+    int h = 0, m = 0;
+    double sec = 0.0;
+    if (std::sscanf(text.c_str(), "%d:%d:%lf", &h, &m, &sec) >= 2) {
+        const std::int64_t ns_per_day = 86'400'000'000'000;
+        const std::int64_t midnight = day.time_since_epoch().count() / ns_per_day * ns_per_day;
+        return mprp::TimePoint(std::chrono::nanoseconds(midnight + std::llround(((h * 60 + m) * 60 + sec) * 1e9)));
+    }
+    return mprp::TimePoint(std::chrono::nanoseconds(std::llround(std::atof(text.c_str()) * 1e9)));
+}
+
+bool parse_args(int argc, char** argv, Options& opt)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(a, "--rate") == 0 && has_value)
+            opt.rate = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--format") == 0 && has_value)
+            opt.format = argv[++i];
+        else if (std::strcmp(a, "--shift") == 0 && has_value)
+            opt.shift_hz = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--out-rate") == 0 && has_value)
+            opt.out_rate = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--passband") == 0 && has_value)
+            opt.passband_hz = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--taps") == 0 && has_value)
+            opt.taps = static_cast<std::size_t>(std::atol(argv[++i]));
+        else if (std::strcmp(a, "--cutoff") == 0 && has_value)
+            opt.cutoff = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--threshold") == 0 && has_value)
+            opt.threshold_db = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--block") == 0 && has_value)
+            opt.block = static_cast<std::size_t>(std::atol(argv[++i]));
+        else if (std::strcmp(a, "--blocks") == 0 && has_value)
+            opt.blocks = static_cast<std::size_t>(std::atol(argv[++i]));
+        else if (std::strcmp(a, "--fft") == 0 && has_value)
+            opt.fft = static_cast<std::size_t>(std::atol(argv[++i]));
+        else if (std::strcmp(a, "--channel") == 0 && has_value)
+            opt.channels.push_back(std::atof(argv[++i]));
+        else if (std::strcmp(a, "--channel-bw") == 0 && has_value)
+            opt.channel_bw = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--metrics") == 0 && has_value)
+            opt.metrics = argv[++i];
+        else if (std::strcmp(a, "--from") == 0 && has_value)
+            opt.from = argv[++i];
+        else if (std::strcmp(a, "--to") == 0 && has_value)
+            opt.to = argv[++i];
+        else if (std::strcmp(a, "--wspr") == 0)
+            opt.wspr = true;
+        else if (std::strcmp(a, "--agc") == 0)
+            opt.agc = true;
+        else if (std::strcmp(a, "--wspr-full-every") == 0 && has_value)
+            opt.wspr_full_every = static_cast<unsigned>(std::atol(argv[++i]));
+        else if (std::strcmp(a, "--wspr-device") == 0 && has_value) {
+            const char* d = argv[++i];
+            if (std::strcmp(d, "cpu") == 0)
+                opt.wspr_device = mprp::SearchDevice::Cpu;
+            else if (std::strcmp(d, "opencl") == 0)
+                opt.wspr_device = mprp::SearchDevice::OpenCl;
+            else
+                return false;
+        } else if (std::strcmp(a, "--log") == 0 && has_value)
+            opt.log = argv[++i];
+        else if (std::strcmp(a, "--dial") == 0 && has_value)
+            opt.dial_hz = std::atof(argv[++i]);
+        else if (std::strcmp(a, "--upload") == 0 && i + 2 < argc) {
+            opt.upload_call = argv[++i];
+            opt.upload_grid = argv[++i];
+        } else if (std::strcmp(a, "--upload-host") == 0 && has_value)
+            opt.upload_host = argv[++i];
+        else if (std::strcmp(a, "--tables") == 0 && has_value)
+            opt.tables = argv[++i];
+        else if (a[0] == '-')
+            return false;
+        else
+            opt.path = a;
+    }
+    if (opt.passband_hz <= 0.0 && opt.out_rate > 0.0)
+        opt.passband_hz = 0.4 * opt.out_rate;
+    return !opt.path.empty() && (opt.rate > 0.0 || is_capture(opt.path));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        usage();
+        return 2;
+    }
+
+    // Unlinks the shared metrics page on every exit path.
+    struct MetricsPage {
+        ~MetricsPage() { mprp::metrics::close(); }
+    } metrics_page;
+    if (!opt.metrics.empty() && !mprp::metrics::open(opt.metrics))
+        std::fprintf(stderr, "mprp-rx: cannot create metrics page %s\n", opt.metrics.c_str());
+
+    if (!opt.tables.empty())
+        mprp::load_table_snapshot(opt.tables);
+
+    try {
+        std::unique_ptr<mprp::CaptureReader> capture;
+        std::unique_ptr<mprp::Source> source;
+        if (is_capture(opt.path)) {
+            capture = std::make_unique<mprp::CaptureReader>(opt.path);
+            const auto day = capture->chunks().empty() ? mprp::TimePoint{} : capture->chunks().front().start();
+            source = std::make_unique<mprp::CaptureSource>(*capture, parse_time(opt.from, day, mprp::TimePoint::min()),
+                                                           parse_time(opt.to, day, mprp::TimePoint::max()));
+            opt.rate = source->sample_rate();
+            if (opt.passband_hz <= 0.0 && opt.out_rate > 0.0)
+                opt.passband_hz = 0.4 * opt.out_rate;
+        } else {
+            source = std::make_unique<mprp::FileSource>(opt.path, mprp::parse_iq_format(opt.format), opt.rate);
+        }
+
+        // Outlives the pipeline, whose stage threads append to it.
+        std::unique_ptr<mprp::SpotLogWriter> log;
+        if (!opt.log.empty())
+            log = std::make_unique<mprp::SpotLogWriter>(opt.log);
+        std::unique_ptr<mprp::SpotUploader> upload;
+        if (!opt.upload_call.empty()) {
+            mprp::SpotUploadOptions uo;
+            uo.reporter_call = opt.upload_call;
+            uo.reporter_grid = opt.upload_grid;
+            if (!opt.upload_host.empty()) {
+                const auto colon = opt.upload_host.rfind(':');
+                uo.host = opt.upload_host.substr(0, colon);
+                if (colon != std::string::npos)
+                    uo.port = static_cast<std::uint16_t>(std::atoi(opt.upload_host.c_str() + colon + 1));
+            }
+            upload = std::make_unique<mprp::SpotUploader>(std::move(uo));
+        }
+
+        mprp::BufferPool pool(opt.blocks, opt.block);
+        mprp::RxPipeline rx(pool, std::move(source));
+        if ((opt.out_rate > 0.0 && opt.out_rate != opt.rate) || opt.agc) {
+            const double out_rate = opt.out_rate > 0.0 ? opt.out_rate : opt.rate;
+            const double passband = opt.passband_hz > 0.0 ? opt.passband_hz : 0.4 * out_rate;
+            rx.add(std::make_unique<mprp::FrontEndStage>(
+                opt.shift_hz, out_rate, passband,
+                opt.agc ? std::optional<mprp::AgcConfig>(mprp::AgcConfig{}) : std::nullopt, opt.block));
+        } else {
+            rx.add(std::make_unique<mprp::MixerStage>(opt.shift_hz));
+        }
+        if (opt.wspr) {
+            mprp::WsprSearchConfig wc;
+            wc.sample_rate = opt.out_rate > 0.0 ? opt.out_rate : opt.rate;
+            wc.full_search_every = opt.wspr_full_every;
+            wc.device = opt.wspr_device;
+            auto stage = std::make_unique<mprp::WsprDecodeStage>(wc, [&](std::span<const mprp::WsprSpot> spots) {
+                for (const auto& s : spots) {
+                    const auto record = mprp::spot_record(s, opt.dial_hz);
+                    if (log)
+                        log->append(record);
+                    if (upload)
+                        upload->submit(record);
+                    const std::time_t t = std::chrono::duration_cast<std::chrono::seconds>(s.slot.time_since_epoch()).count();
+                    std::tm utc{};
+                    gmtime_r(&t, &utc);
+                    std::printf("%02d%02d  %5.1f dB  dt %+5.2f  %+8.2f Hz  drift %+4.1f  %-6s %s %2d\n", utc.tm_hour,
+                                utc.tm_min, s.snr_db, s.dt_s, s.freq_hz, s.drift_hz, s.report.callsign.c_str(),
+                                s.report.grid.c_str(), s.report.power_dbm);
+                }
+            });
+            std::fprintf(stderr, "mprp-rx: wspr search on %s\n", stage->search().backend_name());
+            rx.add(std::move(stage));
+        }
+        if (!opt.channels.empty()) {
+            mprp::SpectrumConfig sc;
+            sc.sample_rate = opt.out_rate > 0.0 ? opt.out_rate : opt.rate;
+            sc.fft_size = opt.fft;
+            sc.hop = opt.fft;
+            for (double hz : opt.channels)
+                sc.channels.push_back({std::to_string(hz), hz, opt.channel_bw});
+            const double rate = sc.sample_rate;
+            rx.add(std::make_unique<mprp::SpectrumStage>(
+                std::move(sc), [rate](const mprp::SpectrumFrame& f) {
+                    for (const auto& r : f.channels)
+                        std::printf("%.3f s  ch%zu  %+.2f Hz  %.1f dB  snr %.1f dB\n",
+                                    static_cast<double>(f.first_sample) / rate, r.channel,
+                                    r.peak_hz, r.peak_db, r.snr_db);
+                }));
+        }
+        rx.add(std::make_unique<mprp::FirStage>(mprp::FirStage::lowpass(opt.taps, opt.cutoff)));
+        rx.add(std::make_unique<mprp::EnergyDetector>(
+            opt.threshold_db, [](const mprp::EnergyDetector::Detection& d) {
+                std::printf("%.3f s  %.1f dB  (floor %.1f dB)\n",
+                            static_cast<double>(d.first_sample) / d.sample_rate, d.power_db,
+                            d.floor_db);
+            }));
+        rx.run();
+        if (!opt.tables.empty() && mprp::table_snapshot_dirty() && !mprp::save_table_snapshot(opt.tables))
+            std::fprintf(stderr, "mprp-rx: cannot write table snapshot %s\n", opt.tables.c_str());
+
+        std::fprintf(stderr, "mprp-rx: %llu samples\n",
+                     static_cast<unsigned long long>(rx.source_samples()));
+        if (upload) {
+            upload->flush(std::chrono::seconds(60));
+            std::fprintf(stderr, "mprp-rx: uploaded %llu spots in %llu requests (%llu retries, %llu dropped, %llu failed)\n",
+                         static_cast<unsigned long long>(upload->sent()),
+                         static_cast<unsigned long long>(upload->batches()),
+                         static_cast<unsigned long long>(upload->retries()),
+                         static_cast<unsigned long long>(upload->dropped()),
+                         static_cast<unsigned long long>(upload->failed()));
+        }
+        if (const auto snap = mprp::metrics::read(opt.metrics))
+            for (const auto& st : snap->stages)
+                std::fprintf(stderr, "mprp-rx: %-16s %8llu blocks  p50 %llu ns  p99 %llu ns  max %llu ns\n",
+                             st.name.c_str(), static_cast<unsigned long long>(st.count),
+                             static_cast<unsigned long long>(st.p50_ns),
+                             static_cast<unsigned long long>(st.p99_ns),
+                             static_cast<unsigned long long>(st.max_ns));
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "mprp-rx: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+// mprp-stat: prints the latency histograms and counters a running mprpd or
+// mprp-rx publishes with --metrics NAME.
+//
+//   mprp-stat [--watch SECONDS] NAME
+
+#include "mprp/metrics.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+
+struct Options {
+    std::string name;
+    double watch_s = 0.0;
+};
+
+void usage()
+{
+    std::fprintf(stderr, "usage: mprp-stat [--watch SECONDS] NAME\n");
+}
+
+bool parse_args(int argc, char** argv, Options& opt)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--watch") == 0 && i + 1 < argc) {
+            opt.watch_s = std::atof(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            return false;
+        } else if (opt.name.empty()) {
+            opt.name = argv[i];
+        } else {
+            return false;
+        }
+    }
+    return !opt.name.empty();
+}
+
+double us(std::uint64_t ns)
+{
+    return static_cast<double>(ns) / 1e3;
+}
+
+void print(const mprp::metrics::Snapshot& snap)
+{
+    std::printf("pid %u\n", snap.pid);
+    std::printf("%-24s %10s %10s %10s %10s %10s %10s %10s\n", "stage", "count", "mean_us", "p50_us",
+                "p90_us", "p99_us", "p999_us", "max_us");
+    for (const auto& s : snap.stages)
+        std::printf("%-24s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", s.name.c_str(),
+                    static_cast<unsigned long long>(s.count), s.mean_ns / 1e3, us(s.p50_ns),
+                    us(s.p90_ns), us(s.p99_ns), us(s.p999_ns), us(s.max_ns));
+    for (const auto& c : snap.counters)
+        std::printf("%-24s %10llu\n", c.name.c_str(), static_cast<unsigned long long>(c.value));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        usage();
+        return 2;
+    }
+
+    for (;;) {
+        const auto snap = mprp::metrics::read(opt.name);
+        if (!snap) {
+            std::fprintf(stderr, "mprp-stat: no metrics page /dev/shm/mprp-%s\n", opt.name.c_str());
+            return 1;
+        }
+        print(*snap);
+        if (opt.watch_s <= 0.0)
+            return 0;
+        std::fflush(stdout);
+        std::this_thread::sleep_for(std::chrono::duration<double>(opt.watch_s));
+        std::printf("\n");
+    }
+}
@@ -0,0 +1,366 @@
+// mprpd: long-running beacon transmitter.
+//
+// Loads the configuration once, then for every slot renders the scheduled
+// entry in-process and streams it as raw 32-bit float samples to the output
+// (stdout by default), e.g. `mprpd beacon.conf | aplay -f FLOAT_LE -r 48000`.
+//
+// Slot starts follow the kernel clock (NTP-disciplined) or, with --pps, a
+// PPS device; the next slot is rendered ahead and the last stretch before
+// the start is busy-waited. --rt-priority and --cpu put the transmit thread
+// on SCHED_FIFO and a fixed core. --log appends a telemetry record per
+// transmission to a binary log (see mprp-log) instead of a stderr line.
+// --tables maps a snapshot of the precomputed DSP tables at start-up and
+// rewrites it whenever something had to be computed, so a rebooted node
+// reaches its first slot without rebuilding them. --rig drives the
+// transmitter over CAT: each entry's dial_hz and tx_power_w are queued as
+// soon as its slot is chosen, and PTT is keyed the command's wire time
+// ahead of the edge and released when the transmission ends. --low-power
+// renders every entry in one burst at start-up and runs no render thread
+// after it; every slot's CPU time and energy (measured or, from --idle-w
+// and --core-w, estimated) go to the metrics page and the slot line.
+// --control serves a Unix socket through which the schedule is changed
+// while running (see control()); a change applies from the next slot not
+// yet committed to, and only entries whose samples changed are rendered.
+
+#include "mprp/control_server.hpp"
+#include "mprp/engine.hpp"
+#include "mprp/live_engine.hpp"
+#include "mprp/metrics.hpp"
+#include "mprp/rig_control.hpp"
+#include "mprp/spot_log.hpp"
+#include "mprp/table_snapshot.hpp"
+#include "mprp/tx_scheduler.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string config;
+    std::string out = "-";
+    std::string metrics;
+    std::string log;
+    std::string pps;
+    std::string cache_dir;
+    std::string tables;
+    std::string control;
+    std::size_t cache_mb = 64;
+    mprp::TxSchedulerOptions tx;
+    mprp::RigControlOptions rig;
+    std::string rig_protocol = "kenwood";
+    bool once = false;
+};
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: mprpd [--once] [--out FILE] [--metrics NAME] [--log FILE] [--pps DEVICE]\n"
+                 "             [--rt-priority N] [--cpu N] [--spin-us N] [--lock-memory]\n"
+                 "             [--cache-dir DIR] [--cache-mb N] [--tables FILE] [--control SOCKET]\n"
+                 "             [--rig DEVICE [--rig-protocol kenwood|civ] [--rig-baud N]\n"
+                 "              [--rig-address N] [--ptt-delay-ms N]]\n"
+                 "             [--low-power [--burst-threads N]] [--idle-w W] [--core-w W] CONFIG\n");
+}
+
+bool parse_args(int argc, char** argv, Options& opt)
+{
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--once") == 0) {
+            opt.once = true;
+        } else if (std::strcmp(argv[i], "--out") == 0 && has_value) {
+            opt.out = argv[++i];
+        } else if (std::strcmp(argv[i], "--metrics") == 0 && has_value) {
+            opt.metrics = argv[++i];
+        } else if (std::strcmp(argv[i], "--log") == 0 && has_value) {
+            opt.log = argv[++i];
+        } else if (std::strcmp(argv[i], "--pps") == 0 && has_value) {
+            opt.pps = argv[++i];
+        } else if (std::strcmp(argv[i], "--rt-priority") == 0 && has_value) {
+            opt.tx.realtime_priority = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--cpu") == 0 && has_value) {
+            opt.tx.cpu = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--spin-us") == 0 && has_value) {
+            opt.tx.spin = std::chrono::microseconds(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--cache-dir") == 0 && has_value) {
+            opt.cache_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--cache-mb") == 0 && has_value) {
+            opt.cache_mb = static_cast<std::size_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--tables") == 0 && has_value) {
+            opt.tables = argv[++i];
+        } else if (std::strcmp(argv[i], "--control") == 0 && has_value) {
+            opt.control = argv[++i];
+        } else if (std::strcmp(argv[i], "--rig") == 0 && has_value) {
+            opt.rig.device = argv[++i];
+        } else if (std::strcmp(argv[i], "--rig-protocol") == 0 && has_value) {
+            opt.rig_protocol = argv[++i];
+        } else if (std::strcmp(argv[i], "--rig-baud") == 0 && has_value) {
+            opt.rig.baud = static_cast<unsigned>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--rig-address") == 0 && has_value) {
+            opt.rig.civ_address = static_cast<std::uint8_t>(std::strtoul(argv[++i], nullptr, 0));
+        } else if (std::strcmp(argv[i], "--ptt-delay-ms") == 0 && has_value) {
+            opt.rig.ptt_delay = std::chrono::microseconds(std::llround(std::atof(argv[++i]) * 1000.0));
+        } else if (std::strcmp(argv[i], "--low-power") == 0) {
+            opt.tx.low_power = true;
+        } else if (std::strcmp(argv[i], "--burst-threads") == 0 && has_value) {
+            opt.tx.burst_threads = static_cast<std::size_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--idle-w") == 0 && has_value) {
+            opt.tx.power.idle_w = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--core-w") == 0 && has_value) {
+            opt.tx.power.core_w = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--lock-memory") == 0) {
+            opt.tx.lock_memory = true;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            return false;
+        } else if (opt.config.empty()) {
+            opt.config = argv[i];
+        } else {
+            return false;
+        }
+    }
+    return !opt.config.empty();
+}
+
+std::string_view next_word(std::string_view& s)
+{
+    while (!s.empty() && s.front() == ' ')
+        s.remove_prefix(1);
+    const auto end = s.find(' ');
+    const auto word = s.substr(0, end);
+    s.remove_prefix(end == std::string_view::npos ? s.size() : end);
+    while (!s.empty() && s.front() == ' ')
+        s.remove_prefix(1);
+    return word;
+}
+
+// An entry by name, or by index if no entry has that name.
+mprp::BeaconEntry& find_entry(mprp::EngineConfig& config, std::string_view name)
+{
+    for (auto& b : config.beacons)
+        if (b.name == name)
+            return b;
+    char* end = nullptr;
+    const std::string s(name);
+    const unsigned long index = std::strtoul(s.c_str(), &end, 10);
+    if (!s.empty() && *end == '\0' && index < config.beacons.size())
+        return config.beacons[index];
+    throw mprp::ConfigError("no entry '" + s + "'");
+}
+
+// One control socket command; every change replies "ok VERSION".
+//   version                  the live configuration's version
+//   show                     version, slot timing and rotation
+//   set KEY VALUE            a top-level key, e.g. set slot_period_s 120
+//   set ENTRY.KEY VALUE      an entry's key, e.g. set wspr.dial_hz 14095600
+//   rotation ENTRY...        the entries to rotate through, in order
+//   reload [FILE]            the configuration file (or another one)
+std::string control(mprp::LiveEngine& live, const std::string& path, const std::function<void()>& changed,
+                    std::string_view line)
+{
+    const auto command = next_word(line);
+    if (command == "version")
+        return "ok " + std::to_string(live.version());
+    if (command == "show") {
+        const auto current = live.current();
+        const auto& config = current->engine.config();
+        std::string reply = "ok " + std::to_string(current->version) + " period "
+                            + std::to_string(config.slot_period_s) + " offset "
+                            + std::to_string(config.slot_offset_s) + " rotation";
+        for (std::size_t e = 0; e < config.beacons.size(); ++e)
+            reply += " " + (config.beacons[e].name.empty() ? std::to_string(e) : config.beacons[e].name);
+        return reply;
+    }
+
+    std::uint64_t version = 0;
+    if (command == "set") {
+        const auto key = next_word(line);
+        if (key.empty() || line.empty())
+            throw mprp::ConfigError("usage: set [ENTRY.]KEY VALUE");
+        version = live.update([&](mprp::EngineConfig& config) {
+            const auto dot = key.find('.');
+            if (dot == std::string_view::npos)
+                mprp::set_config_key(config, nullptr, key, line);
+            else
+                mprp::set_config_key(config, &find_entry(config, key.substr(0, dot)), key.substr(dot + 1), line);
+        });
+    } else if (command == "rotation") {
+        version = live.update([&](mprp::EngineConfig& config) {
+            std::vector<mprp::BeaconEntry> rotation;
+            for (auto name = next_word(line); !name.empty(); name = next_word(line))
+                rotation.push_back(find_entry(config, name));
+            config.beacons = std::move(rotation);
+        });
+    } else if (command == "reload") {
+        version = live.publish(mprp::load_config(line.empty() ? path : std::string(line)));
+    } else {
+        return "error unknown command '" + std::string(command) + "'";
+    }
+    changed();
+    std::fprintf(stderr, "mprpd: configuration version %llu\n", static_cast<unsigned long long>(version));
+    return "ok " + std::to_string(version);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        usage();
+        return 2;
+    }
+
+    // Unlinks the shared metrics page on every exit path.
+    struct MetricsPage {
+        ~MetricsPage() { mprp::metrics::close(); }
+    } metrics_page;
+    if (!opt.metrics.empty() && !mprp::metrics::open(opt.metrics))
+        std::fprintf(stderr, "mprpd: cannot create metrics page %s\n", opt.metrics.c_str());
+
+    if (!opt.tables.empty() && !mprp::load_table_snapshot(opt.tables))
+        std::fprintf(stderr, "mprpd: table snapshot %s missing or stale, regenerating\n", opt.tables.c_str());
+    // Writes the snapshot back if any table had to be built.
+    const auto save_tables = [&] {
+        if (!opt.tables.empty() && mprp::table_snapshot_dirty() && !mprp::save_table_snapshot(opt.tables))
+            std::fprintf(stderr, "mprpd: cannot write table snapshot %s\n", opt.tables.c_str());
+    };
+
+    try {
+        auto config = mprp::load_config(opt.config);
+        if (config.beacons.empty()) {
+            std::fprintf(stderr, "mprpd: no [beacon] entries in %s\n", opt.config.c_str());
+            return 1;
+        }
+        mprp::LiveEngine live(std::move(config));
+
+        std::unique_ptr<mprp::TimeSource> time;
+        if (opt.pps.empty())
+            time = std::make_unique<mprp::SystemTime>();
+        else
+            time = std::make_unique<mprp::PpsTime>(opt.pps);
+        if (time->lock() == mprp::TimeLock::Unsynchronised)
+            std::fprintf(stderr, "mprpd: warning: system clock is not synchronised\n");
+
+        std::FILE* out = opt.out == "-" ? stdout : std::fopen(opt.out.c_str(), "wb");
+        if (!out) {
+            std::fprintf(stderr, "mprpd: cannot open %s\n", opt.out.c_str());
+            return 1;
+        }
+
+        std::unique_ptr<mprp::SpotLogWriter> log;
+        if (!opt.log.empty())
+            log = std::make_unique<mprp::SpotLogWriter>(opt.log);
+
+        // Identical transmissions repeat every rotation; render each once.
+        mprp::RenderCache cache(opt.cache_mb << 20, opt.cache_dir);
+        const auto retain = [&] {
+            const auto current = live.current();
+            std::vector<std::uint64_t> keys;
+            for (std::size_t e = 0; e < current->engine.entries(); ++e)
+                keys.push_back(current->engine.render_key(e));
+            cache.retain(keys);
+        };
+        retain();
+        opt.tx.cache = &cache;
+        save_tables();
+
+        std::unique_ptr<mprp::ControlServer> server;
+        if (!opt.control.empty()) {
+            mprp::ControlServerOptions control_options;
+            control_options.path = opt.control;
+            server = std::make_unique<mprp::ControlServer>(
+                control_options, [&](std::string_view line) { return control(live, opt.config, retain, line); });
+        }
+
+        // Band, mode and power go out when the slot is chosen, well before
+        // the edge; only PTT is left for the edge itself.
+        std::unique_ptr<mprp::RigControl> rig;
+        std::chrono::steady_clock::time_point release{};
+        if (!opt.rig.device.empty()) {
+            opt.rig.protocol = mprp::parse_rig_protocol(opt.rig_protocol);
+            rig = std::make_unique<mprp::RigControl>(opt.rig);
+            opt.tx.prepare = [&](const mprp::SlotPlan& plan, const mprp::Engine& engine) {
+                const auto& entry = engine.config().beacons[plan.entry];
+                mprp::RigState setup;
+                if (entry.dial_hz > 0.0) {
+                    setup.frequency_hz = static_cast<std::uint64_t>(std::llround(entry.dial_hz));
+                    setup.mode = mprp::RigMode::Usb;
+                }
+                if (entry.tx_power_w > 0)
+                    setup.power_w = entry.tx_power_w;
+                rig->request(setup);
+            };
+            opt.tx.key = [&](const mprp::SlotPlan&) { rig->set_ptt(true); };
+            opt.tx.key_lead = rig->ptt_latency();
+        }
+
+        const auto write_timer = mprp::metrics::stage("tx.write");
+        const auto slots = mprp::metrics::counter("tx.slots");
+        const auto samples = mprp::metrics::counter("tx.samples");
+        bool failed = false;
+
+        mprp::TxScheduler scheduler(live, *time, opt.tx);
+        scheduler.run([&](const mprp::TxSlot& slot) {
+            const std::size_t n = slot.samples.size();
+            const auto& config = slot.engine.config();
+            // On the air since the edge, slot.late before the hand-off.
+            const auto on_air = std::chrono::steady_clock::now() - slot.late;
+            {
+                mprp::metrics::ScopedTimer t(write_timer);
+                if (std::fwrite(slot.samples.data(), sizeof(float), n, out) != n) {
+                    std::fprintf(stderr, "mprpd: write failed\n");
+                    failed = true;
+                    return false;
+                }
+                std::fflush(out);
+            }
+            mprp::metrics::add(slots);
+            mprp::metrics::add(samples, n);
+            if (rig) {
+                const std::chrono::duration<double> length(static_cast<double>(n) / config.sample_rate);
+                release = on_air + std::chrono::duration_cast<std::chrono::steady_clock::duration>(length);
+                rig->release_at(release);
+            }
+
+            const auto& entry = config.beacons[slot.plan.entry];
+            if (log) {
+                log->append(mprp::tx_record(slot.plan, entry, slot.lock, slot.late, n));
+                return !opt.once;
+            }
+            std::fprintf(stderr,
+                         "mprpd: slot %lld entry %zu (%s, %s) %zu samples, %s, late %.1f us, "
+                         "cpu %.1f ms, %.2f J%s\n",
+                         static_cast<long long>(slot.plan.index), slot.plan.entry, entry.name.c_str(),
+                         mprp::to_string(entry.mode), n, mprp::to_string(slot.lock),
+                         static_cast<double>(slot.late.count()) / 1e3,
+                         static_cast<double>(slot.power.cpu.count()) / 1e6, slot.power.energy_j,
+                         slot.power.measured ? "" : " (est)");
+            return !opt.once;
+        });
+
+        if (out != stdout)
+            std::fclose(out);
+        // Let the last transmission finish before the rig is unkeyed.
+        if (rig && !failed)
+            std::this_thread::sleep_until(release);
+        save_tables();
+        if (failed)
+            return 1;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "mprpd: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}